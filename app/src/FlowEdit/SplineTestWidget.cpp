@@ -8,6 +8,7 @@
 // -----------------------------------------------------------------------------
 
 #include "FlowEdit/SplineTestWidget.h"
+#include "FlowCore/CurveArray.h"
 #include "FlowCore/CycleCounter.h"
 #include "FlowCore/Log.h"
 #include "FlowCore/MemoryTracer.h"
@@ -16,6 +17,8 @@
 #include <QPaintEvent>
 #include <QPainterPath>
 
+#include <vector>
+
 // -----------------------------------------------------------------------------
 //  Class FSplineTestWidget
 // -----------------------------------------------------------------------------
@@ -97,94 +100,27 @@ void FSplineTestWidget::paintEvent(QPaintEvent* pPaintEvent)
 	QPainterPath splinePath;
 	splinePath.moveTo(m_pt[0]);
 
-	double t0, t1, t2, t3;
-	double ct0, ct1, ct2, ct3, ct22, ct33;
-	double v0, v1, v2, v3;
-	double cv0, cv1, cv2, cv3;
-	double f, df;
-
-	t0 = 0.0;
-	t1 = (m_pt[1].x() - m_pt[0].x()) / (double)(m_pt[3].x() - m_pt[0].x());
-	t2 = (m_pt[2].x() - m_pt[0].x()) / (double)(m_pt[3].x() - m_pt[0].x());
-	t3 = 1.0;
-
-	t1 = fMinMax(t1, 1e-4, 1.0 - 1e-4);
-	t2 = fMinMax(t2, 1e-4, 1.0 - 1e-4);
-
-	ct0 = t0;
-	ct1 = 3.0 * (t1 - t0);
-	ct2 = 3.0 * t0 - 6.0 * t1 + 3.0 * t2;
-	ct3 = -t0 + 3.0 * (t1 - t2) + t3;
-
-	ct33 = ct3 * 3.0;
-	ct22 = ct2 * 2.0;
+	// the x coordinates of the control points define the time curve,
+	// the y coordinates the value curve
+	FCurveArray curve;
+	curve.appendBezier(
+		FVector2f(float(m_pt[0].x()), float(m_pt[0].y())),
+		FVector2f(float(m_pt[1].x()), float(m_pt[1].y())),
+		FVector2f(float(m_pt[2].x()), float(m_pt[2].y())),
+		FVector2f(float(m_pt[3].x()), float(m_pt[3].y())));
 
-	v0 = m_pt[0].y();
-	v1 = m_pt[1].y();
-	v2 = m_pt[2].y();
-	v3 = m_pt[3].y();
-
-	cv0 = v0;
-	cv1 = 3.0 * (v1 - v0);
-	cv2 = 3.0 * v0 - 6.0 * v1 + 3.0 * v2;
-	cv3 = -v0 + 3.0 * (v1 - v2) + v3;
-
-	//F_ALIGN(16) double vct3[2] = { ct3, ct33 };
-	//F_ALIGN(16) double vct2[2] = { ct2, ct22 };
-	//F_ALIGN(16) double vct1[2] = { ct1, ct1 };
-
-	//__m128d mc3 = _mm_load_pd(vct3);
-	//__m128d mc2 = _mm_load_pd(vct2);
-	//__m128d mc1 = _mm_load_pd(vct1);
+	const size_t count = 1001;
+	std::vector<float> times(count), values(count);
+	for (size_t i = 0; i < count; ++i)
+		times[i] = m_pt[0].x() + float(i) * 0.001f * (m_pt[3].x() - m_pt[0].x());
 
 	FCycleCounter cc;
-	double cycles = 0.0;
-
-	for (double s = 0.0; s <= 1000.0; ++s)
-	{
-		double x = s * 0.001;
-		double t = x;
-		double ct00 = ct0 - x;
+	cc.start();
+	curve.evaluate(0, &times[0], &values[0], count);
+	cc.stop();
 
-		//F_ALIGN(16) double vct0[2] = { ct00, ct00 };
-		//__m128d mc0 = _mm_load_pd(vct0);
-		//__m128d t0 = _mm_load1_pd(&t);
-		//__m128d t1, t2;
-
-		cc.start();
-
-		for (int i = 0; i < 14; ++i)
-		{
-			// evaluate the polynomial f and its derivative df
-			// at t using horner scheme
-			f = t * (t * (t * ct3  + ct2 ) + ct1) + ct00;
-			df =     t * (t * ct33 + ct22) + ct1;
-			t = t - f / df;
-
-			/*
-			t1 = _mm_mul_pd(mc3, t0);
-			t1 = _mm_add_pd(t1, mc2);
-			t1 = _mm_mul_pd(t1, t0);
-			t1 = _mm_add_pd(t1, mc1);
-			t1 = _mm_mul_sd(t1, t0);
-			t1 = _mm_add_sd(t1, mc0);
-			t2 = _mm_unpackhi_pd(t1, t1);
-			t1 = _mm_div_sd(t1, t2);
-			t1 = _mm_sub_sd(t0, t1);
-			t0 = _mm_unpacklo_pd(t1, t1);
-			*/
-		}
-
-		//_mm_store_sd(&t, t0);
-		cc.stop();
-
-		double y = t * ( t * ( t * cv3 + cv2) + cv1) + cv0;
-
-		cycles += cc.cycles();
-
-		x = m_pt[0].x() + x * (m_pt[3].x() - m_pt[0].x());
-		splinePath.lineTo(x, y);
-	}
+	for (size_t i = 0; i < count; ++i)
+		splinePath.lineTo(times[i], values[i]);
 
 	painter.setPen(QColor(0, 128, 255));
 	painter.drawPath(splinePath);
@@ -192,7 +128,7 @@ void FSplineTestWidget::paintEvent(QPaintEvent* pPaintEvent)
 	for (int i = 0; i < 4; ++i)
 		painter.fillRect(m_pt[i].x() - 2, m_pt[i].y() - 2, 5, 5, QColor(255, 128, 0));
 
-	F_TRACE << "Cycles: " << (cycles / 1000.0) << std::endl;
+	F_TRACE << "Cycles per sample: " << cc.cyclesPerRun(count) << std::endl;
 }
 
 // Internal functions ----------------------------------------------------------
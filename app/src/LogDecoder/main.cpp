@@ -0,0 +1,105 @@
+// -----------------------------------------------------------------------------
+//  File        main.cpp
+//  Project     LogDecoder
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/BinaryLogReader.h"
+#include "FlowCore/Setup.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <boost/program_options.hpp>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+namespace po = boost::program_options;
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	po::options_description desc("Allowed options");
+
+	desc.add_options()("help,h", "Show this message")
+		("input,i", po::value<std::string>(), "binary log file")
+		("output,o", po::value<std::string>(), "output file, default is standard output")
+		("json,j", "write messages as JSON objects, one per line");
+
+	po::variables_map vm;
+
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);  
+	}
+	catch(po::error e) {
+		std::cerr << "Argument error: " << e.what() << "\n";
+		std::cerr << desc << "\n";
+		return 1;
+	}
+
+	if (vm.count("help") || !vm.count("input"))
+	{
+		std::cerr << desc << "\n";
+		return 1;
+	}
+
+	std::string inputFilePath = vm["input"].as<std::string>();
+	QFile inputFile(QString::fromLocal8Bit(inputFilePath.c_str()));
+	if (!inputFile.open(QIODevice::ReadOnly)) {
+		std::cerr << "Failed to open input file " << inputFilePath << std::endl;
+		return 1;
+	}
+
+	std::ofstream outputFile;
+	if (vm.count("output")) {
+		std::string outputFilePath = vm["output"].as<std::string>();
+		outputFile.open(outputFilePath.c_str(), std::ios::out | std::ios::binary);
+		if (!outputFile) {
+			std::cerr << "Failed to create output file " << outputFilePath << std::endl;
+			return 1;
+		}
+	}
+
+	std::ostream& output = outputFile.is_open() ? outputFile : std::cout;
+	bool writeJson = vm.count("json") > 0;
+
+	FBinaryLogReader reader(&inputFile);
+	if (!reader.isValid()) {
+		std::cerr << "Not a binary log file: " << inputFilePath << std::endl;
+		return 1;
+	}
+
+	size_t messageCount = 0;
+	FBinaryLogEntry entry;
+
+	while (reader.readNext(&entry)) {
+		if (writeJson) {
+			QJsonDocument document(entry.toJson());
+			output << document.toJson(QJsonDocument::Compact).constData() << "\n";
+		}
+		else {
+			output << entry.toString().toUtf8().constData() << "\n";
+		}
+
+		messageCount++;
+	}
+
+	output.flush();
+
+	std::cerr << messageCount << " messages decoded, "
+		<< reader.droppedCount() << " messages dropped." << std::endl;
+
+	if (reader.hasError()) {
+		std::cerr << "Invalid or truncated data after message " << messageCount << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,451 @@
+// -----------------------------------------------------------------------------
+//  File        Allocator.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/24 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/Allocator.h"
+#include "FlowCore/MemoryTracer.h"
+
+#include <cstdlib>
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+#  include <malloc.h>
+#endif
+
+// -----------------------------------------------------------------------------
+//  Class FAllocator
+// -----------------------------------------------------------------------------
+
+// plain atomics without constructors, zero-initialized before any
+// static constructor of another module allocates an array
+static QBasicAtomicPointer<FAllocator> s_pDefaultAllocator;
+static QBasicAtomicPointer<FPoolAllocator> s_pDefaultPool;
+
+// Static methods --------------------------------------------------------------
+
+FAllocator* FAllocator::defaultAllocator()
+{
+	FAllocator* pAllocator = s_pDefaultAllocator.loadAcquire();
+	if (pAllocator)
+		return pAllocator;
+
+	// the global pool is created on first use and intentionally leaked,
+	// arrays in static variables of other modules may outlive any destructor
+	FPoolAllocator* pPool = s_pDefaultPool.loadAcquire();
+	if (!pPool) {
+		FPoolAllocator* pNewPool = new FPoolAllocator();
+		if (s_pDefaultPool.testAndSetOrdered(NULL, pNewPool))
+			pPool = pNewPool;
+		else {
+			delete pNewPool;
+			pPool = s_pDefaultPool.loadAcquire();
+		}
+	}
+
+	return pPool;
+}
+
+void FAllocator::setDefaultAllocator(FAllocator* pAllocator)
+{
+	s_pDefaultAllocator.storeRelease(pAllocator);
+}
+
+void* FAllocator::allocateAligned(size_t size, size_t alignment)
+{
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	return _aligned_malloc(size, alignment);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, alignment, size) != 0)
+		return NULL;
+	return p;
+#endif
+}
+
+void FAllocator::freeAligned(void* p)
+{
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//  Class FPoolAllocator
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FPoolAllocator::FPoolAllocator(size_t chunkSize /* = 1 << 20 */)
+: m_pChunkPos(NULL),
+  m_pChunkEnd(NULL),
+  m_chunkSize(chunkSize),
+  m_allocatedSize(0),
+  m_reservedSize(0)
+{
+	F_ASSERT(chunkSize >= MaxBlockSize);
+
+	for (size_t i = 0; i < ClassCount; ++i)
+		m_freeList[i] = NULL;
+}
+
+FPoolAllocator::~FPoolAllocator()
+{
+	for (size_t i = 0; i < m_chunks.size(); ++i)
+		freeAligned(m_chunks[i]);
+}
+
+// Public commands -------------------------------------------------------------
+
+void* FPoolAllocator::allocate(size_t size)
+{
+	if (size > MaxBlockSize)
+	{
+		void* p = allocateAligned(size);
+		if (!p)
+			return NULL;
+
+		FSectionLock lock(&m_lock);
+		m_allocatedSize += size;
+		m_reservedSize += size;
+		return p;
+	}
+
+	size_t sizeClass = _sizeClass(size);
+	size_t blockSize = size_t(1) << (sizeClass + MinBlockShift);
+
+	FSectionLock lock(&m_lock);
+
+	// recycle a free block of the same class
+	block_t* pBlock = m_freeList[sizeClass];
+	if (pBlock) {
+		m_freeList[sizeClass] = pBlock->pNext;
+		m_allocatedSize += blockSize;
+		return pBlock;
+	}
+
+	// carve a new block from the current chunk, block sizes are multiples
+	// of Alignment, therefore all blocks in a chunk are aligned
+	if (size_t(m_pChunkEnd - m_pChunkPos) < blockSize)
+	{
+		char* pChunk = (char*)allocateAligned(m_chunkSize);
+		if (!pChunk)
+			return NULL;
+
+		_releaseChunkSpace();
+		m_chunks.push_back(pChunk);
+		m_reservedSize += m_chunkSize;
+
+		m_pChunkPos = pChunk;
+		m_pChunkEnd = pChunk + m_chunkSize;
+	}
+
+	void* p = m_pChunkPos;
+	m_pChunkPos += blockSize;
+	m_allocatedSize += blockSize;
+	return p;
+}
+
+void FPoolAllocator::deallocate(void* p, size_t size)
+{
+	if (!p)
+		return;
+
+	if (size > MaxBlockSize)
+	{
+		freeAligned(p);
+
+		FSectionLock lock(&m_lock);
+		m_allocatedSize -= size;
+		m_reservedSize -= size;
+		return;
+	}
+
+	size_t sizeClass = _sizeClass(size);
+
+	FSectionLock lock(&m_lock);
+	m_allocatedSize -= size_t(1) << (sizeClass + MinBlockShift);
+
+	block_t* pBlock = static_cast<block_t*>(p);
+	pBlock->pNext = m_freeList[sizeClass];
+	m_freeList[sizeClass] = pBlock;
+}
+
+void FPoolAllocator::reset()
+{
+	FSectionLock lock(&m_lock);
+
+	// blocks don't know the chunk they belong to, a block still in use
+	// would be returned into a released chunk when it is deallocated
+	F_ASSERT(m_allocatedSize == 0);
+
+	for (size_t i = 0; i < m_chunks.size(); ++i)
+		freeAligned(m_chunks[i]);
+
+	m_chunks.clear();
+	m_pChunkPos = m_pChunkEnd = NULL;
+	m_reservedSize = 0;
+
+	for (size_t i = 0; i < ClassCount; ++i)
+		m_freeList[i] = NULL;
+}
+
+// Public queries --------------------------------------------------------------
+
+size_t FPoolAllocator::allocatedSize() const
+{
+	FSectionLock lock(&m_lock);
+	return m_allocatedSize;
+}
+
+size_t FPoolAllocator::reservedSize() const
+{
+	FSectionLock lock(&m_lock);
+	return m_reservedSize;
+}
+
+// Internal functions ----------------------------------------------------------
+
+size_t FPoolAllocator::_sizeClass(size_t size)
+{
+	size_t sizeClass = 0;
+	size_t blockSize = size_t(1) << MinBlockShift;
+
+	while (blockSize < size) {
+		blockSize <<= 1;
+		++sizeClass;
+	}
+
+	F_ASSERT(sizeClass < ClassCount);
+	return sizeClass;
+}
+
+void FPoolAllocator::_releaseChunkSpace()
+{
+	// split the space left in the current chunk into free blocks of the
+	// largest fitting classes, the space is a multiple of the smallest class
+	for (size_t sizeClass = ClassCount; sizeClass-- > 0; )
+	{
+		size_t blockSize = size_t(1) << (sizeClass + MinBlockShift);
+
+		while (size_t(m_pChunkEnd - m_pChunkPos) >= blockSize) {
+			block_t* pBlock = (block_t*)m_pChunkPos;
+			pBlock->pNext = m_freeList[sizeClass];
+			m_freeList[sizeClass] = pBlock;
+			m_pChunkPos += blockSize;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  Class FSlabAllocator
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FSlabAllocator::FSlabAllocator(size_t elementSize, size_t slabSize /* = 64 * 1024 */)
+: m_elementSize((fMax(elementSize, sizeof(block_t)) + 15) & ~size_t(15)),
+  m_slabSize(slabSize),
+  m_pFree(NULL),
+  m_pSlabPos(NULL),
+  m_pSlabEnd(NULL),
+  m_freeCount(0),
+  m_generation(0)
+{
+	F_ASSERT(slabSize >= m_elementSize);
+}
+
+FSlabAllocator::~FSlabAllocator()
+{
+	for (size_t i = 0; i < m_slabs.size(); ++i)
+		FAllocator::freeAligned(m_slabs[i]);
+}
+
+// Static methods --------------------------------------------------------------
+
+FSlabAllocator* FSlabAllocator::sharedAllocator(QBasicAtomicPointer<FSlabAllocator>* pInstance,
+	size_t elementSize)
+{
+	FSlabAllocator* pAllocator = pInstance->loadAcquire();
+	if (pAllocator)
+		return pAllocator;
+
+	// threads creating the allocator at the same time agree on one of them
+	FSlabAllocator* pNewAllocator = new FSlabAllocator(elementSize);
+	if (pInstance->testAndSetOrdered(NULL, pNewAllocator))
+		return pNewAllocator;
+
+	delete pNewAllocator;
+	return pInstance->loadAcquire();
+}
+
+// Public commands -------------------------------------------------------------
+
+void* FSlabAllocator::allocate(size_t size)
+{
+	if (size > m_elementSize)
+		return malloc(size);
+
+	cache_t* pCache = _cache();
+	if (!pCache->pFree && !_refill(pCache))
+		return NULL;
+
+	block_t* pBlock = pCache->pFree;
+	pCache->pFree = pBlock->pNext;
+	pCache->count--;
+	return pBlock;
+}
+
+void FSlabAllocator::deallocate(void* p, size_t size)
+{
+	if (!p)
+		return;
+
+#ifdef FLOW_DEBUG
+	FMemoryTracer::registerDelete(p);
+#endif
+
+	if (size > m_elementSize) {
+		free(p);
+		return;
+	}
+
+	cache_t* pCache = _cache();
+
+	block_t* pBlock = static_cast<block_t*>(p);
+	pBlock->pNext = pCache->pFree;
+	pCache->pFree = pBlock;
+
+	// keep at most two batches in the cache
+	if (++pCache->count > 2 * BatchSize)
+		_flush(pCache, BatchSize);
+}
+
+void FSlabAllocator::reset()
+{
+	FSectionLock lock(&m_lock);
+
+	for (size_t i = 0; i < m_slabs.size(); ++i)
+		FAllocator::freeAligned(m_slabs[i]);
+
+	m_slabs.clear();
+	m_pSlabPos = m_pSlabEnd = NULL;
+	m_pFree = NULL;
+	m_freeCount = 0;
+
+	// blocks in thread caches are dropped on their next use
+	m_generation++;
+}
+
+// Public queries --------------------------------------------------------------
+
+size_t FSlabAllocator::allocatedCount() const
+{
+	FSectionLock lock(&m_lock);
+	size_t carvedCount = m_slabs.empty() ? 0 : (m_slabs.size() - 1)
+		* (m_slabSize / m_elementSize) + (m_pSlabPos - (char*)m_slabs.back()) / m_elementSize;
+	return carvedCount - m_freeCount;
+}
+
+size_t FSlabAllocator::reservedSize() const
+{
+	FSectionLock lock(&m_lock);
+	return m_slabs.size() * m_slabSize;
+}
+
+// Internal functions ----------------------------------------------------------
+
+FSlabAllocator::cache_t* FSlabAllocator::_cache()
+{
+	if (!m_caches.hasLocalData())
+		m_caches.setLocalData(new cache_t(this));
+
+	cache_t* pCache = m_caches.localData();
+	if (pCache->generation != m_generation) {
+		pCache->pFree = NULL;
+		pCache->count = 0;
+		pCache->generation = m_generation;
+	}
+
+	return pCache;
+}
+
+bool FSlabAllocator::_refill(cache_t* pCache)
+{
+	FSectionLock lock(&m_lock);
+
+	// take a batch of free blocks, carve new blocks if there are not enough
+	for (size_t i = 0; i < BatchSize; ++i)
+	{
+		block_t* pBlock = m_pFree;
+
+		if (pBlock) {
+			m_pFree = pBlock->pNext;
+			m_freeCount--;
+		}
+		else {
+			if (m_pSlabPos + m_elementSize > m_pSlabEnd) {
+				if (pCache->pFree)
+					break;
+
+				char* pSlab = (char*)FAllocator::allocateAligned(m_slabSize);
+				if (!pSlab)
+					break;
+
+				m_slabs.push_back(pSlab);
+				m_pSlabPos = pSlab;
+				m_pSlabEnd = pSlab + m_slabSize;
+			}
+
+			pBlock = (block_t*)m_pSlabPos;
+			m_pSlabPos += m_elementSize;
+		}
+
+		pBlock->pNext = pCache->pFree;
+		pCache->pFree = pBlock;
+		pCache->count++;
+	}
+
+	return pCache->pFree != NULL;
+}
+
+void FSlabAllocator::_flush(cache_t* pCache, size_t count)
+{
+	FSectionLock lock(&m_lock);
+
+	for (size_t i = 0; i < count && pCache->pFree; ++i)
+	{
+		block_t* pBlock = pCache->pFree;
+		pCache->pFree = pBlock->pNext;
+		pCache->count--;
+
+		pBlock->pNext = m_pFree;
+		m_pFree = pBlock;
+		m_freeCount++;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  Class FSlabAllocator::cache_t
+// -----------------------------------------------------------------------------
+
+FSlabAllocator::cache_t::cache_t(FSlabAllocator* pOwner)
+: pOwner(pOwner),
+  pFree(NULL),
+  count(0),
+  generation(pOwner->m_generation)
+{
+}
+
+FSlabAllocator::cache_t::~cache_t()
+{
+	// return the cached blocks when the thread exits
+	if (generation == pOwner->m_generation)
+		pOwner->_flush(this, count);
+}
+
+// -----------------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,242 @@
+// -----------------------------------------------------------------------------
+//  File        Allocator.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/24 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_ALLOCATOR_H
+#define FLOWCORE_ALLOCATOR_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/CriticalSection.h"
+
+#include <QThreadStorage>
+#include <QAtomicPointer>
+#include <new>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Class FAllocator
+// -----------------------------------------------------------------------------
+
+/// Abstract base class for memory allocators providing raw storage for
+/// value arrays. All blocks returned by an allocator must be aligned to
+/// FAllocator::Alignment bytes, which allows aligned SIMD loads on any
+/// element at a multiple of 64 bytes from the start of the block.
+class FLOWCORE_EXPORT FAllocator
+{
+	//  Public types -------------------------------------------------
+
+public:
+	/// Alignment of all blocks in bytes, equals the cache line size.
+	static const size_t Alignment = 64;
+
+	//  Static methods -----------------------------------------------
+
+	/// Returns the allocator used for newly created value arrays.
+	/// Unless changed with setDefaultAllocator(), this is a global,
+	/// thread-safe FPoolAllocator. The global pool is never destroyed,
+	/// arrays in static variables may release their data at any time.
+	static FAllocator* defaultAllocator();
+	/// Sets the allocator used for newly created value arrays. Passing NULL
+	/// restores the global pool. Arrays remember the allocator they were
+	/// created with, the allocator must outlive them.
+	static void setDefaultAllocator(FAllocator* pAllocator);
+
+	/// Allocates a block of the given size and alignment from the heap.
+	static void* allocateAligned(size_t size, size_t alignment = Alignment);
+	/// Frees a block allocated by allocateAligned().
+	static void freeAligned(void* p);
+
+	//  Constructors and destructor ----------------------------------
+
+	virtual ~FAllocator() { }
+
+	//  Public commands ----------------------------------------------
+
+	/// Returns a block of at least size bytes, aligned to Alignment bytes,
+	/// or NULL if no memory is available.
+	virtual void* allocate(size_t size) = 0;
+	/// Returns the given block to the allocator. The size must be the same
+	/// as given when the block was allocated.
+	virtual void deallocate(void* p, size_t size) = 0;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FPoolAllocator
+// -----------------------------------------------------------------------------
+
+/// Allocator serving blocks from size classes (powers of two from 64 bytes
+/// to 256 kilobytes). Blocks are carved from large chunks and recycled via
+/// a free list per size class, so frequent allocation and deallocation of
+/// similar sized arrays does not hit the heap. Larger blocks are allocated
+/// from the heap directly. All methods are thread-safe.
+class FLOWCORE_EXPORT FPoolAllocator : public FAllocator
+{
+	F_DISABLE_COPY(FPoolAllocator);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates a pool allocating memory in chunks of the given size.
+	/// The chunk size must be at least MaxBlockSize.
+	FPoolAllocator(size_t chunkSize = 1 << 20);
+	/// Virtual destructor. Releases all memory held by the pool.
+	virtual ~FPoolAllocator();
+
+	//  Public commands ----------------------------------------------
+
+	virtual void* allocate(size_t size);
+	virtual void deallocate(void* p, size_t size);
+
+	/// Releases all chunks in one go instead of keeping the free blocks,
+	/// e.g. after transient geometry processing. All blocks must have been
+	/// deallocated before, in particular all value arrays using the pool
+	/// must have been destroyed or cleared; this is asserted in debug
+	/// builds. Must not be called while other threads use the pool.
+	void reset();
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the number of bytes in blocks currently in use.
+	size_t allocatedSize() const;
+	/// Returns the number of bytes held by the pool, including free blocks.
+	size_t reservedSize() const;
+
+	/// Size of the largest block served from the pool.
+	static const size_t MaxBlockSize = 256 * 1024;
+
+	//  Internal functions -------------------------------------------
+
+private:
+	static size_t _sizeClass(size_t size);
+	void _releaseChunkSpace();
+
+	//  Internal data members ----------------------------------------
+
+	static const size_t MinBlockShift = 6;
+	static const size_t ClassCount = 13;
+
+	struct block_t
+	{
+		block_t* pNext;
+	};
+
+	block_t* m_freeList[ClassCount];
+	std::vector<void*> m_chunks;
+	char* m_pChunkPos;
+	char* m_pChunkEnd;
+
+	size_t m_chunkSize;
+	size_t m_allocatedSize;
+	size_t m_reservedSize;
+
+	mutable FCriticalSection m_lock;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FSlabAllocator
+// -----------------------------------------------------------------------------
+
+/// Allocator for objects of a single size, usually the objects of one class,
+/// see F_DECLARE_SLAB_ALLOCATED. Objects are carved from large slabs, which
+/// keeps objects created together close in memory and avoids fragmenting the
+/// heap with many small blocks. Each thread keeps a cache of free blocks,
+/// allocation and deallocation lock the allocator only to exchange blocks
+/// between the cache and the allocator in batches. All methods except
+/// reset() are thread-safe.
+class FLOWCORE_EXPORT FSlabAllocator
+{
+	F_DISABLE_COPY(FSlabAllocator);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates an allocator for blocks of the given size. Blocks are
+	/// allocated in slabs of the given size.
+	FSlabAllocator(size_t elementSize, size_t slabSize = 64 * 1024);
+	/// Destructor. Releases all slabs.
+	~FSlabAllocator();
+
+	//  Static methods -----------------------------------------------
+
+	/// Returns the allocator stored in the given pointer, creates it if the
+	/// pointer is NULL. Thread-safe, the allocator is never destroyed.
+	/// Used by F_IMPLEMENT_SLAB_ALLOCATED.
+	static FSlabAllocator* sharedAllocator(QBasicAtomicPointer<FSlabAllocator>* pInstance,
+		size_t elementSize);
+
+	//  Public commands ----------------------------------------------
+
+	/// Returns a block of the given size, or NULL if no memory is available.
+	/// Sizes larger than the element size, e.g. of a derived class, are
+	/// allocated from the heap.
+	void* allocate(size_t size);
+	/// Returns a block to the allocator, size must be the same as given
+	/// when the block was allocated.
+	void deallocate(void* p, size_t size);
+
+	/// Releases all slabs in one go. All objects must have been deleted
+	/// before, or be abandoned without running their destructors, e.g.
+	/// after loading transient data. Must not be called while other
+	/// threads use the allocator.
+	void reset();
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the size of the blocks, including padding for alignment.
+	size_t elementSize() const { return m_elementSize; }
+	/// Returns the number of blocks in use, including blocks in thread caches.
+	size_t allocatedCount() const;
+	/// Returns the number of bytes held by the allocator.
+	size_t reservedSize() const;
+
+	//  Internal types -----------------------------------------------
+
+private:
+	struct block_t
+	{
+		block_t* pNext;
+	};
+
+	struct cache_t
+	{
+		cache_t(FSlabAllocator* pOwner);
+		~cache_t();
+
+		FSlabAllocator* pOwner;
+		block_t* pFree;
+		size_t count;
+		size_t generation;
+	};
+
+	//  Internal functions -------------------------------------------
+
+	cache_t* _cache();
+	bool _refill(cache_t* pCache);
+	void _flush(cache_t* pCache, size_t count);
+
+	//  Internal data members ----------------------------------------
+
+	static const size_t BatchSize = 32;
+
+	size_t m_elementSize;
+	size_t m_slabSize;
+
+	block_t* m_pFree;
+	std::vector<void*> m_slabs;
+	char* m_pSlabPos;
+	char* m_pSlabEnd;
+	size_t m_freeCount;
+	size_t m_generation;
+
+	QThreadStorage<cache_t*> m_caches;
+	mutable FCriticalSection m_lock;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_ALLOCATOR_H
@@ -8,11 +8,64 @@
 // -----------------------------------------------------------------------------
 
 #include "FlowCore/Archive.h"
+#include "FlowCore/IndexedArchive.h"
 #include "FlowCore/Object.h"
 #include "FlowCore/TypeInfo.h"
 #include "FlowCore/TypeRegistry.h"
 #include "FlowCore/MemoryTracer.h"
 
+// Helpers ---------------------------------------------------------------------
+
+enum _byteOrder_t { _LittleEndian = 0, _BigEndian = 1 };
+
+// object tag preceding the tag of an object stored in another
+// section of an indexed archive
+static const quint32 _externalObjectTag = 0xffffffff;
+
+static inline quint8 _fNativeByteOrder()
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+	return _BigEndian;
+#else
+	return _LittleEndian;
+#endif
+}
+
+static inline void _fSwapBytes(quint16* p, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		p[i] = quint16((p[i] >> 8) | (p[i] << 8));
+}
+
+static inline void _fSwapBytes(quint32* p, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		quint32 v = p[i];
+		p[i] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+	}
+}
+
+static inline void _fSwapBytes(quint64* p, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		quint64 v = p[i];
+		quint64 lo = quint32(v), hi = quint32(v >> 32);
+		lo = (lo >> 24) | ((lo >> 8) & 0xff00) | ((lo << 8) & 0xff0000) | ((lo << 24) & 0xff000000);
+		hi = (hi >> 24) | ((hi >> 8) & 0xff00) | ((hi << 8) & 0xff0000) | ((hi << 24) & 0xff000000);
+		p[i] = (lo << 32) | hi;
+	}
+}
+
+static inline void _fSwapBytes(void* p, size_t count, size_t elementSize)
+{
+	switch(elementSize)
+	{
+	case 2: _fSwapBytes((quint16*)p, count); break;
+	case 4: _fSwapBytes((quint32*)p, count); break;
+	case 8: _fSwapBytes((quint64*)p, count); break;
+	}
+}
+
 // -----------------------------------------------------------------------------
 //  Class FArchive
 // -----------------------------------------------------------------------------
@@ -23,7 +76,10 @@ FArchive::FArchive(QIODevice* pDevice, bool checkRefs /* = true */)
 : m_currentVersion(0),
   m_archiveMode(pDevice->isWritable() ? Write : Read),
   m_checkRefs(checkRefs),
-  m_stream(pDevice)
+  m_stream(pDevice),
+  m_isBuffered(false),
+  m_pCursor(NULL),
+  m_pEnd(NULL)
 {
 	F_ASSERT(pDevice);
 	_initialize();
@@ -33,9 +89,19 @@ FArchive::FArchive(QByteArray* pBuffer, mode_t mode, bool checkRefs /* = true */
 : m_currentVersion(0),
   m_archiveMode(mode),
   m_checkRefs(checkRefs),
-  m_stream(pBuffer, mode == Read ? QIODevice::ReadOnly : QIODevice::WriteOnly)
+  m_stream(pBuffer, mode == Read ? QIODevice::ReadOnly : QIODevice::WriteOnly),
+  m_isBuffered(mode == Read),
+  m_pCursor(NULL),
+  m_pEnd(NULL)
 {
 	F_ASSERT(pBuffer);
+
+	if (m_isBuffered) {
+		m_buffer = *pBuffer;
+		m_pCursor = m_buffer.constData();
+		m_pEnd = m_pCursor + m_buffer.size();
+	}
+
 	_initialize();
 }
 
@@ -43,8 +109,23 @@ FArchive::FArchive(const QByteArray& buffer, bool checkRefs /* = true */)
 : m_currentVersion(0),
   m_archiveMode(Read),
   m_checkRefs(checkRefs),
-  m_stream(buffer)
+  m_isBuffered(true),
+  m_buffer(buffer),
+  m_pCursor(m_buffer.constData()),
+  m_pEnd(m_buffer.constData() + m_buffer.size())
+{
+	_initialize();
+}
+
+FArchive::FArchive(const char* pData, size_t size, bool checkRefs /* = true */)
+: m_currentVersion(0),
+  m_archiveMode(Read),
+  m_checkRefs(checkRefs),
+  m_isBuffered(true),
+  m_pCursor(pData),
+  m_pEnd(pData + size)
 {
+	F_ASSERT(pData || size == 0);
 	_initialize();
 }
 
@@ -64,20 +145,17 @@ FObject* FArchive::readObject(const FTypeInfo* pBaseClass /* = NULL */)
 
 	if (!m_checkRefs) {
 
-		m_stream >> m_currentVersion;
+		*this >> m_currentVersion;
 
 		// if the version is 0, a null pointer was stored, i.e. return a null pointer.
 		if (m_currentVersion == 0) {
 			return NULL;
 		}
 
-		// read the class name
-		char* className;
-		m_stream >> className;
-
-		// get the runtime class from the object manager
-		const FTypeInfo* pClass = FTypeRegistry::instance()->classFromName(className);
-		delete[] className;
+		// read the class name and get the runtime class from the object manager
+		const char* className = readStringView();
+		const FTypeInfo* pClass = className
+			? FTypeRegistry::instance()->classFromName(className) : NULL;
 
 		if (!pClass) {
 			F_ASSERT(!"FStaticArchive - Could not find runtime class");
@@ -103,13 +181,23 @@ FObject* FArchive::readObject(const FTypeInfo* pBaseClass /* = NULL */)
 
 	// read the object tag
 	quint32 objTag;
-	m_stream >> objTag;
+	*this >> objTag;
 
 	// if it's the zero tag, we simply return a null pointer
 	if (objTag == 0) {
 		return NULL;
 	}
 
+	// the object is stored in another section of an indexed archive
+	if (objTag == _externalObjectTag) {
+		quint32 indexTag;
+		*this >> indexTag;
+		F_ASSERT(m_pIndex);
+		FObject* pObject = m_pIndex ? m_pIndex->loadObject(indexTag) : NULL;
+		F_ASSERT(!pObject || !pBaseClass || pObject->isKindOf(pBaseClass));
+		return pObject;
+	}
+
 	// check if the object has already been read
 	tagObjTable_t::iterator it = m_pReadObjectTable->find(objTag);
 	if (it != m_pReadObjectTable->end()) {
@@ -123,25 +211,34 @@ FObject* FArchive::readObject(const FTypeInfo* pBaseClass /* = NULL */)
 
 		// it's a previously unseen object, so read the class tag
 		uint16_t classTag;
-		m_stream >> classTag;
+		*this >> classTag;
 
 		// check if we already know this class tag
 		tagClassTable_t::iterator it = m_pReadClassTable->find(classTag);
 		const FTypeInfo* pClass = NULL;
-		if (it != m_pReadClassTable->end())	{
+		if (m_pIndex) {
+			// sections of an indexed archive share the class table of the index
+			quint32 version = 0;
+			pClass = m_pIndex->_readClass(classTag, &version);
+			m_currentVersion = version;
+
+			if (!pClass) {
+				m_stream.setStatus(QDataStream::ReadCorruptData);
+				return NULL;
+			}
+		}
+		else if (it != m_pReadClassTable->end())	{
 			// we found the class, so we can use it to read the object
 			pClass = it->second.pClass;
 			m_currentVersion = it->second.Version;
 		}
 		else {
 			// it's a previously unseen class, so read the class info
-			char* className;
-			m_stream >> m_currentVersion;
-			m_stream >> className;
+			*this >> m_currentVersion;
+			const char* className = readStringView();
 
 			// get the runtime class from the object manager
-			pClass = FTypeRegistry::instance()->classFromName(className);
-			delete[] className;
+			pClass = className ? FTypeRegistry::instance()->classFromName(className) : NULL;
 			F_ASSERT(pClass);
 			m_pReadClassTable->insert(tagClassTable_t::value_type(
 				classTag, classInfo_t(pClass, m_currentVersion)));
@@ -191,6 +288,16 @@ void FArchive::writeObject(const FObject* pObject)
 		return;
 	}
 
+	// objects stored in their own section of an indexed archive
+	// are written as references to the section
+	if (m_pIndex) {
+		quint32 indexTag = m_pIndex->_tagOf(pObject);
+		if (indexTag) {
+			m_stream << _externalObjectTag << indexTag;
+			return;
+		}
+	}
+
 	// check if the object has already been serialized
 	objTagTable_t::iterator it = m_pWriteObjectTable->find(pObject);
 	if (it == m_pWriteObjectTable->end()) {
@@ -204,7 +311,11 @@ void FArchive::writeObject(const FObject* pObject)
 		const FTypeInfo* pClass = pObject->dynamicType();
 		classTagTable_t::iterator it = m_pWriteClassTable->find(pClass);
 
-		if (it == m_pWriteClassTable->end()) {
+		if (m_pIndex) {
+			// sections of an indexed archive share the class table of the index
+			m_stream << m_pIndex->_writeClassTag(pClass);
+		}
+		else if (it == m_pWriteClassTable->end()) {
 
 			// not yet serialized: insert new class/tag pair into hash and
 			// write tag and class info to stream
@@ -231,6 +342,90 @@ void FArchive::writeObject(const FObject* pObject)
 	(const_cast<FObject*>(pObject))->serialize(*this);
 }
 
+void FArchive::writeBlock(const void* pData, size_t count, size_t elementSize)
+{
+	F_ASSERT(isWriting());
+	F_ASSERT(elementSize > 0 && elementSize <= 8);
+
+	quint8 byteOrder = _fNativeByteOrder();
+	m_stream << byteOrder;
+	m_stream << (quint8)elementSize;
+	m_stream << (quint64)(count * elementSize);
+
+	_writeRaw(pData, count * elementSize);
+}
+
+bool FArchive::readBlock(void* pData, size_t count, size_t elementSize)
+{
+	F_ASSERT(isReading());
+
+	quint8 byteOrder;
+	if (!_readBlockHeader(count, elementSize, &byteOrder))
+		return false;
+
+	_readRaw(pData, count * elementSize);
+
+	if (byteOrder != _fNativeByteOrder())
+		_fSwapBytes(pData, count, elementSize);
+
+	return m_stream.status() == QDataStream::Ok;
+}
+
+const void* FArchive::readBlockView(size_t count, size_t elementSize, void* pFallback)
+{
+	F_ASSERT(isReading());
+
+	quint8 byteOrder;
+	if (!_readBlockHeader(count, elementSize, &byteOrder))
+		return NULL;
+
+	if (m_isBuffered && byteOrder == _fNativeByteOrder()
+			&& (quintptr)m_pCursor % elementSize == 0) {
+		return _take(count * elementSize);
+	}
+
+	F_ASSERT(pFallback);
+	_readRaw(pFallback, count * elementSize);
+
+	if (byteOrder != _fNativeByteOrder())
+		_fSwapBytes(pFallback, count, elementSize);
+
+	return m_stream.status() == QDataStream::Ok ? pFallback : NULL;
+}
+
+const char* FArchive::readStringView(size_t* pLength /* = NULL */)
+{
+	F_ASSERT(isReading());
+
+	// the byte count includes the terminating zero, 0 denotes a null string
+	quint32 byteCount;
+	*this >> byteCount;
+
+	const char* pString = NULL;
+
+	if (byteCount > 0) {
+		if (m_isBuffered) {
+			pString = _take(byteCount);
+		}
+		else {
+			m_stringCopy.resize(int(byteCount));
+			_readRaw(m_stringCopy.data(), byteCount);
+			if (m_stream.status() == QDataStream::Ok)
+				pString = m_stringCopy.constData();
+		}
+
+		if (pString && pString[byteCount - 1] != '\0') {
+			m_stream.setStatus(QDataStream::ReadCorruptData);
+			pString = NULL;
+		}
+	}
+
+	if (pLength)
+		*pLength = pString ? byteCount - 1 : 0;
+
+	return pString;
+}
+
 // Operators -------------------------------------------------------------------
 
 /*
@@ -278,8 +473,107 @@ FArchive& FArchive::operator>>(const FTypeInfo*& pTypeInfo)
 
 // Internal functions ----------------------------------------------------------
 
+void FArchive::_readRaw(void* pDest, size_t numBytes)
+{
+	if (m_isBuffered) {
+		const char* p = _take(numBytes);
+		if (p)
+			memcpy(pDest, p, numBytes);
+		return;
+	}
+
+	// QDataStream reads at most 2 GB at once
+	char* p = static_cast<char*>(pDest);
+	while (numBytes > 0)
+	{
+		int n = (int)fMin(numBytes, size_t(1) << 30);
+		if (m_stream.readRawData(p, n) != n) {
+			m_stream.setStatus(QDataStream::ReadPastEnd);
+			return;
+		}
+
+		p += n;
+		numBytes -= n;
+	}
+}
+
+void FArchive::_writeRaw(const void* pSource, size_t numBytes)
+{
+	const char* p = static_cast<const char*>(pSource);
+	while (numBytes > 0)
+	{
+		int n = (int)fMin(numBytes, size_t(1) << 30);
+		m_stream.writeRawData(p, n);
+
+		p += n;
+		numBytes -= n;
+	}
+}
+
+bool FArchive::_readBlockHeader(size_t count, size_t elementSize, quint8* pByteOrder)
+{
+	quint8 blockElementSize;
+	quint64 byteCount;
+	*this >> *pByteOrder;
+	*this >> blockElementSize;
+	*this >> byteCount;
+
+	if (blockElementSize != elementSize || byteCount != count * elementSize) {
+		m_stream.setStatus(QDataStream::ReadCorruptData);
+		return false;
+	}
+
+	return true;
+}
+
+void FArchive::_readBuffered(char*& s)
+{
+	// same as QDataStream: a copy allocated with new[], or null
+	size_t length;
+	const char* p = readStringView(&length);
+
+	s = NULL;
+	if (p) {
+		s = new char[length + 1];
+		memcpy(s, p, length + 1);
+	}
+}
+
+void FArchive::_readBuffered(QString& s)
+{
+	// same as QDataStream: UTF-16 in big endian byte order,
+	// a byte count of 0xffffffff denotes a null string
+	quint32 byteCount;
+	_readBuffered(byteCount);
+
+	if (byteCount == 0xffffffff) {
+		s = QString();
+		return;
+	}
+
+	if (byteCount & 1) {
+		m_stream.setStatus(QDataStream::ReadCorruptData);
+		s.clear();
+		return;
+	}
+
+	const char* p = _take(byteCount);
+	if (!p) {
+		s.clear();
+		return;
+	}
+
+	int length = int(byteCount / 2);
+	s = QString(length, Qt::Uninitialized);
+	ushort* pChars = reinterpret_cast<ushort*>(s.data());
+
+	for (int i = 0; i < length; ++i)
+		pChars[i] = qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(p + 2 * i));
+}
+
 void FArchive::_initialize()
 {
+	m_pIndex = NULL;
 	m_nextClassTag = 1;
 	m_nextObjectTag = 1;
 	m_pReadClassTable = NULL;
@@ -13,12 +13,16 @@
 #include "FlowCore/Library.h"
 
 #include <QString>
+#include <QByteArray>
 #include <QDataStream>
+#include <QtEndian>
+#include <cstring>
 #include <unordered_map>
 #include <vector>
 
 class FTypeInfo;
 class FObject;
+class FIndexedArchive;
 
 // -----------------------------------------------------------------------------
 //  Class FArchive
@@ -28,8 +32,16 @@ class FObject;
 /// Provides serialization of primitive types and classes derived from FObject.
 /// If a dynamic archive is used (see constructors), the archive checks for
 /// cyclic object references and writes or reads each object only once.
+///
+/// Archives reading from memory (a byte array or a mapped file) are
+/// buffered: values are read directly from the memory, without going
+/// through QDataStream and the device. Buffered archives can return views
+/// on strings and blocks pointing into the memory, see readStringView()
+/// and readBlockView(). The data format is the same in both cases.
 class FLOWCORE_EXPORT FArchive
 {
+	friend class FIndexedArchive;
+
 	//  Public types -------------------------------------------------
 	
 public:
@@ -47,13 +59,22 @@ public:
 	FArchive(QIODevice* pDevice, bool checkRefs = true);
 
 	/// Creates an archive for serialization, operating on the given buffer.
+	/// In read mode, the archive is buffered and reads the buffer contents
+	/// at the time of construction.
 	/// If checkRefs is set to true, the archive checks for cyclic pointers.
 	FArchive(QByteArray* pBuffer, mode_t mode, bool checkRefs = true);
 
-	/// Creates an archive for serialization, operating on the given buffer.
+	/// Creates a buffered archive reading from the given buffer. The archive
+	/// keeps a shallow copy of the buffer, the data is not copied.
 	/// If checkRefs is set to true, the archive checks for cyclic pointers.
 	FArchive(const QByteArray& buffer, bool checkRefs = true);
 
+	/// Creates a buffered archive reading size bytes starting at pData,
+	/// e.g. the data of a FMappedFile. The data is not copied and must
+	/// remain valid as long as the archive and any views obtained from it.
+	/// If checkRefs is set to true, the archive checks for cyclic pointers.
+	FArchive(const char* pData, size_t size, bool checkRefs = true);
+
 	/// Virtual destructor.
 	virtual ~FArchive();
 
@@ -67,6 +88,29 @@ public:
 	/// Writes an object to the data stream.
 	void writeObject(const FObject* pObject);
 
+	/// Writes count values of the given size as one raw block in native
+	/// byte order. The block is prefixed with its byte order, element size
+	/// and length, the values are copied without conversion.
+	void writeBlock(const void* pData, size_t count, size_t elementSize);
+	/// Reads a block written by writeBlock() into the given buffer, which
+	/// must provide space for count values of the given size. Values are
+	/// byte swapped only if the block was written with a different byte order.
+	/// Returns false if the block does not match count and element size.
+	bool readBlock(void* pData, size_t count, size_t elementSize);
+	/// Reads a block written by writeBlock() and returns a pointer to its
+	/// values inside the buffer, without copying them. If the archive is not
+	/// buffered, or the values need to be byte swapped or are not aligned
+	/// to their size, they are read into pFallback instead, which must
+	/// provide space for count values. Returns NULL on failure.
+	const void* readBlockView(size_t count, size_t elementSize, void* pFallback);
+
+	/// Reads a string written as const char* and returns a pointer to its
+	/// zero terminated characters. Buffered archives return a pointer into
+	/// the buffer, other archives a pointer to an internal copy which is
+	/// valid until the next call. Returns NULL for a null string.
+	/// Unlike operator>>(char*&), no memory is allocated.
+	const char* readStringView(size_t* pLength = NULL);
+
 	//  Public queries -----------------------------------------------
 
 	/// Returns true if the archive is writing to a stream.
@@ -78,7 +122,16 @@ public:
 	/// the version of the object it is reading.
 	size_t version() const { return m_currentVersion; }
 
-	/// Returns the underlying data stream.
+	/// Returns true if the archive reads directly from memory.
+	bool isBuffered() const { return m_isBuffered; }
+	/// Returns true if a reading archive has reached the end of its data.
+	bool atEnd() const { return m_isBuffered ? m_pCursor == m_pEnd : m_stream.atEnd(); }
+	/// Returns the status of the archive. After reading past the end of
+	/// the data, or reading corrupt data, the status is no longer Ok.
+	QDataStream::Status status() const { return m_stream.status(); }
+
+	/// Returns the underlying data stream. A buffered archive doesn't read
+	/// from the stream, it has no device.
 	QDataStream& stream() { return m_stream; }
 
 	//  Operators ----------------------------------------------------
@@ -129,8 +182,18 @@ public:
 
 private:
 	void _initialize();
-	void _readRaw(void* pSource, size_t numBytes);
-	void _writeRaw(const void* pDest, size_t numBytes);
+	void _readRaw(void* pDest, size_t numBytes);
+	void _writeRaw(const void* pSource, size_t numBytes);
+	bool _readBlockHeader(size_t count, size_t elementSize, quint8* pByteOrder);
+
+	template <typename T>
+	void _readBuffered(T& v);
+	void _readBuffered(bool& v);
+	void _readBuffered(float& v);
+	void _readBuffered(double& v);
+	void _readBuffered(char*& s);
+	void _readBuffered(QString& s);
+	const char* _take(size_t numBytes);
 
 	//  Internal data members --------------------------------------------------
 
@@ -161,7 +224,15 @@ private:
 	mode_t m_archiveMode;
 	bool m_checkRefs;
 
+	FIndexedArchive* m_pIndex;
+
 	QDataStream m_stream;
+
+	bool m_isBuffered;
+	QByteArray m_buffer;
+	const char* m_pCursor;
+	const char* m_pEnd;
+	QByteArray m_stringCopy;
 };
 
 // Inline operators ------------------------------------------------------------
@@ -267,91 +338,130 @@ inline FArchive& FArchive::operator<<(const FObject* pObject)
 inline FArchive& FArchive::operator>>(bool& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(qint8& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(quint8& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(int16_t& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
-	return *this;;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
+	return *this;
 }
 
 inline FArchive& FArchive::operator>>(uint16_t& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(qint32& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(quint32& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(qint64& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(quint64& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(float& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(double& v)
 {
 	F_ASSERT(isReading());
-	m_stream >> v;
+	if (m_isBuffered)
+		_readBuffered(v);
+	else
+		m_stream >> v;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(char* &s)
 {
 	F_ASSERT(isReading());
-	m_stream >> s;
+	if (m_isBuffered)
+		_readBuffered(s);
+	else
+		m_stream >> s;
 	return *this;
 }
 
 inline FArchive& FArchive::operator>>(QString& s)
 {
 	F_ASSERT(isReading());
-	m_stream >> s;
+	if (m_isBuffered)
+		_readBuffered(s);
+	else
+		m_stream >> s;
 	return *this;
 }
 
@@ -362,6 +472,50 @@ inline FArchive& FArchive::operator>>(FObject* &pObject)
 	return *this;
 }
 
+// Internal functions ----------------------------------------------------------
+
+inline const char* FArchive::_take(size_t numBytes)
+{
+	if (size_t(m_pEnd - m_pCursor) < numBytes) {
+		m_pCursor = m_pEnd;
+		m_stream.setStatus(QDataStream::ReadPastEnd);
+		return NULL;
+	}
+
+	const char* p = m_pCursor;
+	m_pCursor += numBytes;
+	return p;
+}
+
+template <typename T>
+inline void FArchive::_readBuffered(T& v)
+{
+	const char* p = _take(sizeof(T));
+	v = p ? qFromBigEndian<T>(reinterpret_cast<const uchar*>(p)) : T(0);
+}
+
+inline void FArchive::_readBuffered(bool& v)
+{
+	qint8 i;
+	_readBuffered(i);
+	v = i != 0;
+}
+
+inline void FArchive::_readBuffered(float& v)
+{
+	// QDataStream writes floats in double precision
+	double d;
+	_readBuffered(d);
+	v = float(d);
+}
+
+inline void FArchive::_readBuffered(double& v)
+{
+	quint64 i;
+	_readBuffered(i);
+	memcpy(&v, &i, sizeof(double));
+}
+
 // Template members ------------------------------------------------------------
 
 template <typename T>
@@ -0,0 +1,185 @@
+// -----------------------------------------------------------------------------
+//  File        ArrayViewT.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/25 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_ARRAYVIEWT_H
+#define FLOWCORE_ARRAYVIEWT_H
+
+#include "FlowCore/Library.h"
+
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+// -----------------------------------------------------------------------------
+//  Class FStridedIteratorT
+// -----------------------------------------------------------------------------
+
+/// Random access iterator over elements placed at a constant distance
+/// (stride, in bytes) in memory.
+template <typename T>
+class FStridedIteratorT
+{
+	//  Public types -------------------------------------------------
+
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef typename std::remove_const<T>::type value_type;
+	typedef ptrdiff_t difference_type;
+	typedef T* pointer;
+	typedef T& reference;
+
+	//  Constructors and destructor ----------------------------------
+
+	FStridedIteratorT() : m_p(NULL), m_stride(sizeof(T)) { }
+	FStridedIteratorT(T* p, ptrdiff_t stride)
+		: m_p(p), m_stride(stride) { }
+
+	/// Creates a const from a mutable iterator (or copies an iterator).
+	FStridedIteratorT(const FStridedIteratorT<value_type>& other)
+		: m_p(other.m_p), m_stride(other.m_stride) { }
+
+	//  Operators ----------------------------------------------------
+
+	T& operator*() const { return *m_p; }
+	T* operator->() const { return m_p; }
+	T& operator[](difference_type i) const { return *_at(i); }
+
+	FStridedIteratorT& operator++() { m_p = _at(1); return *this; }
+	FStridedIteratorT& operator--() { m_p = _at(-1); return *this; }
+	FStridedIteratorT operator++(int) { FStridedIteratorT t(*this); m_p = _at(1); return t; }
+	FStridedIteratorT operator--(int) { FStridedIteratorT t(*this); m_p = _at(-1); return t; }
+
+	FStridedIteratorT& operator+=(difference_type n) { m_p = _at(n); return *this; }
+	FStridedIteratorT& operator-=(difference_type n) { m_p = _at(-n); return *this; }
+	FStridedIteratorT operator+(difference_type n) const { return FStridedIteratorT(_at(n), m_stride); }
+	FStridedIteratorT operator-(difference_type n) const { return FStridedIteratorT(_at(-n), m_stride); }
+	friend FStridedIteratorT operator+(difference_type n, const FStridedIteratorT& it) { return it + n; }
+
+	difference_type operator-(const FStridedIteratorT& other) const {
+		return ((const char*)m_p - (const char*)other.m_p) / m_stride;
+	}
+
+	bool operator==(const FStridedIteratorT& other) const { return m_p == other.m_p; }
+	bool operator!=(const FStridedIteratorT& other) const { return m_p != other.m_p; }
+	bool operator<(const FStridedIteratorT& other) const { return *this - other < 0; }
+	bool operator>(const FStridedIteratorT& other) const { return *this - other > 0; }
+	bool operator<=(const FStridedIteratorT& other) const { return *this - other <= 0; }
+	bool operator>=(const FStridedIteratorT& other) const { return *this - other >= 0; }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	T* _at(difference_type i) const {
+		typedef typename std::conditional<std::is_const<T>::value, const char, char>::type byte_t;
+		return (T*)((byte_t*)m_p + i * m_stride);
+	}
+
+	//  Internal data members ----------------------------------------
+
+	template <typename U> friend class FStridedIteratorT;
+
+	T* m_p;
+	ptrdiff_t m_stride;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FArrayViewT
+// -----------------------------------------------------------------------------
+
+/// Non-owning view on count elements of type T, placed at a constant
+/// distance (stride, in bytes) in memory. Views are cheap to copy and are
+/// meant to be obtained once before a processing loop, element access then
+/// reduces to pointer arithmetic. Use FArrayViewT<const T> for read-only
+/// access; mutable views convert to const views implicitly.
+///
+/// A view does not keep the viewed data alive. It is invalidated whenever
+/// the owner of the data reallocates or detaches it.
+template <typename T>
+class FArrayViewT
+{
+	//  Public types -------------------------------------------------
+
+public:
+	typedef typename std::remove_const<T>::type value_type;
+	typedef T& reference;
+	typedef T* pointer;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef FStridedIteratorT<T> iterator;
+	typedef FStridedIteratorT<const T> const_iterator;
+
+	//  Constructors and destructor ----------------------------------
+
+	/// Creates an empty view.
+	FArrayViewT() : m_pData(NULL), m_count(0), m_stride(sizeof(T)) { }
+	/// Creates a view on count elements starting at pData. The stride is
+	/// the distance between consecutive elements in bytes.
+	FArrayViewT(T* pData, size_t count, ptrdiff_t stride = sizeof(T))
+		: m_pData(pData), m_count(count), m_stride(stride) { }
+
+	/// Creates a const from a mutable view (or copies a view).
+	FArrayViewT(const FArrayViewT<value_type>& other)
+		: m_pData(other.data()), m_count(other.size()), m_stride(other.stride()) { }
+
+	//  Operators ----------------------------------------------------
+
+	/// Returns the element at the given index.
+	T& operator[](size_t index) const {
+		F_ASSERT(index < m_count);
+		return *(T*)((_byte_t*)m_pData + ptrdiff_t(index) * m_stride);
+	}
+
+	//  Public commands ----------------------------------------------
+
+	/// Assigns the given value to all elements.
+	void fill(const value_type& val) const {
+		for (size_t i = 0; i < m_count; ++i)
+			(*this)[i] = val;
+	}
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns an iterator to the first element.
+	iterator begin() const { return iterator(m_pData, m_stride); }
+	/// Returns an iterator past the last element.
+	iterator end() const { return begin() + difference_type(m_count); }
+
+	/// Returns a view on count elements starting at the given index.
+	FArrayViewT<T> mid(size_t start, size_t count) const {
+		F_ASSERT(start + count <= m_count);
+		return FArrayViewT<T>((T*)((_byte_t*)m_pData + ptrdiff_t(start) * m_stride),
+			count, m_stride);
+	}
+
+	/// Returns a pointer to the first element.
+	T* data() const { return m_pData; }
+	/// Returns the number of elements.
+	size_t size() const { return m_count; }
+	/// Returns the distance between consecutive elements in bytes.
+	ptrdiff_t stride() const { return m_stride; }
+	/// Returns true if the view contains no elements.
+	bool isEmpty() const { return m_count == 0; }
+	/// Returns true if the elements are tightly packed.
+	bool isContiguous() const { return m_stride == sizeof(T); }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	typedef typename std::conditional<std::is_const<T>::value, const char, char>::type _byte_t;
+
+	//  Internal data members ----------------------------------------
+
+	T* m_pData;
+	size_t m_count;
+	ptrdiff_t m_stride;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_ARRAYVIEWT_H
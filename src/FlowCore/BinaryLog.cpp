@@ -0,0 +1,356 @@
+// -----------------------------------------------------------------------------
+//  File        BinaryLog.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/BinaryLog.h"
+
+#include <QThread>
+#include <QDateTime>
+#include <QtEndian>
+
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLog::writer_t
+// -----------------------------------------------------------------------------
+
+class FBinaryLog::writer_t : public QThread
+{
+public:
+	writer_t(FBinaryLog* pLog) : m_pLog(pLog) { }
+
+protected:
+	virtual void run() { m_pLog->_run(); }
+
+private:
+	FBinaryLog* m_pLog;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLog
+// -----------------------------------------------------------------------------
+
+// Helpers ---------------------------------------------------------------------
+
+template <typename T>
+static inline void _append(QByteArray& buffer, T value)
+{
+	T data = qToLittleEndian(value);
+	buffer.append((const char*)&data, int(sizeof(T)));
+}
+
+static inline void _appendString(QByteArray& buffer, const char* pText)
+{
+	size_t size = pText ? strlen(pText) : 0;
+	if (size > 0xffff)
+		size = 0xffff;
+
+	_append(buffer, quint16(size));
+	buffer.append(pText, int(size));
+}
+
+// Static members --------------------------------------------------------------
+
+QAtomicInt FBinaryLog::s_enabledLevel(FLogType::All);
+QElapsedTimer FBinaryLog::s_clock;
+
+// Constructors and destructor -------------------------------------------------
+
+FBinaryLog::FBinaryLog()
+: m_queue(QueueCapacity),
+  m_level(FLogType::Trace),
+  m_pWriter(NULL),
+  m_isStopping(false),
+  m_droppedCount(0),
+  m_writtenDropCount(0)
+{
+}
+
+FBinaryLog::~FBinaryLog()
+{
+	close();
+}
+
+// Public commands -------------------------------------------------------------
+
+bool FBinaryLog::open(const QString& fileName)
+{
+	close();
+
+	m_file.setFileName(fileName);
+	if (!m_file.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+
+	m_fileName = fileName;
+
+	// discard messages added while the previous file was closed
+	record_t record;
+	while (m_queue.dequeue(record)) { }
+
+	m_formatTable.clear();
+	m_droppedCount.store(0);
+	m_writtenDropCount = 0;
+
+	m_buffer.clear();
+	m_buffer.append("FBLG", 4);
+	_append(m_buffer, FormatVersion);
+	_append(m_buffer, qint64(QDateTime::currentMSecsSinceEpoch()));
+	s_clock.start();
+
+	m_isStopping = false;
+	m_pWriter = new writer_t(this);
+	m_pWriter->start();
+
+	s_enabledLevel.store(int(m_level));
+	return true;
+}
+
+void FBinaryLog::close()
+{
+	if (!m_file.isOpen())
+		return;
+
+	s_enabledLevel.store(FLogType::All);
+
+	m_wakeMutex.lock();
+	m_isStopping = true;
+	m_wakeCondition.wakeOne();
+	m_wakeMutex.unlock();
+
+	m_pWriter->wait();
+	F_SAFE_DELETE(m_pWriter);
+
+	_writeQueue();
+	m_file.close();
+}
+
+void FBinaryLog::setLevel(FLogType level)
+{
+	m_level = level;
+
+	if (m_file.isOpen())
+		s_enabledLevel.store(int(level));
+}
+
+// Internal functions ----------------------------------------------------------
+
+void FBinaryLog::_submit(const record_t& record)
+{
+	if (!m_queue.enqueue(record))
+		m_droppedCount.fetchAndAddRelaxed(1);
+}
+
+void FBinaryLog::_run()
+{
+	for (;;) {
+		_writeQueue();
+
+		QMutexLocker locker(&m_wakeMutex);
+		if (m_isStopping)
+			break;
+
+		m_wakeCondition.wait(&m_wakeMutex, WriteInterval);
+	}
+}
+
+void FBinaryLog::_writeQueue()
+{
+	record_t record;
+	while (m_queue.dequeue(record))
+		_encode(record);
+
+	int dropCount = m_droppedCount.load();
+	if (dropCount != m_writtenDropCount) {
+		m_buffer.append(char(DroppedRecord));
+		_append(m_buffer, quint32(dropCount - m_writtenDropCount));
+		m_writtenDropCount = dropCount;
+	}
+
+	if (!m_buffer.isEmpty()) {
+		m_file.write(m_buffer);
+		m_file.flush();
+		m_buffer.clear();
+	}
+}
+
+void FBinaryLog::_encode(const record_t& record)
+{
+	quint32 id = _formatId(record);
+
+	m_buffer.append(char(MessageRecord));
+	_append(m_buffer, id);
+	_append(m_buffer, record.timestamp);
+	_append(m_buffer, record.threadId);
+	m_buffer.append(char(record.isTruncated));
+	m_buffer.append(char(record.argsSize));
+	m_buffer.append(record.args, int(record.argsSize));
+}
+
+quint32 FBinaryLog::_formatId(const record_t& record)
+{
+	formatKey_t key;
+	key.module = record.module;
+	key.format = record.format;
+	key.file = record.file;
+	key.line = record.line;
+	key.type = record.type;
+
+	formatTable_t::const_iterator it = m_formatTable.find(key);
+	if (it != m_formatTable.end())
+		return it->second;
+
+	// first message with this format, write the format definition
+	quint32 id = quint32(m_formatTable.size() + 1);
+	m_formatTable.insert(formatTable_t::value_type(key, id));
+
+	m_buffer.append(char(FormatRecord));
+	_append(m_buffer, id);
+	m_buffer.append(char(record.type));
+	_append(m_buffer, record.line);
+	_appendString(m_buffer, record.module);
+	_appendString(m_buffer, record.format);
+	_appendString(m_buffer, record.file);
+
+	return id;
+}
+
+bool FBinaryLog::formatKey_t::operator<(const formatKey_t& other) const
+{
+	if (format != other.format)
+		return format < other.format;
+	if (module != other.module)
+		return module < other.module;
+	if (file != other.file)
+		return file < other.file;
+	if (line != other.line)
+		return line < other.line;
+	return type < other.type;
+}
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogRecord
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FBinaryLogRecord::FBinaryLogRecord(FLogType type, const char* module,
+	const char* format, const char* file, int line)
+{
+	m_record.module = module;
+	m_record.format = format;
+	m_record.file = file;
+	m_record.line = quint32(line);
+	m_record.type = quint8(type);
+	m_record.argsSize = 0;
+	m_record.isTruncated = 0;
+	m_record.timestamp = FBinaryLog::_timestamp();
+	m_record.threadId = quint64(quintptr(QThread::currentThreadId()));
+}
+
+FBinaryLogRecord::~FBinaryLogRecord()
+{
+	FBinaryLog::instance()->_submit(m_record);
+}
+
+// Public commands -------------------------------------------------------------
+
+FBinaryLogRecord& FBinaryLogRecord::operator<<(bool value)
+{
+	char* pData = _reserve(char(FBinaryLog::BoolArg), 1);
+	if (pData)
+		*pData = value ? 1 : 0;
+
+	return *this;
+}
+
+FBinaryLogRecord& FBinaryLogRecord::operator<<(double value)
+{
+	char* pData = _reserve(char(FBinaryLog::DoubleArg), 8);
+	if (pData) {
+		quint64 bits;
+		memcpy(&bits, &value, 8);
+		qToLittleEndian(bits, (uchar*)pData);
+	}
+
+	return *this;
+}
+
+FBinaryLogRecord& FBinaryLogRecord::operator<<(const char* pText)
+{
+	return _addString(pText, pText ? strlen(pText) : 0);
+}
+
+FBinaryLogRecord& FBinaryLogRecord::operator<<(const QString& text)
+{
+	QByteArray data = text.toUtf8();
+	return _addString(data.constData(), size_t(data.size()));
+}
+
+FBinaryLogRecord& FBinaryLogRecord::operator<<(const void* p)
+{
+	char* pData = _reserve(char(FBinaryLog::PointerArg), 8);
+	if (pData)
+		qToLittleEndian(quint64(quintptr(p)), (uchar*)pData);
+
+	return *this;
+}
+
+// Internal functions ----------------------------------------------------------
+
+FBinaryLogRecord& FBinaryLogRecord::_addSigned(qint64 value)
+{
+	char* pData = _reserve(char(FBinaryLog::SignedArg), 8);
+	if (pData)
+		qToLittleEndian(value, (uchar*)pData);
+
+	return *this;
+}
+
+FBinaryLogRecord& FBinaryLogRecord::_addUnsigned(quint64 value)
+{
+	char* pData = _reserve(char(FBinaryLog::UnsignedArg), 8);
+	if (pData)
+		qToLittleEndian(value, (uchar*)pData);
+
+	return *this;
+}
+
+FBinaryLogRecord& FBinaryLogRecord::_addString(const char* pData, size_t size)
+{
+	size_t available = FBinaryLog::ArgsCapacity - m_record.argsSize;
+	if (available < 3) {
+		m_record.isTruncated = 1;
+		return *this;
+	}
+
+	if (size > available - 3) {
+		size = available - 3;
+		m_record.isTruncated = 1;
+	}
+
+	char* pTarget = _reserve(char(FBinaryLog::StringArg), 2 + size);
+	qToLittleEndian(quint16(size), (uchar*)pTarget);
+	memcpy(pTarget + 2, pData, size);
+
+	return *this;
+}
+
+char* FBinaryLogRecord::_reserve(char tag, size_t size)
+{
+	size_t offset = m_record.argsSize;
+	if (offset + 1 + size > FBinaryLog::ArgsCapacity) {
+		m_record.isTruncated = 1;
+		return NULL;
+	}
+
+	m_record.args[offset] = tag;
+	m_record.argsSize = quint8(offset + 1 + size);
+	return m_record.args + offset + 1;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,250 @@
+// -----------------------------------------------------------------------------
+//  File        BinaryLog.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_BINARYLOG_H
+#define FLOWCORE_BINARYLOG_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/LogType.h"
+#include "FlowCore/SingletonT.h"
+#include "FlowCore/MpscQueueT.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <map>
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLog
+// -----------------------------------------------------------------------------
+
+/// Log sink writing messages in a compact binary format, for verbose tracing
+/// with minimal overhead. Messages are not formatted when they are logged:
+/// a message consists of a static format string with placeholders %1, %2...,
+/// the time, the thread and the raw values of the arguments. Messages are
+/// added to a lock-free queue and written to the file by a writer thread.
+/// Each format string is written once per file and referenced by an ID.
+/// The file starts with "FBLG", the format version and the start time in
+/// milliseconds since the epoch, followed by records, see recordKind_t.
+/// All numbers are stored in little endian byte order, timestamps are
+/// nanoseconds since the start time.
+/// FBinaryLogReader and the LogDecoder tool read and format the messages.
+///
+/// Messages are logged with F_BINARY_LOG, only while a log file is open:
+/// @code
+/// FBinaryLog::instance()->open("render.flb");
+/// F_BINARY_LOG(FLogType::Debug, "FRenderer", "Tile %1 done in %2 ms") << tile << time;
+/// @endcode
+class FLOWCORE_EXPORT FBinaryLog : public FSingletonAutoT<FBinaryLog>
+{
+	friend class FSingletonAutoT<FBinaryLog>;
+	friend class FBinaryLogRecord;
+
+	//  Public types -------------------------------------------------
+
+public:
+	/// Version of the file format.
+	static const quint32 FormatVersion = 1;
+	/// Maximum size of the encoded arguments of a message.
+	static const size_t ArgsCapacity = 200;
+
+	/// Kinds of records in the file, each record starts with its kind.
+	enum recordKind_t
+	{
+		/// Format definition: quint32 id, quint8 type, quint32 line,
+		/// strings module, format and source file.
+		FormatRecord = 1,
+		/// Message: quint32 format id, quint64 timestamp, quint64 thread id,
+		/// quint8 truncated flag, quint8 size of the encoded arguments.
+		MessageRecord = 2,
+		/// Dropped messages: quint32 number of messages dropped.
+		DroppedRecord = 3
+	};
+
+	/// Type tags of encoded arguments. Numbers and pointers are stored as
+	/// 8 bytes, strings as quint16 size and UTF-8 data, booleans as one byte.
+	enum argTag_t
+	{
+		BoolArg = 'b',
+		SignedArg = 'i',
+		UnsignedArg = 'u',
+		DoubleArg = 'd',
+		StringArg = 's',
+		PointerArg = 'p'
+	};
+
+	/// A message as it is added to the queue. Module, format and file
+	/// must be string literals, only the pointers are stored.
+	struct record_t
+	{
+		const char* module;
+		const char* format;
+		const char* file;
+		quint32 line;
+		quint8 type;
+		quint8 argsSize;
+		quint8 isTruncated;
+		quint64 timestamp;
+		quint64 threadId;
+		char args[ArgsCapacity];
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+protected:
+	/// Default constructor.
+	FBinaryLog();
+	/// Virtual destructor. Closes the log file.
+	virtual ~FBinaryLog();
+
+	//  Public commands ----------------------------------------------
+
+public:
+	/// Creates the log file with the given name and starts logging.
+	/// Returns false if the file can't be created.
+	bool open(const QString& fileName);
+	/// Writes all queued messages, closes the log file and stops logging.
+	void close();
+	/// Sets the minimum type of messages written to the log. Default is Trace.
+	void setLevel(FLogType level);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns true if messages of the given type are logged.
+	static bool isEnabled(FLogType type) { return int(type) >= s_enabledLevel.load(); }
+
+	/// Returns true if a log file is open.
+	bool isOpen() const { return m_file.isOpen(); }
+	/// Returns the name of the log file.
+	const QString& fileName() const { return m_fileName; }
+	/// Returns the minimum type of messages written to the log.
+	FLogType level() const { return m_level; }
+	/// Returns the number of messages dropped because the queue was full.
+	size_t droppedCount() const { return size_t(m_droppedCount.load()); }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	class writer_t;
+	friend class writer_t;
+
+	static quint64 _timestamp() { return quint64(s_clock.nsecsElapsed()); }
+	void _submit(const record_t& record);
+	void _run();
+	void _writeQueue();
+	void _encode(const record_t& record);
+	quint32 _formatId(const record_t& record);
+
+	//  Internal data members ----------------------------------------
+
+	static const size_t QueueCapacity = 8192;
+	static const int WriteInterval = 20;
+
+	struct formatKey_t
+	{
+		bool operator<(const formatKey_t& other) const;
+
+		const char* module;
+		const char* format;
+		const char* file;
+		quint32 line;
+		quint8 type;
+	};
+
+	typedef std::map<formatKey_t, quint32> formatTable_t;
+
+	static QAtomicInt s_enabledLevel;
+	static QElapsedTimer s_clock;
+
+	FMpscQueueT<record_t> m_queue;
+	QFile m_file;
+	QString m_fileName;
+	FLogType m_level;
+	QByteArray m_buffer;
+	formatTable_t m_formatTable;
+
+	writer_t* m_pWriter;
+	QMutex m_wakeMutex;
+	QWaitCondition m_wakeCondition;
+	bool m_isStopping;
+
+	QAtomicInt m_droppedCount;
+	int m_writtenDropCount;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogRecord
+// -----------------------------------------------------------------------------
+
+/// Collects the arguments of a binary log message, see F_BINARY_LOG.
+/// The message is added to the log when the record is destroyed. Arguments
+/// which don't fit into the record are dropped, long strings are truncated.
+class FLOWCORE_EXPORT FBinaryLogRecord
+{
+	F_DISABLE_COPY(FBinaryLogRecord);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	FBinaryLogRecord(FLogType type, const char* module, const char* format,
+		const char* file, int line);
+	~FBinaryLogRecord();
+
+	//  Public commands ----------------------------------------------
+
+	FBinaryLogRecord& operator<<(bool value);
+	FBinaryLogRecord& operator<<(int value) { return _addSigned(value); }
+	FBinaryLogRecord& operator<<(unsigned int value) { return _addUnsigned(value); }
+	FBinaryLogRecord& operator<<(long value) { return _addSigned(value); }
+	FBinaryLogRecord& operator<<(unsigned long value) { return _addUnsigned(value); }
+	FBinaryLogRecord& operator<<(long long value) { return _addSigned(value); }
+	FBinaryLogRecord& operator<<(unsigned long long value) { return _addUnsigned(value); }
+	FBinaryLogRecord& operator<<(double value);
+	FBinaryLogRecord& operator<<(const char* pText);
+	FBinaryLogRecord& operator<<(const QString& text);
+	/// Logs the address, pointers other than strings would
+	/// otherwise be converted to bool.
+	FBinaryLogRecord& operator<<(const void* p);
+
+	//  Internal functions -------------------------------------------
+
+private:
+	FBinaryLogRecord& _addSigned(qint64 value);
+	FBinaryLogRecord& _addUnsigned(quint64 value);
+	FBinaryLogRecord& _addString(const char* pData, size_t size);
+	char* _reserve(char tag, size_t size);
+
+	//  Internal data members ----------------------------------------
+
+	FBinaryLog::record_t m_record;
+};
+
+// Macros ----------------------------------------------------------------------
+
+/// Minimum type of binary log messages compiled into the program.
+/// By default, all binary log messages are compiled in.
+#ifndef FLOW_BINARY_LOG_MIN_LEVEL
+#  define FLOW_BINARY_LOG_MIN_LEVEL FLogType::Trace
+#endif
+
+/// Starts a binary log message with the given type, module and format, the
+/// arguments are added with operator<<. Module and format must be string
+/// literals. If no binary log is open or the type is below its level, the
+/// arguments are not evaluated.
+#define F_BINARY_LOG(type, module, format) \
+	if (type < FLOW_BINARY_LOG_MIN_LEVEL || !FBinaryLog::isEnabled(type)) { } \
+	else FBinaryLogRecord(type, module, format, __FILE__, __LINE__)
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_BINARYLOG_H
@@ -0,0 +1,319 @@
+// -----------------------------------------------------------------------------
+//  File        BinaryLogReader.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/BinaryLogReader.h"
+#include "FlowCore/BinaryLog.h"
+
+#include <QJsonArray>
+#include <QtEndian>
+
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogEntry
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FBinaryLogEntry::FBinaryLogEntry()
+: m_type(FLogType::Trace),
+  m_line(0),
+  m_timestamp(0),
+  m_threadId(0),
+  m_isTruncated(false)
+{
+}
+
+// Public queries --------------------------------------------------------------
+
+QString FBinaryLogEntry::text() const
+{
+	// replace all placeholders in one pass, text inserted by an argument
+	// is not searched for placeholders again
+	QString result;
+	result.reserve(m_format.size());
+
+	int size = m_format.size();
+	for (int i = 0; i < size; ++i)
+	{
+		QChar c = m_format[i];
+		if (c == QChar('%') && i + 1 < size && m_format[i + 1].isDigit()) {
+			int end = i + 1;
+			int index = 0;
+			while (end < size && end < i + 3 && m_format[end].isDigit())
+				index = index * 10 + m_format[end++].digitValue();
+
+			// placeholders without argument, e.g. of truncated messages, are kept
+			if (index > 0 && index <= m_args.size()) {
+				result += m_args[index - 1].toString();
+				i = end - 1;
+				continue;
+			}
+		}
+
+		result += c;
+	}
+
+	return result;
+}
+
+QString FBinaryLogEntry::toString() const
+{
+	return m_dateTime.toString("dd.MM.yyyy hh:mm:ss.zzz") + " " + m_type.name()
+		+ " [" + QString::number(m_threadId) + "] - " + m_module + " " + text();
+}
+
+QJsonObject FBinaryLogEntry::toJson() const
+{
+	QJsonArray args;
+	for (int i = 0; i < m_args.size(); ++i)
+		args.append(QJsonValue::fromVariant(m_args[i]));
+
+	QJsonObject object;
+	object.insert("time", m_dateTime.toString(Qt::ISODate));
+	object.insert("timestamp", double(m_timestamp));
+	object.insert("type", QString(m_type.name()));
+	object.insert("module", m_module);
+	object.insert("thread", QString::number(m_threadId));
+	object.insert("file", m_file);
+	object.insert("line", m_line);
+	object.insert("format", m_format);
+	object.insert("args", args);
+	object.insert("text", text());
+	object.insert("truncated", m_isTruncated);
+	return object;
+}
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogReader
+// -----------------------------------------------------------------------------
+
+// Helpers ---------------------------------------------------------------------
+
+template <typename T>
+static inline T _fromLittleEndian(const char* pData)
+{
+	return qFromLittleEndian<T>((const uchar*)pData);
+}
+
+// Constructors and destructor -------------------------------------------------
+
+FBinaryLogReader::FBinaryLogReader(QIODevice* pDevice)
+: m_pDevice(pDevice),
+  m_droppedCount(0),
+  m_isValid(false),
+  m_hasError(false)
+{
+	F_ASSERT(pDevice);
+
+	char magic[4];
+	quint32 version;
+	qint64 startTime;
+
+	if (!_read(magic, 4) || memcmp(magic, "FBLG", 4) != 0
+			|| !_read(&version) || version != FBinaryLog::FormatVersion
+			|| !_read(&startTime)) {
+		m_hasError = true;
+		return;
+	}
+
+	m_startTime = QDateTime::fromMSecsSinceEpoch(startTime);
+	m_isValid = true;
+}
+
+// Public commands -------------------------------------------------------------
+
+bool FBinaryLogReader::readNext(FBinaryLogEntry* pEntry)
+{
+	F_ASSERT(pEntry);
+
+	while (m_isValid && !m_hasError) {
+		char kind;
+		if (!_read(&kind, 1))
+			return false; // end of file
+
+		if (kind == char(FBinaryLog::FormatRecord)) {
+			if (!_readFormat())
+				break;
+		}
+		else if (kind == char(FBinaryLog::DroppedRecord)) {
+			quint32 count;
+			if (!_read(&count))
+				break;
+			m_droppedCount += count;
+		}
+		else if (kind == char(FBinaryLog::MessageRecord)) {
+			quint32 id;
+			quint64 timestamp, threadId;
+			quint8 isTruncated, argsSize;
+
+			if (!_read(&id) || !_read(&timestamp) || !_read(&threadId)
+					|| !_read(&isTruncated) || !_read(&argsSize))
+				break;
+
+			QByteArray args(int(argsSize), '\0');
+			if (!_read(args.data(), argsSize))
+				break;
+
+			if (id == 0 || id > m_formats.size())
+				break;
+
+			const format_t& format = m_formats[id - 1];
+			pEntry->m_type = format.type;
+			pEntry->m_module = format.module;
+			pEntry->m_format = format.format;
+			pEntry->m_file = format.file;
+			pEntry->m_line = format.line;
+			pEntry->m_timestamp = timestamp;
+			pEntry->m_dateTime = m_startTime.addMSecs(qint64(timestamp / 1000000));
+			pEntry->m_threadId = threadId;
+			pEntry->m_isTruncated = isTruncated != 0;
+
+			if (!_readArgs(args, pEntry))
+				break;
+
+			return true;
+		}
+		else {
+			break;
+		}
+	}
+
+	m_hasError = true;
+	return false;
+}
+
+// Internal functions ----------------------------------------------------------
+
+bool FBinaryLogReader::_read(void* pData, qint64 size)
+{
+	return size == 0 || m_pDevice->read((char*)pData, size) == size;
+}
+
+template <typename T>
+bool FBinaryLogReader::_read(T* pValue)
+{
+	char data[sizeof(T)];
+	if (!_read(data, qint64(sizeof(T))))
+		return false;
+
+	*pValue = _fromLittleEndian<T>(data);
+	return true;
+}
+
+bool FBinaryLogReader::_readString(QString* pText)
+{
+	quint16 size;
+	if (!_read(&size))
+		return false;
+
+	QByteArray data(int(size), '\0');
+	if (!_read(data.data(), size))
+		return false;
+
+	*pText = QString::fromUtf8(data);
+	return true;
+}
+
+bool FBinaryLogReader::_readFormat()
+{
+	quint32 id, line;
+	quint8 type;
+	format_t format;
+
+	if (!_read(&id) || !_read(&type) || !_read(&line)
+			|| !_readString(&format.module)
+			|| !_readString(&format.format)
+			|| !_readString(&format.file))
+		return false;
+
+	// format IDs are assigned in ascending order, starting at 1
+	if (id != m_formats.size() + 1 || type >= FLogType::All)
+		return false;
+
+	format.type = FLogType::state_t(type);
+	format.line = int(line);
+	m_formats.push_back(format);
+	return true;
+}
+
+bool FBinaryLogReader::_readArgs(const QByteArray& data, FBinaryLogEntry* pEntry)
+{
+	pEntry->m_args.clear();
+
+	const char* pData = data.constData();
+	int size = data.size();
+	int offset = 0;
+
+	while (offset < size) {
+		char tag = pData[offset++];
+		const char* pValue = pData + offset;
+		int available = size - offset;
+
+		switch (tag) {
+		case FBinaryLog::BoolArg:
+			if (available < 1)
+				return false;
+			pEntry->m_args.append(QVariant(*pValue != 0));
+			offset += 1;
+			break;
+
+		case FBinaryLog::SignedArg:
+			if (available < 8)
+				return false;
+			pEntry->m_args.append(QVariant(_fromLittleEndian<qint64>(pValue)));
+			offset += 8;
+			break;
+
+		case FBinaryLog::UnsignedArg:
+			if (available < 8)
+				return false;
+			pEntry->m_args.append(QVariant(_fromLittleEndian<quint64>(pValue)));
+			offset += 8;
+			break;
+
+		case FBinaryLog::DoubleArg: {
+			if (available < 8)
+				return false;
+			quint64 bits = _fromLittleEndian<quint64>(pValue);
+			double value;
+			memcpy(&value, &bits, 8);
+			pEntry->m_args.append(QVariant(value));
+			offset += 8;
+			break;
+		}
+
+		case FBinaryLog::PointerArg:
+			if (available < 8)
+				return false;
+			pEntry->m_args.append(QVariant(QString("0x%1").arg(
+				_fromLittleEndian<quint64>(pValue), 16, 16, QChar('0'))));
+			offset += 8;
+			break;
+
+		case FBinaryLog::StringArg: {
+			if (available < 2)
+				return false;
+			int length = int(_fromLittleEndian<quint16>(pValue));
+			if (available < 2 + length)
+				return false;
+			pEntry->m_args.append(QVariant(QString::fromUtf8(pValue + 2, length)));
+			offset += 2 + length;
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,155 @@
+// -----------------------------------------------------------------------------
+//  File        BinaryLogReader.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_BINARYLOGREADER_H
+#define FLOWCORE_BINARYLOGREADER_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/LogType.h"
+
+#include <QString>
+#include <QDateTime>
+#include <QVariant>
+#include <QJsonObject>
+#include <QIODevice>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogEntry
+// -----------------------------------------------------------------------------
+
+/// A message read from a binary log file, see FBinaryLogReader.
+class FLOWCORE_EXPORT FBinaryLogEntry
+{
+	friend class FBinaryLogReader;
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Default constructor.
+	FBinaryLogEntry();
+
+	//  Public queries -----------------------------------------------
+
+	FLogType type() const { return m_type; }
+	const QString& module() const { return m_module; }
+	/// Returns the format string with placeholders %1, %2...
+	const QString& format() const { return m_format; }
+	/// Returns the name of the source file which logged the message.
+	const QString& file() const { return m_file; }
+	/// Returns the line in the source file which logged the message.
+	int line() const { return m_line; }
+	/// Returns the nanoseconds since the start of the log.
+	quint64 timestamp() const { return m_timestamp; }
+	/// Returns the date and time the message was logged.
+	const QDateTime& dateTime() const { return m_dateTime; }
+	/// Returns the ID of the thread which logged the message.
+	quint64 threadId() const { return m_threadId; }
+	/// Returns the argument values.
+	const QVariantList& args() const { return m_args; }
+	/// Returns true if arguments were truncated or dropped
+	/// because they didn't fit into a log record.
+	bool isTruncated() const { return m_isTruncated; }
+
+	/// Returns the text of the message, the format string with its
+	/// placeholders replaced by the arguments.
+	QString text() const;
+	/// Returns date, time, type, thread, module and text of the message.
+	QString toString() const;
+	/// Returns all properties of the message as JSON object.
+	QJsonObject toJson() const;
+
+	//  Internal data members ----------------------------------------
+
+private:
+	FLogType m_type;
+	QString m_module;
+	QString m_format;
+	QString m_file;
+	int m_line;
+	quint64 m_timestamp;
+	QDateTime m_dateTime;
+	quint64 m_threadId;
+	QVariantList m_args;
+	bool m_isTruncated;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FBinaryLogReader
+// -----------------------------------------------------------------------------
+
+/// Reads the messages from a file written by FBinaryLog.
+/// @code
+/// QFile file("render.flb");
+/// file.open(QIODevice::ReadOnly);
+/// FBinaryLogReader reader(&file);
+/// FBinaryLogEntry entry;
+/// while (reader.readNext(&entry))
+///     F_PRINT << entry.toString();
+/// @endcode
+class FLOWCORE_EXPORT FBinaryLogReader
+{
+	F_DISABLE_COPY(FBinaryLogReader);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates a reader for the given device and reads the file header.
+	FBinaryLogReader(QIODevice* pDevice);
+
+	//  Public commands ----------------------------------------------
+
+	/// Reads the next message. Returns false at the end of the file or
+	/// if the file is invalid.
+	bool readNext(FBinaryLogEntry* pEntry);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns true if the file header is valid.
+	bool isValid() const { return m_isValid; }
+	/// Returns true if invalid data was encountered while reading.
+	bool hasError() const { return m_hasError; }
+	/// Returns the date and time the log was started.
+	const QDateTime& startTime() const { return m_startTime; }
+	/// Returns the number of messages the log dropped, up to the
+	/// current position in the file.
+	size_t droppedCount() const { return m_droppedCount; }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	bool _read(void* pData, qint64 size);
+	template <typename T>
+	bool _read(T* pValue);
+	bool _readString(QString* pText);
+	bool _readFormat();
+	bool _readArgs(const QByteArray& data, FBinaryLogEntry* pEntry);
+
+	//  Internal data members ----------------------------------------
+
+	struct format_t
+	{
+		FLogType type;
+		int line;
+		QString module;
+		QString format;
+		QString file;
+	};
+
+	QIODevice* m_pDevice;
+	QDateTime m_startTime;
+	std::vector<format_t> m_formats;
+	size_t m_droppedCount;
+	bool m_isValid;
+	bool m_hasError;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_BINARYLOGREADER_H
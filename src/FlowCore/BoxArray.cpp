@@ -0,0 +1,110 @@
+// -----------------------------------------------------------------------------
+//  File        BoxArray.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/20 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/BoxArray.h"
+#include "FlowCore/Frustum.h"
+#include "FlowCore/SimdKernels.h"
+
+#include <algorithm>
+
+// -----------------------------------------------------------------------------
+//  Class FBoxArray
+// -----------------------------------------------------------------------------
+
+// Public commands -------------------------------------------------------------
+
+void FBoxArray::append(const FRange3f& box)
+{
+	m_components[MinX].push_back(box.lowerBound().x);
+	m_components[MinY].push_back(box.lowerBound().y);
+	m_components[MinZ].push_back(box.lowerBound().z);
+	m_components[MaxX].push_back(box.upperBound().x);
+	m_components[MaxY].push_back(box.upperBound().y);
+	m_components[MaxZ].push_back(box.upperBound().z);
+}
+
+void FBoxArray::set(size_t index, const FRange3f& box)
+{
+	F_ASSERT(index < size());
+
+	m_components[MinX][index] = box.lowerBound().x;
+	m_components[MinY][index] = box.lowerBound().y;
+	m_components[MinZ][index] = box.lowerBound().z;
+	m_components[MaxX][index] = box.upperBound().x;
+	m_components[MaxY][index] = box.upperBound().y;
+	m_components[MaxZ][index] = box.upperBound().z;
+}
+
+void FBoxArray::resize(size_t size)
+{
+	for (size_t i = 0; i < 6; ++i)
+		m_components[i].resize(size);
+}
+
+void FBoxArray::reserve(size_t size)
+{
+	for (size_t i = 0; i < 6; ++i)
+		m_components[i].reserve(size);
+}
+
+void FBoxArray::clear()
+{
+	for (size_t i = 0; i < 6; ++i)
+		m_components[i].clear();
+}
+
+// Public queries --------------------------------------------------------------
+
+FRange3f FBoxArray::box(size_t index) const
+{
+	F_ASSERT(index < size());
+
+	return FRange3f(
+		m_components[MinX][index], m_components[MinY][index], m_components[MinZ][index],
+		m_components[MaxX][index], m_components[MaxY][index], m_components[MaxZ][index]);
+}
+
+FRange3f FBoxArray::bounds() const
+{
+	FRange3f result;
+	result.invalidate();
+
+	if (isEmpty())
+		return result;
+
+	result.set(
+		*std::min_element(m_components[MinX].begin(), m_components[MinX].end()),
+		*std::min_element(m_components[MinY].begin(), m_components[MinY].end()),
+		*std::min_element(m_components[MinZ].begin(), m_components[MinZ].end()),
+		*std::max_element(m_components[MaxX].begin(), m_components[MaxX].end()),
+		*std::max_element(m_components[MaxY].begin(), m_components[MaxY].end()),
+		*std::max_element(m_components[MaxZ].begin(), m_components[MaxZ].end()));
+
+	return result;
+}
+
+size_t FBoxArray::cull(const FFrustum& frustum, uint32_t* pVisible) const
+{
+	if (isEmpty())
+		return 0;
+
+	const float* pBox[6] = {
+		data(MinX), data(MinY), data(MinZ), data(MaxX), data(MaxY), data(MaxZ)
+	};
+
+	return FSimdKernels::current().cullBoxes(pBox, frustum.planes(), size(), pVisible);
+}
+
+void FBoxArray::cull(const FFrustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.resize(size());
+	visible.resize(visible.empty() ? 0 : cull(frustum, &visible[0]));
+}
+
+// -----------------------------------------------------------------------------
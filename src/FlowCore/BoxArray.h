@@ -0,0 +1,91 @@
+// -----------------------------------------------------------------------------
+//  File        BoxArray.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/20 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_BOXARRAY_H
+#define FLOWCORE_BOXARRAY_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Range3T.h"
+
+#include <vector>
+
+class FFrustum;
+
+// -----------------------------------------------------------------------------
+//  Class FBoxArray
+// -----------------------------------------------------------------------------
+
+/// Array of axis aligned boxes, stored as six separate component arrays
+/// (SoA layout). Boxes can be culled against a view frustum in batches
+/// of 4, 8 or 16 depending on the SIMD tier selected by FCpu.
+class FLOWCORE_EXPORT FBoxArray
+{
+	//  Public types -------------------------------------------------
+
+public:
+	enum Component
+	{
+		MinX = 0,
+		MinY,
+		MinZ,
+		MaxX,
+		MaxY,
+		MaxZ
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+	FBoxArray() { }
+	explicit FBoxArray(size_t size) { resize(size); }
+
+	//  Public commands ----------------------------------------------
+
+public:
+	/// Appends a box to the end of the array.
+	void append(const FRange3f& box);
+	/// Replaces the box at the given index.
+	void set(size_t index, const FRange3f& box);
+
+	void resize(size_t size);
+	void reserve(size_t size);
+	void clear();
+
+	/// Returns a pointer to the given component array, e.g. for filling
+	/// the boxes directly in SoA layout.
+	float* data(Component component) { return m_components[component].empty() ? NULL : &m_components[component][0]; }
+
+	//  Public queries -----------------------------------------------
+
+	size_t size() const { return m_components[MinX].size(); }
+	bool isEmpty() const { return m_components[MinX].empty(); }
+
+	/// Returns the box at the given index.
+	FRange3f box(size_t index) const;
+	/// Returns the bounding box of all boxes in the array.
+	FRange3f bounds() const;
+
+	const float* data(Component component) const { return m_components[component].empty() ? NULL : &m_components[component][0]; }
+
+	/// Tests all boxes against the given frustum and writes the indices of
+	/// the boxes which are at least partially inside to pVisible, in ascending
+	/// order. pVisible must provide space for size() indices. Returns the
+	/// number of visible boxes.
+	size_t cull(const FFrustum& frustum, uint32_t* pVisible) const;
+	/// Same as above, stores the indices of the visible boxes in the given vector.
+	void cull(const FFrustum& frustum, std::vector<uint32_t>& visible) const;
+
+	//  Internal data members ----------------------------------------
+
+private:
+	std::vector<float> m_components[6];
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_BOXARRAY_H
@@ -0,0 +1,528 @@
+// -----------------------------------------------------------------------------
+//  File        CompressedDevice.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/27 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/CompressedDevice.h"
+#include "FlowCore/LzCodec.h"
+#include "FlowCore/Log.h"
+
+#include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+// Helpers ---------------------------------------------------------------------
+
+// Layout of the compressed data, all values in big endian byte order:
+// header     "FBLK", quint16 version, quint32 block size
+// blocks     quint8 method, quint32 raw size, quint32 stored size, data
+// end        a block header with raw size 0
+// index      quint64 file offset, quint32 raw size, quint32 stored size per block
+// trailer    quint64 index offset, quint32 block count, "FBLI"
+
+static const char _fileMagic[] = "FBLK";
+static const char _indexMagic[] = "FBLI";
+static const quint16 _version = 1;
+
+static const qint64 _headerSize = 10;
+static const qint64 _blockHeaderSize = 9;
+static const qint64 _indexEntrySize = 16;
+static const qint64 _trailerSize = 16;
+static const size_t _maxBlockSize = size_t(1) << 30;
+
+static inline quint32 _fMagic(const char* pMagic)
+{
+	return (quint32(uint8_t(pMagic[0])) << 24) | (quint32(uint8_t(pMagic[1])) << 16)
+		| (quint32(uint8_t(pMagic[2])) << 8) | quint32(uint8_t(pMagic[3]));
+}
+
+// -----------------------------------------------------------------------------
+//  Class FCompressedDevice
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FCompressedDevice::FCompressedDevice(QIODevice* pDevice, QObject* pParent /* = NULL */)
+: QIODevice(pParent),
+  m_pDevice(pDevice),
+  m_deviceStart(0),
+  m_compression(FastCompression),
+  m_blockSize(1 << 20)
+{
+	F_ASSERT(pDevice);
+	_reset();
+}
+
+FCompressedDevice::~FCompressedDevice()
+{
+	close();
+}
+
+// Public commands -------------------------------------------------------------
+
+void FCompressedDevice::setBlockSize(size_t blockSize)
+{
+	F_ASSERT(!isOpen());
+	F_ASSERT(blockSize > 0 && blockSize <= _maxBlockSize);
+	m_blockSize = blockSize;
+}
+
+bool FCompressedDevice::open(OpenMode mode)
+{
+	F_ASSERT(!isOpen());
+
+	if ((mode & ReadWrite) == ReadWrite || !(mode & ReadWrite)) {
+		setErrorString("FCompressedDevice supports either read or write mode");
+		return false;
+	}
+
+	if (!m_pDevice->isOpen()) {
+		setErrorString("Underlying device is not open");
+		return false;
+	}
+
+	_reset();
+	m_deviceStart = m_pDevice->isSequential() ? 0 : m_pDevice->pos();
+
+	if (mode & WriteOnly)
+	{
+		QDataStream stream(m_pDevice);
+		stream << _fMagic(_fileMagic) << _version << quint32(m_blockSize);
+		m_storedSize = _headerSize;
+		m_block.reserve(int(m_blockSize));
+	}
+	else
+	{
+		// pass through data not written by a compressed device
+		QByteArray magic = m_pDevice->peek(4);
+		m_isPassThrough = magic.size() < 4 || memcmp(magic.constData(), _fileMagic, 4) != 0;
+
+		if (!m_isPassThrough && !_readHeader())
+			return false;
+	}
+
+	// data is buffered in blocks already
+	return QIODevice::open(mode | Unbuffered);
+}
+
+void FCompressedDevice::close()
+{
+	if (!isOpen())
+		return;
+
+	if (isWritable()) {
+		_writeBlock();
+		_writeIndex();
+	}
+
+	_reset();
+	QIODevice::close();
+}
+
+bool FCompressedDevice::seek(qint64 pos)
+{
+	if (m_isPassThrough) {
+		return m_pDevice->seek(m_deviceStart + pos) && QIODevice::seek(pos);
+	}
+
+	if (isSequential() || pos < 0 || quint64(pos) > m_rawSize)
+		return false;
+
+	// find the block containing the position
+	size_t index = m_blocks.size();
+	if (quint64(pos) < m_rawSize) {
+		index = 0;
+		for (size_t lo = 0, hi = m_blocks.size(); lo < hi; ) {
+			size_t mid = (lo + hi) / 2;
+			if (m_blocks[mid].rawOffset <= quint64(pos)) {
+				index = mid;
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+	}
+
+	if (index == m_blocks.size()) {
+		// end of data
+		m_block.clear();
+		m_blockIndex = index - 1;
+		m_blockPos = 0;
+	}
+	else {
+		// the block is empty after seeking to the end or a failed load
+		if ((index != m_blockIndex || m_block.isEmpty()) && !_loadBlock(index))
+			return false;
+
+		m_blockPos = int(pos - m_blocks[index].rawOffset);
+	}
+
+	return QIODevice::seek(pos);
+}
+
+// Public queries --------------------------------------------------------------
+
+qint64 FCompressedDevice::pos() const
+{
+	// the write position is not tracked for sequential devices
+	if (isWritable())
+		return qint64(m_rawSize) + m_block.size();
+
+	return QIODevice::pos();
+}
+
+qint64 FCompressedDevice::size() const
+{
+	if (m_isPassThrough)
+		return m_pDevice->size() - m_deviceStart;
+
+	if (isWritable())
+		return qint64(m_rawSize) + m_block.size();
+
+	return m_hasIndex ? qint64(m_rawSize) : 0;
+}
+
+bool FCompressedDevice::atEnd() const
+{
+	if (!isReadable())
+		return true;
+
+	if (m_isPassThrough)
+		return m_pDevice->atEnd();
+
+	if (m_blockPos < m_block.size())
+		return false;
+
+	return m_hasIndex ? m_blockIndex + 1 >= m_blocks.size() : m_nextHeader.rawSize == 0;
+}
+
+bool FCompressedDevice::isSequential() const
+{
+	if (m_isPassThrough)
+		return m_pDevice->isSequential();
+
+	return !isReadable() || !m_hasIndex;
+}
+
+qint64 FCompressedDevice::bytesAvailable() const
+{
+	if (m_isPassThrough)
+		return m_pDevice->bytesAvailable();
+
+	if (m_hasIndex)
+		return size() - pos();
+
+	return m_block.size() - m_blockPos + QIODevice::bytesAvailable();
+}
+
+// Protected functions ---------------------------------------------------------
+
+qint64 FCompressedDevice::readData(char* pData, qint64 maxSize)
+{
+	if (m_isPassThrough)
+		return m_pDevice->read(pData, maxSize);
+
+	qint64 total = 0;
+	while (total < maxSize)
+	{
+		if (m_blockPos >= m_block.size()) {
+			if (atEnd() || !_loadNextBlock())
+				break;
+			continue;
+		}
+
+		int n = int(fMin(qint64(m_block.size() - m_blockPos), maxSize - total));
+		memcpy(pData + total, m_block.constData() + m_blockPos, n);
+		m_blockPos += n;
+		total += n;
+	}
+
+	return total;
+}
+
+qint64 FCompressedDevice::writeData(const char* pData, qint64 size)
+{
+	qint64 remaining = size;
+	while (remaining > 0)
+	{
+		int n = int(fMin(qint64(m_blockSize) - m_block.size(), remaining));
+		m_block.append(pData, n);
+		pData += n;
+		remaining -= n;
+
+		if (size_t(m_block.size()) >= m_blockSize && !_writeBlock())
+			return -1;
+	}
+
+	return size;
+}
+
+// Internal functions ----------------------------------------------------------
+
+bool FCompressedDevice::_readHeader()
+{
+	quint32 fileMagic, blockSize;
+	quint16 version;
+	QDataStream stream(m_pDevice);
+	stream >> fileMagic >> version >> blockSize;
+
+	if (version > _version) {
+		setErrorString("Unsupported version of compressed data");
+		return false;
+	}
+
+	if (blockSize == 0 || blockSize > _maxBlockSize) {
+		setErrorString("Invalid block size of compressed data");
+		return false;
+	}
+
+	m_blockSize = blockSize;
+	m_hasIndex = !m_pDevice->isSequential() && _readIndex();
+
+	if (!m_hasIndex)
+		_readBlockHeader(&m_nextHeader);
+
+	return true;
+}
+
+bool FCompressedDevice::_readIndex()
+{
+	qint64 end = m_pDevice->size();
+	if (end - m_deviceStart < _headerSize + _blockHeaderSize + _trailerSize)
+		return false;
+
+	QDataStream stream(m_pDevice);
+
+	quint64 indexOffset;
+	quint32 blockCount, indexMagic;
+	m_pDevice->seek(end - _trailerSize);
+	stream >> indexOffset >> blockCount >> indexMagic;
+
+	bool isValid = indexMagic == _fMagic(_indexMagic)
+		&& indexOffset + quint64(blockCount) * _indexEntrySize + _trailerSize
+			== quint64(end - m_deviceStart);
+
+	if (isValid)
+	{
+		m_blocks.resize(blockCount);
+		m_pDevice->seek(m_deviceStart + qint64(indexOffset));
+
+		quint64 rawOffset = 0;
+		for (size_t i = 0; i < m_blocks.size(); ++i) {
+			blockInfo_t& block = m_blocks[i];
+			stream >> block.fileOffset >> block.rawSize >> block.storedSize;
+			block.rawOffset = rawOffset;
+			rawOffset += block.rawSize;
+		}
+
+		m_rawSize = rawOffset;
+		isValid = stream.status() == QDataStream::Ok;
+	}
+
+	if (!isValid)
+		m_blocks.clear();
+
+	// continue with the first block
+	m_pDevice->seek(m_deviceStart + _headerSize);
+	return isValid;
+}
+
+bool FCompressedDevice::_readBlockHeader(blockHeader_t* pHeader)
+{
+	QDataStream stream(m_pDevice);
+	stream >> pHeader->method >> pHeader->rawSize >> pHeader->storedSize;
+
+	if (stream.status() != QDataStream::Ok) {
+		F_WARNING("FCompressedDevice") << "unexpected end of data";
+		pHeader->rawSize = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool FCompressedDevice::_readBlock(const blockHeader_t& header)
+{
+	m_block.clear();
+	m_blockPos = 0;
+
+	// stored data is never larger than the raw data, and raw data never
+	// larger than a block, check before allocating memory for either
+	if (header.rawSize > m_blockSize || header.storedSize > header.rawSize) {
+		F_WARNING("FCompressedDevice") << "invalid block size";
+		setErrorString("Corrupt block header");
+		return false;
+	}
+
+	m_packed = m_pDevice->read(header.storedSize);
+	if (quint32(m_packed.size()) != header.storedSize) {
+		F_WARNING("FCompressedDevice") << "unexpected end of data";
+		return false;
+	}
+
+	bool isValid = false;
+
+	switch(header.method)
+	{
+	case NoCompression:
+		m_block = m_packed;
+		isValid = header.storedSize == header.rawSize;
+		break;
+
+	case FastCompression:
+		m_block.resize(int(header.rawSize));
+		isValid = FLzCodec::decompress(m_packed.constData(), m_packed.size(),
+			m_block.data(), m_block.size());
+		break;
+
+	case HighCompression:
+		// qUncompress allocates the size stored in the first four bytes
+		if (m_packed.size() >= 4 && qFromBigEndian<quint32>(
+				reinterpret_cast<const uchar*>(m_packed.constData())) == header.rawSize) {
+			m_block = qUncompress(m_packed);
+			isValid = quint32(m_block.size()) == header.rawSize;
+		}
+		break;
+	}
+
+	if (!isValid) {
+		F_WARNING("FCompressedDevice") << "corrupt block data";
+		setErrorString("Corrupt block data");
+		m_block.clear();
+	}
+
+	return isValid;
+}
+
+bool FCompressedDevice::_loadBlock(size_t index)
+{
+	F_ASSERT(m_hasIndex && index < m_blocks.size());
+
+	const blockInfo_t& block = m_blocks[index];
+	m_pDevice->seek(m_deviceStart + qint64(block.fileOffset));
+
+	blockHeader_t header;
+	if (!_readBlockHeader(&header) || header.rawSize != block.rawSize
+			|| header.storedSize != block.storedSize) {
+		setErrorString("Block index doesn't match data");
+		return false;
+	}
+
+	m_blockIndex = index;
+	return _readBlock(header);
+}
+
+bool FCompressedDevice::_loadNextBlock()
+{
+	if (m_hasIndex)
+		return _loadBlock(m_blockIndex + 1);
+
+	// without index, the header of the next block has been read already
+	blockHeader_t header = m_nextHeader;
+	++m_blockIndex;
+
+	if (!_readBlock(header)) {
+		m_nextHeader.rawSize = 0;
+		return false;
+	}
+
+	_readBlockHeader(&m_nextHeader);
+	return true;
+}
+
+bool FCompressedDevice::_writeBlock()
+{
+	if (m_block.isEmpty())
+		return true;
+
+	blockHeader_t header;
+	header.method = quint8(m_compression);
+	header.rawSize = quint32(m_block.size());
+	header.storedSize = header.rawSize;
+
+	const char* pStored = m_block.constData();
+
+	if (m_compression == FastCompression)
+	{
+		// compressed data must be smaller than the raw data
+		m_packed.resize(m_block.size());
+		header.storedSize = quint32(FLzCodec::compress(m_block.constData(),
+			m_block.size(), m_packed.data(), m_packed.size() - 1));
+		pStored = m_packed.constData();
+	}
+	else if (m_compression == HighCompression)
+	{
+		m_packed = qCompress(reinterpret_cast<const uchar*>(m_block.constData()), m_block.size());
+		header.storedSize = quint32(m_packed.size());
+		pStored = m_packed.constData();
+	}
+
+	if (header.storedSize == 0 || header.storedSize >= header.rawSize) {
+		// incompressible, store raw data
+		header.method = NoCompression;
+		header.storedSize = header.rawSize;
+		pStored = m_block.constData();
+	}
+
+	blockInfo_t block;
+	block.fileOffset = m_storedSize;
+	block.rawOffset = m_rawSize;
+	block.rawSize = header.rawSize;
+	block.storedSize = header.storedSize;
+	m_blocks.push_back(block);
+
+	QDataStream stream(m_pDevice);
+	stream << header.method << header.rawSize << header.storedSize;
+	qint64 written = m_pDevice->write(pStored, header.storedSize);
+
+	m_storedSize += _blockHeaderSize + header.storedSize;
+	m_rawSize += header.rawSize;
+	m_block.resize(0);
+
+	if (written != qint64(header.storedSize)) {
+		setErrorString(m_pDevice->errorString());
+		return false;
+	}
+
+	return true;
+}
+
+void FCompressedDevice::_writeIndex()
+{
+	QDataStream stream(m_pDevice);
+
+	// end marker for sequential reading
+	stream << quint8(NoCompression) << quint32(0) << quint32(0);
+	quint64 indexOffset = m_storedSize + _blockHeaderSize;
+
+	for (size_t i = 0; i < m_blocks.size(); ++i) {
+		const blockInfo_t& block = m_blocks[i];
+		stream << block.fileOffset << block.rawSize << block.storedSize;
+	}
+
+	stream << indexOffset << quint32(m_blocks.size()) << _fMagic(_indexMagic);
+}
+
+void FCompressedDevice::_reset()
+{
+	m_blocks.clear();
+	m_block.clear();
+	m_packed.clear();
+	m_nextHeader.method = NoCompression;
+	m_nextHeader.rawSize = 0;
+	m_nextHeader.storedSize = 0;
+	m_blockIndex = size_t(-1);
+	m_blockPos = 0;
+	m_rawSize = 0;
+	m_storedSize = 0;
+	m_hasIndex = false;
+	m_isPassThrough = false;
+}
+
+// -----------------------------------------------------------------------------
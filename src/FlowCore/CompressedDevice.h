@@ -0,0 +1,160 @@
+// -----------------------------------------------------------------------------
+//  File        CompressedDevice.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/27 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_COMPRESSEDDEVICE_H
+#define FLOWCORE_COMPRESSEDDEVICE_H
+
+#include "FlowCore/Library.h"
+
+#include <QIODevice>
+#include <QByteArray>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Class FCompressedDevice
+// -----------------------------------------------------------------------------
+
+/// I/O device adding buffering and block compression to another device.
+/// Data written to the device is collected into large blocks, each block
+/// is compressed separately and written to the underlying device. Closing
+/// the device writes an index of all blocks, which allows to seek in the
+/// uncompressed data when reading from a random access device.
+///
+/// When reading, blocks are decompressed on demand. Data not written by a
+/// compressed device is passed through unchanged, i.e. an archive can read
+/// compressed and uncompressed files alike:
+/// @code
+/// QFile file("scene.far");
+/// file.open(QIODevice::ReadOnly);
+/// FCompressedDevice device(&file);
+/// device.open(QIODevice::ReadOnly);
+/// FArchive archive(&device);
+/// @endcode
+class FLOWCORE_EXPORT FCompressedDevice : public QIODevice
+{
+	//  Public types -------------------------------------------------
+
+public:
+	enum Compression
+	{
+		/// Blocks are stored without compression.
+		NoCompression = 0,
+		/// Fast LZ compression, see FLzCodec.
+		FastCompression,
+		/// Slower zlib compression with a higher compression ratio.
+		HighCompression
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+	/// Creates a device reading from or writing to the given device. The
+	/// device must be opened before this device is opened, in the same mode.
+	FCompressedDevice(QIODevice* pDevice, QObject* pParent = NULL);
+	/// Destructor. Closes the device.
+	virtual ~FCompressedDevice();
+
+	//  Public commands ----------------------------------------------
+
+	/// Sets the compression method used for writing. Default is fast compression.
+	void setCompression(Compression compression) { m_compression = compression; }
+	/// Sets the size of the uncompressed blocks. Default is 1 MB.
+	/// Must be set before the device is opened for writing.
+	void setBlockSize(size_t blockSize);
+
+	/// Opens the device in read only or write only mode. In read mode,
+	/// the header and, if the underlying device is random access, the
+	/// block index are read.
+	virtual bool open(OpenMode mode);
+	/// Closes the device. In write mode, the last block and the block
+	/// index are written. The underlying device is left open.
+	virtual void close();
+
+	/// Seeks to the given position in the uncompressed data.
+	virtual bool seek(qint64 pos);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the compression method used for writing.
+	Compression compression() const { return m_compression; }
+	/// Returns the size of the uncompressed blocks.
+	size_t blockSize() const { return m_blockSize; }
+	/// Returns true if reading data that is not block compressed.
+	bool isPassThrough() const { return m_isPassThrough; }
+
+	/// Returns the position in the uncompressed data.
+	virtual qint64 pos() const;
+	/// Returns the size of the uncompressed data. When reading from a
+	/// sequential device, the size is not known and 0 is returned.
+	virtual qint64 size() const;
+	/// Returns true if no more data can be read.
+	virtual bool atEnd() const;
+	/// Returns true if the device doesn't support seeking.
+	virtual bool isSequential() const;
+	/// Returns the number of bytes that can be read without blocking.
+	virtual qint64 bytesAvailable() const;
+
+	//  Protected functions ------------------------------------------
+
+protected:
+	virtual qint64 readData(char* pData, qint64 maxSize);
+	virtual qint64 writeData(const char* pData, qint64 size);
+
+	//  Internal types -----------------------------------------------
+
+private:
+	struct blockHeader_t
+	{
+		quint8 method;
+		quint32 rawSize;
+		quint32 storedSize;
+	};
+
+	struct blockInfo_t
+	{
+		quint64 fileOffset;
+		quint64 rawOffset;
+		quint32 rawSize;
+		quint32 storedSize;
+	};
+
+	//  Internal functions -------------------------------------------
+
+	bool _readHeader();
+	bool _readIndex();
+	bool _readBlockHeader(blockHeader_t* pHeader);
+	bool _readBlock(const blockHeader_t& header);
+	bool _loadBlock(size_t index);
+	bool _loadNextBlock();
+	bool _writeBlock();
+	void _writeIndex();
+	void _reset();
+
+	//  Internal data members ----------------------------------------
+
+	QIODevice* m_pDevice;
+	qint64 m_deviceStart;
+	Compression m_compression;
+	size_t m_blockSize;
+
+	std::vector<blockInfo_t> m_blocks;
+	blockHeader_t m_nextHeader;
+	QByteArray m_block;
+	QByteArray m_packed;
+	size_t m_blockIndex;
+	int m_blockPos;
+	quint64 m_rawSize;
+	quint64 m_storedSize;
+
+	bool m_hasIndex;
+	bool m_isPassThrough;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_COMPRESSEDDEVICE_H
@@ -0,0 +1,184 @@
+// -----------------------------------------------------------------------------
+//  File        Cpu.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/Cpu.h"
+#include "FlowCore/Log.h"
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QAtomicInt>
+
+#if (FLOW_COMPILER & FLOW_COMPILER_VC)
+#  include <intrin.h>
+#  include <immintrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#  include <cpuid.h>
+#endif
+
+// -----------------------------------------------------------------------------
+//  Processor queries
+// -----------------------------------------------------------------------------
+
+/// Executes cpuid for the given leaf and sub-leaf. Registers are returned
+/// in the order eax, ebx, ecx, edx.
+static inline void _fCpuId(unsigned int leaf, unsigned int subLeaf, unsigned int* r)
+{
+#if (FLOW_COMPILER & FLOW_COMPILER_VC)
+	int regs[4];
+	__cpuidex(regs, (int)leaf, (int)subLeaf);
+	r[0] = regs[0]; r[1] = regs[1]; r[2] = regs[2]; r[3] = regs[3];
+#elif defined(__i386__) || defined(__x86_64__)
+	__cpuid_count(leaf, subLeaf, r[0], r[1], r[2], r[3]);
+#else
+	r[0] = r[1] = r[2] = r[3] = 0;
+#endif
+}
+
+/// Returns the extended control register XCR0, which tells which register
+/// states the operating system saves on context switches.
+static inline quint64 _fXcr0()
+{
+#if (FLOW_COMPILER & FLOW_COMPILER_VC)
+	return _xgetbv(0);
+#elif defined(__i386__) || defined(__x86_64__)
+	unsigned int eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((quint64)edx << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
+static FCpu::SimdTier _fDetectTier()
+{
+	unsigned int r[4];
+	_fCpuId(0, 0, r);
+	unsigned int maxLeaf = r[0];
+
+	if (maxLeaf < 7)
+		return FCpu::SSE4;
+
+	_fCpuId(1, 0, r);
+	bool osxsave = (r[2] & (1u << 27)) != 0;
+	bool avx = (r[2] & (1u << 28)) != 0;
+	bool fma = (r[2] & (1u << 12)) != 0;
+
+	if (!osxsave || !avx || !fma)
+		return FCpu::SSE4;
+
+	// XMM and YMM state (bits 1, 2), opmask and ZMM state (bits 5 - 7)
+	quint64 xcr0 = _fXcr0();
+	if ((xcr0 & 0x06) != 0x06)
+		return FCpu::SSE4;
+
+	_fCpuId(7, 0, r);
+	bool avx2 = (r[1] & (1u << 5)) != 0;
+	bool avx512f = (r[1] & (1u << 16)) != 0;
+
+	if (!avx2)
+		return FCpu::SSE4;
+	if (avx512f && (xcr0 & 0xe6) == 0xe6)
+		return FCpu::AVX512;
+
+	return FCpu::AVX2;
+}
+
+static FCpu::SimdTier _fInitialTier()
+{
+	FCpu::SimdTier supported = FCpu::supportedTier();
+	QByteArray name = qgetenv("FLOW_SIMD_TIER");
+
+	if (name.isEmpty())
+		return supported;
+
+	FCpu::SimdTier requested;
+	if (!FCpu::parseTier(name.constData(), &requested)) {
+		F_WARNING("FCpu") << "unknown FLOW_SIMD_TIER '" << name.constData()
+			<< "', using " << FCpu::tierName(supported);
+		return supported;
+	}
+
+	if (requested > supported) {
+		F_WARNING("FCpu") << "FLOW_SIMD_TIER " << FCpu::tierName(requested)
+			<< " not supported, using " << FCpu::tierName(supported);
+		return supported;
+	}
+
+	return requested;
+}
+
+// tiers are stored incremented by one, zero means not determined yet; plain
+// atomics without constructors are zero-initialized before static constructors
+static QBasicAtomicInt s_supportedTier;
+static QBasicAtomicInt s_currentTier;
+
+// -----------------------------------------------------------------------------
+//  Class FCpu
+// -----------------------------------------------------------------------------
+
+// Static members --------------------------------------------------------------
+
+FCpu::SimdTier FCpu::supportedTier()
+{
+	int tier = s_supportedTier.load();
+	if (!tier) {
+		// threads detecting the tier at the same time store the same value
+		tier = int(_fDetectTier()) + 1;
+		s_supportedTier.store(tier);
+	}
+
+	return SimdTier(tier - 1);
+}
+
+FCpu::SimdTier FCpu::simdTier()
+{
+	int tier = s_currentTier.load();
+	if (!tier) {
+		// a tier set in the meantime takes precedence
+		s_currentTier.testAndSetOrdered(0, int(_fInitialTier()) + 1);
+		tier = s_currentTier.load();
+	}
+
+	return SimdTier(tier - 1);
+}
+
+void FCpu::setSimdTier(SimdTier tier)
+{
+	s_currentTier.store(int(fMin(tier, supportedTier())) + 1);
+}
+
+const char* FCpu::tierName(SimdTier tier)
+{
+	switch (tier)
+	{
+	case SSE4:   return "SSE4.1";
+	case AVX2:   return "AVX2";
+	case AVX512: return "AVX-512";
+	}
+
+	return "unknown";
+}
+
+bool FCpu::parseTier(const char* pName, SimdTier* pTier)
+{
+	F_ASSERT(pName && pTier);
+
+	if (!qstricmp(pName, "sse4") || !qstricmp(pName, "sse4.1"))
+		*pTier = SSE4;
+	else if (!qstricmp(pName, "avx2"))
+		*pTier = AVX2;
+	else if (!qstricmp(pName, "avx512") || !qstricmp(pName, "avx-512"))
+		*pTier = AVX512;
+	else
+		return false;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
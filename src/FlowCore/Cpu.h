@@ -0,0 +1,63 @@
+// -----------------------------------------------------------------------------
+//  File        Cpu.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_CPU_H
+#define FLOWCORE_CPU_H
+
+#include "FlowCore/Library.h"
+
+// -----------------------------------------------------------------------------
+//  Class FCpu
+// -----------------------------------------------------------------------------
+
+/// Queries the instruction set extensions of the host processor and selects
+/// the SIMD tier used by the runtime dispatched kernels (see FSimdKernels).
+/// The detected tier can be lowered for benchmarking by setting the
+/// environment variable FLOW_SIMD_TIER to "sse4", "avx2" or "avx512".
+class FLOWCORE_EXPORT FCpu
+{
+	//  Public types -------------------------------------------------
+
+public:
+	enum SimdTier
+	{
+		SSE4 = 0,
+		AVX2,
+		AVX512
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+private:
+	/// Private constructor. Class only contains static methods.
+	FCpu();
+
+	//  Static members -----------------------------------------------
+
+public:
+	/// Returns the highest tier supported by both processor and operating system.
+	static SimdTier supportedTier();
+	/// Returns the tier currently used for dispatching. Unless set explicitly,
+	/// this is the supported tier, optionally lowered by FLOW_SIMD_TIER.
+	static SimdTier simdTier();
+	/// Forces the given tier. Tiers above the supported tier are clamped.
+	/// Thread-safe, kernels obtained from FSimdKernels::current() before
+	/// the call keep running at the previous tier.
+	static void setSimdTier(SimdTier tier);
+
+	/// Returns a readable name for the given tier.
+	static const char* tierName(SimdTier tier);
+	/// Parses a tier name as accepted by FLOW_SIMD_TIER. Returns false if
+	/// the name is not recognized.
+	static bool parseTier(const char* pName, SimdTier* pTier);
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_CPU_H
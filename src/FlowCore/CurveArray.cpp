@@ -0,0 +1,113 @@
+// -----------------------------------------------------------------------------
+//  File        CurveArray.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/21 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/CurveArray.h"
+#include "FlowCore/SimdKernels.h"
+
+// -----------------------------------------------------------------------------
+//  Class FCurveArray
+// -----------------------------------------------------------------------------
+
+// Public commands -------------------------------------------------------------
+
+void FCurveArray::appendBezier(const FVector2f& p0, const FVector2f& p1,
+	const FVector2f& p2, const FVector2f& p3)
+{
+	float duration = p3.x - p0.x;
+	float invDuration = duration > 0.0f ? 1.0f / duration : 0.0f;
+
+	// normalized time handles, clamped to [0, 1]
+	float a = 1.0f / 3.0f, b = 2.0f / 3.0f;
+	if (duration > 0.0f) {
+		a = fMinMax((p1.x - p0.x) * invDuration, 0.0f, 1.0f);
+		b = fMinMax((p2.x - p0.x) * invDuration, 0.0f, 1.0f);
+	}
+
+	float segment[SegmentSize] = {
+		p0.x,
+		invDuration,
+		3.0f * a,
+		3.0f * b - 6.0f * a,
+		1.0f + 3.0f * (a - b),
+		p0.y,
+		3.0f * (p1.y - p0.y),
+		3.0f * p0.y - 6.0f * p1.y + 3.0f * p2.y,
+		-p0.y + 3.0f * (p1.y - p2.y) + p3.y,
+		0.0f, 0.0f, 0.0f
+	};
+
+	m_segments.insert(m_segments.end(), segment, segment + SegmentSize);
+}
+
+void FCurveArray::appendHermite(float t0, float v0, float outTangent,
+	float t1, float v1, float inTangent)
+{
+	float third = (t1 - t0) / 3.0f;
+
+	appendBezier(
+		FVector2f(t0, v0),
+		FVector2f(t0 + third, v0 + outTangent * third),
+		FVector2f(t1 - third, v1 - inTangent * third),
+		FVector2f(t1, v1));
+}
+
+void FCurveArray::reserve(size_t size)
+{
+	m_segments.reserve(size * SegmentSize);
+}
+
+void FCurveArray::clear()
+{
+	m_segments.clear();
+}
+
+// Public queries --------------------------------------------------------------
+
+float FCurveArray::startTime(size_t index) const
+{
+	F_ASSERT(index < size());
+	return m_segments[index * SegmentSize];
+}
+
+float FCurveArray::endTime(size_t index) const
+{
+	F_ASSERT(index < size());
+	const float* p = &m_segments[index * SegmentSize];
+	return p[1] > 0.0f ? p[0] + 1.0f / p[1] : p[0];
+}
+
+float FCurveArray::evaluate(size_t segment, float time) const
+{
+	float value;
+	evaluate(segment, &time, &value, 1);
+	return value;
+}
+
+void FCurveArray::evaluate(size_t segment, const float* pTimes, float* pValues, size_t count) const
+{
+	F_ASSERT(segment < size());
+
+	if (count > 0)
+		FSimdKernels::current().evalCurves(&m_segments[segment * SegmentSize],
+			NULL, 0, pTimes, pValues, count);
+}
+
+void FCurveArray::evaluate(const uint32_t* pSegments, const float* pTimes, float* pValues, size_t count) const
+{
+	if (count > 0)
+		FSimdKernels::current().evalCurves(data(), pSegments, 0, pTimes, pValues, count);
+}
+
+void FCurveArray::evaluate(const float* pTimes, float* pValues) const
+{
+	if (!isEmpty())
+		FSimdKernels::current().evalCurves(data(), NULL, SegmentSize, pTimes, pValues, size());
+}
+
+// -----------------------------------------------------------------------------
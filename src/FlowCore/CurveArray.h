@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+//  File        CurveArray.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/21 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_CURVEARRAY_H
+#define FLOWCORE_CURVEARRAY_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Vector2T.h"
+
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Class FCurveArray
+// -----------------------------------------------------------------------------
+
+/// Array of 1D cubic animation curve segments. A segment maps time to value
+/// and is given by four Bezier control points (time, value), the time
+/// component of the inner points is clamped to the segment's time range,
+/// which makes the time polynomial monotonic. Hermite segments are stored
+/// as Bezier segments with evenly spaced time handles.
+///
+/// Evaluation solves the time polynomial for the curve parameter using
+/// Newton iterations on a bisection bracket, stopping as soon as all samples
+/// in a register have converged (normalized time error below 1e-6, usually
+/// after 2 to 4 iterations). Samples are processed 4 or 8 at a time
+/// depending on the SIMD tier selected by FCpu, each lane may refer to a
+/// different segment.
+class FLOWCORE_EXPORT FCurveArray
+{
+	//  Public types -------------------------------------------------
+
+public:
+	/// Number of floats per segment. Layout: start time, inverse duration,
+	/// coefficients 1 to 3 of the normalized time polynomial, coefficients
+	/// 0 to 3 of the value polynomial, 3 floats padding.
+	static const size_t SegmentSize = 12;
+
+	//  Constructors and destructor ----------------------------------
+
+	FCurveArray() { }
+
+	//  Public commands ----------------------------------------------
+
+public:
+	/// Appends a Bezier segment given by its control points (time, value).
+	void appendBezier(const FVector2f& p0, const FVector2f& p1,
+		const FVector2f& p2, const FVector2f& p3);
+	/// Appends a Hermite segment from time t0 to t1, given the values
+	/// and the tangents (value per time) at both ends.
+	void appendHermite(float t0, float v0, float outTangent,
+		float t1, float v1, float inTangent);
+
+	void reserve(size_t size);
+	void clear();
+
+	//  Public queries -----------------------------------------------
+
+	size_t size() const { return m_segments.size() / SegmentSize; }
+	bool isEmpty() const { return m_segments.empty(); }
+
+	float startTime(size_t index) const;
+	float endTime(size_t index) const;
+
+	/// Returns the value of the given segment at the given time. Times outside
+	/// the segment's range are clamped.
+	float evaluate(size_t segment, float time) const;
+	/// Evaluates the given segment at count times.
+	void evaluate(size_t segment, const float* pTimes, float* pValues, size_t count) const;
+	/// Evaluates count samples, sample i is taken from segment pSegments[i]
+	/// at time pTimes[i].
+	void evaluate(const uint32_t* pSegments, const float* pTimes, float* pValues, size_t count) const;
+	/// Evaluates all segments, segment i at time pTimes[i]. Both arrays must
+	/// provide space for size() elements.
+	void evaluate(const float* pTimes, float* pValues) const;
+
+	/// Returns the segment data, SegmentSize floats per segment.
+	const float* data() const { return m_segments.empty() ? NULL : &m_segments[0]; }
+
+	//  Internal data members ----------------------------------------
+
+private:
+	std::vector<float> m_segments;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_CURVEARRAY_H
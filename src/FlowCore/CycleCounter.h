@@ -18,26 +18,13 @@
 // -----------------------------------------------------------------------------
 
 #if (FLOW_COMPILER & FLOW_COMPILER_VC)
-
-#if (FLOW_ARCH & FLOW_ARCH_64)
-
-#include <intrin.h>
-#define F_RDTSC(cnt) cnt = __rdtsc();
-#else // 32bit
-#define F_RDTSC(cnt)   \
-	__asm { rdtsc \
-			mov (cnt).uint32.lo, eax \
-			mov (cnt).uint32.hi, edx }
-#endif
-
-#elif (FLOW_COMPILER && FLOW_COMPILER_GCC)
-
-#define F_RDTSC(tsc) __asm__ __volatile__ ("mov %0=ar.itc" : "=r" ((tsc).int64))
-
-#elif (FLOW_COMPILER && FLOW_COMPILER_INTEL)
-
-#define F_RDTSC(tsc) (tsc).int64=__getReg(3116)
-
+#  include <intrin.h>
+#  define F_RDTSC(cnt) (cnt) = __rdtsc()
+#elif defined(__i386__) || defined(__x86_64__)
+#  include <x86intrin.h>
+#  define F_RDTSC(cnt) (cnt) = __rdtsc()
+#else
+#  define F_RDTSC(cnt) (cnt) = 0
 #endif
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+// -----------------------------------------------------------------------------
+//  File        FastMat.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/11 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/FastMat.h"
+#include "FlowCore/SimdKernels.h"
+
+// -----------------------------------------------------------------------------
+//  Class FFastMat4f
+// -----------------------------------------------------------------------------
+
+// Batch transforms ------------------------------------------------------------
+
+void FFastMat4f::transformPoints(const float* pSrc, float* pDst, size_t count,
+	size_t srcStride /* = 3 */, size_t dstStride /* = 3 */) const
+{
+	F_ASSERT(srcStride >= 3 && dstStride >= 3);
+	float affine[12];
+	_affineRows(affine, true);
+	FSimdKernels::current().transformStrided(affine, pSrc, pDst, count, srcStride, dstStride, false);
+}
+
+void FFastMat4f::transformVectors(const float* pSrc, float* pDst, size_t count,
+	size_t srcStride /* = 3 */, size_t dstStride /* = 3 */) const
+{
+	F_ASSERT(srcStride >= 3 && dstStride >= 3);
+	float affine[12];
+	_affineRows(affine, false);
+	FSimdKernels::current().transformStrided(affine, pSrc, pDst, count, srcStride, dstStride, false);
+}
+
+void FFastMat4f::transformNormals(const float* pSrc, float* pDst, size_t count,
+	size_t srcStride /* = 3 */, size_t dstStride /* = 3 */,
+	bool normalize /* = true */) const
+{
+	F_ASSERT(srcStride >= 3 && dstStride >= 3);
+	float affine[12];
+	_normalRows(affine);
+	FSimdKernels::current().transformStrided(affine, pSrc, pDst, count, srcStride, dstStride, normalize);
+}
+
+void FFastMat4f::transformPoints(
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count) const
+{
+	float affine[12];
+	_affineRows(affine, true);
+	FSimdKernels::current().transformSoA(affine,
+		pSrcX, pSrcY, pSrcZ, pDstX, pDstY, pDstZ, count, false);
+}
+
+void FFastMat4f::transformVectors(
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count) const
+{
+	float affine[12];
+	_affineRows(affine, false);
+	FSimdKernels::current().transformSoA(affine,
+		pSrcX, pSrcY, pSrcZ, pDstX, pDstY, pDstZ, count, false);
+}
+
+void FFastMat4f::transformNormals(
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count,
+	bool normalize /* = true */) const
+{
+	float affine[12];
+	_normalRows(affine);
+	FSimdKernels::current().transformSoA(affine,
+		pSrcX, pSrcY, pSrcZ, pDstX, pDstY, pDstZ, count, normalize);
+}
+
+// Array operations ------------------------------------------------------------
+
+void FFastMat4f::multiplyMany(const FFastMat4f* pA, const FFastMat4f* pB,
+	FFastMat4f* pDst, size_t count)
+{
+	FSimdKernels::current().multiplyMany(reinterpret_cast<const float*>(pA),
+		reinterpret_cast<const float*>(pB), reinterpret_cast<float*>(pDst), count);
+}
+
+void FFastMat4f::inverseMany(const FFastMat4f* pSrc, FFastMat4f* pDst, size_t count)
+{
+	FSimdKernels::current().inverseMany(reinterpret_cast<const float*>(pSrc),
+		reinterpret_cast<float*>(pDst), count, false);
+}
+
+void FFastMat4f::inverseTransposeMany(const FFastMat4f* pSrc, FFastMat4f* pDst, size_t count)
+{
+	FSimdKernels::current().inverseMany(reinterpret_cast<const float*>(pSrc),
+		reinterpret_cast<float*>(pDst), count, true);
+}
+
+void FFastMat4f::multiplyMany(const FFastMat4fBlock* pA, const FFastMat4fBlock* pB,
+	FFastMat4fBlock* pDst, size_t blockCount)
+{
+	FSimdKernels::current().multiplyBlocks(pA->m[0], pB->m[0], pDst->m[0], blockCount);
+}
+
+void FFastMat4f::inverseMany(const FFastMat4fBlock* pSrc, FFastMat4fBlock* pDst, size_t blockCount)
+{
+	FSimdKernels::current().inverseBlocks(pSrc->m[0], pDst->m[0], blockCount, false);
+}
+
+void FFastMat4f::inverseTransposeMany(const FFastMat4fBlock* pSrc, FFastMat4fBlock* pDst,
+	size_t blockCount)
+{
+	FSimdKernels::current().inverseBlocks(pSrc->m[0], pDst->m[0], blockCount, true);
+}
+
+void FFastMat4f::toBlocks(const FFastMat4f* pSrc, FFastMat4fBlock* pDst, size_t count)
+{
+	for (size_t i = 0; i < (count + 7) / 8 * 8; ++i) {
+		FFastMat4fBlock& block = pDst[i / 8];
+		for (size_t k = 0; k < 16; ++k)
+			block.m[k][i % 8] = (i < count) ? pSrc[i](k / 4, k % 4) : (k % 5 == 0 ? 1.0f : 0.0f);
+	}
+}
+
+void FFastMat4f::fromBlocks(const FFastMat4fBlock* pSrc, FFastMat4f* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		const FFastMat4fBlock& block = pSrc[i / 8];
+		for (size_t k = 0; k < 16; ++k)
+			pDst[i](k / 4, k % 4) = block.m[k][i % 8];
+	}
+}
+
+// Internal functions ----------------------------------------------------------
+
+void FFastMat4f::_affineRows(float* pAffine, bool translate) const
+{
+	F_ALIGN(16) float e[16];
+	copyToAligned(e);
+
+	for (size_t i = 0; i < 12; ++i)
+		pAffine[i] = e[i];
+
+	if (!translate)
+		pAffine[3] = pAffine[7] = pAffine[11] = 0.0f;
+}
+
+void FFastMat4f::_normalRows(float* pAffine) const
+{
+	F_ALIGN(16) float e[16];
+	copyToAligned(e);
+
+	// cofactors of the upper 3x3 matrix, equal to the inverse transpose
+	// multiplied by the determinant
+	float c00 = e[5] * e[10] - e[6] * e[9];
+	float c01 = e[6] * e[8]  - e[4] * e[10];
+	float c02 = e[4] * e[9]  - e[5] * e[8];
+	float c10 = e[2] * e[9]  - e[1] * e[10];
+	float c11 = e[0] * e[10] - e[2] * e[8];
+	float c12 = e[1] * e[8]  - e[0] * e[9];
+	float c20 = e[1] * e[6]  - e[2] * e[5];
+	float c21 = e[2] * e[4]  - e[0] * e[6];
+	float c22 = e[0] * e[5]  - e[1] * e[4];
+
+	float det = e[0] * c00 + e[1] * c01 + e[2] * c02;
+	float s = (det != 0.0f) ? 1.0f / det : 1.0f;
+
+	pAffine[0] = c00 * s; pAffine[1] = c01 * s; pAffine[2]  = c02 * s; pAffine[3]  = 0.0f;
+	pAffine[4] = c10 * s; pAffine[5] = c11 * s; pAffine[6]  = c12 * s; pAffine[7]  = 0.0f;
+	pAffine[8] = c20 * s; pAffine[9] = c21 * s; pAffine[10] = c22 * s; pAffine[11] = 0.0f;
+}
+
+// -----------------------------------------------------------------------------
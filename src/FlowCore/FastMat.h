@@ -18,6 +18,18 @@
 
 #include <ostream>
 
+// -----------------------------------------------------------------------------
+//  Struct FFastMat4fBlock
+// -----------------------------------------------------------------------------
+
+/// Block of 8 matrices in element-interleaved (AoSoA) layout, element (r, c)
+/// of matrix i is stored in m[r * 4 + c][i]. Arrays of blocks are processed
+/// by the array functions of FFastMat4f without any shuffling.
+struct FFastMat4fBlock
+{
+	F_ALIGN(32) float m[16][8];
+};
+
 // -----------------------------------------------------------------------------
 //  Class FFastMat4f
 // -----------------------------------------------------------------------------
@@ -136,8 +148,75 @@ public:
 	/// Returns the determinant of the matrix.
 	float determinant() const;
 
+	//  Batch transforms ---------------------------------------------
+
+	// The batch functions treat the matrix as an affine transform, the bottom
+	// row is not evaluated. Strides are given in floats, the source and
+	// destination arrays may be identical (in-place transform).
+
+	/// Transforms an array of 3-component points (w = 1).
+	void transformPoints(const float* pSrc, float* pDst, size_t count,
+		size_t srcStride = 3, size_t dstStride = 3) const;
+	/// Transforms an array of 3-component direction vectors (w = 0).
+	void transformVectors(const float* pSrc, float* pDst, size_t count,
+		size_t srcStride = 3, size_t dstStride = 3) const;
+	/// Transforms an array of normals by the inverse transpose of the upper
+	/// 3x3 matrix. If normalize is true, the results are scaled to unit length.
+	void transformNormals(const float* pSrc, float* pDst, size_t count,
+		size_t srcStride = 3, size_t dstStride = 3, bool normalize = true) const;
+
+	/// Transforms points given as separate x, y, z arrays (SoA layout).
+	void transformPoints(const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+		float* pDstX, float* pDstY, float* pDstZ, size_t count) const;
+	/// Transforms direction vectors given as separate x, y, z arrays (SoA layout).
+	void transformVectors(const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+		float* pDstX, float* pDstY, float* pDstZ, size_t count) const;
+	/// Transforms normals given as separate x, y, z arrays (SoA layout).
+	void transformNormals(const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+		float* pDstX, float* pDstY, float* pDstZ, size_t count,
+		bool normalize = true) const;
+
+	//  Array operations ---------------------------------------------
+
+	// The array functions process 4 or 8 matrices in parallel, depending on
+	// the SIMD tier selected by FCpu. The destination array may be identical
+	// to one of the source arrays. Storing the matrices in blocks saves the
+	// transposition to and from the element-interleaved layout.
+
+	/// Multiplies count pairs of matrices, pDst[i] = pA[i] * pB[i].
+	static void multiplyMany(const FFastMat4f* pA, const FFastMat4f* pB,
+		FFastMat4f* pDst, size_t count);
+	/// Inverts count matrices.
+	static void inverseMany(const FFastMat4f* pSrc, FFastMat4f* pDst, size_t count);
+	/// Calculates the inverse transpose of count matrices, e.g. to obtain
+	/// the normal matrices of an array of model transforms.
+	static void inverseTransposeMany(const FFastMat4f* pSrc, FFastMat4f* pDst, size_t count);
+
+	/// Multiplies count pairs of matrix blocks, see FFastMat4fBlock.
+	static void multiplyMany(const FFastMat4fBlock* pA, const FFastMat4fBlock* pB,
+		FFastMat4fBlock* pDst, size_t blockCount);
+	/// Inverts all matrices in count matrix blocks.
+	static void inverseMany(const FFastMat4fBlock* pSrc, FFastMat4fBlock* pDst, size_t blockCount);
+	/// Calculates the inverse transpose of all matrices in count matrix blocks.
+	static void inverseTransposeMany(const FFastMat4fBlock* pSrc, FFastMat4fBlock* pDst,
+		size_t blockCount);
+
+	/// Converts count matrices to block layout. The destination must hold
+	/// (count + 7) / 8 blocks, unused slots are set to the identity matrix.
+	static void toBlocks(const FFastMat4f* pSrc, FFastMat4fBlock* pDst, size_t count);
+	/// Converts count matrices from block layout.
+	static void fromBlocks(const FFastMat4fBlock* pSrc, FFastMat4f* pDst, size_t count);
+
+	//  Internal functions -------------------------------------------
+
+private:
+	void _affineRows(float* pAffine, bool translate) const;
+	void _normalRows(float* pAffine) const;
+
 	//  Related non-member functions ---------------------------------
 
+public:
+
 	/// Component-wise addition of two matrices.
 	friend FFastMat4f operator+(const FFastMat4f& v1, const FFastMat4f& v2);
 	/// Component-wise addition of a matrix and a scalar.
@@ -483,10 +562,15 @@ inline FFastMat4f FFastMat4f::inverse() const
 	__m128 row0, row1, row2, row3;
 	__m128 det, tmp1;
 
+	// Cramer's rule operates on the columns, the second and fourth
+	// column are expected with swapped halves
 	row0 = m_row[0].m_reg;
 	row1 = m_row[1].m_reg;
 	row2 = m_row[2].m_reg;
 	row3 = m_row[3].m_reg;
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+	row1 = _mm_shuffle_ps(row1, row1, 0x4E);
+	row3 = _mm_shuffle_ps(row3, row3, 0x4E);
 
 	tmp1 = _mm_mul_ps(row2, row3);
 	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
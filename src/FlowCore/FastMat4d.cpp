@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+//  File        FastMat4d.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/17 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/FastMat4d.h"
+
+// -----------------------------------------------------------------------------
+//  Class FFastMat4d
+// -----------------------------------------------------------------------------
+
+// Both the inverse and the determinant are computed from the 2x2 sub-
+// determinants of the upper two rows (s) and the lower two rows (c).
+
+// Public queries --------------------------------------------------------------
+
+FFastMat4d FFastMat4d::inverse() const
+{
+	F_ALIGN(32) double m[16];
+	copyToAligned(m);
+
+	double s0 = m[0] * m[5]  - m[1] * m[4];
+	double s1 = m[0] * m[6]  - m[2] * m[4];
+	double s2 = m[0] * m[7]  - m[3] * m[4];
+	double s3 = m[1] * m[6]  - m[2] * m[5];
+	double s4 = m[1] * m[7]  - m[3] * m[5];
+	double s5 = m[2] * m[7]  - m[3] * m[6];
+
+	double c5 = m[10] * m[15] - m[11] * m[14];
+	double c4 = m[9]  * m[15] - m[11] * m[13];
+	double c3 = m[9]  * m[14] - m[10] * m[13];
+	double c2 = m[8]  * m[15] - m[11] * m[12];
+	double c1 = m[8]  * m[14] - m[10] * m[12];
+	double c0 = m[8]  * m[13] - m[9]  * m[12];
+
+	double det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+	// each row of the adjugate is a sum of three products of a signed
+	// element vector and a broadcast sub-determinant pair
+	FFastVec4d a0( m[5], -m[1],  m[13], -m[9]);
+	FFastVec4d a1(-m[6],  m[2], -m[14],  m[10]);
+	FFastVec4d a2( m[7], -m[3],  m[15], -m[11]);
+	FFastVec4d r0 = fCompMul(a0, FFastVec4d(c5, c5, s5, s5))
+	              + fCompMul(a1, FFastVec4d(c4, c4, s4, s4))
+	              + fCompMul(a2, FFastVec4d(c3, c3, s3, s3));
+
+	FFastVec4d b0(-m[4],  m[0], -m[12],  m[8]);
+	FFastVec4d b1( m[6], -m[2],  m[14], -m[10]);
+	FFastVec4d b2(-m[7],  m[3], -m[15],  m[11]);
+	FFastVec4d r1 = fCompMul(b0, FFastVec4d(c5, c5, s5, s5))
+	              + fCompMul(b1, FFastVec4d(c2, c2, s2, s2))
+	              + fCompMul(b2, FFastVec4d(c1, c1, s1, s1));
+
+	FFastVec4d d0( m[4], -m[0],  m[12], -m[8]);
+	FFastVec4d d1(-m[5],  m[1], -m[13],  m[9]);
+	FFastVec4d d2( m[7], -m[3],  m[15], -m[11]);
+	FFastVec4d r2 = fCompMul(d0, FFastVec4d(c4, c4, s4, s4))
+	              + fCompMul(d1, FFastVec4d(c2, c2, s2, s2))
+	              + fCompMul(d2, FFastVec4d(c0, c0, s0, s0));
+
+	FFastVec4d e0(-m[4],  m[0], -m[12],  m[8]);
+	FFastVec4d e1( m[5], -m[1],  m[13], -m[9]);
+	FFastVec4d e2(-m[6],  m[2], -m[14],  m[10]);
+	FFastVec4d r3 = fCompMul(e0, FFastVec4d(c3, c3, s3, s3))
+	              + fCompMul(e1, FFastVec4d(c1, c1, s1, s1))
+	              + fCompMul(e2, FFastVec4d(c0, c0, s0, s0));
+
+	double invDet = 1.0 / det;
+	return FFastMat4d(r0 * invDet, r1 * invDet, r2 * invDet, r3 * invDet);
+}
+
+double FFastMat4d::determinant() const
+{
+	F_ALIGN(32) double m[16];
+	copyToAligned(m);
+
+	// products of the upper (s) and lower (c) 2x2 sub-determinants,
+	// paired such that the expansion is a 6-element dot product
+	FFastVec4d s(m[0] * m[5] - m[1] * m[4], m[0] * m[6] - m[2] * m[4],
+	             m[0] * m[7] - m[3] * m[4], m[1] * m[6] - m[2] * m[5]);
+	FFastVec4d c(m[10] * m[15] - m[11] * m[14], m[11] * m[13] - m[9] * m[15],
+	             m[9]  * m[14] - m[10] * m[13], m[8]  * m[15] - m[11] * m[12]);
+
+	double s4 = m[1] * m[7]  - m[3] * m[5];
+	double s5 = m[2] * m[7]  - m[3] * m[6];
+	double c1 = m[8] * m[14] - m[10] * m[12];
+	double c0 = m[8] * m[13] - m[9]  * m[12];
+
+	return s.dot(c) - s4 * c1 + s5 * c0;
+}
+
+// -----------------------------------------------------------------------------
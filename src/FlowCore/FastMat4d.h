@@ -0,0 +1,481 @@
+// -----------------------------------------------------------------------------
+//  File        FastMat4d.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/17 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_FASTMAT4D_H
+#define FLOWCORE_FASTMAT4D_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/FastVec4d.h"
+#include "FlowCore/FastMat.h"
+#include "FlowCore/Vector4T.h"
+#include "FlowCore/Matrix4T.h"
+
+// -----------------------------------------------------------------------------
+//  Class FFastMat4d
+// -----------------------------------------------------------------------------
+
+/// Double precision counterpart of FFastMat4f, stored as four FFastVec4d rows.
+class FLOWCORE_EXPORT FFastMat4d
+{
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Default Constructor. Creates an uninitialized matrix.
+	FFastMat4d() { }
+	/// Creates a matrix from the given elements.
+	FFastMat4d(double m00, double m01, double m02, double m03,
+	           double m10, double m11, double m12, double m13,
+	           double m20, double m21, double m22, double m23,
+	           double m30, double m31, double m32, double m33);
+	/// Creates a matrix from the given unaligned double array.
+	explicit FFastMat4d(const double* pValues);
+	/// Creates a matrix from the given row vectors.
+	FFastMat4d(const FFastVec4d& row0, const FFastVec4d& row1,
+	           const FFastVec4d& row2, const FFastVec4d& row3);
+	/// Creates a matrix from the given matrix.
+	explicit FFastMat4d(const FMatrix4d& mat);
+	/// Converts a single precision fast matrix.
+	explicit FFastMat4d(const FFastMat4f& mat);
+
+	//  Access -------------------------------------------------------
+
+public:
+	/// Conversion to FMatrix4d.
+	operator FMatrix4d() const;
+	/// Conversion to a single precision fast matrix.
+	FFastMat4f toFloat() const;
+	/// Returns a text representation of the matrix.
+	QString toString() const;
+
+	/// Sets all components of the matrix to the given values.
+	void set(double m00, double m01, double m02, double m03,
+	         double m10, double m11, double m12, double m13,
+	         double m20, double m21, double m22, double m23,
+	         double m30, double m31, double m32, double m33);
+	/// Sets all rows of the matrix to the given values.
+	void set(const FFastVec4d& row0, const FFastVec4d& row1,
+	         const FFastVec4d& row2, const FFastVec4d& row3);
+	/// Copies the values from the given matrix.
+	void set(const FMatrix4d& mat);
+
+	/// Sets the matrix to the identity matrix.
+	void setIdentity();
+
+	/// Replaces a row by the given vector.
+	void setRow(const FFastVec4d& vec, size_t index);
+	/// Replaces a column by the given vector.
+	void setColumn(const FFastVec4d& vec, size_t index);
+
+	/// Returns the row vector at the given index.
+	const FFastVec4d& row(size_t index) const;
+	/// Returns the column vector at the given index.
+	FFastVec4d column(size_t index) const;
+
+	/// Read/write access to the row with the given index in the range [0; 3].
+	FFastVec4d& operator[](size_t rowIndex);
+	/// Const access to the row with the given index in the range [0; 3].
+	const FFastVec4d& operator[](size_t rowIndex) const;
+	/// Read/write access to the element at the given row and column.
+	double& operator()(size_t rowIndex, size_t columnIndex);
+	/// Const access to the element at the given row and column.
+	const double& operator()(size_t rowIndex, size_t columnIndex) const;
+
+	/// Writes the matrix' values to the given 32-byte aligned double array.
+	void copyToAligned(double* pValues) const;
+	/// Writes the matrix' values to the given unaligned double array.
+	void copyTo(double* pValues) const;
+	/// Replaces the matrix' values by the values of the given 32-byte aligned double array.
+	void copyFromAligned(const double* pValues);
+	/// Replaces the matrix' values by the values of the given unaligned double array.
+	void copyFrom(const double* pValues);
+
+	//  Operators ----------------------------------------------------
+
+	/// Component-wise addition of the right-hand matrix.
+	FFastMat4d& operator+=(const FFastMat4d& mat);
+	/// Component-wise subtraction of the right-hand matrix.
+	FFastMat4d& operator-=(const FFastMat4d& mat);
+	/// Matrix-matrix multiplication.
+	FFastMat4d& operator*=(const FFastMat4d& rhs);
+	/// Component-wise multiplication of the right-hand scalar.
+	FFastMat4d& operator*=(double scalar);
+	/// Component-wise division by the right-hand scalar.
+	FFastMat4d& operator/=(double scalar);
+
+	//  Public commands ----------------------------------------------
+
+	/// Transposes the matrix, i.e. inverts rows and columns.
+	void transpose();
+	/// Inverts the matrix.
+	void invert();
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the transposed matrix.
+	FFastMat4d transposed() const;
+	/// Returns the inverse of the matrix. If the matrix is singular,
+	/// the result contains infinite values.
+	FFastMat4d inverse() const;
+	/// Returns the determinant of the matrix.
+	double determinant() const;
+	/// Component-wise linear interpolation between two matrices.
+	FFastMat4d lerp(const FFastMat4d& mat, double factor) const;
+
+	//  Related non-member functions ---------------------------------
+
+	/// Component-wise addition of two matrices.
+	friend FFastMat4d operator+(const FFastMat4d& m1, const FFastMat4d& m2);
+	/// Component-wise subtraction of two matrices.
+	friend FFastMat4d operator-(const FFastMat4d& m1, const FFastMat4d& m2);
+	/// Matrix-matrix multiplication.
+	friend FFastMat4d operator*(const FFastMat4d& m1, const FFastMat4d& m2);
+	/// Matrix-vector multiplication.
+	friend FFastVec4d operator*(const FFastMat4d& mat, const FFastVec4d& vec);
+	/// Vector-matrix multiplication.
+	friend FFastVec4d operator*(const FFastVec4d& vec, const FFastMat4d& mat);
+	/// Component-wise multiplication of a matrix with a scalar.
+	friend FFastMat4d operator*(const FFastMat4d& mat, double scalar);
+	/// Component-wise multiplication of a scalar with a matrix.
+	friend FFastMat4d operator*(double scalar, const FFastMat4d& mat);
+	/// Component-wise division of a matrix by a scalar.
+	friend FFastMat4d operator/(const FFastMat4d& mat, double scalar);
+	/// Outer product of two vectors.
+	friend FFastMat4d fOuterProduct(const FFastVec4d& v1, const FFastVec4d& v2);
+
+	//  Internal data members ----------------------------------------
+
+private:
+	FFastVec4d m_row[4];
+};
+
+// Constructors ----------------------------------------------------------------
+
+inline FFastMat4d::FFastMat4d(double m00, double m01, double m02, double m03,
+	                          double m10, double m11, double m12, double m13,
+	                          double m20, double m21, double m22, double m23,
+	                          double m30, double m31, double m32, double m33)
+{
+	m_row[0].set(m00, m01, m02, m03);
+	m_row[1].set(m10, m11, m12, m13);
+	m_row[2].set(m20, m21, m22, m23);
+	m_row[3].set(m30, m31, m32, m33);
+}
+
+inline FFastMat4d::FFastMat4d(const double* pValues)
+{
+	copyFrom(pValues);
+}
+
+inline FFastMat4d::FFastMat4d(const FFastVec4d& row0, const FFastVec4d& row1,
+	                          const FFastVec4d& row2, const FFastVec4d& row3)
+{
+	m_row[0] = row0;
+	m_row[1] = row1;
+	m_row[2] = row2;
+	m_row[3] = row3;
+}
+
+inline FFastMat4d::FFastMat4d(const FMatrix4d& mat)
+{
+	copyFrom(mat.ptr());
+}
+
+inline FFastMat4d::FFastMat4d(const FFastMat4f& mat)
+{
+	m_row[0] = FFastVec4d(mat[0]);
+	m_row[1] = FFastVec4d(mat[1]);
+	m_row[2] = FFastVec4d(mat[2]);
+	m_row[3] = FFastVec4d(mat[3]);
+}
+
+// Conversion ------------------------------------------------------------------
+
+inline FFastMat4d::operator FMatrix4d() const
+{
+	FMatrix4d result;
+	copyTo(result.ptr());
+	return result;
+}
+
+inline FFastMat4f FFastMat4d::toFloat() const
+{
+	return FFastMat4f(m_row[0].toFloat(), m_row[1].toFloat(),
+	                  m_row[2].toFloat(), m_row[3].toFloat());
+}
+
+inline QString FFastMat4d::toString() const
+{
+	return FMatrix4d(*this).toString();
+}
+
+// Access ----------------------------------------------------------------------
+
+inline void FFastMat4d::set(double m00, double m01, double m02, double m03,
+	                        double m10, double m11, double m12, double m13,
+	                        double m20, double m21, double m22, double m23,
+	                        double m30, double m31, double m32, double m33)
+{
+	m_row[0].set(m00, m01, m02, m03);
+	m_row[1].set(m10, m11, m12, m13);
+	m_row[2].set(m20, m21, m22, m23);
+	m_row[3].set(m30, m31, m32, m33);
+}
+
+inline void FFastMat4d::set(const FFastVec4d& row0, const FFastVec4d& row1,
+	                        const FFastVec4d& row2, const FFastVec4d& row3)
+{
+	m_row[0] = row0;
+	m_row[1] = row1;
+	m_row[2] = row2;
+	m_row[3] = row3;
+}
+
+inline void FFastMat4d::set(const FMatrix4d& mat)
+{
+	copyFrom(mat.ptr());
+}
+
+inline void FFastMat4d::setIdentity()
+{
+	m_row[0].set(1.0, 0.0, 0.0, 0.0);
+	m_row[1].set(0.0, 1.0, 0.0, 0.0);
+	m_row[2].set(0.0, 0.0, 1.0, 0.0);
+	m_row[3].set(0.0, 0.0, 0.0, 1.0);
+}
+
+inline void FFastMat4d::setRow(const FFastVec4d& vec, size_t index)
+{
+	F_ASSERT(index < 4);
+	m_row[index] = vec;
+}
+
+inline void FFastMat4d::setColumn(const FFastVec4d& vec, size_t index)
+{
+	F_ASSERT(index < 4);
+	m_row[0][index] = vec[0];
+	m_row[1][index] = vec[1];
+	m_row[2][index] = vec[2];
+	m_row[3][index] = vec[3];
+}
+
+inline const FFastVec4d& FFastMat4d::row(size_t index) const
+{
+	F_ASSERT(index < 4);
+	return m_row[index];
+}
+
+inline FFastVec4d FFastMat4d::column(size_t index) const
+{
+	F_ASSERT(index < 4);
+	return FFastVec4d(m_row[0][index], m_row[1][index],
+	                  m_row[2][index], m_row[3][index]);
+}
+
+inline FFastVec4d& FFastMat4d::operator[](size_t index)
+{
+	F_ASSERT(index < 4);
+	return m_row[index];
+}
+
+inline const FFastVec4d& FFastMat4d::operator[](size_t index) const
+{
+	F_ASSERT(index < 4);
+	return m_row[index];
+}
+
+inline double& FFastMat4d::operator()(size_t rowIndex, size_t columnIndex)
+{
+	F_ASSERT(rowIndex < 4 && columnIndex < 4);
+	return m_row[rowIndex][columnIndex];
+}
+
+inline const double& FFastMat4d::operator()(size_t rowIndex, size_t columnIndex) const
+{
+	F_ASSERT(rowIndex < 4 && columnIndex < 4);
+	return m_row[rowIndex][columnIndex];
+}
+
+inline void FFastMat4d::copyToAligned(double* pValues) const
+{
+	m_row[0].copyToAligned(pValues     );
+	m_row[1].copyToAligned(pValues +  4);
+	m_row[2].copyToAligned(pValues +  8);
+	m_row[3].copyToAligned(pValues + 12);
+}
+
+inline void FFastMat4d::copyTo(double* pValues) const
+{
+	m_row[0].copyTo(pValues     );
+	m_row[1].copyTo(pValues +  4);
+	m_row[2].copyTo(pValues +  8);
+	m_row[3].copyTo(pValues + 12);
+}
+
+inline void FFastMat4d::copyFromAligned(const double* pValues)
+{
+	m_row[0].copyFromAligned(pValues     );
+	m_row[1].copyFromAligned(pValues +  4);
+	m_row[2].copyFromAligned(pValues +  8);
+	m_row[3].copyFromAligned(pValues + 12);
+}
+
+inline void FFastMat4d::copyFrom(const double* pValues)
+{
+	m_row[0].copyFrom(pValues     );
+	m_row[1].copyFrom(pValues +  4);
+	m_row[2].copyFrom(pValues +  8);
+	m_row[3].copyFrom(pValues + 12);
+}
+
+// Operators -------------------------------------------------------------------
+
+inline FFastMat4d& FFastMat4d::operator+=(const FFastMat4d& mat)
+{
+	m_row[0] += mat.m_row[0];
+	m_row[1] += mat.m_row[1];
+	m_row[2] += mat.m_row[2];
+	m_row[3] += mat.m_row[3];
+	return *this;
+}
+
+inline FFastMat4d& FFastMat4d::operator-=(const FFastMat4d& mat)
+{
+	m_row[0] -= mat.m_row[0];
+	m_row[1] -= mat.m_row[1];
+	m_row[2] -= mat.m_row[2];
+	m_row[3] -= mat.m_row[3];
+	return *this;
+}
+
+inline FFastMat4d& FFastMat4d::operator*=(const FFastMat4d& mat)
+{
+	*this = *this * mat;
+	return *this;
+}
+
+inline FFastMat4d& FFastMat4d::operator*=(double scalar)
+{
+	m_row[0] *= scalar;
+	m_row[1] *= scalar;
+	m_row[2] *= scalar;
+	m_row[3] *= scalar;
+	return *this;
+}
+
+inline FFastMat4d& FFastMat4d::operator/=(double scalar)
+{
+	m_row[0] /= scalar;
+	m_row[1] /= scalar;
+	m_row[2] /= scalar;
+	m_row[3] /= scalar;
+	return *this;
+}
+
+// Public commands -------------------------------------------------------------
+
+inline void FFastMat4d::transpose()
+{
+	_fd4Transpose(m_row[0].m_reg, m_row[1].m_reg, m_row[2].m_reg, m_row[3].m_reg);
+}
+
+inline void FFastMat4d::invert()
+{
+	*this = inverse();
+}
+
+// Public queries --------------------------------------------------------------
+
+inline FFastMat4d FFastMat4d::transposed() const
+{
+	FFastMat4d result(*this);
+	result.transpose();
+	return result;
+}
+
+inline FFastMat4d FFastMat4d::lerp(const FFastMat4d& mat, double factor) const
+{
+	return FFastMat4d(fLerp(m_row[0], mat.m_row[0], factor),
+	                  fLerp(m_row[1], mat.m_row[1], factor),
+	                  fLerp(m_row[2], mat.m_row[2], factor),
+	                  fLerp(m_row[3], mat.m_row[3], factor));
+}
+
+// Related non-member functions ------------------------------------------------
+
+inline FFastMat4d operator+(const FFastMat4d& m1, const FFastMat4d& m2)
+{
+	return FFastMat4d(m1.m_row[0] + m2.m_row[0], m1.m_row[1] + m2.m_row[1],
+	                  m1.m_row[2] + m2.m_row[2], m1.m_row[3] + m2.m_row[3]);
+}
+
+inline FFastMat4d operator-(const FFastMat4d& m1, const FFastMat4d& m2)
+{
+	return FFastMat4d(m1.m_row[0] - m2.m_row[0], m1.m_row[1] - m2.m_row[1],
+	                  m1.m_row[2] - m2.m_row[2], m1.m_row[3] - m2.m_row[3]);
+}
+
+inline FFastMat4d operator*(const FFastMat4d& m1, const FFastMat4d& m2)
+{
+	_fReg4d res[4];
+	for (int i = 0; i < 4; i++)
+	{
+		const FFastVec4d& r = m1.m_row[i];
+		_fReg4d t0 = _fd4Mul(_fd4Set1(r[0]), m2.m_row[0].m_reg);
+		_fReg4d t1 = _fd4Mul(_fd4Set1(r[1]), m2.m_row[1].m_reg);
+		_fReg4d t2 = _fd4Mul(_fd4Set1(r[2]), m2.m_row[2].m_reg);
+		_fReg4d t3 = _fd4Mul(_fd4Set1(r[3]), m2.m_row[3].m_reg);
+		res[i] = _fd4Add(_fd4Add(t0, t1), _fd4Add(t2, t3));
+	}
+
+	return FFastMat4d(FFastVec4d(res[0]), FFastVec4d(res[1]),
+	                  FFastVec4d(res[2]), FFastVec4d(res[3]));
+}
+
+inline FFastVec4d operator*(const FFastMat4d& mat, const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4HSum4(_fd4Mul(mat.m_row[0].m_reg, vec.m_reg),
+	                            _fd4Mul(mat.m_row[1].m_reg, vec.m_reg),
+	                            _fd4Mul(mat.m_row[2].m_reg, vec.m_reg),
+	                            _fd4Mul(mat.m_row[3].m_reg, vec.m_reg)));
+}
+
+inline FFastVec4d operator*(const FFastVec4d& vec, const FFastMat4d& mat)
+{
+	_fReg4d t0 = _fd4Mul(mat.m_row[0].m_reg, _fd4Set1(vec[0]));
+	_fReg4d t1 = _fd4Mul(mat.m_row[1].m_reg, _fd4Set1(vec[1]));
+	_fReg4d t2 = _fd4Mul(mat.m_row[2].m_reg, _fd4Set1(vec[2]));
+	_fReg4d t3 = _fd4Mul(mat.m_row[3].m_reg, _fd4Set1(vec[3]));
+	return FFastVec4d(_fd4Add(_fd4Add(t0, t1), _fd4Add(t2, t3)));
+}
+
+inline FFastMat4d operator*(const FFastMat4d& mat, double scalar)
+{
+	return FFastMat4d(mat.m_row[0] * scalar, mat.m_row[1] * scalar,
+	                  mat.m_row[2] * scalar, mat.m_row[3] * scalar);
+}
+
+inline FFastMat4d operator*(double scalar, const FFastMat4d& mat)
+{
+	return mat * scalar;
+}
+
+inline FFastMat4d operator/(const FFastMat4d& mat, double scalar)
+{
+	return FFastMat4d(mat.m_row[0] / scalar, mat.m_row[1] / scalar,
+	                  mat.m_row[2] / scalar, mat.m_row[3] / scalar);
+}
+
+inline FFastMat4d fOuterProduct(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastMat4d(v2 * v1[0], v2 * v1[1], v2 * v1[2], v2 * v1[3]);
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_FASTMAT4D_H
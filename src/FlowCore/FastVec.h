@@ -12,6 +12,8 @@
 
 #include "FlowCore/Library.h"
 #include "FlowCore/Intrinsics.h"
+#include "FlowCore/MathSimd.h"
+#include "FlowCore/Math.h"
 #include "FlowCore/Vector4T.h"
 
 // -----------------------------------------------------------------------------
@@ -35,6 +37,15 @@ FFastMat4f operator*(float scalar, const FFastMat4f& mat);
 FFastMat4f operator/(const FFastMat4f& mat, float scalar);
 FFastMat4f fOuterProduct(const FFastVec4f& v1, const FFastVec4f& v2);
 
+FFastVec4f fSin(const FFastVec4f& vec, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fCos(const FFastVec4f& vec, FMath::Accuracy accuracy = FMath::Precise);
+void fSinCos(const FFastVec4f& vec, FFastVec4f& sin, FFastVec4f& cos, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fExp(const FFastVec4f& vec, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fLog(const FFastVec4f& vec, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fPow(const FFastVec4f& base, const FFastVec4f& exponent, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fAtan2(const FFastVec4f& y, const FFastVec4f& x, FMath::Accuracy accuracy = FMath::Precise);
+FFastVec4f fAcos(const FFastVec4f& vec, FMath::Accuracy accuracy = FMath::Precise);
+
 
 class FLOWCORE_EXPORT FFastVec4f
 {
@@ -197,6 +208,23 @@ public:
 	/// Component-wise division of two vectors.
 	friend FFastVec4f fCompDiv(const FFastVec4f& v1, const FFastVec4f& v2);
 
+	/// Component-wise approximated sine, see FMath::approxSin().
+	friend FFastVec4f fSin(const FFastVec4f& vec, FMath::Accuracy accuracy);
+	/// Component-wise approximated cosine, see FMath::approxCos().
+	friend FFastVec4f fCos(const FFastVec4f& vec, FMath::Accuracy accuracy);
+	/// Component-wise approximated sine and cosine, see FMath::approxSinCos().
+	friend void fSinCos(const FFastVec4f& vec, FFastVec4f& sin, FFastVec4f& cos, FMath::Accuracy accuracy);
+	/// Component-wise approximated exponential, see FMath::approxExp().
+	friend FFastVec4f fExp(const FFastVec4f& vec, FMath::Accuracy accuracy);
+	/// Component-wise approximated natural logarithm, see FMath::approxLog().
+	friend FFastVec4f fLog(const FFastVec4f& vec, FMath::Accuracy accuracy);
+	/// Component-wise approximated power, see FMath::approxPow().
+	friend FFastVec4f fPow(const FFastVec4f& base, const FFastVec4f& exponent, FMath::Accuracy accuracy);
+	/// Component-wise approximated arc tangent of y / x, see FMath::approxAtan2().
+	friend FFastVec4f fAtan2(const FFastVec4f& y, const FFastVec4f& x, FMath::Accuracy accuracy);
+	/// Component-wise approximated arc cosine, see FMath::approxAcos().
+	friend FFastVec4f fAcos(const FFastVec4f& vec, FMath::Accuracy accuracy);
+
 	//  Implemented in FFastMat4f ------------------------------------
 
 	/// Component-wise addition of two matrices.
@@ -644,6 +672,64 @@ inline FFastVec4f fCompDiv(const FFastVec4f& v1, const FFastVec4f& v2)
 	return FFastVec4f(_mm_div_ps(v1.m_reg, v2.m_reg));
 }
 
+inline FFastVec4f fSin(const FFastVec4f& vec, FMath::Accuracy accuracy)
+{
+	__m128 s, c;
+	if (accuracy == FMath::Precise)
+		_fSinCos4<true>(vec.m_reg, s, c);
+	else
+		_fSinCos4<false>(vec.m_reg, s, c);
+	return FFastVec4f(s);
+}
+
+inline FFastVec4f fCos(const FFastVec4f& vec, FMath::Accuracy accuracy)
+{
+	__m128 s, c;
+	if (accuracy == FMath::Precise)
+		_fSinCos4<true>(vec.m_reg, s, c);
+	else
+		_fSinCos4<false>(vec.m_reg, s, c);
+	return FFastVec4f(c);
+}
+
+inline void fSinCos(const FFastVec4f& vec, FFastVec4f& sin, FFastVec4f& cos, FMath::Accuracy accuracy)
+{
+	if (accuracy == FMath::Precise)
+		_fSinCos4<true>(vec.m_reg, sin.m_reg, cos.m_reg);
+	else
+		_fSinCos4<false>(vec.m_reg, sin.m_reg, cos.m_reg);
+}
+
+inline FFastVec4f fExp(const FFastVec4f& vec, FMath::Accuracy accuracy)
+{
+	return FFastVec4f(accuracy == FMath::Precise
+		? _fExp4<true>(vec.m_reg) : _fExp4<false>(vec.m_reg));
+}
+
+inline FFastVec4f fLog(const FFastVec4f& vec, FMath::Accuracy accuracy)
+{
+	return FFastVec4f(accuracy == FMath::Precise
+		? _fLog4<true>(vec.m_reg) : _fLog4<false>(vec.m_reg));
+}
+
+inline FFastVec4f fPow(const FFastVec4f& base, const FFastVec4f& exponent, FMath::Accuracy accuracy)
+{
+	return FFastVec4f(accuracy == FMath::Precise
+		? _fPow4<true>(base.m_reg, exponent.m_reg) : _fPow4<false>(base.m_reg, exponent.m_reg));
+}
+
+inline FFastVec4f fAtan2(const FFastVec4f& y, const FFastVec4f& x, FMath::Accuracy accuracy)
+{
+	return FFastVec4f(accuracy == FMath::Precise
+		? _fAtan24<true>(y.m_reg, x.m_reg) : _fAtan24<false>(y.m_reg, x.m_reg));
+}
+
+inline FFastVec4f fAcos(const FFastVec4f& vec, FMath::Accuracy accuracy)
+{
+	return FFastVec4f(accuracy == FMath::Precise
+		? _fAcos4<true>(vec.m_reg) : _fAcos4<false>(vec.m_reg));
+}
+
 // -----------------------------------------------------------------------------
 
 #endif // FLOWCORE_FASTVEC_H
\ No newline at end of file
@@ -0,0 +1,722 @@
+// -----------------------------------------------------------------------------
+//  File        FastVec4d.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/17 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_FASTVEC4D_H
+#define FLOWCORE_FASTVEC4D_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Intrinsics.h"
+#include "FlowCore/Vector4T.h"
+#include "FlowCore/FastVec.h"
+
+#if (FLOW_INTRINSICS >= FLOW_INTRINSICS_AVX)
+#  include <immintrin.h>
+#  define FLOW_FASTVEC4D_AVX
+#endif
+
+// -----------------------------------------------------------------------------
+//  Register helpers
+// -----------------------------------------------------------------------------
+
+// A vector of four doubles is held in one 256-bit AVX register if the library
+// is compiled for AVX, otherwise in two 128-bit SSE2 registers. The helpers
+// below hide the difference from FFastVec4d and FFastMat4d.
+
+#ifdef FLOW_FASTVEC4D_AVX
+
+typedef __m256d _fReg4d;
+
+inline _fReg4d _fd4Zero() { return _mm256_setzero_pd(); }
+inline _fReg4d _fd4Set1(double v) { return _mm256_set1_pd(v); }
+inline _fReg4d _fd4Set(double x, double y, double z, double w) { return _mm256_setr_pd(x, y, z, w); }
+inline _fReg4d _fd4Load(const double* p) { return _mm256_load_pd(p); }
+inline _fReg4d _fd4LoadU(const double* p) { return _mm256_loadu_pd(p); }
+inline void _fd4Store(double* p, _fReg4d a) { _mm256_store_pd(p, a); }
+inline void _fd4StoreU(double* p, _fReg4d a) { _mm256_storeu_pd(p, a); }
+
+inline _fReg4d _fd4Add(_fReg4d a, _fReg4d b) { return _mm256_add_pd(a, b); }
+inline _fReg4d _fd4Sub(_fReg4d a, _fReg4d b) { return _mm256_sub_pd(a, b); }
+inline _fReg4d _fd4Mul(_fReg4d a, _fReg4d b) { return _mm256_mul_pd(a, b); }
+inline _fReg4d _fd4Div(_fReg4d a, _fReg4d b) { return _mm256_div_pd(a, b); }
+inline _fReg4d _fd4Min(_fReg4d a, _fReg4d b) { return _mm256_min_pd(a, b); }
+inline _fReg4d _fd4Max(_fReg4d a, _fReg4d b) { return _mm256_max_pd(a, b); }
+inline _fReg4d _fd4Xor(_fReg4d a, _fReg4d b) { return _mm256_xor_pd(a, b); }
+inline _fReg4d _fd4AndNot(_fReg4d a, _fReg4d b) { return _mm256_andnot_pd(a, b); }
+inline _fReg4d _fd4Sqrt(_fReg4d a) { return _mm256_sqrt_pd(a); }
+inline _fReg4d _fd4Floor(_fReg4d a) { return _mm256_floor_pd(a); }
+inline _fReg4d _fd4Ceil(_fReg4d a) { return _mm256_ceil_pd(a); }
+inline bool _fd4Equal(_fReg4d a, _fReg4d b) {
+	return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)) == 0xf;
+}
+
+/// Returns (y, z, x, w).
+inline _fReg4d _fd4Yzxw(_fReg4d a)
+{
+	__m256d s = _mm256_permute2f128_pd(a, a, 0x01);  // z w x y
+	__m256d t0 = _mm256_shuffle_pd(a, s, 0x1);       // y z . .
+	__m256d t1 = _mm256_shuffle_pd(s, a, 0x8);       // . . x w
+	return _mm256_blend_pd(t0, t1, 0xc);
+}
+
+/// Returns (a0 + a1 + a2 + a3) in the lowest element.
+inline __m128d _fd4HSum(_fReg4d a)
+{
+	__m128d t = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+	return _mm_add_sd(t, _mm_unpackhi_pd(t, t));
+}
+
+/// Returns the horizontal sums of the four given vectors.
+inline _fReg4d _fd4HSum4(_fReg4d a, _fReg4d b, _fReg4d c, _fReg4d d)
+{
+	__m256d t0 = _mm256_hadd_pd(a, b); // a01 b01 a23 b23
+	__m256d t1 = _mm256_hadd_pd(c, d); // c01 d01 c23 d23
+	return _mm256_add_pd(_mm256_permute2f128_pd(t0, t1, 0x20),
+	                     _mm256_permute2f128_pd(t0, t1, 0x31));
+}
+
+inline void _fd4Transpose(_fReg4d& r0, _fReg4d& r1, _fReg4d& r2, _fReg4d& r3)
+{
+	__m256d t0 = _mm256_unpacklo_pd(r0, r1); // 00 10 02 12
+	__m256d t1 = _mm256_unpackhi_pd(r0, r1); // 01 11 03 13
+	__m256d t2 = _mm256_unpacklo_pd(r2, r3); // 20 30 22 32
+	__m256d t3 = _mm256_unpackhi_pd(r2, r3); // 21 31 23 33
+	r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+	r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+	r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+	r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+inline __m128 _fd4ToFloat(_fReg4d a) { return _mm256_cvtpd_ps(a); }
+inline _fReg4d _fd4FromFloat(__m128 a) { return _mm256_cvtps_pd(a); }
+
+#else // FLOW_FASTVEC4D_AVX
+
+struct _fReg4d { __m128d lo, hi; };
+
+inline _fReg4d _fd4Make(__m128d lo, __m128d hi) { _fReg4d r = { lo, hi }; return r; }
+
+inline _fReg4d _fd4Zero() { return _fd4Make(_mm_setzero_pd(), _mm_setzero_pd()); }
+inline _fReg4d _fd4Set1(double v) { __m128d t = _mm_set1_pd(v); return _fd4Make(t, t); }
+inline _fReg4d _fd4Set(double x, double y, double z, double w) {
+	return _fd4Make(_mm_setr_pd(x, y), _mm_setr_pd(z, w));
+}
+inline _fReg4d _fd4Load(const double* p) { return _fd4Make(_mm_load_pd(p), _mm_load_pd(p + 2)); }
+inline _fReg4d _fd4LoadU(const double* p) { return _fd4Make(_mm_loadu_pd(p), _mm_loadu_pd(p + 2)); }
+inline void _fd4Store(double* p, _fReg4d a) { _mm_store_pd(p, a.lo); _mm_store_pd(p + 2, a.hi); }
+inline void _fd4StoreU(double* p, _fReg4d a) { _mm_storeu_pd(p, a.lo); _mm_storeu_pd(p + 2, a.hi); }
+
+#define _F_FD4_BINARY(name, op) \
+	inline _fReg4d name(_fReg4d a, _fReg4d b) { return _fd4Make(op(a.lo, b.lo), op(a.hi, b.hi)); }
+
+_F_FD4_BINARY(_fd4Add, _mm_add_pd)
+_F_FD4_BINARY(_fd4Sub, _mm_sub_pd)
+_F_FD4_BINARY(_fd4Mul, _mm_mul_pd)
+_F_FD4_BINARY(_fd4Div, _mm_div_pd)
+_F_FD4_BINARY(_fd4Min, _mm_min_pd)
+_F_FD4_BINARY(_fd4Max, _mm_max_pd)
+_F_FD4_BINARY(_fd4Xor, _mm_xor_pd)
+_F_FD4_BINARY(_fd4AndNot, _mm_andnot_pd)
+
+#undef _F_FD4_BINARY
+
+inline _fReg4d _fd4Sqrt(_fReg4d a) { return _fd4Make(_mm_sqrt_pd(a.lo), _mm_sqrt_pd(a.hi)); }
+inline _fReg4d _fd4Floor(_fReg4d a) { return _fd4Make(_mm_floor_pd(a.lo), _mm_floor_pd(a.hi)); }
+inline _fReg4d _fd4Ceil(_fReg4d a) { return _fd4Make(_mm_ceil_pd(a.lo), _mm_ceil_pd(a.hi)); }
+inline bool _fd4Equal(_fReg4d a, _fReg4d b) {
+	return (_mm_movemask_pd(_mm_cmpeq_pd(a.lo, b.lo)) & _mm_movemask_pd(_mm_cmpeq_pd(a.hi, b.hi))) == 0x3;
+}
+
+/// Returns (y, z, x, w).
+inline _fReg4d _fd4Yzxw(_fReg4d a)
+{
+	return _fd4Make(_mm_shuffle_pd(a.lo, a.hi, 0x1), _mm_shuffle_pd(a.lo, a.hi, 0x2));
+}
+
+/// Returns (a0 + a1 + a2 + a3) in the lowest element.
+inline __m128d _fd4HSum(_fReg4d a)
+{
+	__m128d t = _mm_add_pd(a.lo, a.hi);
+	return _mm_add_sd(t, _mm_unpackhi_pd(t, t));
+}
+
+/// Returns the horizontal sums of the four given vectors.
+inline _fReg4d _fd4HSum4(_fReg4d a, _fReg4d b, _fReg4d c, _fReg4d d)
+{
+	return _fd4Make(_mm_hadd_pd(_mm_add_pd(a.lo, a.hi), _mm_add_pd(b.lo, b.hi)),
+	                _mm_hadd_pd(_mm_add_pd(c.lo, c.hi), _mm_add_pd(d.lo, d.hi)));
+}
+
+inline void _fd4Transpose(_fReg4d& r0, _fReg4d& r1, _fReg4d& r2, _fReg4d& r3)
+{
+	_fReg4d t0 = _fd4Make(_mm_unpacklo_pd(r0.lo, r1.lo), _mm_unpacklo_pd(r2.lo, r3.lo));
+	_fReg4d t1 = _fd4Make(_mm_unpackhi_pd(r0.lo, r1.lo), _mm_unpackhi_pd(r2.lo, r3.lo));
+	_fReg4d t2 = _fd4Make(_mm_unpacklo_pd(r0.hi, r1.hi), _mm_unpacklo_pd(r2.hi, r3.hi));
+	_fReg4d t3 = _fd4Make(_mm_unpackhi_pd(r0.hi, r1.hi), _mm_unpackhi_pd(r2.hi, r3.hi));
+	r0 = t0; r1 = t1; r2 = t2; r3 = t3;
+}
+
+inline __m128 _fd4ToFloat(_fReg4d a) {
+	return _mm_movelh_ps(_mm_cvtpd_ps(a.lo), _mm_cvtpd_ps(a.hi));
+}
+inline _fReg4d _fd4FromFloat(__m128 a) {
+	return _fd4Make(_mm_cvtps_pd(a), _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+}
+
+#endif // FLOW_FASTVEC4D_AVX
+
+/// Returns a mask with only the sign bits set (-0.0).
+inline _fReg4d _fd4SignMask() { return _fd4Set1(-0.0); }
+
+// -----------------------------------------------------------------------------
+//  Class FFastVec4d
+// -----------------------------------------------------------------------------
+
+class FFastVec4d;
+class FFastMat4d;
+
+FFastMat4d operator*(const FFastMat4d& m1, const FFastMat4d& m2);
+FFastVec4d operator*(const FFastMat4d& mat, const FFastVec4d& vec);
+FFastVec4d operator*(const FFastVec4d& vec, const FFastMat4d& mat);
+FFastMat4d fOuterProduct(const FFastVec4d& v1, const FFastVec4d& v2);
+
+/// Double precision counterpart of FFastVec4f. Uses a 256-bit AVX register
+/// if available, two 128-bit SSE2 registers otherwise. Aligned copy functions
+/// require 32-byte alignment.
+class FLOWCORE_EXPORT FFastVec4d
+{
+	friend class FFastMat4d;
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Default constructor. Creates an uninitialized vector.
+	FFastVec4d() { }
+	/// Creates a vector from the given values.
+	FFastVec4d(double x, double y, double z, double w);
+	/// Creates a vector with all components set to the given scalar.
+	explicit FFastVec4d(double v);
+	/// Creates a vector from the given unaligned array of values.
+	explicit FFastVec4d(const double* pValues);
+	/// Loads a fast vector with the given vector.
+	explicit FFastVec4d(const FVector4d& vec);
+	/// Converts a single precision fast vector.
+	explicit FFastVec4d(const FFastVec4f& vec);
+
+private:
+	explicit FFastVec4d(_fReg4d reg);
+
+	//  Conversions and access ---------------------------------------
+
+public:
+	/// Conversion to FVector4d.
+	operator FVector4d() const;
+	/// Conversion to a single precision fast vector.
+	FFastVec4f toFloat() const;
+	/// Returns a text representation of the vector.
+	QString toString() const;
+
+	/// Sets the vector's components to the given values.
+	void set(double x, double y, double z, double w);
+	/// Sets all components to the given value.
+	void setAll(double v);
+	/// Copies the values from the given FVector4d.
+	void set(const FVector4d& vec);
+
+	/// Index access.
+	double& operator[](size_t index);
+	/// Const index access.
+	const double& operator[](size_t index) const;
+
+	/// Copies the vector's components to the given 32-byte aligned array.
+	void copyToAligned(double* pValues) const;
+	/// Copies the vector's components to the given unaligned array.
+	void copyTo(double* pValues) const;
+	/// Copies the vector's components from the given 32-byte aligned array.
+	void copyFromAligned(const double* pValues);
+	/// Copies the vector's components from the given unaligned array.
+	void copyFrom(const double* pValues);
+
+	//  Operators ----------------------------------------------------
+
+	/// Component-wise addition of two vectors: Compound-assignment.
+	FFastVec4d& operator+=(const FFastVec4d& vec);
+	/// Component-wise addition of a scalar: Compound-assignment.
+	FFastVec4d& operator+=(double scalar);
+	/// Component-wise subtraction of two vectors: Compound-assignment.
+	FFastVec4d& operator-=(const FFastVec4d& vec);
+	/// Component-wise subtraction of a scalar: Compound-assignment.
+	FFastVec4d& operator-=(double scalar);
+	/// Component-wise scalar multiplication: Compound assignment.
+	FFastVec4d& operator*=(double scalar);
+	/// Component-wise scalar division: Compound assignment.
+	FFastVec4d& operator/=(double scalar);
+
+	/// Returns true if all components of two vectors are equal.
+	bool operator==(const FFastVec4d& vec) const;
+	/// Returns true if at least one component of the two vectors is different.
+	bool operator!=(const FFastVec4d& vec) const;
+
+	//  Public commands ----------------------------------------------
+
+	/// Sets all components of the vector to zero.
+	void setZero();
+	/// Normalizes the vector to unit length.
+	void normalize();
+	/// Homogenization of the vector by dividing it by its last component.
+	void homogenize();
+	/// Projects the vector onto the given vector.
+	void project(const FFastVec4d& vec);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the 2-norm (length) of the vector.
+	double length() const;
+	/// Returns the squared 2-norm of the vector.
+	double lengthSquared() const;
+	/// Returns the normalized vector (unit length).
+	FFastVec4d normalized() const;
+	/// Returns the homogenized vector.
+	FFastVec4d homogenized() const;
+	/// Returns the projection of this vector onto the given vector.
+	FFastVec4d projected(const FFastVec4d& vec) const;
+
+	/// Returns the component-wise absolute value.
+	FFastVec4d abs() const;
+	/// Returns the component-wise square root.
+	FFastVec4d sqrt() const;
+	/// Returns the component-wise floor.
+	FFastVec4d floor() const;
+	/// Returns the component-wise ceiling.
+	FFastVec4d ceil() const;
+
+	/// Returns the minimum component of the vector.
+	double min() const;
+	/// Returns the maximum component of the vector.
+	double max() const;
+	/// Returns the sum of all components of the vector.
+	double sum() const;
+
+	/// Returns the dot product of this and the given vector.
+	double dot(const FFastVec4d& vec) const;
+	/// Returns the cross product of the first 3 components of this and the
+	/// given vector. The 4th component of the result is set to zero.
+	FFastVec4d cross(const FFastVec4d& vec) const;
+	/// Linear interpolation between two vectors.
+	FFastVec4d lerp(const FFastVec4d& vec, double factor) const;
+
+	//  Related non-member functions ---------------------------------
+
+	/// Unary minus.
+	friend FFastVec4d operator-(const FFastVec4d& vec);
+	/// Addition of two vectors.
+	friend FFastVec4d operator+(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Component-wise addition of a vector and a scalar.
+	friend FFastVec4d operator+(const FFastVec4d& vec, double scalar);
+	/// Component-wise addition of a scalar and a vector.
+	friend FFastVec4d operator+(double scalar, const FFastVec4d& vec);
+	/// Subtraction of two vectors.
+	friend FFastVec4d operator-(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Component-wise subtraction of a vector and a scalar.
+	friend FFastVec4d operator-(const FFastVec4d& vec, double scalar);
+	/// Component-wise subtraction of a scalar and a vector.
+	friend FFastVec4d operator-(double scalar, const FFastVec4d& vec);
+	/// Component-wise multiplication of a vector and a scalar.
+	friend FFastVec4d operator*(const FFastVec4d& vec, double scalar);
+	/// Component-wise multiplication of a scalar and a vector.
+	friend FFastVec4d operator*(double scalar, const FFastVec4d& vec);
+	/// Component-wise division of a vector and a scalar.
+	friend FFastVec4d operator/(const FFastVec4d& vec, double scalar);
+	/// Component-wise division of a scalar and a vector.
+	friend FFastVec4d operator/(double scalar, const FFastVec4d& vec);
+	/// Dot product (inner products) of two vectors.
+	friend double operator*(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Dot product (inner product) of two vectors.
+	friend double fDot(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Cross product (outer product) of two vectors.
+	friend FFastVec4d fCross(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Returns the component-wise minimum of two vectors.
+	friend FFastVec4d fMin(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Returns the component-wise maximum of two vectors.
+	friend FFastVec4d fMax(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Linear interpolation between two vectors.
+	friend FFastVec4d fLerp(const FFastVec4d& v1, const FFastVec4d& v2, double factor);
+	/// Component-wise multiplication of two vectors.
+	friend FFastVec4d fCompMul(const FFastVec4d& v1, const FFastVec4d& v2);
+	/// Component-wise division of two vectors.
+	friend FFastVec4d fCompDiv(const FFastVec4d& v1, const FFastVec4d& v2);
+
+	//  Implemented in FFastMat4d ------------------------------------
+
+	/// Matrix-matrix multiplication.
+	friend FFastMat4d operator*(const FFastMat4d& m1, const FFastMat4d& m2);
+	/// Matrix-vector multiplication.
+	friend FFastVec4d operator*(const FFastMat4d& mat, const FFastVec4d& vec);
+	/// Vector-matrix multiplication.
+	friend FFastVec4d operator*(const FFastVec4d& vec, const FFastMat4d& mat);
+	/// Outer product of two vectors.
+	friend FFastMat4d fOuterProduct(const FFastVec4d& v1, const FFastVec4d& v2);
+
+	//  Internal data members ----------------------------------------
+
+private:
+	_fReg4d m_reg;
+};
+
+// Constructors ----------------------------------------------------------------
+
+inline FFastVec4d::FFastVec4d(double x, double y, double z, double w)
+{
+	m_reg = _fd4Set(x, y, z, w);
+}
+
+inline FFastVec4d::FFastVec4d(double v)
+{
+	m_reg = _fd4Set1(v);
+}
+
+inline FFastVec4d::FFastVec4d(const double* pValues)
+{
+	m_reg = _fd4LoadU(pValues);
+}
+
+inline FFastVec4d::FFastVec4d(const FVector4d& vec)
+{
+	m_reg = _fd4LoadU(vec.ptr());
+}
+
+inline FFastVec4d::FFastVec4d(const FFastVec4f& vec)
+{
+	F_ALIGN(16) float v[4];
+	vec.copyToAligned(v);
+	m_reg = _fd4FromFloat(_mm_load_ps(v));
+}
+
+inline FFastVec4d::FFastVec4d(_fReg4d reg)
+{
+	m_reg = reg;
+}
+
+// Conversion ------------------------------------------------------------------
+
+inline FFastVec4d::operator FVector4d() const
+{
+	FVector4d result;
+	_fd4StoreU(result.ptr(), m_reg);
+	return result;
+}
+
+inline FFastVec4f FFastVec4d::toFloat() const
+{
+	F_ALIGN(16) float v[4];
+	_mm_store_ps(v, _fd4ToFloat(m_reg));
+	return FFastVec4f(v);
+}
+
+inline QString FFastVec4d::toString() const
+{
+	return FVector4d(*this).toString();
+}
+
+// Access ----------------------------------------------------------------------
+
+inline void FFastVec4d::set(double x, double y, double z, double w)
+{
+	m_reg = _fd4Set(x, y, z, w);
+}
+
+inline void FFastVec4d::setAll(double v)
+{
+	m_reg = _fd4Set1(v);
+}
+
+inline void FFastVec4d::set(const FVector4d& vec)
+{
+	m_reg = _fd4LoadU(vec.ptr());
+}
+
+inline double& FFastVec4d::operator[](size_t index)
+{
+	F_ASSERT(index < 4);
+	return ((double*)&m_reg)[index];
+}
+
+inline const double& FFastVec4d::operator[](size_t index) const
+{
+	F_ASSERT(index < 4);
+	return ((const double*)&m_reg)[index];
+}
+
+inline void FFastVec4d::copyToAligned(double* pValues) const
+{
+	_fd4Store(pValues, m_reg);
+}
+
+inline void FFastVec4d::copyTo(double* pValues) const
+{
+	_fd4StoreU(pValues, m_reg);
+}
+
+inline void FFastVec4d::copyFromAligned(const double* pValues)
+{
+	m_reg = _fd4Load(pValues);
+}
+
+inline void FFastVec4d::copyFrom(const double* pValues)
+{
+	m_reg = _fd4LoadU(pValues);
+}
+
+// Operators -------------------------------------------------------------------
+
+inline FFastVec4d& FFastVec4d::operator+=(const FFastVec4d& vec) {
+	m_reg = _fd4Add(m_reg, vec.m_reg);
+	return *this;
+}
+
+inline FFastVec4d& FFastVec4d::operator+=(double scalar) {
+	m_reg = _fd4Add(m_reg, _fd4Set1(scalar));
+	return *this;
+}
+
+inline FFastVec4d& FFastVec4d::operator-=(const FFastVec4d& vec) {
+	m_reg = _fd4Sub(m_reg, vec.m_reg);
+	return *this;
+}
+
+inline FFastVec4d& FFastVec4d::operator-=(double scalar) {
+	m_reg = _fd4Sub(m_reg, _fd4Set1(scalar));
+	return *this;
+}
+
+inline FFastVec4d& FFastVec4d::operator*=(double scalar) {
+	m_reg = _fd4Mul(m_reg, _fd4Set1(scalar));
+	return *this;
+}
+
+inline FFastVec4d& FFastVec4d::operator/=(double scalar) {
+	m_reg = _fd4Div(m_reg, _fd4Set1(scalar));
+	return *this;
+}
+
+inline bool FFastVec4d::operator==(const FFastVec4d& vec) const {
+	return _fd4Equal(m_reg, vec.m_reg);
+}
+
+inline bool FFastVec4d::operator!=(const FFastVec4d& vec) const {
+	return !(*this == vec);
+}
+
+// Public commands -------------------------------------------------------------
+
+inline void FFastVec4d::setZero()
+{
+	m_reg = _fd4Zero();
+}
+
+inline void FFastVec4d::normalize()
+{
+	m_reg = _fd4Div(m_reg, _fd4Set1(length()));
+}
+
+inline void FFastVec4d::homogenize()
+{
+	m_reg = _fd4Div(m_reg, _fd4Set1((*this)[3]));
+}
+
+inline void FFastVec4d::project(const FFastVec4d& vec)
+{
+	*this = vec * (this->dot(vec) / vec.lengthSquared());
+}
+
+// Public queries --------------------------------------------------------------
+
+inline double FFastVec4d::length() const
+{
+	return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _fd4HSum(_fd4Mul(m_reg, m_reg))));
+}
+
+inline double FFastVec4d::lengthSquared() const
+{
+	return _mm_cvtsd_f64(_fd4HSum(_fd4Mul(m_reg, m_reg)));
+}
+
+inline FFastVec4d FFastVec4d::normalized() const
+{
+	FFastVec4d t(*this);
+	t.normalize();
+	return t;
+}
+
+inline FFastVec4d FFastVec4d::homogenized() const
+{
+	FFastVec4d t(*this);
+	t.homogenize();
+	return t;
+}
+
+inline FFastVec4d FFastVec4d::projected(const FFastVec4d& vec) const
+{
+	return vec * (this->dot(vec) / vec.lengthSquared());
+}
+
+inline FFastVec4d FFastVec4d::abs() const
+{
+	return FFastVec4d(_fd4AndNot(_fd4SignMask(), m_reg));
+}
+
+inline FFastVec4d FFastVec4d::sqrt() const
+{
+	return FFastVec4d(_fd4Sqrt(m_reg));
+}
+
+inline FFastVec4d FFastVec4d::floor() const
+{
+	return FFastVec4d(_fd4Floor(m_reg));
+}
+
+inline FFastVec4d FFastVec4d::ceil() const
+{
+	return FFastVec4d(_fd4Ceil(m_reg));
+}
+
+inline double FFastVec4d::min() const
+{
+	const double* v = (const double*)&m_reg;
+	return fMin(fMin(v[0], v[1]), fMin(v[2], v[3]));
+}
+
+inline double FFastVec4d::max() const
+{
+	const double* v = (const double*)&m_reg;
+	return fMax(fMax(v[0], v[1]), fMax(v[2], v[3]));
+}
+
+inline double FFastVec4d::sum() const
+{
+	return _mm_cvtsd_f64(_fd4HSum(m_reg));
+}
+
+inline double FFastVec4d::dot(const FFastVec4d& vec) const
+{
+	return _mm_cvtsd_f64(_fd4HSum(_fd4Mul(m_reg, vec.m_reg)));
+}
+
+inline FFastVec4d FFastVec4d::cross(const FFastVec4d& vec) const
+{
+	return fCross(*this, vec);
+}
+
+inline FFastVec4d FFastVec4d::lerp(const FFastVec4d& vec, double factor) const
+{
+	return *this + factor * (vec - *this);
+}
+
+// Related non-member functions ------------------------------------------------
+
+inline FFastVec4d operator-(const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4Xor(vec.m_reg, _fd4SignMask()));
+}
+
+inline FFastVec4d operator+(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Add(v1.m_reg, v2.m_reg));
+}
+
+inline FFastVec4d operator+(const FFastVec4d& vec, double scalar)
+{
+	return FFastVec4d(_fd4Add(vec.m_reg, _fd4Set1(scalar)));
+}
+
+inline FFastVec4d operator+(double scalar, const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4Add(_fd4Set1(scalar), vec.m_reg));
+}
+
+inline FFastVec4d operator-(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Sub(v1.m_reg, v2.m_reg));
+}
+
+inline FFastVec4d operator-(const FFastVec4d& vec, double scalar)
+{
+	return FFastVec4d(_fd4Sub(vec.m_reg, _fd4Set1(scalar)));
+}
+
+inline FFastVec4d operator-(double scalar, const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4Sub(_fd4Set1(scalar), vec.m_reg));
+}
+
+inline FFastVec4d operator*(const FFastVec4d& vec, double scalar)
+{
+	return FFastVec4d(_fd4Mul(vec.m_reg, _fd4Set1(scalar)));
+}
+
+inline FFastVec4d operator*(double scalar, const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4Mul(_fd4Set1(scalar), vec.m_reg));
+}
+
+inline FFastVec4d operator/(const FFastVec4d& vec, double scalar)
+{
+	return FFastVec4d(_fd4Div(vec.m_reg, _fd4Set1(scalar)));
+}
+
+inline FFastVec4d operator/(double scalar, const FFastVec4d& vec)
+{
+	return FFastVec4d(_fd4Div(_fd4Set1(scalar), vec.m_reg));
+}
+
+inline double operator*(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return v1.dot(v2);
+}
+
+inline double fDot(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return v1.dot(v2);
+}
+
+inline FFastVec4d fCross(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	// (a * b.yzx - a.yzx * b).yzx, the w component cancels out
+	_fReg4d t0 = _fd4Mul(v1.m_reg, _fd4Yzxw(v2.m_reg));
+	_fReg4d t1 = _fd4Mul(_fd4Yzxw(v1.m_reg), v2.m_reg);
+	return FFastVec4d(_fd4Yzxw(_fd4Sub(t0, t1)));
+}
+
+inline FFastVec4d fMin(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Min(v1.m_reg, v2.m_reg));
+}
+
+inline FFastVec4d fMax(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Max(v1.m_reg, v2.m_reg));
+}
+
+inline FFastVec4d fLerp(const FFastVec4d& v1, const FFastVec4d& v2, double factor)
+{
+	return v1 + factor * (v2 - v1);
+}
+
+inline FFastVec4d fCompMul(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Mul(v1.m_reg, v2.m_reg));
+}
+
+inline FFastVec4d fCompDiv(const FFastVec4d& v1, const FFastVec4d& v2)
+{
+	return FFastVec4d(_fd4Div(v1.m_reg, v2.m_reg));
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_FASTVEC4D_H
@@ -0,0 +1,140 @@
+// -----------------------------------------------------------------------------
+//  File        Frustum.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/20 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_FRUSTUM_H
+#define FLOWCORE_FRUSTUM_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Matrix4T.h"
+#include "FlowCore/Range3T.h"
+#include "FlowCore/Vector4T.h"
+
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+//  Class FFrustum
+// -----------------------------------------------------------------------------
+
+/// View frustum given by 6 planes. The planes are extracted from a combined
+/// view-projection matrix as produced by the FMatrix4T::makeProjectionXXX()
+/// functions, i.e. for column vectors and a clip space depth range of [0, w].
+/// Plane normals point inside and are normalized, such that
+/// a * x + b * y + c * z + d is the signed distance of a point.
+class FFrustum
+{
+	//  Public types -------------------------------------------------
+
+public:
+	enum Plane
+	{
+		Left = 0,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+	FFrustum() { }
+	template <typename REAL>
+	explicit FFrustum(const FMatrix4T<REAL>& viewProjection) { set(viewProjection); }
+
+	//  Public commands ----------------------------------------------
+
+public:
+	/// Extracts the planes from the given view-projection matrix.
+	template <typename REAL>
+	void set(const FMatrix4T<REAL>& viewProjection);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the coefficients a, b, c, d of the given plane.
+	FVector4f plane(Plane index) const;
+	/// Returns a pointer to the coefficients of all 6 planes (24 floats).
+	const float* planes() const { return m_planes[0]; }
+
+	/// Returns true if the given point lies inside the frustum.
+	bool includes(const FVector3f& point) const;
+	/// Returns true if the given box lies at least partially inside the
+	/// frustum. The test is conservative, boxes which are outside but
+	/// close to a corner of the frustum may be reported as intersecting.
+	bool intersects(const FRange3f& box) const;
+
+	//  Internal data members ----------------------------------------
+
+private:
+	F_ALIGN(16) float m_planes[6][4];
+};
+
+// Members ---------------------------------------------------------------------
+
+template <typename REAL>
+void FFrustum::set(const FMatrix4T<REAL>& viewProjection)
+{
+	const FMatrix4T<REAL>& m = viewProjection;
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		m_planes[Left][i]   = float(m[3][i] + m[0][i]);
+		m_planes[Right][i]  = float(m[3][i] - m[0][i]);
+		m_planes[Bottom][i] = float(m[3][i] + m[1][i]);
+		m_planes[Top][i]    = float(m[3][i] - m[1][i]);
+		m_planes[Near][i]   = float(m[2][i]);
+		m_planes[Far][i]    = float(m[3][i] - m[2][i]);
+	}
+
+	for (size_t k = 0; k < 6; ++k)
+	{
+		float* p = m_planes[k];
+		float length = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+		if (length > 0.0f) {
+			float invLength = 1.0f / length;
+			p[0] *= invLength; p[1] *= invLength; p[2] *= invLength; p[3] *= invLength;
+		}
+	}
+}
+
+inline FVector4f FFrustum::plane(Plane index) const
+{
+	const float* p = m_planes[index];
+	return FVector4f(p[0], p[1], p[2], p[3]);
+}
+
+inline bool FFrustum::includes(const FVector3f& point) const
+{
+	for (size_t k = 0; k < 6; ++k) {
+		const float* p = m_planes[k];
+		if (p[0] * point.x + p[1] * point.y + p[2] * point.z + p[3] < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+inline bool FFrustum::intersects(const FRange3f& box) const
+{
+	FVector3f center = (box.lowerBound() + box.upperBound()) * 0.5f;
+	FVector3f extent = box.size() * 0.5f;
+
+	for (size_t k = 0; k < 6; ++k) {
+		const float* p = m_planes[k];
+		float dist = p[0] * center.x + p[1] * center.y + p[2] * center.z + p[3]
+			+ fabsf(p[0]) * extent.x + fabsf(p[1]) * extent.y + fabsf(p[2]) * extent.z;
+		if (dist < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_FRUSTUM_H
@@ -0,0 +1,512 @@
+// -----------------------------------------------------------------------------
+//  File        IndexedArchive.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/IndexedArchive.h"
+#include "FlowCore/Archive.h"
+#include "FlowCore/TypeInfo.h"
+#include "FlowCore/TypeRegistry.h"
+#include "FlowCore/Log.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QMutex>
+
+// Helpers ---------------------------------------------------------------------
+
+// Layout of the archive:
+// sections   serialized object, per object
+// index      quint32 class count
+//            class name, quint32 version, per class
+//            quint16 class tag, quint64 offset, quint64 size, per object
+// trailer    quint64 index offset, quint64 archive size, quint32 object count, "FIDX"
+
+static const quint32 _indexMagic = 0x46494458;
+static const qint64 _trailerSize = 24;
+static const quint64 _minClassSize = 8;
+static const quint64 _minEntrySize = 18;
+
+// -----------------------------------------------------------------------------
+//  Class FIndexedArchive::loadTask_t
+// -----------------------------------------------------------------------------
+
+/// Loads sections of an indexed archive, taking the next pending section
+/// until all sections have been loaded. Several tasks run concurrently.
+/// Sections are read from memory, or one at a time from the device, which
+/// is shared by all tasks and protected by the device lock.
+class FIndexedArchive::loadTask_t : public QRunnable
+{
+public:
+	loadTask_t(FIndexedArchive* pArchive, const char* pData, QMutex* pDeviceLock,
+		const std::vector<quint32>* pTags, QAtomicInt* pNext, QAtomicInt* pFailed)
+	: m_pArchive(pArchive), m_pData(pData), m_pDeviceLock(pDeviceLock),
+	  m_pTags(pTags), m_pNext(pNext), m_pFailed(pFailed) { }
+
+	virtual void run()
+	{
+		for (;;)
+		{
+			size_t i = size_t(m_pNext->fetchAndAddRelaxed(1));
+			if (i >= m_pTags->size())
+				return;
+
+			quint32 tag = (*m_pTags)[i];
+			const entry_t& entry = m_pArchive->m_entries[tag - 1];
+
+			if (m_pData) {
+				FArchive archive(m_pData + entry.offset, size_t(entry.size));
+				if (!m_pArchive->_readObject(&archive, tag))
+					m_pFailed->ref();
+				continue;
+			}
+
+			QByteArray section;
+			{
+				QMutexLocker locker(m_pDeviceLock);
+				QIODevice* pDevice = m_pArchive->m_pDevice;
+				if (pDevice->seek(m_pArchive->m_start + qint64(entry.offset)))
+					section = pDevice->read(qint64(entry.size));
+			}
+
+			if (quint64(section.size()) != entry.size) {
+				F_WARNING("FIndexedArchive") << "failed to read section of object " << tag;
+				m_pFailed->ref();
+				continue;
+			}
+
+			FArchive archive(section.constData(), size_t(section.size()));
+			if (!m_pArchive->_readObject(&archive, tag))
+				m_pFailed->ref();
+		}
+	}
+
+private:
+	FIndexedArchive* m_pArchive;
+	const char* m_pData;
+	QMutex* m_pDeviceLock;
+	const std::vector<quint32>* m_pTags;
+	QAtomicInt* m_pNext;
+	QAtomicInt* m_pFailed;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FIndexedArchive
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FIndexedArchive::FIndexedArchive(QIODevice* pDevice)
+: m_pDevice(pDevice),
+  m_pData(NULL),
+  m_start(0),
+  m_indexOffset(0),
+  m_isWriting(pDevice->isWritable()),
+  m_isWritten(false),
+  m_isValid(true)
+{
+	// writing requires only the position, reading must be random access
+	if (m_isWriting) {
+		m_start = pDevice->pos();
+	}
+	else {
+		F_ASSERT(!pDevice->isSequential());
+		m_isValid = _readIndex(pDevice->size());
+	}
+}
+
+FIndexedArchive::FIndexedArchive(const QByteArray& buffer)
+: m_pDevice(NULL),
+  m_buffer(buffer),
+  m_pData(m_buffer.constData()),
+  m_start(0),
+  m_indexOffset(0),
+  m_isWriting(false),
+  m_isWritten(false),
+  m_isValid(false)
+{
+	m_isValid = _readIndex(m_buffer.size());
+}
+
+FIndexedArchive::FIndexedArchive(const char* pData, size_t size)
+: m_pDevice(NULL),
+  m_pData(pData),
+  m_start(0),
+  m_indexOffset(0),
+  m_isWriting(false),
+  m_isWritten(false),
+  m_isValid(false)
+{
+	m_isValid = _readIndex(qint64(size));
+}
+
+FIndexedArchive::~FIndexedArchive()
+{
+	if (m_isWriting && !m_isWritten)
+		write();
+}
+
+// Public commands -------------------------------------------------------------
+
+quint32 FIndexedArchive::addObject(const FObject* pObject)
+{
+	F_ASSERT(m_isWriting && !m_isWritten);
+	F_ASSERT(pObject);
+
+	quint32 tag = _tagOf(pObject);
+	if (tag)
+		return tag;
+
+	entry_t entry;
+	entry.offset = 0;
+	entry.size = 0;
+	entry.classTag = _writeClassTag(pObject->dynamicType());
+	entry.pWriteObject = pObject;
+	entry.pReadObject = NULL;
+	entry.isLoaded = false;
+	m_entries.push_back(entry);
+
+	tag = quint32(m_entries.size());
+	m_tagTable.insert(objTagTable_t::value_type(pObject, tag));
+	return tag;
+}
+
+void FIndexedArchive::write()
+{
+	F_ASSERT(m_isWriting && !m_isWritten);
+	m_isWritten = true;
+
+	// each object is written to its own section, references to other
+	// top-level objects are resolved through the index (see FArchive)
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		entry_t& entry = m_entries[i];
+		entry.offset = quint64(m_pDevice->pos() - m_start);
+
+		FArchive archive(m_pDevice);
+		archive.m_pIndex = this;
+		const_cast<FObject*>(entry.pWriteObject)->serialize(archive);
+
+		entry.size = quint64(m_pDevice->pos() - m_start) - entry.offset;
+	}
+
+	quint64 indexOffset = quint64(m_pDevice->pos() - m_start);
+	FArchive archive(m_pDevice, false);
+
+	archive << quint32(m_classes.size());
+	for (size_t i = 0; i < m_classes.size(); ++i) {
+		const class_t& info = m_classes[i];
+		archive << info.name.constData() << info.version;
+	}
+
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		const entry_t& entry = m_entries[i];
+		archive << entry.classTag << entry.offset << entry.size;
+	}
+
+	quint64 archiveSize = quint64(m_pDevice->pos() - m_start) + _trailerSize;
+	archive << indexOffset << archiveSize << quint32(m_entries.size()) << _indexMagic;
+}
+
+FObject* FIndexedArchive::loadObject(quint32 tag)
+{
+	F_ASSERT(!m_isWriting);
+
+	if (tag == 0 || tag > m_entries.size())
+		return NULL;
+
+	// objects are registered before they are read, to resolve cyclic
+	// references, and created before the sections are read by loadAll()
+	entry_t& entry = m_entries[tag - 1];
+	if (entry.pReadObject)
+		return entry.pReadObject;
+
+	const class_t& info = m_classes[entry.classTag];
+	if (!info.pClass) {
+		F_WARNING("FIndexedArchive") << "unknown class '"
+			<< info.name.constData() << "'";
+		return NULL;
+	}
+
+	// abstract classes can't be instantiated
+	entry.pReadObject = info.pClass->createObject();
+	if (!entry.pReadObject) {
+		F_WARNING("FIndexedArchive") << "failed to create object of class '"
+			<< info.name.constData() << "'";
+		return NULL;
+	}
+
+	// when called while loading another object from a device,
+	// reading continues at the current position afterwards
+	qint64 resumePos = m_pDevice ? m_pDevice->pos() : 0;
+
+	FArchive* pArchive = _createReader(entry.offset, entry.size);
+	bool isRead = _readObject(pArchive, tag);
+	F_SAFE_DELETE(pArchive);
+
+	if (m_pDevice)
+		m_pDevice->seek(resumePos);
+
+	// a partially read object is discarded
+	if (!isRead) {
+		F_SAFE_DELETE(entry.pReadObject);
+		return NULL;
+	}
+
+	return entry.pReadObject;
+}
+
+bool FIndexedArchive::loadAll(int threadCount /* = 0 */)
+{
+	F_ASSERT(!m_isWriting);
+
+	if (!m_isValid)
+		return false;
+
+	// sections are read from memory, or each section from the device
+	const char* pData = m_pData ? m_pData + m_start : NULL;
+	QMutex deviceLock;
+
+	// all objects are created before any section is read, references
+	// between sections resolve to the created objects
+	std::vector<quint32> tags;
+	bool isComplete = true;
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		entry_t& entry = m_entries[i];
+		if (entry.pReadObject)
+			continue;
+
+		const class_t& info = m_classes[entry.classTag];
+		if (!info.pClass) {
+			F_WARNING("FIndexedArchive") << "unknown class '"
+				<< info.name.constData() << "'";
+			isComplete = false;
+			continue;
+		}
+
+		entry.pReadObject = info.pClass->createObject();
+		if (!entry.pReadObject) {
+			F_WARNING("FIndexedArchive") << "failed to create object of class '"
+				<< info.name.constData() << "'";
+			isComplete = false;
+			continue;
+		}
+
+		tags.push_back(quint32(i + 1));
+	}
+
+	if (threadCount <= 0)
+		threadCount = QThread::idealThreadCount();
+	threadCount = int(fMin(size_t(threadCount), tags.size()));
+
+	QAtomicInt next(0);
+	QAtomicInt failed(0);
+
+	if (threadCount > 0)
+	{
+		QThreadPool pool;
+		pool.setMaxThreadCount(threadCount);
+
+		for (int i = 0; i < threadCount; ++i)
+			pool.start(new loadTask_t(this, pData, &deviceLock, &tags, &next, &failed));
+
+		pool.waitForDone();
+	}
+
+	// partially read objects are discarded, as by loadObject(), a later
+	// call to loadObject() tries to load them again
+	for (size_t i = 0; i < tags.size(); ++i) {
+		entry_t& entry = m_entries[tags[i] - 1];
+		if (!entry.isLoaded)
+			F_SAFE_DELETE(entry.pReadObject);
+	}
+
+	return isComplete && failed.load() == 0;
+}
+
+// Public queries --------------------------------------------------------------
+
+const FTypeInfo* FIndexedArchive::objectClass(quint32 tag) const
+{
+	return tag > 0 && tag <= m_entries.size()
+		? m_classes[m_entries[tag - 1].classTag].pClass : NULL;
+}
+
+quint64 FIndexedArchive::objectSize(quint32 tag) const
+{
+	return tag > 0 && tag <= m_entries.size() ? m_entries[tag - 1].size : 0;
+}
+
+bool FIndexedArchive::isLoaded(quint32 tag) const
+{
+	return tag > 0 && tag <= m_entries.size() && m_entries[tag - 1].isLoaded;
+}
+
+std::vector<quint32> FIndexedArchive::findObjects(const FTypeInfo* pBaseClass) const
+{
+	std::vector<quint32> result;
+
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		const FTypeInfo* pClass = m_classes[m_entries[i].classTag].pClass;
+		if (pClass && pClass->isDerivedFrom(pBaseClass))
+			result.push_back(quint32(i + 1));
+	}
+
+	return result;
+}
+
+// Internal functions ----------------------------------------------------------
+
+bool FIndexedArchive::_readIndex(qint64 endPos)
+{
+	if (endPos < _trailerSize)
+		return false;
+
+	quint64 indexOffset, archiveSize;
+	quint32 objectCount, magic;
+
+	FArchive* pArchive = _createReader(endPos - _trailerSize, _trailerSize);
+	*pArchive >> indexOffset >> archiveSize >> objectCount >> magic;
+	F_SAFE_DELETE(pArchive);
+
+	if (magic != _indexMagic || archiveSize > quint64(endPos) || archiveSize < _trailerSize
+			|| indexOffset > archiveSize - _trailerSize) {
+		F_WARNING("FIndexedArchive") << "no valid archive index found";
+		return false;
+	}
+
+	m_start = endPos - qint64(archiveSize);
+	m_indexOffset = indexOffset;
+
+	quint64 indexSize = archiveSize - _trailerSize - indexOffset;
+	pArchive = _createReader(indexOffset, indexSize);
+
+	quint32 classCount = 0;
+	*pArchive >> classCount;
+
+	// reject counts the index is too small for, before allocating
+	bool isValid = classCount <= 0xffff
+		&& 4 + quint64(classCount) * _minClassSize
+			+ quint64(objectCount) * _minEntrySize <= indexSize;
+
+	if (isValid)
+	{
+		FTypeRegistry* pRegistry = FTypeRegistry::instance();
+		m_classes.resize(classCount);
+
+		for (size_t i = 0; i < m_classes.size(); ++i)
+		{
+			class_t& info = m_classes[i];
+			const char* className = pArchive->readStringView();
+			*pArchive >> info.version;
+
+			info.name = className;
+			info.pClass = className ? pRegistry->classFromName(className) : NULL;
+		}
+
+		m_entries.resize(objectCount);
+
+		for (size_t i = 0; i < m_entries.size(); ++i)
+		{
+			entry_t& entry = m_entries[i];
+			*pArchive >> entry.classTag >> entry.offset >> entry.size;
+
+			entry.pWriteObject = NULL;
+			entry.pReadObject = NULL;
+			entry.isLoaded = false;
+		}
+
+		isValid = pArchive->status() == QDataStream::Ok;
+	}
+
+	F_SAFE_DELETE(pArchive);
+
+	// sections must be located before the index
+	for (size_t i = 0; i < m_entries.size() && isValid; ++i) {
+		const entry_t& entry = m_entries[i];
+		isValid = entry.classTag < m_classes.size()
+			&& entry.offset <= indexOffset && entry.size <= indexOffset - entry.offset;
+	}
+
+	if (!isValid) {
+		F_WARNING("FIndexedArchive") << "archive index is corrupt";
+		m_classes.clear();
+		m_entries.clear();
+	}
+
+	return isValid;
+}
+
+FArchive* FIndexedArchive::_createReader(quint64 offset, quint64 size)
+{
+	if (m_pData)
+		return new FArchive(m_pData + m_start + offset, size_t(size));
+
+	m_pDevice->seek(m_start + qint64(offset));
+	return new FArchive(m_pDevice);
+}
+
+bool FIndexedArchive::_readObject(FArchive* pArchive, quint32 tag)
+{
+	entry_t& entry = m_entries[tag - 1];
+	F_ASSERT(entry.pReadObject);
+
+	pArchive->m_pIndex = this;
+	pArchive->m_currentVersion = m_classes[entry.classTag].version;
+	entry.pReadObject->serialize(*pArchive);
+	pArchive->m_currentVersion = 0;
+
+	if (pArchive->status() != QDataStream::Ok) {
+		F_WARNING("FIndexedArchive") << "failed to read object " << tag;
+		return false;
+	}
+
+	entry.isLoaded = true;
+	return true;
+}
+
+quint32 FIndexedArchive::_tagOf(const FObject* pObject) const
+{
+	objTagTable_t::const_iterator it = m_tagTable.find(pObject);
+	return it != m_tagTable.end() ? it->second : 0;
+}
+
+uint16_t FIndexedArchive::_writeClassTag(const FTypeInfo* pClass)
+{
+	classTagTable_t::const_iterator it = m_classTagTable.find(pClass);
+	if (it != m_classTagTable.end())
+		return it->second;
+
+	F_ASSERT(pClass->version() > 0);
+	F_ASSERT(m_classes.size() < 0xffff);
+
+	class_t info;
+	info.name = pClass->typeName();
+	info.version = quint32(pClass->version());
+	info.pClass = pClass;
+	m_classes.push_back(info);
+
+	uint16_t classTag = uint16_t(m_classes.size() - 1);
+	m_classTagTable.insert(classTagTable_t::value_type(pClass, classTag));
+	return classTag;
+}
+
+const FTypeInfo* FIndexedArchive::_readClass(uint16_t classTag, quint32* pVersion) const
+{
+	if (classTag >= m_classes.size())
+		return NULL;
+
+	const class_t& info = m_classes[classTag];
+	*pVersion = info.version;
+	return info.pClass;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,183 @@
+// -----------------------------------------------------------------------------
+//  File        IndexedArchive.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_INDEXEDARCHIVE_H
+#define FLOWCORE_INDEXEDARCHIVE_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Object.h"
+
+#include <QIODevice>
+#include <QByteArray>
+#include <unordered_map>
+#include <vector>
+
+class FArchive;
+class FTypeInfo;
+
+// -----------------------------------------------------------------------------
+//  Class FIndexedArchive
+// -----------------------------------------------------------------------------
+
+/// Archive of top-level objects, each stored in its own section and listed
+/// in an index at the end of the archive. Individual objects can be loaded
+/// on demand, without reading the rest of the archive, or all objects can
+/// be loaded in parallel, see loadAll().
+///
+/// Each section is an independent FArchive with its own object tag table.
+/// The classes of all objects are stored once in a class table shared by
+/// all sections. References between top-level objects are stored as
+/// references to the other object's section. When an object is loaded, the
+/// top-level objects it references are loaded as well, objects not reachable
+/// from it are never read. Objects not added as top-level objects are stored
+/// in the section of each top-level object referencing them, objects shared
+/// by several top-level objects should therefore be added themselves.
+///
+/// Reading requires random access: a file, a byte array, a mapped file
+/// or a FCompressedDevice reading a compressed file with block index.
+class FLOWCORE_EXPORT FIndexedArchive
+{
+	F_DISABLE_COPY(FIndexedArchive);
+	friend class FArchive;
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates an archive writing to or reading from the given device,
+	/// depending on the mode the device is opened in. For reading, the
+	/// archive must end at the end of the device.
+	FIndexedArchive(QIODevice* pDevice);
+	/// Creates an archive reading from the given buffer.
+	FIndexedArchive(const QByteArray& buffer);
+	/// Creates an archive reading size bytes starting at pData, e.g. the
+	/// data of a FMappedFile. The data must remain valid while the archive
+	/// is in use.
+	FIndexedArchive(const char* pData, size_t size);
+
+	/// Destructor. Writes the archive if it hasn't been written yet.
+	~FIndexedArchive();
+
+	//  Public commands ----------------------------------------------
+
+	/// Adds a top-level object to a writing archive. Returns the tag
+	/// identifying the object in the archive. Tags are assigned in the
+	/// order objects are added, starting at 1.
+	quint32 addObject(const FObject* pObject);
+	/// Writes all added objects and the index. Objects must not be added
+	/// after the archive has been written.
+	void write();
+
+	/// Loads and returns the top-level object with the given tag, together
+	/// with the top-level objects it references. Each object is loaded only
+	/// once, subsequent calls return the same object. The caller owns the
+	/// loaded objects, they must stay alive as long as the archive is used.
+	/// Returns NULL if the tag is invalid or the object can't be loaded.
+	/// An object which fails to load is deleted, objects loaded together
+	/// with it must not use their references to it.
+	FObject* loadObject(quint32 tag);
+	/// Loads a top-level object of the given type, see loadObject().
+	/// Returns NULL if the object is not of type T.
+	template <class T>
+	T* loadObject(quint32 tag);
+	/// Loads all top-level objects, distributing the sections on the given
+	/// number of threads. If threadCount is 0, the ideal thread count for
+	/// the system is used. Serialization functions must therefore be safe to
+	/// run concurrently for different objects, and must not access other
+	/// top-level objects they reference, as these may still be loading.
+	/// Sections are read from a device one at a time, only the sections
+	/// being loaded are held in memory.
+	/// Returns true if all objects could be loaded. Objects which fail to
+	/// load are deleted once all sections have been read, loadObject()
+	/// then returns NULL for them; loaded objects must not use their
+	/// references to them.
+	bool loadAll(int threadCount = 0);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns true if the archive is writing.
+	bool isWriting() const { return m_isWriting; }
+	/// Returns true if a reading archive has a valid index.
+	bool isValid() const { return m_isValid; }
+
+	/// Returns the number of top-level objects in the archive.
+	size_t objectCount() const { return m_entries.size(); }
+	/// Returns the class of the top-level object with the given tag, or
+	/// NULL if the class is not registered.
+	const FTypeInfo* objectClass(quint32 tag) const;
+	/// Returns the size of the section of the object with the given tag.
+	quint64 objectSize(quint32 tag) const;
+	/// Returns true if the object with the given tag has been loaded.
+	bool isLoaded(quint32 tag) const;
+	/// Returns the tags of all top-level objects whose class is derived
+	/// from the given class.
+	std::vector<quint32> findObjects(const FTypeInfo* pBaseClass) const;
+
+	//  Internal functions -------------------------------------------
+
+private:
+	class loadTask_t;
+	friend class loadTask_t;
+
+	bool _readIndex(qint64 endPos);
+	FArchive* _createReader(quint64 offset, quint64 size);
+	bool _readObject(FArchive* pArchive, quint32 tag);
+	quint32 _tagOf(const FObject* pObject) const;
+	uint16_t _writeClassTag(const FTypeInfo* pClass);
+	const FTypeInfo* _readClass(uint16_t classTag, quint32* pVersion) const;
+
+	//  Internal data members ----------------------------------------
+
+	struct class_t
+	{
+		QByteArray name;
+		quint32 version;
+		const FTypeInfo* pClass;
+	};
+
+	struct entry_t
+	{
+		quint64 offset;
+		quint64 size;
+		uint16_t classTag;
+		const FObject* pWriteObject;
+		FObject* pReadObject;
+		bool isLoaded;
+	};
+
+	typedef std::unordered_map<const FObject*, quint32> objTagTable_t;
+	typedef std::unordered_map<const FTypeInfo*, uint16_t> classTagTable_t;
+
+	QIODevice* m_pDevice;
+	QByteArray m_buffer;
+	const char* m_pData;
+	qint64 m_start;
+	quint64 m_indexOffset;
+
+	std::vector<class_t> m_classes;
+	classTagTable_t m_classTagTable;
+	std::vector<entry_t> m_entries;
+	objTagTable_t m_tagTable;
+
+	bool m_isWriting;
+	bool m_isWritten;
+	bool m_isValid;
+};
+
+// Template members ------------------------------------------------------------
+
+template <class T>
+inline T* FIndexedArchive::loadObject(quint32 tag)
+{
+	FObject* pObject = loadObject(tag);
+	return pObject ? pObject->castTo<T>() : NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_INDEXEDARCHIVE_H
@@ -12,6 +12,7 @@
 
 #include "FlowCore/Library.h"
 #include "FlowCore/LogType.h"
+#include "FlowCore/LogFilter.h"
 
 #include <QString>
 #include <QTextStream>
@@ -43,21 +44,76 @@ private:
 	QTextStream m_stream;
 };
 
+// -----------------------------------------------------------------------------
+//  Class FLogStatement
+// -----------------------------------------------------------------------------
+
+/// Evaluates the module of a log statement once and checks the statement
+/// against the runtime filter. Used by F_LOG, which declares the statement
+/// in the condition of an if statement.
+class FLogStatement
+{
+	//  Constructors and destructor ----------------------------------
+
+public:
+	FLogStatement(FLogType type, const char* module)
+	: m_pModule(module), m_isFiltered(!FLogFilter::isEnabled(type, module)) { }
+	FLogStatement(FLogType type, const QString& module)
+	: m_pModule(NULL), m_module(module), m_isFiltered(!FLogFilter::isEnabled(type, module)) { }
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns true if the statement is filtered out. Inverted, so that
+	/// F_LOG can end in an else branch and an else following the
+	/// statement is not bound to the macro.
+	operator bool() const { return m_isFiltered; }
+
+	/// Returns the module of the statement.
+	QString moduleName() const { return m_pModule ? QString(m_pModule) : m_module; }
+
+	//  Internal data members ----------------------------------------
+
+private:
+	const char* m_pModule;
+	QString m_module;
+	bool m_isFiltered;
+};
+
 // Macros ----------------------------------------------------------------------
 
-#ifdef FLOW_DEBUG
-#  define F_TRACE FLogStream().stream()
-#  define F_DEBUG(module) FLogStream(FLogType::Debug, module).stream()
-#else
-#  define F_TRACE if(0) FLogStream().stream()
-#  define F_DEBUG(module) if(0) FLogStream(FLogType::Debug, module).stream()
+/// Minimum type of log messages compiled into the program. Log statements
+/// below this level are removed by the compiler. Can be defined before Log.h
+/// is included, e.g. as FLogType::Warning, by default debug and trace
+/// messages are only compiled into debug builds.
+#ifndef FLOW_LOG_MIN_LEVEL
+#  ifdef FLOW_DEBUG
+#    define FLOW_LOG_MIN_LEVEL FLogType::Trace
+#  else
+#    define FLOW_LOG_MIN_LEVEL FLogType::Info
+#  endif
 #endif
 
+/// Starts a log message of the given type and module if it passes the
+/// compile time minimum level and the runtime filter, see FLogFilter.
+/// Otherwise, the message expression is not evaluated. The module
+/// expression is evaluated once, modules given as const char* must be
+/// string literals, see FLogFilter::isEnabled().
+#define F_LOG(type, module) \
+	if (type < FLOW_LOG_MIN_LEVEL) { } \
+	else if (FLogStatement _fLogStatement = FLogStatement(type, module)) { } \
+	else FLogStream(type, _fLogStatement.moduleName()).stream()
+
+#define F_TRACE \
+	if (FLogType::Trace < FLOW_LOG_MIN_LEVEL || !FLogFilter::isEnabled(FLogType::Trace)) { } \
+	else FLogStream().stream()
+
 #define F_PRINT FLogStream().stream()
 
-#define F_INFO(module)     FLogStream(FLogType::Info, module).stream()
-#define F_WARNING(module)  FLogStream(FLogType::Warning, module).stream()
-#define F_CRITICAL(module) FLogStream(FLogType::Critical, module).stream()
+#define F_DEBUG(module)    F_LOG(FLogType::Debug, module)
+#define F_INFO(module)     F_LOG(FLogType::Info, module)
+#define F_WARNING(module)  F_LOG(FLogType::Warning, module)
+#define F_CRITICAL(module) F_LOG(FLogType::Critical, module)
+/// Fatal messages are never filtered.
 #define F_FATAL(module)    FLogStream(FLogType::Fatal, module).stream()
 
 // -----------------------------------------------------------------------------
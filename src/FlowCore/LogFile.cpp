@@ -0,0 +1,144 @@
+// -----------------------------------------------------------------------------
+//  File        LogFile.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/LogFile.h"
+
+// -----------------------------------------------------------------------------
+//  Class FLogFile
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FLogFile::FLogFile(const QString& fileName)
+: m_fileName(fileName),
+  m_fileSize(0),
+  m_bufferSize(64 * 1024),
+  m_flushInterval(1000),
+  m_maxFileSize(0),
+  m_rotationInterval(0),
+  m_retentionCount(5)
+{
+}
+
+FLogFile::~FLogFile()
+{
+	close();
+}
+
+// Public commands -------------------------------------------------------------
+
+void FLogFile::setFileName(const QString& fileName)
+{
+	close();
+	m_fileName = fileName;
+}
+
+void FLogFile::write(const QString& text)
+{
+	if (m_buffer.isEmpty())
+		m_flushTimer.start();
+
+	m_buffer.append(text.toLocal8Bit());
+
+	if (size_t(m_buffer.size()) >= m_bufferSize
+			|| m_flushTimer.elapsed() >= m_flushInterval) {
+		flush();
+	}
+}
+
+void FLogFile::update()
+{
+	if (!m_buffer.isEmpty() && m_flushTimer.elapsed() >= m_flushInterval)
+		flush();
+}
+
+void FLogFile::flush()
+{
+	if (m_buffer.isEmpty())
+		return;
+
+	bool isOpen = _open();
+	if (isOpen && _isRotationDue()) {
+		rotate();
+		isOpen = _open();
+	}
+
+	// if the file can't be written, the text is discarded
+	if (isOpen) {
+		m_file.write(m_buffer);
+		m_file.flush();
+		m_fileSize += m_buffer.size();
+	}
+
+	m_buffer.clear();
+}
+
+void FLogFile::close()
+{
+	flush();
+	m_file.close();
+}
+
+void FLogFile::rotate()
+{
+	m_file.close();
+
+	if (m_retentionCount > 0) {
+		QFile::remove(rotatedFileName(m_retentionCount));
+
+		for (int i = m_retentionCount - 1; i > 0; --i) {
+			QString name = rotatedFileName(i);
+			if (QFile::exists(name))
+				QFile::rename(name, rotatedFileName(i + 1));
+		}
+
+		QFile::rename(m_fileName, rotatedFileName(1));
+	}
+	else {
+		QFile::remove(m_fileName);
+	}
+
+	m_fileSize = 0;
+}
+
+// Public queries --------------------------------------------------------------
+
+QString FLogFile::rotatedFileName(int index) const
+{
+	return m_fileName + "." + QString::number(index);
+}
+
+// Internal functions ----------------------------------------------------------
+
+bool FLogFile::_open()
+{
+	if (m_file.isOpen())
+		return true;
+
+	m_file.setFileName(m_fileName);
+	if (!m_file.open(QFile::WriteOnly | QFile::Append))
+		return false;
+
+	m_fileSize = m_file.size();
+	m_fileTimer.start();
+	return true;
+}
+
+bool FLogFile::_isRotationDue() const
+{
+	if (m_maxFileSize > 0 && m_fileSize > 0
+			&& m_fileSize + m_buffer.size() > m_maxFileSize) {
+		return true;
+	}
+
+	return m_rotationInterval > 0
+		&& m_fileTimer.elapsed() >= qint64(m_rotationInterval) * 1000;
+}
+
+// -----------------------------------------------------------------------------
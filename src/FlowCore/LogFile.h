@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+//  File        LogFile.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_LOGFILE_H
+#define FLOWCORE_LOGFILE_H
+
+#include "FlowCore/Library.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QElapsedTimer>
+
+// -----------------------------------------------------------------------------
+//  Class FLogFile
+// -----------------------------------------------------------------------------
+
+/// Buffered writer for log files. The file is opened once and stays open,
+/// written text is collected in a buffer which is written to the file when
+/// it exceeds the buffer size or when the flush interval has passed.
+///
+/// The file can be rotated when it exceeds a maximum size or when it has
+/// been written to for longer than the rotation interval. Rotating renames
+/// the current file to "<name>.1", previously rotated files are renamed to
+/// "<name>.2" and so on, files exceeding the retention count are deleted.
+/// The class is not thread safe.
+class FLOWCORE_EXPORT FLogFile
+{
+	F_DISABLE_COPY(FLogFile);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates a writer for the file with the given name.
+	/// The file is opened when text is written the first time.
+	FLogFile(const QString& fileName);
+	/// Destructor. Writes the buffered text and closes the file.
+	~FLogFile();
+
+	//  Public commands ----------------------------------------------
+
+	/// Closes the current file and sets the name of the file to write to.
+	void setFileName(const QString& fileName);
+	/// Sets the size of the write buffer in bytes. Default is 64 KB.
+	void setBufferSize(size_t bufferSize) { m_bufferSize = bufferSize; }
+	/// Sets the maximum time in milliseconds written text is kept in the
+	/// buffer. Default is 1000 ms.
+	void setFlushInterval(int interval) { m_flushInterval = interval; }
+	/// Sets the size in bytes at which the file is rotated.
+	/// Default is 0, the file is not rotated by size.
+	void setMaxFileSize(qint64 size) { m_maxFileSize = size; }
+	/// Sets the time in seconds after which the file is rotated.
+	/// Default is 0, the file is not rotated by time.
+	void setRotationInterval(int interval) { m_rotationInterval = interval; }
+	/// Sets the number of rotated files which are kept. Default is 5.
+	void setRetentionCount(int count) { m_retentionCount = count; }
+
+	/// Adds the given text to the buffer. The buffer is written to the file
+	/// if it exceeds the buffer size or the flush interval has passed.
+	void write(const QString& text);
+	/// Writes the buffer to the file if the flush interval has passed. Call
+	/// this regularly to limit the delay of text written to the file.
+	void update();
+	/// Writes the buffer to the file.
+	void flush();
+	/// Writes the buffer and closes the file.
+	void close();
+	/// Closes the current file and starts a new one, see class description.
+	/// Text in the buffer is written to the new file.
+	void rotate();
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the name of the file.
+	const QString& fileName() const { return m_fileName; }
+	/// Returns the name of the rotated file with the given index.
+	QString rotatedFileName(int index) const;
+
+	/// Returns the size of the write buffer in bytes.
+	size_t bufferSize() const { return m_bufferSize; }
+	/// Returns the maximum time in milliseconds text is kept in the buffer.
+	int flushInterval() const { return m_flushInterval; }
+	/// Returns the size in bytes at which the file is rotated.
+	qint64 maxFileSize() const { return m_maxFileSize; }
+	/// Returns the time in seconds after which the file is rotated.
+	int rotationInterval() const { return m_rotationInterval; }
+	/// Returns the number of rotated files which are kept.
+	int retentionCount() const { return m_retentionCount; }
+
+	/// Returns true if the file is open.
+	bool isOpen() const { return m_file.isOpen(); }
+	/// Returns the size of the file including the buffered text.
+	qint64 fileSize() const { return m_fileSize + m_buffer.size(); }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	bool _open();
+	bool _isRotationDue() const;
+
+	//  Internal data members ----------------------------------------
+
+	QString m_fileName;
+	QFile m_file;
+	QByteArray m_buffer;
+	qint64 m_fileSize;
+
+	size_t m_bufferSize;
+	int m_flushInterval;
+	qint64 m_maxFileSize;
+	int m_rotationInterval;
+	int m_retentionCount;
+
+	QElapsedTimer m_flushTimer;
+	QElapsedTimer m_fileTimer;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_LOGFILE_H
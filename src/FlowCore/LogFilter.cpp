@@ -0,0 +1,183 @@
+// -----------------------------------------------------------------------------
+//  File        LogFilter.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/LogFilter.h"
+
+#include <QReadWriteLock>
+#include <QAtomicPointer>
+#include <map>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------
+//  Class FLogFilter
+// -----------------------------------------------------------------------------
+
+// Helpers ---------------------------------------------------------------------
+
+struct moduleTable_t
+{
+	std::map<QString, int> levels;
+	QReadWriteLock lock;
+};
+
+/// Returns the table of module levels. The table is only looked up
+/// by the log macros after a level has been set.
+static inline moduleTable_t& _moduleTable()
+{
+	static moduleTable_t table;
+	return table;
+}
+
+/// Cached level of a module name literal. The cache is a plain array
+/// of atomics without constructors, it is zero-initialized before any
+/// static constructor logs a message.
+struct moduleEntry_t
+{
+	QBasicAtomicPointer<const char> module;
+	QBasicAtomicInt level;
+};
+
+static const size_t _cacheSize = 256;
+static const size_t _maxProbes = 8;
+static moduleEntry_t s_moduleCache[_cacheSize];
+
+static inline size_t _cacheIndex(const char* module)
+{
+	quintptr key = quintptr(module);
+	return size_t(key ^ (key >> 8)) % _cacheSize;
+}
+
+static inline int _clampLevel(FLogType level)
+{
+	return std::min(int(level), int(FLogType::Fatal));
+}
+
+// Static members --------------------------------------------------------------
+
+QAtomicInt FLogFilter::s_level(FLogType::Trace);
+QAtomicInt FLogFilter::s_lowestLevel(FLogType::Trace);
+QAtomicInt FLogFilter::s_highestLevel(FLogType::Trace);
+
+// Static commands -------------------------------------------------------------
+
+void FLogFilter::setLevel(FLogType level)
+{
+	QWriteLocker locker(&_moduleTable().lock);
+	s_level.store(_clampLevel(level));
+	_update();
+}
+
+void FLogFilter::setModuleLevel(const QString& module, FLogType level)
+{
+	QWriteLocker locker(&_moduleTable().lock);
+	_moduleTable().levels[module] = _clampLevel(level);
+	_update();
+}
+
+void FLogFilter::resetModuleLevel(const QString& module)
+{
+	QWriteLocker locker(&_moduleTable().lock);
+	_moduleTable().levels.erase(module);
+	_update();
+}
+
+void FLogFilter::resetModuleLevels()
+{
+	QWriteLocker locker(&_moduleTable().lock);
+	_moduleTable().levels.clear();
+	_update();
+}
+
+// Static queries --------------------------------------------------------------
+
+FLogType FLogFilter::moduleLevel(const QString& module)
+{
+	QReadLocker locker(&_moduleTable().lock);
+	return FLogType::state_t(_findLevel(module));
+}
+
+// Internal functions ----------------------------------------------------------
+
+bool FLogFilter::_isModuleEnabled(FLogType type, const char* module)
+{
+	size_t index = _cacheIndex(module);
+
+	for (size_t i = 0; i < _maxProbes; ++i) {
+		moduleEntry_t& entry = s_moduleCache[(index + i) % _cacheSize];
+		const char* cached = entry.module.loadAcquire();
+		if (cached == module)
+			return int(type) >= entry.level.load();
+		if (!cached)
+			return _cacheModule(type, module);
+	}
+
+	// no free entry left, resolve the module without taking the write lock
+	return int(type) >= int(moduleLevel(QString(module)));
+}
+
+bool FLogFilter::_isModuleEnabled(FLogType type, const QString& module)
+{
+	return int(type) >= int(moduleLevel(module));
+}
+
+bool FLogFilter::_cacheModule(FLogType type, const char* module)
+{
+	QWriteLocker locker(&_moduleTable().lock);
+	int level = _findLevel(QString(module));
+
+	// entries are only added under the write lock, the level is stored
+	// before the module is published to readers
+	size_t index = _cacheIndex(module);
+	for (size_t i = 0; i < _maxProbes; ++i) {
+		moduleEntry_t& entry = s_moduleCache[(index + i) % _cacheSize];
+		const char* cached = entry.module.load();
+		if (cached == module)
+			break;
+		if (!cached) {
+			entry.level.store(level);
+			entry.module.storeRelease(module);
+			break;
+		}
+	}
+
+	// if another module took the free entry meanwhile, the module
+	// is resolved under the read lock on later calls
+	return int(type) >= level;
+}
+
+int FLogFilter::_findLevel(const QString& module)
+{
+	const std::map<QString, int>& levels = _moduleTable().levels;
+	std::map<QString, int>::const_iterator it = levels.find(module);
+	return it != levels.end() ? it->second : s_level.load();
+}
+
+void FLogFilter::_update()
+{
+	for (size_t i = 0; i < _cacheSize; ++i) {
+		moduleEntry_t& entry = s_moduleCache[i];
+		const char* module = entry.module.load();
+		if (module)
+			entry.level.store(_findLevel(QString(module)));
+	}
+
+	int lowest = s_level.load();
+	int highest = lowest;
+
+	const std::map<QString, int>& levels = _moduleTable().levels;
+	for (std::map<QString, int>::const_iterator it = levels.begin(); it != levels.end(); ++it) {
+		lowest = std::min(lowest, it->second);
+		highest = std::max(highest, it->second);
+	}
+
+	s_lowestLevel.store(lowest);
+	s_highestLevel.store(highest);
+}
+
+// -----------------------------------------------------------------------------
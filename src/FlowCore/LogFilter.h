@@ -0,0 +1,116 @@
+// -----------------------------------------------------------------------------
+//  File        LogFilter.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_LOGFILTER_H
+#define FLOWCORE_LOGFILTER_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/LogType.h"
+
+#include <QString>
+#include <QAtomicInt>
+
+// -----------------------------------------------------------------------------
+//  Class FLogFilter
+// -----------------------------------------------------------------------------
+
+/// Runtime filter for log messages, used by the log macros in Log.h before
+/// a message is composed. Messages below the global level or below the
+/// level set for their module are discarded. By default, all messages pass.
+/// Fatal messages always pass, levels above FLogType::Fatal are clamped.
+///
+/// Checking a message whose type is below the lowest or above the highest
+/// level of all modules costs a single atomic load and compare. Otherwise,
+/// modules given as string literal are looked up in a lock-free cache
+/// keyed by the address of the literal, each literal is resolved once
+/// and its cached level is updated if levels change. The cache holds 256
+/// literals; if it fills up, e.g. with many distinct literals, literals
+/// not cached are looked up in the module table under a read lock on
+/// every check. Module names given as QString are always looked up in
+/// the module table under a read lock.
+class FLOWCORE_EXPORT FLogFilter
+{
+	//  Static commands ----------------------------------------------
+
+public:
+	/// Sets the minimum type of messages passing the filter,
+	/// for modules without a level of their own.
+	static void setLevel(FLogType level);
+	/// Sets the minimum type of messages of the given module
+	/// passing the filter.
+	static void setModuleLevel(const QString& module, FLogType level);
+	/// Removes the level of the given module, messages of the
+	/// module are filtered by the global level.
+	static void resetModuleLevel(const QString& module);
+	/// Removes the levels of all modules.
+	static void resetModuleLevels();
+
+	//  Static queries -----------------------------------------------
+
+	/// Returns the global level.
+	static FLogType level() { return FLogType::state_t(s_level.load()); }
+	/// Returns the level of the given module, or the global level
+	/// if no level has been set for the module.
+	static FLogType moduleLevel(const QString& module);
+
+	/// Returns true if messages of the given type pass the global level.
+	static bool isEnabled(FLogType type);
+	/// Returns true if messages of the given type and module pass the filter.
+	/// The module must be a string literal, or any other string which is
+	/// never changed nor released.
+	static bool isEnabled(FLogType type, const char* module);
+	/// Returns true if messages of the given type and module pass the filter.
+	static bool isEnabled(FLogType type, const QString& module);
+
+	//  Internal functions -------------------------------------------
+
+private:
+	static bool _isModuleEnabled(FLogType type, const char* module);
+	static bool _isModuleEnabled(FLogType type, const QString& module);
+	static bool _cacheModule(FLogType type, const char* module);
+	static int _findLevel(const QString& module);
+	static void _update();
+
+	//  Internal data members ----------------------------------------
+
+	static QAtomicInt s_level;
+	static QAtomicInt s_lowestLevel;
+	static QAtomicInt s_highestLevel;
+};
+
+// Inline members --------------------------------------------------------------
+
+inline bool FLogFilter::isEnabled(FLogType type)
+{
+	return int(type) >= s_level.load();
+}
+
+inline bool FLogFilter::isEnabled(FLogType type, const char* module)
+{
+	if (int(type) < s_lowestLevel.load())
+		return false;
+	if (int(type) >= s_highestLevel.load())
+		return true;
+
+	return _isModuleEnabled(type, module);
+}
+
+inline bool FLogFilter::isEnabled(FLogType type, const QString& module)
+{
+	if (int(type) < s_lowestLevel.load())
+		return false;
+	if (int(type) >= s_highestLevel.load())
+		return true;
+
+	return _isModuleEnabled(type, module);
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_LOGFILTER_H
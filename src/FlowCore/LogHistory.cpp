@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+//  File        LogHistory.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/LogHistory.h"
+
+// -----------------------------------------------------------------------------
+//  Class FLogHistory
+// -----------------------------------------------------------------------------
+
+// Helpers ---------------------------------------------------------------------
+
+/// Collects copies of the visited messages.
+struct _collector_t
+{
+	void operator()(quint64, const FLogMessage& message) { messages.push_back(message); }
+	std::vector<FLogMessage> messages;
+};
+
+// Constructors and destructor -------------------------------------------------
+
+FLogHistory::FLogHistory(size_t capacity)
+: m_firstSequence(1),
+  m_nextSequence(1)
+{
+	reset(capacity);
+}
+
+// Public commands -------------------------------------------------------------
+
+quint64 FLogHistory::add(const FLogMessage& message)
+{
+	size_t capacity = m_messages.size();
+	quint64 sequence = m_nextSequence++;
+
+	m_messages[size_t(sequence % capacity)] = message;
+	if (m_nextSequence - m_firstSequence > capacity)
+		m_firstSequence++;
+
+	index_t& index = m_indices[message.type()];
+	index.sequences[(index.first + index.count) % capacity] = sequence;
+	if (index.count < capacity)
+		index.count++;
+	else
+		index.first = (index.first + 1) % capacity;
+
+	return sequence;
+}
+
+void FLogHistory::reset(size_t capacity)
+{
+	F_ASSERT(capacity > 0);
+
+	m_messages.clear();
+	m_messages.resize(capacity);
+	m_firstSequence = m_nextSequence;
+
+	for (size_t i = 0; i < FLogType::All; ++i) {
+		m_indices[i].sequences.clear();
+		m_indices[i].sequences.resize(capacity);
+		m_indices[i].first = 0;
+		m_indices[i].count = 0;
+	}
+}
+
+// Public queries --------------------------------------------------------------
+
+const FLogMessage& FLogHistory::message(quint64 sequence) const
+{
+	F_ASSERT(sequence >= m_firstSequence && sequence < m_nextSequence);
+	return m_messages[size_t(sequence % m_messages.size())];
+}
+
+std::vector<FLogMessage> FLogHistory::messages(FLogType type,
+	quint64 sinceSequence) const
+{
+	_collector_t collector;
+	visit(collector, type, sinceSequence);
+	return collector.messages;
+}
+
+// Internal functions ----------------------------------------------------------
+
+size_t FLogHistory::_findIndexStart(int type, quint64 sinceSequence) const
+{
+	// the sequence numbers in an index ring are ascending,
+	// find the first one after sinceSequence
+	const index_t& index = m_indices[type];
+	size_t capacity = index.sequences.size();
+	size_t lower = 0;
+	size_t upper = index.count;
+
+	while (lower < upper) {
+		size_t middle = (lower + upper) / 2;
+		if (index.sequences[(index.first + middle) % capacity] <= sinceSequence)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+
+	return lower;
+}
+
+// -----------------------------------------------------------------------------
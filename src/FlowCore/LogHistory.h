@@ -0,0 +1,122 @@
+// -----------------------------------------------------------------------------
+//  File        LogHistory.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_LOGHISTORY_H
+#define FLOWCORE_LOGHISTORY_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/LogMessage.h"
+
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Class FLogHistory
+// -----------------------------------------------------------------------------
+
+/// Keeps the most recent log messages in a ring of fixed capacity. When the
+/// ring is full, adding a message replaces the oldest message. Each message
+/// is numbered with a sequence number, starting at 1, which allows to
+/// retrieve only the messages added after a given message. For each message
+/// type, an index ring holds the sequence numbers of the messages of the
+/// type, so messages of a single type are found without scanning all
+/// messages. The class is not thread safe.
+class FLOWCORE_EXPORT FLogHistory
+{
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates a history keeping up to the given number of messages.
+	FLogHistory(size_t capacity);
+
+	//  Public commands ----------------------------------------------
+
+	/// Adds a message and returns its sequence number.
+	quint64 add(const FLogMessage& message);
+	/// Removes all messages and sets the capacity of the history.
+	/// Sequence numbers continue after the last added message.
+	void reset(size_t capacity);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the maximum number of messages in the history.
+	size_t capacity() const { return m_messages.size(); }
+	/// Returns the number of messages in the history.
+	size_t size() const { return size_t(m_nextSequence - m_firstSequence); }
+	/// Returns the sequence number of the oldest message in the history.
+	quint64 firstSequence() const { return m_firstSequence; }
+	/// Returns the sequence number of the last added message,
+	/// or 0 if no message has been added yet.
+	quint64 lastSequence() const { return m_nextSequence - 1; }
+
+	/// Returns the message with the given sequence number. The sequence
+	/// number must be in the range of firstSequence() and lastSequence().
+	const FLogMessage& message(quint64 sequence) const;
+
+	/// Returns a copy of the messages of the given type which have been
+	/// added after the message with the given sequence number.
+	std::vector<FLogMessage> messages(FLogType type = FLogType::All,
+		quint64 sinceSequence = 0) const;
+
+	/// Calls visitor(sequence, message) for each message of the given type
+	/// which has been added after the message with the given sequence
+	/// number, without copying the messages. Returns the last sequence
+	/// number, to be used as sinceSequence in the next call.
+	template <typename VISITOR>
+	quint64 visit(VISITOR& visitor, FLogType type = FLogType::All,
+		quint64 sinceSequence = 0) const;
+
+	//  Internal functions -------------------------------------------
+
+private:
+	size_t _findIndexStart(int type, quint64 sinceSequence) const;
+
+	//  Internal data members ----------------------------------------
+
+	struct index_t
+	{
+		std::vector<quint64> sequences;
+		size_t first;
+		size_t count;
+	};
+
+	std::vector<FLogMessage> m_messages;
+	index_t m_indices[FLogType::All];
+	quint64 m_firstSequence;
+	quint64 m_nextSequence;
+};
+
+// Template members ------------------------------------------------------------
+
+template <typename VISITOR>
+quint64 FLogHistory::visit(VISITOR& visitor, FLogType type,
+	quint64 sinceSequence) const
+{
+	if (sinceSequence < m_firstSequence)
+		sinceSequence = m_firstSequence - 1;
+
+	if (type == FLogType::All) {
+		for (quint64 s = sinceSequence + 1; s < m_nextSequence; ++s)
+			visitor(s, m_messages[size_t(s % m_messages.size())]);
+	}
+	else {
+		const index_t& index = m_indices[type];
+		size_t capacity = index.sequences.size();
+
+		for (size_t i = _findIndexStart(type, sinceSequence); i < index.count; ++i) {
+			quint64 s = index.sequences[(index.first + i) % capacity];
+			visitor(s, m_messages[size_t(s % m_messages.size())]);
+		}
+	}
+
+	return lastSequence();
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_LOGHISTORY_H
@@ -11,10 +11,29 @@
 #include "FlowCore/Log.h"
 
 #include <QDateTime>
-#include <QFile>
 #include <QTextStream>
+#include <QThread>
+#include <QElapsedTimer>
 #include <QDebug>
 
+#include <cstdlib>
+
+// -----------------------------------------------------------------------------
+//  Class FLogManager::consumer_t
+// -----------------------------------------------------------------------------
+
+class FLogManager::consumer_t : public QThread
+{
+public:
+	consumer_t(FLogManager* pManager) : m_pManager(pManager) { }
+
+protected:
+	virtual void run() { m_pManager->_consume(); }
+
+private:
+	FLogManager* m_pManager;
+};
+
 // -----------------------------------------------------------------------------
 //  Class FLogManager
 // -----------------------------------------------------------------------------
@@ -22,7 +41,16 @@
 // Constructors and destructor -------------------------------------------------
 
 FLogManager::FLogManager()
-: m_logFileName("log.txt")
+: m_logFileName("log.txt"),
+  m_logFile(m_logFileName),
+  m_queue(QueueCapacity),
+  m_isConsumerWaiting(0),
+  m_isStopping(false),
+  m_postedCount(0),
+  m_processedCount(0),
+  m_droppedCount(0),
+  m_reportedDropCount(0),
+  m_history(HistoryCapacity)
 {
 #ifdef FLOW_DEBUG
 	m_logFileEnabled = true;
@@ -33,10 +61,29 @@ FLogManager::FLogManager()
 	if (m_logFileEnabled) {
 		_writeLogFileSessionStart();
 	}
+
+	m_pConsumer = new consumer_t(this);
+	m_pConsumer->start();
+
+	std::atexit(_flushAtExit);
 }
 
 FLogManager::~FLogManager()
 {
+	m_wakeMutex.lock();
+	m_isStopping = true;
+	m_wakeCondition.wakeOne();
+	m_wakeMutex.unlock();
+
+	m_pConsumer->wait();
+	F_SAFE_DELETE(m_pConsumer);
+
+	// process messages added while the consumer was stopping
+	FLogMessage message;
+	while (m_queue.dequeue(message)) {
+		_processMessage(message);
+	}
+
 	if (m_logFileEnabled) {
 		_writeLogFileSessionEnd();
 	}
@@ -46,18 +93,56 @@ FLogManager::~FLogManager()
 
 void FLogManager::addMessage(const FLogMessage& message)
 {
-	FSectionLock lock(&m_objectLock);
+	bool isFatal = (message.type() == FLogType::Fatal);
 
-	if (m_logFileEnabled) {
-		_writeLogFileMessage(message);
+	if (!m_queue.enqueue(message)) {
+		// a fatal message must not get lost, make room and try again
+		if (!isFatal || !flush(FatalFlushTimeout) || !m_queue.enqueue(message)) {
+			m_droppedCount.fetchAndAddRelaxed(1);
+			return;
+		}
 	}
 
-	qDebug() << message.toString().toStdString().c_str();
+	m_postedCount.fetchAndAddRelease(1);
+
+	if (m_isConsumerWaiting.loadAcquire()) {
+		QMutexLocker locker(&m_wakeMutex);
+		m_wakeCondition.wakeOne();
+	}
 
-	m_messages.push_back(message);
-	
-    for (int i = 0; i < m_listeners.size(); ++i)
-		m_listeners[i]->logMessage(message);
+	if (isFatal) {
+		flush(FatalFlushTimeout);
+	}
+}
+
+bool FLogManager::flush(int timeout)
+{
+	// listeners logging messages must not wait for themselves
+	if (QThread::currentThread() == m_pConsumer)
+		return true;
+
+	quint32 target = quint32(m_postedCount.loadAcquire());
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QMutexLocker locker(&m_wakeMutex);
+
+	while (int(quint32(m_processedCount.loadAcquire()) - target) < 0) {
+		m_wakeCondition.wakeOne();
+
+		if (timeout < 0) {
+			m_flushCondition.wait(&m_wakeMutex);
+		}
+		else {
+			qint64 remaining = timeout - timer.elapsed();
+			if (remaining <= 0)
+				return false;
+			m_flushCondition.wait(&m_wakeMutex, (unsigned long)remaining);
+		}
+	}
+
+	return true;
 }
 
 void FLogManager::addListener(FLogListener* pListener)
@@ -79,65 +164,198 @@ void FLogManager::removeListener(FLogListener* pListener)
 void FLogManager::setLogFileName(const QString& fileName)
 {
 	FSectionLock lock(&m_objectLock);
+	m_logFile.setFileName(fileName);
 	m_logFileName = fileName;
 }
 
+void FLogManager::enableLogFile(bool state)
+{
+	FSectionLock lock(&m_objectLock);
+
+	if (state == m_logFileEnabled)
+		return;
+
+	if (state) {
+		m_logFileEnabled = true;
+		_writeLogFileSessionStart();
+	}
+	else {
+		_writeLogFileSessionEnd();
+		m_logFile.close();
+		m_logFileEnabled = false;
+	}
+}
+
+void FLogManager::setLogFileBuffer(size_t bufferSize, int flushInterval)
+{
+	FSectionLock lock(&m_objectLock);
+	m_logFile.setBufferSize(bufferSize);
+	m_logFile.setFlushInterval(flushInterval);
+}
+
+void FLogManager::setLogFileRotation(qint64 maxSize, int interval, int retentionCount)
+{
+	FSectionLock lock(&m_objectLock);
+	m_logFile.setMaxFileSize(maxSize);
+	m_logFile.setRotationInterval(interval);
+	m_logFile.setRetentionCount(retentionCount);
+}
+
+void FLogManager::setHistoryCapacity(size_t capacity)
+{
+	QWriteLocker locker(&m_historyLock);
+	m_history.reset(capacity);
+}
+
 // Public queries --------------------------------------------------------------
 
-std::vector<FLogMessage> FLogManager::getMessages(FLogType type) const
+bool FLogManager::logFileEnabled() const
 {
 	FSectionLock lock(&m_objectLock);
-    std::vector<FLogMessage> messages;
+	return m_logFileEnabled;
+}
 
-    for (messageVec_t::const_iterator it = m_messages.begin(); it != m_messages.end(); ++it) {
-		if (type == FLogType::All || type == it->type()) {
-			messages.push_back(*it);
-		}
-	}
+std::vector<FLogMessage> FLogManager::getMessages(FLogType type) const
+{
+	QReadLocker locker(&m_historyLock);
+	return m_history.messages(type);
+}
+
+std::vector<FLogMessage> FLogManager::getMessagesSince(quint64 sinceSequence,
+	FLogType type, quint64* pLastSequence) const
+{
+	QReadLocker locker(&m_historyLock);
+
+	if (pLastSequence)
+		*pLastSequence = m_history.lastSequence();
 
-	return messages;
+	return m_history.messages(type, sinceSequence);
+}
+
+quint64 FLogManager::lastSequence() const
+{
+	QReadLocker locker(&m_historyLock);
+	return m_history.lastSequence();
 }
 
 // Internal functions ----------------------------------------------------------
 
-void FLogManager::_writeLogFileMessage(const FLogMessage& message)
+void FLogManager::_flushAtExit()
+{
+	// processes the messages still queued when the program exits
+	if (!isNull()) {
+		FLogManager* pManager = instance();
+		pManager->flush(FatalFlushTimeout);
+
+		FSectionLock lock(&pManager->m_objectLock);
+		pManager->m_logFile.flush();
+	}
+}
+
+void FLogManager::_consume()
+{
+	FLogMessage message;
+
+	for (;;) {
+		int count = 0;
+		while (count < BatchSize && m_queue.dequeue(message)) {
+			_processMessage(message);
+			m_processedCount.fetchAndAddRelease(1);
+			++count;
+		}
+
+		int dropCount = m_droppedCount.load();
+		if (dropCount != m_reportedDropCount) {
+			_processMessage(FLogMessage(FLogType::Warning, "FLogManager",
+				QString("%1 log messages dropped").arg(dropCount - m_reportedDropCount)));
+			m_reportedDropCount = dropCount;
+		}
+
+		{
+			FSectionLock lock(&m_objectLock);
+			if (m_logFileEnabled)
+				m_logFile.update();
+		}
+
+		QMutexLocker locker(&m_wakeMutex);
+		m_flushCondition.wakeAll();
+
+		if (count == BatchSize)
+			continue;
+		if (m_isStopping)
+			break;
+
+		// the flag is checked by producers after adding a message; if a wake-up
+		// is missed nevertheless, the timed wait limits the delay
+		m_isConsumerWaiting.fetchAndStoreOrdered(1);
+		if (m_queue.isEmpty())
+			m_wakeCondition.wait(&m_wakeMutex, WakeInterval);
+		m_isConsumerWaiting.fetchAndStoreOrdered(0);
+	}
+}
+
+void FLogManager::_processMessage(const FLogMessage& message)
 {
-	QFile logFile(m_logFileName);
-	if (logFile.open(QFile::WriteOnly | QFile::Append)) {
-		QTextStream stream(&logFile);
+	// listeners are called without holding the lock, they may log
+	// messages or add and remove listeners
+	listenerList_t listeners;
+	{
+		FSectionLock lock(&m_objectLock);
 
-		stream << message.toString() << "\n";
-		stream.flush();
+		if (m_logFileEnabled) {
+			_writeLogFileMessage(message);
+			if (message.type() == FLogType::Fatal)
+				m_logFile.flush();
+		}
+
+		listeners = m_listeners;
 	}
+
+	qDebug() << message.toString().toStdString().c_str();
+
+	{
+		QWriteLocker locker(&m_historyLock);
+		m_history.add(message);
+	}
+
+	for (int i = 0; i < listeners.size(); ++i)
+		listeners[i]->logMessage(message);
+}
+
+void FLogManager::_writeLogFileMessage(const FLogMessage& message)
+{
+	m_logFile.write(message.toString() + "\n");
 }
 
 void FLogManager::_writeLogFileSessionStart()
 {
-	QFile logFile(m_logFileName);
-	if (logFile.open(QFile::WriteOnly | QFile::Append)) {
-		QTextStream stream(&logFile);
+	QString text;
+	QTextStream stream(&text);
 #ifdef FLOW_DEBUG
-		stream << "***** DEBUG SESSION STARTED: ";
+	stream << "***** DEBUG SESSION STARTED: ";
 #else
-		stream << "***** RELEASE SESSION STARTED: ";
+	stream << "***** RELEASE SESSION STARTED: ";
 #endif
-		stream << QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss");
-		stream << " *****\n\n";
-		stream.flush();
-	}
+	stream << QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss");
+	stream << " *****\n\n";
+	stream.flush();
+
+	m_logFile.write(text);
+	m_logFile.flush();
 }
 
 void FLogManager::_writeLogFileSessionEnd()
 {
-	QFile logFile(m_logFileName);
-	if (logFile.open(QFile::WriteOnly | QFile::Append)) {
-		QTextStream stream(&logFile);
+	QString text;
+	QTextStream stream(&text);
 
-		stream << "\n***** SESSION CLOSED: ";
-		stream << QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss");
-		stream << " *****\n\n";
-		stream.flush();
-	}
+	stream << "\n***** SESSION CLOSED: ";
+	stream << QDateTime::currentDateTime().toString("dd.MM.yyyy hh:mm:ss");
+	stream << " *****\n\n";
+	stream.flush();
+
+	m_logFile.write(text);
+	m_logFile.flush();
 }
 
 // -----------------------------------------------------------------------------
@@ -15,8 +15,15 @@
 #include "FlowCore/SingletonT.h"
 #include "FlowCore/CriticalSection.h"
 #include "FlowCore/LogMessage.h"
+#include "FlowCore/LogFile.h"
+#include "FlowCore/LogHistory.h"
+#include "FlowCore/MpscQueueT.h"
 
 #include <QString>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QWaitCondition>
+#include <QAtomicInt>
 #include <vector>
 
 // -----------------------------------------------------------------------------
@@ -34,6 +41,13 @@ public:
 //  Class FLogManager
 // -----------------------------------------------------------------------------
 
+/// Collects log messages and dispatches them to the debug output, the log
+/// file and the registered listeners. Messages are added to a lock-free queue
+/// and processed by a consumer thread, so threads adding messages never wait
+/// for file I/O or listeners. Listeners are therefore called on the consumer
+/// thread. If the queue is full, messages are dropped and counted; the
+/// consumer reports the number of dropped messages with a warning. Adding
+/// a fatal message waits until it has been processed.
 class FLOWCORE_EXPORT FLogManager : public FSingletonAutoT<FLogManager>
 {
 	friend class FSingletonAutoT<FLogManager>;
@@ -49,10 +63,19 @@ protected:
 	//  Public commands ----------------------------------------------
 
 public:
-	/// Writes an entry to the log system.
+	/// Writes an entry to the log system. Can be called from any thread.
 	void addMessage(const FLogMessage& message);
-
+	/// Waits until all messages added before the call have been processed,
+	/// or until the timeout in milliseconds expires. A negative timeout
+	/// waits without limit. Returns false if the timeout expired.
+	bool flush(int timeout = -1);
+
+	/// Adds a listener which is called on the consumer thread for each
+	/// message. Listeners are called without locks held and may log
+	/// messages or add and remove listeners themselves.
 	void addListener(FLogListener* pListener);
+	/// Removes a listener. A message being dispatched may still reach the
+	/// listener, call flush() before deleting it.
 	void removeListener(FLogListener* pListener);
 
 	/// Sets the file name used to write the log entries to a file.
@@ -61,20 +84,57 @@ public:
 	/// Enables or disables logging to a file.
 	void enableLogFile(bool state);
 
+	/// Sets the size of the log file write buffer in bytes and the maximum
+	/// time in milliseconds messages are kept in the buffer.
+	void setLogFileBuffer(size_t bufferSize, int flushInterval);
+	/// Sets the size in bytes and the time in seconds after which the log
+	/// file is rotated, and the number of rotated files which are kept.
+	/// A size or time of 0 disables rotation by size or time. See FLogFile.
+	void setLogFileRotation(qint64 maxSize, int interval, int retentionCount);
+
+	/// Sets the number of recent messages kept in the message history.
+	/// Messages in the history are discarded. Default is 10000.
+	void setHistoryCapacity(size_t capacity);
+
 	//  Public queries -----------------------------------------------
 
-	/// Returns a list with all log entries of the given type.
+	/// Returns a list with the log entries of the given type in the message
+	/// history, see setHistoryCapacity().
     std::vector<FLogMessage> getMessages(FLogType type = FLogType::All) const;
+	/// Returns the log entries of the given type in the message history
+	/// which have been added after the entry with the given sequence number.
+	/// If pLastSequence is given, it receives the sequence number of the last
+	/// entry in the history, to be passed as sinceSequence in the next call.
+	std::vector<FLogMessage> getMessagesSince(quint64 sinceSequence,
+		FLogType type = FLogType::All, quint64* pLastSequence = NULL) const;
+	/// Calls visitor(sequence, message) for the entries in the message history
+	/// like getMessagesSince(), without copying them. The history is locked
+	/// for reading during the call, the visitor must not log messages.
+	/// Returns the sequence number of the last entry in the history.
+	template <typename VISITOR>
+	quint64 visitMessages(VISITOR& visitor, quint64 sinceSequence = 0,
+		FLogType type = FLogType::All) const;
+	/// Returns the sequence number of the last entry in the message history.
+	quint64 lastSequence() const;
 
 	/// Returns the name of the log file.
 	const QString& logFileName() const { return m_logFileName; }
 	
 	/// Returns true if logging to a file is enabled.
-	bool logFileEnabled() const { return m_logFileEnabled; }
+	bool logFileEnabled() const;
+
+	/// Returns the number of messages dropped because the queue was full.
+	size_t droppedCount() const { return size_t(m_droppedCount.load()); }
 
 	//  Internal functions -------------------------------------------
 
 private:
+	class consumer_t;
+	friend class consumer_t;
+
+	static void _flushAtExit();
+	void _consume();
+	void _processMessage(const FLogMessage& message);
 	void _writeLogFileMessage(const FLogMessage& message);
 	void _writeLogFileSessionStart();
 	void _writeLogFileSessionEnd();
@@ -82,17 +142,47 @@ private:
 	//  Internal data members ----------------------------------------
 
 private:
+	static const size_t QueueCapacity = 8192;
+	static const int BatchSize = 256;
+	static const int WakeInterval = 100;
+	static const int FatalFlushTimeout = 2000;
+	static const size_t HistoryCapacity = 10000;
+
 	mutable FCriticalSection m_objectLock;
 	QString m_logFileName;
+	FLogFile m_logFile;
 	bool m_logFileEnabled;
 
-    typedef std::vector<FLogMessage> messageVec_t;
-	messageVec_t m_messages;
+	FMpscQueueT<FLogMessage> m_queue;
+	consumer_t* m_pConsumer;
+	QMutex m_wakeMutex;
+	QWaitCondition m_wakeCondition;
+	QWaitCondition m_flushCondition;
+	QAtomicInt m_isConsumerWaiting;
+	bool m_isStopping;
+
+	QAtomicInt m_postedCount;
+	QAtomicInt m_processedCount;
+	QAtomicInt m_droppedCount;
+	int m_reportedDropCount;
+
+	mutable QReadWriteLock m_historyLock;
+	FLogHistory m_history;
 
 	typedef QList<FLogListener*> listenerList_t;
 	listenerList_t m_listeners;
 };
 	
+// Template members ------------------------------------------------------------
+
+template <typename VISITOR>
+quint64 FLogManager::visitMessages(VISITOR& visitor, quint64 sinceSequence,
+	FLogType type) const
+{
+	QReadLocker locker(&m_historyLock);
+	return m_history.visit(visitor, type, sinceSequence);
+}
+
 // -----------------------------------------------------------------------------
 
 #endif // FLOWCORE_LOGMANAGER_H
@@ -0,0 +1,217 @@
+// -----------------------------------------------------------------------------
+//  File        LzCodec.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/27 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/LzCodec.h"
+
+#include <cstring>
+
+// Helpers ---------------------------------------------------------------------
+
+static const int _hashBits = 14;
+static const size_t _minMatch = 4;
+static const size_t _maxOffset = 65535;
+
+// the last bytes of the input are always stored as literals
+static const size_t _lastLiterals = 5;
+static const size_t _matchLimit = 12;
+
+static inline uint32_t _fRead32(const char* p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t _fHash(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - _hashBits);
+}
+
+static inline char* _fWriteLength(char* op, size_t length)
+{
+	for (; length >= 255; length -= 255)
+		*op++ = char(255);
+
+	*op++ = char(length);
+	return op;
+}
+
+static inline bool _fReadLength(const uint8_t*& ip, const uint8_t* iend, size_t& length)
+{
+	uint8_t b;
+	do {
+		if (ip >= iend || length > (size_t(-1) >> 1))
+			return false;
+		b = *ip++;
+		length += b;
+	} while (b == 255);
+
+	return true;
+}
+
+/// Writes a literal run followed by a back reference. A zero offset
+/// denotes the last sequence, which has no back reference.
+static char* _fWriteSequence(char* op, char* oend, const char* pLiterals,
+	size_t literalCount, size_t offset, size_t matchLength)
+{
+	size_t required = 2 + literalCount / 255 + literalCount;
+	if (offset)
+		required += 3 + matchLength / 255;
+	if (size_t(oend - op) < required)
+		return NULL;
+
+	size_t matchCode = offset ? matchLength - _minMatch : 0;
+	*op++ = char(((literalCount < 15 ? literalCount : 15) << 4)
+		| (matchCode < 15 ? matchCode : 15));
+
+	if (literalCount >= 15)
+		op = _fWriteLength(op, literalCount - 15);
+
+	memcpy(op, pLiterals, literalCount);
+	op += literalCount;
+
+	if (offset) {
+		*op++ = char(offset & 0xff);
+		*op++ = char(offset >> 8);
+
+		if (matchCode >= 15)
+			op = _fWriteLength(op, matchCode - 15);
+	}
+
+	return op;
+}
+
+// -----------------------------------------------------------------------------
+//  Class FLzCodec
+// -----------------------------------------------------------------------------
+
+// Public static functions -----------------------------------------------------
+
+size_t FLzCodec::compressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t FLzCodec::compress(const char* pSrc, size_t srcSize,
+	char* pDst, size_t dstCapacity)
+{
+	const char* ip = pSrc;
+	const char* anchor = pSrc;
+	const char* iend = pSrc + srcSize;
+	char* op = pDst;
+	char* oend = pDst + dstCapacity;
+
+	if (srcSize > _matchLimit)
+	{
+		const char* mflimit = iend - _matchLimit;
+		const char* matchEnd = iend - _lastLiterals;
+
+		// positions of the last occurrence of 4-byte sequences, by hash
+		uint32_t table[1 << _hashBits];
+		memset(table, 0, sizeof(table));
+
+		while (ip < mflimit)
+		{
+			uint32_t seq = _fRead32(ip);
+			uint32_t h = _fHash(seq);
+			const char* ref = pSrc + table[h];
+			table[h] = uint32_t(ip - pSrc);
+
+			if (ref < ip && size_t(ip - ref) <= _maxOffset && _fRead32(ref) == seq)
+			{
+				// extend the match in both directions
+				while (ip > anchor && ref > pSrc && ip[-1] == ref[-1]) {
+					--ip;
+					--ref;
+				}
+
+				const char* p = ip + _minMatch;
+				const char* r = ref + _minMatch;
+				while (p < matchEnd && *p == *r) {
+					++p;
+					++r;
+				}
+
+				op = _fWriteSequence(op, oend, anchor, ip - anchor, ip - ref, p - ip);
+				if (!op)
+					return 0;
+
+				ip = anchor = p;
+
+				if (ip < mflimit)
+					table[_fHash(_fRead32(ip - 2))] = uint32_t(ip - 2 - pSrc);
+			}
+			else
+			{
+				// skip faster through incompressible data
+				ip += 1 + ((ip - anchor) >> 6);
+			}
+		}
+	}
+
+	op = _fWriteSequence(op, oend, anchor, iend - anchor, 0, 0);
+	return op ? size_t(op - pDst) : 0;
+}
+
+bool FLzCodec::decompress(const char* pSrc, size_t srcSize,
+	char* pDst, size_t dstSize)
+{
+	const uint8_t* ip = reinterpret_cast<const uint8_t*>(pSrc);
+	const uint8_t* iend = ip + srcSize;
+	char* op = pDst;
+	char* oend = pDst + dstSize;
+
+	while (ip < iend)
+	{
+		uint32_t token = *ip++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !_fReadLength(ip, iend, literalCount))
+			return false;
+		if (size_t(iend - ip) < literalCount || size_t(oend - op) < literalCount)
+			return false;
+
+		memcpy(op, ip, literalCount);
+		ip += literalCount;
+		op += literalCount;
+
+		// the last sequence consists of literals only
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return false;
+
+		size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > size_t(op - pDst))
+			return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !_fReadLength(ip, iend, matchLength))
+			return false;
+		matchLength += _minMatch;
+		if (size_t(oend - op) < matchLength)
+			return false;
+
+		// overlapping matches repeat a pattern, the distance between
+		// source and destination doubles with each copy
+		const char* ref = op - offset;
+		while (matchLength > 0) {
+			size_t n = fMin(size_t(op - ref), matchLength);
+			memcpy(op, ref, n);
+			op += n;
+			matchLength -= n;
+		}
+	}
+
+	return op == oend;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,55 @@
+// -----------------------------------------------------------------------------
+//  File        LzCodec.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/27 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_LZCODEC_H
+#define FLOWCORE_LZCODEC_H
+
+#include "FlowCore/Library.h"
+
+#include <cstddef>
+
+// -----------------------------------------------------------------------------
+//  Class FLzCodec
+// -----------------------------------------------------------------------------
+
+/// Fast LZ77 compression of memory blocks, trading compression ratio for
+/// speed. The compressed data is a sequence of literal runs and back
+/// references of at most 64 KB distance, similar to LZ4. Decompression
+/// validates the data and never reads or writes outside the given buffers.
+class FLOWCORE_EXPORT FLzCodec
+{
+	//  Constructors and destructor ----------------------------------
+
+private:
+	/// Private constructor. Class provides only static methods
+	FLzCodec();
+
+	//  Public static functions --------------------------------------
+
+public:
+	/// Returns the maximum size of the compressed data for the given
+	/// number of input bytes. Incompressible data grows slightly.
+	static size_t compressBound(size_t srcSize);
+
+	/// Compresses srcSize bytes from pSrc into pDst, which must provide
+	/// space for dstCapacity bytes. Returns the compressed size, or 0 if
+	/// the compressed data doesn't fit into the destination.
+	static size_t compress(const char* pSrc, size_t srcSize,
+		char* pDst, size_t dstCapacity);
+
+	/// Decompresses srcSize bytes from pSrc into pDst. The size of the
+	/// decompressed data must be known and equal to dstSize. Returns false
+	/// if the compressed data is corrupt.
+	static bool decompress(const char* pSrc, size_t srcSize,
+		char* pDst, size_t dstSize);
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_LZCODEC_H
@@ -0,0 +1,230 @@
+// -----------------------------------------------------------------------------
+//  File        MappedFile.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/26 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/MappedFile.h"
+#include "FlowCore/Log.h"
+
+#include <QFile>
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+#  include "FlowCore/Windows.h"
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------------
+//  Class FFileMapping
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FFileMapping::FFileMapping(char* pBase, qint64 baseSize, char* pData, qint64 size)
+: m_pBase(pBase),
+  m_baseSize(baseSize),
+  m_pData(pData),
+  m_size(size),
+  m_refCount(1)
+{
+}
+
+FFileMapping::~FFileMapping()
+{
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	UnmapViewOfFile(m_pBase);
+#else
+	munmap(m_pBase, size_t(m_baseSize));
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//  Class FMappedFile
+// -----------------------------------------------------------------------------
+
+// Constructors and destructor -------------------------------------------------
+
+FMappedFile::FMappedFile()
+: m_pMapping(NULL),
+  m_mode(ReadOnly)
+{
+}
+
+FMappedFile::FMappedFile(const QString& filePath, Mode mode /* = ReadOnly */)
+: m_pMapping(NULL),
+  m_mode(mode)
+{
+	map(filePath, mode);
+}
+
+FMappedFile::FMappedFile(const FMappedFile& other)
+: m_pMapping(other.m_pMapping),
+  m_mode(other.m_mode)
+{
+	if (m_pMapping)
+		m_pMapping->ref();
+}
+
+FMappedFile& FMappedFile::operator=(const FMappedFile& other)
+{
+	if (other.m_pMapping)
+		other.m_pMapping->ref();
+
+	unmap();
+	m_pMapping = other.m_pMapping;
+	m_mode = other.m_mode;
+	return *this;
+}
+
+FMappedFile::~FMappedFile()
+{
+	unmap();
+}
+
+// Public commands -------------------------------------------------------------
+
+bool FMappedFile::map(const QString& filePath, Mode mode /* = ReadOnly */,
+	qint64 offset /* = 0 */, qint64 size /* = -1 */)
+{
+	F_ASSERT(offset >= 0);
+
+	unmap();
+	m_mode = mode;
+
+	char* pBase = NULL;
+	qint64 fileSize = 0;
+	qint64 delta = 0;
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	HANDLE hFile = CreateFileW((LPCWSTR)filePath.utf16(), GENERIC_READ,
+		FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE) {
+		F_WARNING("FMappedFile") << "failed to open '" << filePath << "'";
+		return false;
+	}
+
+	LARGE_INTEGER li;
+	GetFileSizeEx(hFile, &li);
+	fileSize = li.QuadPart;
+
+	// the view must start at a multiple of the allocation granularity
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	delta = offset % info.dwAllocationGranularity;
+
+	if (size < 0)
+		size = fileSize - offset;
+
+	if (size > 0 && offset + size <= fileSize)
+	{
+		HANDLE hMapping = CreateFileMappingW(hFile, NULL,
+			mode == ReadOnly ? PAGE_READONLY : PAGE_WRITECOPY, 0, 0, NULL);
+
+		if (hMapping) {
+			qint64 start = offset - delta;
+			pBase = (char*)MapViewOfFile(hMapping,
+				mode == ReadOnly ? FILE_MAP_READ : FILE_MAP_COPY,
+				DWORD(start >> 32), DWORD(start & 0xffffffff), SIZE_T(size + delta));
+
+			// the view keeps the mapping object alive
+			CloseHandle(hMapping);
+		}
+	}
+
+	CloseHandle(hFile);
+#else
+	int fd = ::open(QFile::encodeName(filePath).constData(), O_RDONLY);
+
+	if (fd < 0) {
+		F_WARNING("FMappedFile") << "failed to open '" << filePath << "'";
+		return false;
+	}
+
+	struct stat st;
+	fileSize = fstat(fd, &st) == 0 ? qint64(st.st_size) : 0;
+
+	// the mapping must start at a multiple of the page size
+	delta = offset % qint64(sysconf(_SC_PAGESIZE));
+
+	if (size < 0)
+		size = fileSize - offset;
+
+	if (size > 0 && offset + size <= fileSize)
+	{
+		void* p = mmap(NULL, size_t(size + delta),
+			mode == ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, off_t(offset - delta));
+
+		if (p != MAP_FAILED)
+			pBase = (char*)p;
+	}
+
+	// the mapping remains valid after closing the file
+	::close(fd);
+#endif
+
+	if (!pBase) {
+		F_WARNING("FMappedFile") << "failed to map " << size << " bytes at offset "
+			<< offset << " of '" << filePath << "' (" << fileSize << " bytes)";
+		return false;
+	}
+
+	m_pMapping = new FFileMapping(pBase, size + delta, pBase + delta, size);
+	return true;
+}
+
+void FMappedFile::unmap()
+{
+	if (m_pMapping) {
+		m_pMapping->release();
+		m_pMapping = NULL;
+	}
+}
+
+// Public queries --------------------------------------------------------------
+
+#define _F_MF_ARRAY(valueType, realType) \
+	case FValueType::valueType: return array<realType>(offset, channels, dimensions);
+
+FValueArray FMappedFile::array(FValueType type, qint64 offset,
+	FValueArray::size_type channels, FValueArray::size_type dimensions /* = 1 */) const
+{
+	switch (type)
+	{
+		_F_MF_ARRAY(Float,  float   );
+		_F_MF_ARRAY(Double, double  );
+		_F_MF_ARRAY(Bool,   bool    );
+		_F_MF_ARRAY(Int8,   qint8   );
+		_F_MF_ARRAY(UInt8,  quint8  );
+		_F_MF_ARRAY(Int16,  qint16  );
+		_F_MF_ARRAY(UInt16, quint16 );
+		_F_MF_ARRAY(Int32,  qint32  );
+		_F_MF_ARRAY(UInt32, quint32 );
+		_F_MF_ARRAY(Int64,  qint64  );
+		_F_MF_ARRAY(UInt64, quint64 );
+
+	default:
+		F_ASSERT(false);
+		return FValueArray();
+	}
+}
+
+// Internal functions ----------------------------------------------------------
+
+void FMappedFile::_reference(FValueArray& array) const
+{
+	F_ASSERT(array.isReference() && !array.m_pMapping);
+
+	m_pMapping->ref();
+	array.m_pMapping = m_pMapping;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+// -----------------------------------------------------------------------------
+//  File        MappedFile.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/26 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_MAPPEDFILE_H
+#define FLOWCORE_MAPPEDFILE_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/ValueArray.h"
+
+#include <QString>
+#include <QAtomicInt>
+
+// -----------------------------------------------------------------------------
+//  Class FFileMapping
+// -----------------------------------------------------------------------------
+
+/// A region of a file mapped into memory. The mapping is shared by
+/// FMappedFile handles and the value arrays referencing its data, it is
+/// unmapped when the last of them releases it. Use FMappedFile to create
+/// mappings.
+class FLOWCORE_EXPORT FFileMapping
+{
+	F_DISABLE_COPY(FFileMapping);
+	friend class FMappedFile;
+
+	//  Public commands ----------------------------------------------
+
+public:
+	/// Adds a reference to the mapping.
+	void ref() { m_refCount.ref(); }
+	/// Releases a reference, the last reference unmaps the file.
+	void release() { if (!m_refCount.deref()) delete this; }
+
+	//  Constructors and destructor ----------------------------------
+
+private:
+	FFileMapping(char* pBase, qint64 baseSize, char* pData, qint64 size);
+	~FFileMapping();
+
+	//  Internal data members ----------------------------------------
+
+	char* m_pBase;
+	qint64 m_baseSize;
+	char* m_pData;
+	qint64 m_size;
+	QAtomicInt m_refCount;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FMappedFile
+// -----------------------------------------------------------------------------
+
+/// Maps a file region into memory and exposes its contents as value arrays
+/// in reference mode, without copying. Pages are loaded by the operating
+/// system on first access, so even very large files open instantly.
+///
+/// FMappedFile is a handle, copies share the same mapping. Value arrays
+/// obtained from array() keep the mapping alive after all handles are gone.
+class FLOWCORE_EXPORT FMappedFile
+{
+	//  Public types -------------------------------------------------
+
+public:
+	enum Mode
+	{
+		/// The data can only be read. Writing to it, e.g. via the
+		/// non-const accessors of the value arrays, is an access violation.
+		ReadOnly = 0,
+		/// The data can be modified, modified pages are private copies
+		/// and are never written back to the file.
+		CopyOnWrite
+	};
+
+	//  Constructors and destructor ----------------------------------
+
+	/// Default constructor, creates an unmapped handle.
+	FMappedFile();
+	/// Creates a handle and maps the given file, see map().
+	FMappedFile(const QString& filePath, Mode mode = ReadOnly);
+	/// Copy constructor, the copy shares the mapping.
+	FMappedFile(const FMappedFile& other);
+	/// Assignment operator, shares the mapping of other.
+	FMappedFile& operator=(const FMappedFile& other);
+
+	/// Destructor. Releases the reference to the mapping.
+	~FMappedFile();
+
+	//  Public commands ----------------------------------------------
+
+	/// Maps size bytes of the given file, starting at offset. A size of -1
+	/// maps up to the end of the file. The offset needs no alignment.
+	/// Returns false and leaves the handle unmapped if the file can't
+	/// be mapped.
+	bool map(const QString& filePath, Mode mode = ReadOnly,
+		qint64 offset = 0, qint64 size = -1);
+
+	/// Releases the mapping held by this handle. Value arrays referencing
+	/// the data remain valid.
+	void unmap();
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns a value array referencing channels * dimensions values
+	/// of type T at the given byte offset into the mapped region. The
+	/// offset should be a multiple of the size of T.
+	template <typename T>
+	FValueArray array(qint64 offset, FValueArray::size_type channels,
+		FValueArray::size_type dimensions = 1) const;
+
+	/// Returns a value array referencing numeric values of the given type.
+	FValueArray array(FValueType type, qint64 offset,
+		FValueArray::size_type channels, FValueArray::size_type dimensions = 1) const;
+
+	/// Returns true if a file region is mapped.
+	bool isMapped() const { return m_pMapping != NULL; }
+	/// Returns the mode of the mapping.
+	Mode mode() const { return m_mode; }
+	/// Returns a pointer to the start of the mapped region.
+	const char* data() const { return m_pMapping ? m_pMapping->m_pData : NULL; }
+	/// Returns the size of the mapped region in bytes.
+	qint64 size() const { return m_pMapping ? m_pMapping->m_size : 0; }
+
+	//  Internal functions -------------------------------------------
+
+private:
+	void _reference(FValueArray& array) const;
+
+	//  Internal data members ----------------------------------------
+
+	FFileMapping* m_pMapping;
+	Mode m_mode;
+};
+
+// Public queries --------------------------------------------------------------
+
+template <typename T>
+FValueArray FMappedFile::array(qint64 offset, FValueArray::size_type channels,
+	FValueArray::size_type dimensions /* = 1 */) const
+{
+	F_ASSERT(m_pMapping);
+	F_ASSERT(offset >= 0 && offset + qint64(channels) * qint64(dimensions) * qint64(sizeof(T)) <= size());
+
+	FValueArray result((T*)(m_pMapping->m_pData + offset), channels, dimensions, true);
+	_reference(result);
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_MAPPEDFILE_H
@@ -8,6 +8,8 @@
 // -----------------------------------------------------------------------------
 
 #include "FlowCore/Math.h"
+#include "FlowCore/SimdKernels.h"
+
 #include <math.h>
 
 // -----------------------------------------------------------------------------
@@ -24,4 +26,56 @@ const double FMath::e = 2.7182818284590452353602874713526624977572;
 const double FMath::r2d = 57.295779513082320876798154814114;
 const double FMath::d2r = 0.017453292519943295769236907684883;
 
+// Approximations --------------------------------------------------------------
+
+void FMath::approxSin(const float* pSrc, float* pDst, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxSin,
+		pSrc, NULL, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxCos(const float* pSrc, float* pDst, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxCos,
+		pSrc, NULL, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxSinCos(const float* pSrc, float* pSin, float* pCos, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxSinCos,
+		pSrc, NULL, pSin, pCos, count, accuracy == Precise);
+}
+
+void FMath::approxExp(const float* pSrc, float* pDst, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxExp,
+		pSrc, NULL, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxLog(const float* pSrc, float* pDst, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxLog,
+		pSrc, NULL, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxPow(const float* pBase, const float* pExponent, float* pDst, size_t count,
+	Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxPow,
+		pBase, pExponent, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxAtan2(const float* pY, const float* pX, float* pDst, size_t count,
+	Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxAtan2,
+		pY, pX, pDst, NULL, count, accuracy == Precise);
+}
+
+void FMath::approxAcos(const float* pSrc, float* pDst, size_t count, Accuracy accuracy)
+{
+	FSimdKernels::current().approx(FSimdKernels::ApproxAcos,
+		pSrc, NULL, pDst, NULL, count, accuracy == Precise);
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
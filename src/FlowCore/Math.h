@@ -35,6 +35,18 @@ private:
 	/// Private constructor. Class contains only static members.
 	FMath();
 
+	//  Public types -------------------------------------------------
+
+public:
+	/// Accuracy of the approximated transcendental functions.
+	enum Accuracy
+	{
+		/// Maximum error in the order of 1e-4.
+		Fast = 0,
+		/// Maximum error in the order of 1e-7.
+		Precise
+	};
+
 	//  Public static constants --------------------------------------
 
 public:
@@ -103,6 +115,46 @@ public:
 		f = fMax(REAL(0.0), fMin(REAL(1.0), f));
 		return outMin + f * (outMax - outMin);
 	}
+
+	//  Approximations -----------------------------------------------
+
+	// The following functions evaluate polynomial approximations for arrays
+	// of floats, processing 4 or 8 elements in parallel depending on the SIMD
+	// tier selected by FCpu. Source and destination may be identical. The
+	// same approximations are available for FFastVec4f (fSin(), fExp() etc.).
+	// Measured maximum errors (fast / precise):
+	// - sin, cos: absolute 4e-4 / 1e-7 for |x| <= 1e4
+	// - exp: relative 8e-5 / 1e-7
+	// - log: relative 3e-5 / 3e-7
+	// - pow: relative 1e-4 / 2e-6 for |exponent * log(base)| <= 10
+	// - atan2: absolute 3e-4 / 3e-7
+	// - acos: absolute 7e-5 / 5e-7
+
+	/// Computes the sine of count values.
+	static void approxSin(const float* pSrc, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes the cosine of count values.
+	static void approxCos(const float* pSrc, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes sine and cosine of count values.
+	static void approxSinCos(const float* pSrc, float* pSin, float* pCos, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes e^x for count values. Results below e^-87.3 are flushed to zero,
+	/// NaN values are passed through.
+	static void approxExp(const float* pSrc, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes the natural logarithm of count values.
+	static void approxLog(const float* pSrc, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes base^exponent for count pairs of values. The base must be positive.
+	static void approxPow(const float* pBase, const float* pExponent, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes atan2(y, x) for count pairs of finite values.
+	static void approxAtan2(const float* pY, const float* pX, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
+	/// Computes the arc cosine of count values in [-1, 1].
+	static void approxAcos(const float* pSrc, float* pDst, size_t count,
+		Accuracy accuracy = Precise);
 };
 	
 // -----------------------------------------------------------------------------
@@ -0,0 +1,225 @@
+// -----------------------------------------------------------------------------
+//  File        MathSimd.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/21 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_MATHSIMD_H
+#define FLOWCORE_MATHSIMD_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Intrinsics.h"
+
+#include <float.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+//  Approximations of transcendental functions
+// -----------------------------------------------------------------------------
+
+// Polynomial approximations operating on 4 floats, used by the FFastVec4f
+// functions and the SSE4 array kernels (see FMath::approxSin() etc.). The
+// AVX2 kernels use the same coefficients and reduction steps. Each function
+// comes in a fast (PRECISE = false) and a precise (PRECISE = true) variant.
+
+/// Coefficients of sin(r) = r * P(r^2) and cos(r) = P(r^2) for
+/// r in [-pi/4, pi/4], fast variant.
+static const float _fSinFast[2] = { 0.99961353f, -0.16160381f };
+static const float _fCosFast[3] = { 0.99998826f, -0.49968574f, 0.040362617f };
+
+/// Same as above, precise variant (Cephes sinf/cosf). Coefficients start
+/// at the term r^3 and r^4 respectively.
+static const float _fSinPrecise[3] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+static const float _fCosPrecise[3] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+
+/// Coefficients of exp(r) = P(r) for r in [-ln(2)/2, ln(2)/2], fast variant.
+static const float _fExpFast[4] = { 0.99992807f, 1.0001642f, 0.50496326f, 0.16566829f };
+
+/// Coefficients of exp(r) = 1 + r + r^2 * P(r), precise variant (Cephes expf),
+/// highest order first.
+static const float _fExpPrecise[6] = {
+	1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+	4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f
+};
+
+/// Coefficients of log(m) = s * P(s^2) with s = (m - 1) / (m + 1) for
+/// m in [sqrt(0.5), sqrt(2)].
+static const float _fLogFast[2] = { 1.9999554f, 0.67868850f };
+static const float _fLogPrecise[4] = { 2.0f, 0.66666816f, 0.39974766f, 0.29926328f };
+
+/// Coefficients of atan(t) = t * P(t^2) for t in [0, tan(pi/8)].
+static const float _fAtanFast[2] = { 0.99938251f, -0.30274713f };
+static const float _fAtanPrecise[5] = { 0.99999998f, -0.33332808f, 0.19974736f, -0.13854548f, 0.079938796f };
+
+/// Coefficients of acos(x) = sqrt(1 - x) * P(x) for x in [0, 1]
+/// (Abramowitz/Stegun 4.4.45 and 4.4.46), absolute error <= 7e-5 and 2e-8.
+static const float _fAcosFast[4] = { 1.5707288f, -0.2121144f, 0.0742610f, -0.0187293f };
+static const float _fAcosCoeffs[8] = {
+	1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+	0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f
+};
+
+/// Evaluates the polynomial with n coefficients (lowest order first) at x.
+static inline __m128 _fPoly4(__m128 x, const float* c, size_t n)
+{
+	__m128 r = _mm_set1_ps(c[n - 1]);
+	for (size_t i = n - 1; i > 0; --i)
+		r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(c[i - 1]));
+	return r;
+}
+
+static inline __m128 _fSignMask4()
+{
+	return _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+}
+
+/// Computes sine and cosine. The argument is reduced to [-pi/4, pi/4] in
+/// three steps, results are accurate for |x| up to about 1e5.
+template <bool PRECISE>
+static inline void _fSinCos4(__m128 x, __m128& s, __m128& c)
+{
+	__m128 j = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(0.63661977f)),
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(4.837512969970703125e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(7.54978995489188216e-8f)));
+	__m128i q = _mm_cvtps_epi32(j);
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 ps, pc;
+	if (PRECISE) {
+		ps = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), _fPoly4(r2, _fSinPrecise, 3)));
+		pc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))),
+			_mm_mul_ps(_mm_mul_ps(r2, r2), _fPoly4(r2, _fCosPrecise, 3)));
+	}
+	else {
+		ps = _mm_mul_ps(r, _fPoly4(r2, _fSinFast, 2));
+		pc = _fPoly4(r2, _fCosFast, 3);
+	}
+
+	// odd quadrants swap sine and cosine, the signs follow from bit 1
+	// of the quadrant for the sine and of the quadrant + 1 for the cosine
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+		_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 signS = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+	__m128 signC = _mm_castsi128_ps(_mm_slli_epi32(
+		_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+	s = _mm_xor_ps(_mm_blendv_ps(ps, pc, swap), signS);
+	c = _mm_xor_ps(_mm_blendv_ps(pc, ps, swap), signC);
+}
+
+/// Computes e^x. Results below e^-87.3 are flushed to zero, results
+/// above e^88.3 are infinite, NaN is passed through.
+template <bool PRECISE>
+static inline __m128 _fExp4(__m128 x)
+{
+	const __m128 lo = _mm_set1_ps(-87.3f);
+	const __m128 hi = _mm_set1_ps(88.3f);
+	// min/max return the second operand if one is NaN, keep NaN in xc
+	__m128 xc = _mm_min_ps(hi, _mm_max_ps(lo, x));
+
+	__m128 n = _mm_round_ps(_mm_mul_ps(xc, _mm_set1_ps(1.44269504f)),
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m128 r = _mm_sub_ps(xc, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+	r = _mm_add_ps(r, _mm_mul_ps(n, _mm_set1_ps(2.12194440e-4f)));
+
+	__m128 p;
+	if (PRECISE) {
+		p = _mm_set1_ps(_fExpPrecise[0]);
+		for (size_t i = 1; i < 6; ++i)
+			p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(_fExpPrecise[i]));
+		p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, r), p), r), _mm_set1_ps(1.0f));
+	}
+	else {
+		p = _fPoly4(r, _fExpFast, 4);
+	}
+
+	__m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+	__m128 result = _mm_mul_ps(p, _mm_castsi128_ps(e));
+
+	result = _mm_and_ps(result, _mm_cmpnlt_ps(x, lo));
+	return _mm_blendv_ps(result, _mm_set1_ps(HUGE_VALF), _mm_cmpgt_ps(x, hi));
+}
+
+/// Computes the natural logarithm. Returns -inf for zero,
+/// NaN for negative values and inf for inf.
+template <bool PRECISE>
+static inline __m128 _fLog4(__m128 x)
+{
+	// scale denormals into the normal range
+	__m128 denormal = _mm_cmplt_ps(x, _mm_set1_ps(FLT_MIN));
+	__m128 xs = _mm_blendv_ps(x, _mm_mul_ps(x, _mm_set1_ps(8388608.0f)), denormal);
+	__m128i xi = _mm_castps_si128(xs);
+
+	__m128i e = _mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(127));
+	e = _mm_sub_epi32(e, _mm_and_si128(_mm_castps_si128(denormal), _mm_set1_epi32(23)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(
+		_mm_and_si128(xi, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+	// move the mantissa from [1, 2) to [sqrt(0.5), sqrt(2))
+	__m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+	m = _mm_blendv_ps(m, _mm_mul_ps(m, _mm_set1_ps(0.5f)), large);
+	e = _mm_sub_epi32(e, _mm_castps_si128(large));
+	__m128 ef = _mm_cvtepi32_ps(e);
+
+	__m128 s = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_add_ps(m, _mm_set1_ps(1.0f)));
+	__m128 s2 = _mm_mul_ps(s, s);
+	__m128 p = PRECISE ? _fPoly4(s2, _fLogPrecise, 4) : _fPoly4(s2, _fLogFast, 2);
+
+	__m128 result = _mm_add_ps(_mm_mul_ps(ef, _mm_set1_ps(0.693359375f)),
+		_mm_sub_ps(_mm_mul_ps(s, p), _mm_mul_ps(ef, _mm_set1_ps(2.12194440e-4f))));
+
+	result = _mm_blendv_ps(result, _mm_set1_ps(-HUGE_VALF), _mm_cmpeq_ps(x, _mm_setzero_ps()));
+	result = _mm_blendv_ps(result, x, _mm_cmpeq_ps(x, _mm_set1_ps(HUGE_VALF)));
+	return _mm_or_ps(result, _mm_cmpnge_ps(x, _mm_setzero_ps()));
+}
+
+/// Computes x^y for x > 0.
+template <bool PRECISE>
+static inline __m128 _fPow4(__m128 x, __m128 y)
+{
+	return _fExp4<PRECISE>(_mm_mul_ps(y, _fLog4<PRECISE>(x)));
+}
+
+/// Computes atan2(y, x) in [-pi, pi].
+template <bool PRECISE>
+static inline __m128 _fAtan24(__m128 y, __m128 x)
+{
+	const __m128 sign = _fSignMask4();
+	__m128 ax = _mm_andnot_ps(sign, x);
+	__m128 ay = _mm_andnot_ps(sign, y);
+
+	// t = min / max in [0, 1], reduced to [0, tan(pi/8)]
+	__m128 mx = _mm_max_ps(ax, ay);
+	__m128 t = _mm_div_ps(_mm_min_ps(ax, ay), mx);
+	t = _mm_and_ps(t, _mm_cmpgt_ps(mx, _mm_setzero_ps()));
+	__m128 reduce = _mm_cmpgt_ps(t, _mm_set1_ps(0.41421356f));
+	t = _mm_blendv_ps(t, _mm_div_ps(_mm_sub_ps(t, _mm_set1_ps(1.0f)),
+		_mm_add_ps(t, _mm_set1_ps(1.0f))), reduce);
+
+	__m128 t2 = _mm_mul_ps(t, t);
+	__m128 a = _mm_mul_ps(t, PRECISE ? _fPoly4(t2, _fAtanPrecise, 5) : _fPoly4(t2, _fAtanFast, 2));
+	a = _mm_add_ps(a, _mm_and_ps(reduce, _mm_set1_ps(0.78539816f)));
+
+	a = _mm_blendv_ps(a, _mm_sub_ps(_mm_set1_ps(1.57079633f), a), _mm_cmpgt_ps(ay, ax));
+	a = _mm_blendv_ps(a, _mm_sub_ps(_mm_set1_ps(3.14159265f), a), x);
+	return _mm_xor_ps(a, _mm_and_ps(y, sign));
+}
+
+/// Computes acos(x) for x in [-1, 1].
+template <bool PRECISE>
+static inline __m128 _fAcos4(__m128 x)
+{
+	__m128 ax = _mm_min_ps(_mm_andnot_ps(_fSignMask4(), x), _mm_set1_ps(1.0f));
+	__m128 p = PRECISE ? _fPoly4(ax, _fAcosCoeffs, 8) : _fPoly4(ax, _fAcosFast, 4);
+	__m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), ax)), p);
+	return _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(3.14159265f), r), x);
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_MATHSIMD_H
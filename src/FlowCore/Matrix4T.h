@@ -12,6 +12,7 @@
 
 #include "FlowCore/Library.h"
 
+#include "FlowCore/Vector2T.h"
 #include "FlowCore/Vector4T.h"
 #include "FlowCore/QuaternionT.h"
 #include "FlowCore/Matrix3T.h"
@@ -824,10 +825,10 @@ void FMatrix4T<REAL>::makeProjectionOrthogonalLH(
 {
 	REAL width2 = width * REAL(0.5);
 	REAL height2 = height * REAL(0.5);
-	REAL left = center.x() - width2;
-	REAL right = center.x() + width2;
-	REAL bottom = center.y() - height2;
-	REAL top = center.y() + height2;
+	REAL left = center.x - width2;
+	REAL right = center.x + width2;
+	REAL bottom = center.y - height2;
+	REAL top = center.y + height2;
 
 	m_row[0][0] = REAL(2.0) / width;
 	m_row[1][1] = REAL(2.0) / height;
@@ -846,10 +847,10 @@ void FMatrix4T<REAL>::makeProjectionOrthogonalRH(
 	REAL width, REAL height, REAL n, REAL f,
 	const FVector2T<REAL> center /* = FVector2T<REAL> */)
 {
-	REAL left = center.x() - width * REAL(0.5);;
-	REAL right = center.x() + width * REAL(0.5);;
-	REAL bottom = center.y() - height * REAL(0.5);
-	REAL top = center.y() + height * REAL(0.5);
+	REAL left = center.x - width * REAL(0.5);;
+	REAL right = center.x + width * REAL(0.5);;
+	REAL bottom = center.y - height * REAL(0.5);
+	REAL top = center.y + height * REAL(0.5);
 
 	m_row[0][0] = REAL(2.0) / width;
 	m_row[1][1] = REAL(2.0) / height;
@@ -881,10 +882,10 @@ void FMatrix4T<REAL>::makeProjectionPerspectiveLH(
 		height = width / aspect;
 	}
 
-	REAL left = center.x() - width * REAL(0.5);;
-	REAL right = center.x() + width * REAL(0.5);;
-	REAL bottom = center.y() - height * REAL(0.5);
-	REAL top = center.y() + height * REAL(0.5);
+	REAL left = center.x - width * REAL(0.5);;
+	REAL right = center.x + width * REAL(0.5);;
+	REAL bottom = center.y - height * REAL(0.5);
+	REAL top = center.y + height * REAL(0.5);
 
 	m_row[0][0] = REAL(2.0) * n / width;
 	m_row[0][2] = -(left + right) / width;
@@ -916,10 +917,10 @@ void FMatrix4T<REAL>::makeProjectionPerspectiveRH(
 		height = width / aspect;
 	}
 
-	REAL left = center.x() - width * REAL(0.5);;
-	REAL right = center.x() + width * REAL(0.5);;
-	REAL bottom = center.y() - height * REAL(0.5);
-	REAL top = center.y() + height * REAL(0.5);
+	REAL left = center.x - width * REAL(0.5);;
+	REAL right = center.x + width * REAL(0.5);;
+	REAL bottom = center.y - height * REAL(0.5);
+	REAL top = center.y + height * REAL(0.5);
 
 	m_row[0][0] = REAL(2.0) * n / width;
 	m_row[0][2] = (left + right) / width;
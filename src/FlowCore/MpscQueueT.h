@@ -0,0 +1,165 @@
+// -----------------------------------------------------------------------------
+//  File        MpscQueueT.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_MPSCQUEUET_H
+#define FLOWCORE_MPSCQUEUET_H
+
+#include "FlowCore/Library.h"
+
+#include <QAtomicInt>
+
+// -----------------------------------------------------------------------------
+//  Class FMpscQueueT
+// -----------------------------------------------------------------------------
+
+/// Bounded lock-free queue for multiple producer threads and a single
+/// consumer thread. The queue is a ring of cells, each cell carries a
+/// sequence number telling producers and the consumer whether the cell
+/// is free or holds a value. Producers never block: if the queue is full,
+/// enqueue() fails and the value is not stored.
+template <typename T>
+class FMpscQueueT
+{
+	F_DISABLE_COPY(FMpscQueueT);
+
+	//  Constructors and destructor ----------------------------------
+
+public:
+	/// Creates a queue holding up to the given number of values. The
+	/// capacity is rounded up to the next power of two.
+	FMpscQueueT(size_t capacity);
+	/// Destructor. Values remaining in the queue are discarded.
+	~FMpscQueueT();
+
+	//  Public commands ----------------------------------------------
+
+	/// Adds a value to the queue. Can be called from any thread.
+	/// Returns false if the queue is full.
+	bool enqueue(const T& value);
+	/// Removes the oldest value from the queue. Must only be called from
+	/// the consumer thread. Returns false if the queue is empty.
+	bool dequeue(T& value);
+
+	//  Public queries -----------------------------------------------
+
+	/// Returns the maximum number of values in the queue.
+	size_t capacity() const { return m_mask + 1; }
+	/// Returns true if the queue holds no values. The result is a snapshot
+	/// and may be outdated if other threads add values concurrently.
+	bool isEmpty() const;
+
+	//  Internal data members ----------------------------------------
+
+private:
+	struct cell_t
+	{
+		QAtomicInt sequence;
+		T data;
+	};
+
+	cell_t* m_pCells;
+	quint32 m_mask;
+
+	char m_padding0[64];
+	QAtomicInt m_enqueuePos;
+	char m_padding1[64];
+	QAtomicInt m_dequeuePos;
+	char m_padding2[64];
+};
+
+// Constructors and destructor -------------------------------------------------
+
+template <typename T>
+FMpscQueueT<T>::FMpscQueueT(size_t capacity)
+: m_enqueuePos(0),
+  m_dequeuePos(0)
+{
+	F_ASSERT(capacity > 0 && capacity <= 0x40000000);
+
+	quint32 size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	m_mask = size - 1;
+	m_pCells = new cell_t[size];
+
+	for (quint32 i = 0; i < size; ++i)
+		m_pCells[i].sequence.store(int(i));
+}
+
+template <typename T>
+FMpscQueueT<T>::~FMpscQueueT()
+{
+	delete[] m_pCells;
+}
+
+// Public commands -------------------------------------------------------------
+
+template <typename T>
+bool FMpscQueueT<T>::enqueue(const T& value)
+{
+	cell_t* pCell;
+	quint32 pos = quint32(m_enqueuePos.load());
+
+	for (;;) {
+		pCell = &m_pCells[pos & m_mask];
+		quint32 sequence = quint32(pCell->sequence.loadAcquire());
+		int diff = int(sequence - pos);
+
+		if (diff == 0) {
+			// cell is free, try to claim it
+			if (m_enqueuePos.testAndSetRelaxed(int(pos), int(pos + 1)))
+				break;
+			pos = quint32(m_enqueuePos.load());
+		}
+		else if (diff < 0) {
+			// cell still holds the value from the previous round
+			return false;
+		}
+		else {
+			// another producer claimed the cell
+			pos = quint32(m_enqueuePos.load());
+		}
+	}
+
+	pCell->data = value;
+	pCell->sequence.storeRelease(int(pos + 1));
+	return true;
+}
+
+template <typename T>
+bool FMpscQueueT<T>::dequeue(T& value)
+{
+	quint32 pos = quint32(m_dequeuePos.load());
+	cell_t* pCell = &m_pCells[pos & m_mask];
+	quint32 sequence = quint32(pCell->sequence.loadAcquire());
+
+	if (int(sequence - (pos + 1)) < 0)
+		return false;
+
+	value = pCell->data;
+	pCell->data = T();
+	pCell->sequence.storeRelease(int(pos + m_mask + 1));
+	m_dequeuePos.store(int(pos + 1));
+	return true;
+}
+
+// Public queries --------------------------------------------------------------
+
+template <typename T>
+bool FMpscQueueT<T>::isEmpty() const
+{
+	quint32 pos = quint32(m_dequeuePos.load());
+	quint32 sequence = quint32(m_pCells[pos & m_mask].sequence.loadAcquire());
+	return int(sequence - (pos + 1)) < 0;
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_MPSCQUEUET_H
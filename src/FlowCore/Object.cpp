@@ -36,10 +36,6 @@ const FTypeInfo* FObject::dynamicType() const {
 	return &FObject::typeInfo;
 }
 
-bool FObject::isKindOf(const FTypeInfo* pClass) const {
-	return dynamicType()->isDerivedFrom(pClass);
-}
-
 QString FObject::toString() const
 {
 	return dynamicType()->typeName();
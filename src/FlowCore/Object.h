@@ -21,6 +21,7 @@
 
 class FArchive;
 class FTypeInfo;
+class FSlabAllocator;
 
 class FLOWCORE_EXPORT FObject
 {
@@ -90,6 +91,13 @@ public:
 #endif
 };
 
+// Inline members --------------------------------------------------------------
+
+inline bool FObject::isKindOf(const FTypeInfo* pClass) const
+{
+	return dynamicType()->isDerivedFrom(pClass);
+}
+
 // Macro definitions -----------------------------------------------------------
 
 /// Creates an object of the given class, using its default constructor.
@@ -138,6 +146,20 @@ protected: \
 	className() { } \
 	F_DECLARE_SERIALIZABLE_CUSTOM_DC(className)
 
+/// Allocates the objects of a class from a slab allocator of its own, see
+/// FSlabAllocator. Must be used in the class declaration in a header file,
+/// together with F_IMPLEMENT_SLAB_ALLOCATED in the implementation.
+#define F_DECLARE_SLAB_ALLOCATED(className) \
+private: \
+	static void* _slabAllocate(size_t size); \
+	static void _slabDeallocate(void* p, size_t size); \
+public: \
+	static void* operator new(size_t size) { return _slabAllocate(size); } \
+	static void* operator new(size_t, void* p) { return p; } \
+	static void operator delete(void* p, size_t size) { _slabDeallocate(p, size); } \
+	static void operator delete(void*, void*) { } \
+	static FSlabAllocator* slabAllocator();
+
 // Macros for implementation ---------------------------------------------------
 
 #define F_IMPLEMENT_TYPEINFO_CLASS(className, baseClassName, version, pfnCreate) \
@@ -171,6 +193,22 @@ protected: \
 	pObject = static_cast<className*>(ar.readObject(className::staticType())); return ar; } \
 	F_IMPLEMENT_TYPEINFO_CLASS(className, baseClassName, version, className::createObject)
 
+/// Implements the slab allocator of a class. The size of the blocks is the
+/// size of the class given by its type information. The allocator is created
+/// on first use and never destroyed, objects in static variables may be
+/// deleted at any time. Requires FlowCore/Allocator.h.
+#define F_IMPLEMENT_SLAB_ALLOCATED(className) \
+	static QBasicAtomicPointer<FSlabAllocator> s_p##className##SlabAllocator; \
+	FSlabAllocator* className::slabAllocator() { \
+		return FSlabAllocator::sharedAllocator(&s_p##className##SlabAllocator, \
+			className::staticType()->typeSize()); } \
+	void* className::_slabAllocate(size_t size) { \
+		void* p = slabAllocator()->allocate(size); \
+		if (!p) throw std::bad_alloc(); \
+		return p; } \
+	void className::_slabDeallocate(void* p, size_t size) { \
+		slabAllocator()->deallocate(p, size); }
+
 
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,95 @@
+// -----------------------------------------------------------------------------
+//  File        QuaternionBatch.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/19 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/QuaternionBatch.h"
+#include "FlowCore/FastMat.h"
+#include "FlowCore/SimdKernels.h"
+
+// -----------------------------------------------------------------------------
+//  Class FQuaternionBatch
+// -----------------------------------------------------------------------------
+
+// Static members --------------------------------------------------------------
+
+void FQuaternionBatch::normalize(const FQuaternionSoA& src, const FQuaternionSoA& dst, size_t count)
+{
+	const float* s[4] = { src.x, src.y, src.z, src.w };
+	float* d[4] = { dst.x, dst.y, dst.z, dst.w };
+	FSimdKernels::current().quatNormalize(s, d, count);
+}
+
+void FQuaternionBatch::nlerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+	const float* pFactors, const FQuaternionSoA& dst, size_t count)
+{
+	const float* pa[4] = { a.x, a.y, a.z, a.w };
+	const float* pb[4] = { b.x, b.y, b.z, b.w };
+	float* d[4] = { dst.x, dst.y, dst.z, dst.w };
+	FSimdKernels::current().quatInterpolate(pa, pb, pFactors, 1, d, count, false);
+}
+
+void FQuaternionBatch::nlerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+	float factor, const FQuaternionSoA& dst, size_t count)
+{
+	const float* pa[4] = { a.x, a.y, a.z, a.w };
+	const float* pb[4] = { b.x, b.y, b.z, b.w };
+	float* d[4] = { dst.x, dst.y, dst.z, dst.w };
+	FSimdKernels::current().quatInterpolate(pa, pb, &factor, 0, d, count, false);
+}
+
+void FQuaternionBatch::slerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+	const float* pFactors, const FQuaternionSoA& dst, size_t count)
+{
+	const float* pa[4] = { a.x, a.y, a.z, a.w };
+	const float* pb[4] = { b.x, b.y, b.z, b.w };
+	float* d[4] = { dst.x, dst.y, dst.z, dst.w };
+	FSimdKernels::current().quatInterpolate(pa, pb, pFactors, 1, d, count, true);
+}
+
+void FQuaternionBatch::slerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+	float factor, const FQuaternionSoA& dst, size_t count)
+{
+	const float* pa[4] = { a.x, a.y, a.z, a.w };
+	const float* pb[4] = { b.x, b.y, b.z, b.w };
+	float* d[4] = { dst.x, dst.y, dst.z, dst.w };
+	FSimdKernels::current().quatInterpolate(pa, pb, &factor, 0, d, count, true);
+}
+
+void FQuaternionBatch::rotate(const FQuaternionSoA& q,
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count)
+{
+	const float* pq[4] = { q.x, q.y, q.z, q.w };
+	const float* s[3] = { pSrcX, pSrcY, pSrcZ };
+	float* d[3] = { pDstX, pDstY, pDstZ };
+	FSimdKernels::current().quatRotate(pq, s, d, count);
+}
+
+void FQuaternionBatch::toMatrices(const FQuaternionSoA& q, FFastMat4f* pDst, size_t count)
+{
+	const float* pq[4] = { q.x, q.y, q.z, q.w };
+	FSimdKernels::current().quatToMatrix(pq, reinterpret_cast<float*>(pDst), count);
+}
+
+void FQuaternionBatch::fromQuaternions(const FQuaternion4f* pSrc, const FQuaternionSoA& dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		dst.x[i] = pSrc[i].x;
+		dst.y[i] = pSrc[i].y;
+		dst.z[i] = pSrc[i].z;
+		dst.w[i] = pSrc[i].w;
+	}
+}
+
+void FQuaternionBatch::toQuaternions(const FQuaternionSoA& src, FQuaternion4f* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		pDst[i] = FQuaternion4f(src.x[i], src.y[i], src.z[i], src.w[i]);
+}
+
+// -----------------------------------------------------------------------------
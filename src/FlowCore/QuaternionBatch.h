@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+//  File        QuaternionBatch.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/19 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_QUATERNIONBATCH_H
+#define FLOWCORE_QUATERNIONBATCH_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/QuaternionT.h"
+
+class FFastMat4f;
+
+// -----------------------------------------------------------------------------
+//  Struct FQuaternionSoA
+// -----------------------------------------------------------------------------
+
+/// References four component arrays holding quaternions in SoA layout.
+/// The arrays are not owned by the struct.
+struct FQuaternionSoA
+{
+	FQuaternionSoA(float* px, float* py, float* pz, float* pw)
+		: x(px), y(py), z(pz), w(pw) { }
+
+	float* x;
+	float* y;
+	float* z;
+	float* w;
+};
+
+// -----------------------------------------------------------------------------
+//  Class FQuaternionBatch
+// -----------------------------------------------------------------------------
+
+/// Batch operations on arrays of unit quaternions in SoA layout, processing
+/// 4 or 8 quaternions in parallel depending on the SIMD tier selected by FCpu.
+/// Source and destination arrays may be identical.
+///
+/// Maximum absolute component error compared to the scalar functions in
+/// QuaternionT.h and FMatrix4T::makeRotation() evaluated in double precision,
+/// for unit quaternion inputs:
+/// - normalize, nlerp, slerp, toMatrices: 3e-7
+/// - rotate: 5e-7 times the vector length
+/// The slerp uses polynomial approximations of acos and sin instead of library
+/// calls. Like fSlerp(), it falls back to nlerp if the dot product of the
+/// two quaternions exceeds 0.9995. Its results are renormalized.
+class FLOWCORE_EXPORT FQuaternionBatch
+{
+	//  Static members -----------------------------------------------
+
+public:
+	/// Normalizes count quaternions.
+	static void normalize(const FQuaternionSoA& src, const FQuaternionSoA& dst, size_t count);
+
+	/// Normalized linear interpolation with one factor per element.
+	static void nlerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+		const float* pFactors, const FQuaternionSoA& dst, size_t count);
+	/// Normalized linear interpolation with a constant factor.
+	static void nlerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+		float factor, const FQuaternionSoA& dst, size_t count);
+	/// Spherical linear interpolation with one factor per element.
+	static void slerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+		const float* pFactors, const FQuaternionSoA& dst, size_t count);
+	/// Spherical linear interpolation with a constant factor.
+	static void slerp(const FQuaternionSoA& a, const FQuaternionSoA& b,
+		float factor, const FQuaternionSoA& dst, size_t count);
+
+	/// Rotates vector i, given as separate x, y, z arrays, by quaternion i.
+	static void rotate(const FQuaternionSoA& q,
+		const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+		float* pDstX, float* pDstY, float* pDstZ, size_t count);
+	/// Converts count quaternions to rotation matrices.
+	static void toMatrices(const FQuaternionSoA& q, FFastMat4f* pDst, size_t count);
+
+	/// Copies count quaternions into SoA layout.
+	static void fromQuaternions(const FQuaternion4f* pSrc, const FQuaternionSoA& dst, size_t count);
+	/// Copies count quaternions from SoA layout.
+	static void toQuaternions(const FQuaternionSoA& src, FQuaternion4f* pDst, size_t count);
+
+	//  Internal functions -------------------------------------------
+
+private:
+	/// Private constructor. Class only contains static methods.
+	FQuaternionBatch() { }
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_QUATERNIONBATCH_H
@@ -138,9 +138,9 @@ FQuaternionT<REAL>::FQuaternionT(const FVector3T<REAL>& axis, REAL angle)
 {
 	REAL angle2 = angle * REAL(0.5);
 	REAL sin2 = sin(angle2);
-	x = axis.x() * sin2;
-	y = axis.y() * sin2;
-	z = axis.z() * sin2;
+	x = axis.x * sin2;
+	y = axis.y * sin2;
+	z = axis.z * sin2;
 	w = cos(angle2);
 }
 
@@ -148,13 +148,13 @@ template <typename REAL>
 FQuaternionT<REAL>::FQuaternionT(const FVector4T<REAL>& axis, REAL angle)
 {
 	// axis is a vector, not a point, the w component must be zero
-	F_ASSERT(axis.w() == REAL(0.0));
+	F_ASSERT(axis.w == REAL(0.0));
 
 	REAL angle2 = angle * REAL(0.5);
 	REAL sin2 = sin(angle2);
-	x = axis.x() * sin2;
-	y = axis.y() * sin2;
-	z = axis.z() * sin2;
+	x = axis.x * sin2;
+	y = axis.y * sin2;
+	z = axis.z * sin2;
 	w = cos(angle2);
 }
 
@@ -349,6 +349,52 @@ inline FQuaternionT<REAL> operator*(
 	return result;
 }
 
+/// Dot product of two quaternions.
+template <typename REAL>
+inline REAL fDot(const FQuaternionT<REAL>& q1, const FQuaternionT<REAL>& q2)
+{
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+/// Normalized linear interpolation between two unit quaternions along the
+/// shorter arc.
+template <typename REAL>
+inline FQuaternionT<REAL> fNlerp(
+	const FQuaternionT<REAL>& q1, const FQuaternionT<REAL>& q2, REAL factor)
+{
+	REAL f2 = fDot(q1, q2) < REAL(0.0) ? -factor : factor;
+	REAL f1 = REAL(1.0) - factor;
+
+	FQuaternionT<REAL> result;
+	for (size_t i = 0; i < 4; i++)
+		result[i] = f1 * q1[i] + f2 * q2[i];
+	return result.normalized();
+}
+
+/// Spherical linear interpolation between two unit quaternions along the
+/// shorter arc. Falls back to fNlerp() for nearly identical rotations.
+template <typename REAL>
+inline FQuaternionT<REAL> fSlerp(
+	const FQuaternionT<REAL>& q1, const FQuaternionT<REAL>& q2, REAL factor)
+{
+	REAL d = fDot(q1, q2);
+	REAL sign = d < REAL(0.0) ? REAL(-1.0) : REAL(1.0);
+	d *= sign;
+
+	if (d > REAL(0.9995))
+		return fNlerp(q1, q2, factor);
+
+	REAL theta = acos(d);
+	REAL s = REAL(1.0) / sin(theta);
+	REAL f1 = sin((REAL(1.0) - factor) * theta) * s;
+	REAL f2 = sin(factor * theta) * s * sign;
+
+	FQuaternionT<REAL> result;
+	for (size_t i = 0; i < 4; i++)
+		result[i] = f1 * q1[i] + f2 * q2[i];
+	return result;
+}
+
 // Typedefs --------------------------------------------------------------------
 
 /// Quaternion of type float
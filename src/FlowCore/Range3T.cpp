@@ -0,0 +1,29 @@
+// -----------------------------------------------------------------------------
+//  File        Range3T.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/20 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/Range3T.h"
+#include "FlowCore/SimdKernels.h"
+
+// -----------------------------------------------------------------------------
+//  Class FRange3T
+// -----------------------------------------------------------------------------
+
+// Specializations -------------------------------------------------------------
+
+template <>
+void FRange3T<float>::include(const FVector3T<float>* pPoints, size_t count)
+{
+	if (count == 0)
+		return;
+
+	FSimdKernels::current().includeBounds(&pPoints[0].x, count, 3,
+		&m_lowerBound.x, &m_upperBound.x);
+}
+
+// -----------------------------------------------------------------------------
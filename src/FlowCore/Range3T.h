@@ -55,6 +55,10 @@ public:
 	/// the given point lies inside.
 	void include(const FVector3T<T>& point);
 
+	/// Includes count points from the given array. For ranges of type
+	/// float, the bounds are computed using SIMD min/max reductions.
+	void include(const FVector3T<T>* pPoints, size_t count);
+
 	/// Unites this with the given range. The result is a range that
 	/// covers both input ranges.
 	void uniteWith(const FRange3T<T>& other);
@@ -186,6 +190,13 @@ inline void FRange3T<T>::include(const FVector3T<T>& point)
 	m_upperBound = fMax(m_upperBound, point);
 }
 
+template <typename T>
+inline void FRange3T<T>::include(const FVector3T<T>* pPoints, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		include(pPoints[i]);
+}
+
 template <typename T>
 inline void FRange3T<T>::uniteWith(const FRange3T<T>& other)
 {
@@ -281,6 +292,11 @@ QString FRange3T<T>::toString() const
 		.arg(m_upperBound.toString());
 }
 
+// Specializations -------------------------------------------------------------
+
+template <>
+FLOWCORE_EXPORT void FRange3T<float>::include(const FVector3T<float>* pPoints, size_t count);
+
 // Typedefs --------------------------------------------------------------------
 
 /// 3-component range of type float
@@ -265,6 +265,7 @@
 #define FLOW_INTRINSICS_AVX            0x00000800
 #define FLOW_INTRINSICS_AVX2           0x00001000
 #define FLOW_INTRINSICS_NEON           0x00002000
+#define FLOW_INTRINSICS_AVX512         0x00004000
 
 #if ((defined(__WORDSIZE) && (__WORDSIZE == 64)) || defined(__arch64__) || defined(__LP64__) || defined(_M_X64) || defined(__ppc64__) || defined(__x86_64__))
 #  define FLOW_ARCH FLOW_ARCH_64
@@ -293,11 +294,13 @@
 #elif ((FLOW_PLATFORM & FLOW_PLATFORM_OSX) && (FLOW_COMPILER & FLOW_COMPILER_GCC))
 #	define FLOW_INTRINSICS FLOW_INTRINSICS_NONE
 #elif (((FLOW_COMPILER & FLOW_COMPILER_GCC) && (defined(__i386__) || defined(__x86_64__))) || (FLOW_COMPILER & FLOW_COMPILER_LLVM_GCC))
-#  if(defined(__AVX2__))
+#  if(defined(__AVX512F__))
+#    define FLOW_INTRINSICS FLOW_INTRINSICS_AVX512
+#  elif(defined(__AVX2__))
 #    define FLOW_INTRINSICS FLOW_INTRINSICS_AVX2
 #  elif(defined(__AVX__))
 #    define FLOW_INTRINSICS FLOW_INTRINSICS_AVX
-#  elif(defined(__SSE4__))
+#  elif(defined(__SSE4_1__))
 #    define FLOW_INTRINSICS FLOW_INTRINSICS_SSE4
 #  elif(defined(__SSE3__))
 #    define FLOW_INTRINSICS FLOW_INTRINSICS_SSE3
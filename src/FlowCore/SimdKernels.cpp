@@ -0,0 +1,1421 @@
+// -----------------------------------------------------------------------------
+//  File        SimdKernels.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/SimdKernels.h"
+#include "FlowCore/ValueType.h"
+
+#include <string.h>
+#include <limits>
+#include <type_traits>
+
+// -----------------------------------------------------------------------------
+//  SSE4.1 kernels
+// -----------------------------------------------------------------------------
+
+// The transform kernels operate on an affine 3x4 matrix given as 12 floats in
+// row-major order, the translation is stored in the last column of each row.
+// The matrix elements are broadcast into registers once, each lane processes
+// one point.
+
+static inline void _fAffine3x4(const __m128* m, __m128& x, __m128& y, __m128& z)
+{
+	__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[1], y)),
+	                       _mm_add_ps(_mm_mul_ps(m[2], z), m[3]));
+	__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[4], x), _mm_mul_ps(m[5], y)),
+	                       _mm_add_ps(_mm_mul_ps(m[6], z), m[7]));
+	__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], x), _mm_mul_ps(m[9], y)),
+	                       _mm_add_ps(_mm_mul_ps(m[10], z), m[11]));
+	x = ox; y = oy; z = oz;
+}
+
+static inline void _fNormalize3x4(__m128& x, __m128& y, __m128& z)
+{
+	__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	__m128 len = _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(FLT_MIN)));
+	__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), len);
+	x = _mm_mul_ps(x, inv);
+	y = _mm_mul_ps(y, inv);
+	z = _mm_mul_ps(z, inv);
+}
+
+static void _fTransformStridedSSE4(const float* m, const float* pSrc, float* pDst,
+	size_t count, size_t srcStride, size_t dstStride, bool normalize)
+{
+	const bool packed = (srcStride == 3 && dstStride == 3);
+	size_t i = 0;
+
+	__m128 m4[12];
+	for (size_t k = 0; k < 12; ++k)
+		m4[k] = _mm_set1_ps(m[k]);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const float* s = pSrc + i * srcStride;
+		float* d = pDst + i * dstStride;
+		__m128 x, y, z;
+
+		if (packed)
+			_fLoadPacked3x4(s, x, y, z);
+		else
+			_fGather3x4(s, srcStride, x, y, z);
+
+		_fAffine3x4(m4, x, y, z);
+		if (normalize)
+			_fNormalize3x4(x, y, z);
+
+		if (packed)
+			_fStorePacked3x4(d, x, y, z);
+		else
+			_fScatter3x4(d, dstStride, x, y, z);
+	}
+
+	for (; i < count; ++i)
+		_fAffine3x1(m, pSrc + i * srcStride, pDst + i * dstStride, normalize);
+}
+
+static void _fTransformSoASSE4(const float* m,
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count, bool normalize)
+{
+	size_t i = 0;
+
+	__m128 m4[12];
+	for (size_t k = 0; k < 12; ++k)
+		m4[k] = _mm_set1_ps(m[k]);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(pSrcX + i);
+		__m128 y = _mm_loadu_ps(pSrcY + i);
+		__m128 z = _mm_loadu_ps(pSrcZ + i);
+
+		_fAffine3x4(m4, x, y, z);
+		if (normalize)
+			_fNormalize3x4(x, y, z);
+
+		_mm_storeu_ps(pDstX + i, x);
+		_mm_storeu_ps(pDstY + i, y);
+		_mm_storeu_ps(pDstZ + i, z);
+	}
+
+	for (; i < count; ++i)
+	{
+		float s[3] = { pSrcX[i], pSrcY[i], pSrcZ[i] };
+		float d[3];
+		_fAffine3x1(m, s, d, normalize);
+		pDstX[i] = d[0]; pDstY[i] = d[1]; pDstZ[i] = d[2];
+	}
+}
+
+/// Strided copy with fixed size moves for the common attribute sizes
+/// (1 to 4 floats), avoiding a memcpy call per element.
+static void _fInterleaveSSE4(char* pDst, size_t dstStride,
+	const char* pSrc, size_t elementBytes, size_t count)
+{
+	switch (elementBytes)
+	{
+	case 4:
+		for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += 4)
+			_mm_store_ss((float*)pDst, _mm_load_ss((const float*)pSrc));
+		break;
+	case 8:
+		for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += 8)
+			_mm_storel_epi64((__m128i*)pDst, _mm_loadl_epi64((const __m128i*)pSrc));
+		break;
+	case 12:
+		for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += 12) {
+			_mm_storel_epi64((__m128i*)pDst, _mm_loadl_epi64((const __m128i*)pSrc));
+			_mm_store_ss((float*)(pDst + 8), _mm_load_ss((const float*)(pSrc + 8)));
+		}
+		break;
+	case 16:
+		for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += 16)
+			_mm_storeu_si128((__m128i*)pDst, _mm_loadu_si128((const __m128i*)pSrc));
+		break;
+	default:
+		for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += elementBytes)
+			memcpy(pDst, pSrc, elementBytes);
+		break;
+	}
+}
+
+// The matrix array kernels keep one matrix element of 4 matrices per register
+// (AoSoA layout), e[r*4+c] holds element (r, c). Each lane then works on one
+// matrix without any further shuffling. Arrays of plain matrices are
+// transposed on load and store, incomplete groups are padded with identity
+// matrices. Matrix blocks (8 matrices, element-interleaved) are processed as
+// two halves of 4 matrices and need no transposition.
+
+/// Loads row r of 4 consecutive matrices and transposes it to e[0..3].
+static inline void _fLoadRow4x4(const float* p, __m128* e)
+{
+	__m128 a = _mm_loadu_ps(p);
+	__m128 b = _mm_loadu_ps(p + 16);
+	__m128 c = _mm_loadu_ps(p + 32);
+	__m128 d = _mm_loadu_ps(p + 48);
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	e[0] = a; e[1] = b; e[2] = c; e[3] = d;
+}
+
+static inline void _fStoreRow4x4(float* p, const __m128* e)
+{
+	__m128 a = e[0], b = e[1], c = e[2], d = e[3];
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	_mm_storeu_ps(p, a);
+	_mm_storeu_ps(p + 16, b);
+	_mm_storeu_ps(p + 32, c);
+	_mm_storeu_ps(p + 48, d);
+}
+
+static inline void _fLoadMat4x4(const float* p, __m128* e)
+{
+	_fLoadRow4x4(p, e);
+	_fLoadRow4x4(p + 4, e + 4);
+	_fLoadRow4x4(p + 8, e + 8);
+	_fLoadRow4x4(p + 12, e + 12);
+}
+
+static inline void _fStoreMat4x4(float* p, const __m128* e)
+{
+	_fStoreRow4x4(p, e);
+	_fStoreRow4x4(p + 4, e + 4);
+	_fStoreRow4x4(p + 8, e + 8);
+	_fStoreRow4x4(p + 12, e + 12);
+}
+
+/// Loads one matrix row of 4 matrices from a block of 8, p points to the
+/// first or second half. Written out on purpose, a loop over a local array
+/// is turned into a memcpy call by some compilers.
+static inline void _fLoadBlockRow4x4(const float* p, __m128* e)
+{
+	e[0] = _mm_loadu_ps(p);
+	e[1] = _mm_loadu_ps(p + 8);
+	e[2] = _mm_loadu_ps(p + 16);
+	e[3] = _mm_loadu_ps(p + 24);
+}
+
+static inline void _fStoreBlockRow4x4(float* p, const __m128* e)
+{
+	_mm_storeu_ps(p, e[0]);
+	_mm_storeu_ps(p + 8, e[1]);
+	_mm_storeu_ps(p + 16, e[2]);
+	_mm_storeu_ps(p + 24, e[3]);
+}
+
+static inline void _fLoadBlock4x4(const float* p, __m128* e)
+{
+	_fLoadBlockRow4x4(p, e);
+	_fLoadBlockRow4x4(p + 32, e + 4);
+	_fLoadBlockRow4x4(p + 64, e + 8);
+	_fLoadBlockRow4x4(p + 96, e + 12);
+}
+
+static inline void _fStoreBlock4x4(float* p, const __m128* e)
+{
+	_fStoreBlockRow4x4(p, e);
+	_fStoreBlockRow4x4(p + 32, e + 4);
+	_fStoreBlockRow4x4(p + 64, e + 8);
+	_fStoreBlockRow4x4(p + 96, e + 12);
+}
+
+static inline __m128 _fDet2x4(__m128 a, __m128 b, __m128 c, __m128 d)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, b), _mm_mul_ps(c, d));
+}
+
+static inline __m128 _fCofactor3x4(__m128 a, __m128 ka, __m128 b, __m128 kb, __m128 c, __m128 kc)
+{
+	return _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a, ka), _mm_mul_ps(b, kb)), _mm_mul_ps(c, kc));
+}
+
+static inline __m128 _fDot4x4(const __m128* a, const __m128* b, size_t c)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[c]), _mm_mul_ps(a[1], b[4 + c])),
+		_mm_add_ps(_mm_mul_ps(a[2], b[8 + c]), _mm_mul_ps(a[3], b[12 + c])));
+}
+
+static inline void _fMultiply4x4(const __m128* a, const __m128* b, __m128* d)
+{
+	for (size_t r = 0; r < 16; r += 4) {
+		d[r]     = _fDot4x4(a + r, b, 0);
+		d[r + 1] = _fDot4x4(a + r, b, 1);
+		d[r + 2] = _fDot4x4(a + r, b, 2);
+		d[r + 3] = _fDot4x4(a + r, b, 3);
+	}
+}
+
+/// Inverse by expansion into the 2x2 sub-determinants of the upper (s) and
+/// lower (c) two rows. The result is written to d, transposed if requested.
+static inline void _fInverse4x4(const __m128* m, __m128* d, bool transpose)
+{
+	__m128 s0 = _fDet2x4(m[0], m[5], m[1], m[4]);
+	__m128 s1 = _fDet2x4(m[0], m[6], m[2], m[4]);
+	__m128 s2 = _fDet2x4(m[0], m[7], m[3], m[4]);
+	__m128 s3 = _fDet2x4(m[1], m[6], m[2], m[5]);
+	__m128 s4 = _fDet2x4(m[1], m[7], m[3], m[5]);
+	__m128 s5 = _fDet2x4(m[2], m[7], m[3], m[6]);
+
+	__m128 c0 = _fDet2x4(m[8], m[13], m[9], m[12]);
+	__m128 c1 = _fDet2x4(m[8], m[14], m[10], m[12]);
+	__m128 c2 = _fDet2x4(m[8], m[15], m[11], m[12]);
+	__m128 c3 = _fDet2x4(m[9], m[14], m[10], m[13]);
+	__m128 c4 = _fDet2x4(m[9], m[15], m[11], m[13]);
+	__m128 c5 = _fDet2x4(m[10], m[15], m[11], m[14]);
+
+	__m128 det = _mm_add_ps(
+		_mm_add_ps(_fDet2x4(s0, c5, s1, c4), _mm_add_ps(_mm_mul_ps(s2, c3), _mm_mul_ps(s3, c2))),
+		_fDet2x4(s5, c0, s4, c1));
+
+	__m128 p = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	__m128 n = _mm_sub_ps(_mm_setzero_ps(), p);
+
+	// index of element (r, c) in the result, swapped if transposed
+	const size_t i01 = transpose ? 4 : 1,  i02 = transpose ? 8 : 2,  i03 = transpose ? 12 : 3;
+	const size_t i10 = transpose ? 1 : 4,  i12 = transpose ? 9 : 6,  i13 = transpose ? 13 : 7;
+	const size_t i20 = transpose ? 2 : 8,  i21 = transpose ? 6 : 9,  i23 = transpose ? 14 : 11;
+	const size_t i30 = transpose ? 3 : 12, i31 = transpose ? 7 : 13, i32 = transpose ? 11 : 14;
+
+	d[0]   = _mm_mul_ps(p, _fCofactor3x4(m[5],  c5, m[6],  c4, m[7],  c3));
+	d[i01] = _mm_mul_ps(n, _fCofactor3x4(m[1],  c5, m[2],  c4, m[3],  c3));
+	d[i02] = _mm_mul_ps(p, _fCofactor3x4(m[13], s5, m[14], s4, m[15], s3));
+	d[i03] = _mm_mul_ps(n, _fCofactor3x4(m[9],  s5, m[10], s4, m[11], s3));
+	d[i10] = _mm_mul_ps(n, _fCofactor3x4(m[4],  c5, m[6],  c2, m[7],  c1));
+	d[5]   = _mm_mul_ps(p, _fCofactor3x4(m[0],  c5, m[2],  c2, m[3],  c1));
+	d[i12] = _mm_mul_ps(n, _fCofactor3x4(m[12], s5, m[14], s2, m[15], s1));
+	d[i13] = _mm_mul_ps(p, _fCofactor3x4(m[8],  s5, m[10], s2, m[11], s1));
+	d[i20] = _mm_mul_ps(p, _fCofactor3x4(m[4],  c4, m[5],  c2, m[7],  c0));
+	d[i21] = _mm_mul_ps(n, _fCofactor3x4(m[0],  c4, m[1],  c2, m[3],  c0));
+	d[10]  = _mm_mul_ps(p, _fCofactor3x4(m[12], s4, m[13], s2, m[15], s0));
+	d[i23] = _mm_mul_ps(n, _fCofactor3x4(m[8],  s4, m[9],  s2, m[11], s0));
+	d[i30] = _mm_mul_ps(n, _fCofactor3x4(m[4],  c3, m[5],  c1, m[6],  c0));
+	d[i31] = _mm_mul_ps(p, _fCofactor3x4(m[0],  c3, m[1],  c1, m[2],  c0));
+	d[i32] = _mm_mul_ps(n, _fCofactor3x4(m[12], s3, m[13], s1, m[14], s0));
+	d[15]  = _mm_mul_ps(p, _fCofactor3x4(m[8],  s3, m[9],  s1, m[10], s0));
+}
+
+/// For the product of plain matrices, the transposition costs more than it
+/// saves. Each result row is a sum of the rows of b, weighted by broadcast
+/// elements of a.
+static void _fMultiplyManySSE4(const float* pA, const float* pB, float* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, pA += 16, pB += 16, pDst += 16)
+	{
+		__m128 b0 = _mm_loadu_ps(pB);
+		__m128 b1 = _mm_loadu_ps(pB + 4);
+		__m128 b2 = _mm_loadu_ps(pB + 8);
+		__m128 b3 = _mm_loadu_ps(pB + 12);
+
+		__m128 d[4];
+		for (size_t r = 0; r < 4; ++r) {
+			const float* a = pA + r * 4;
+			d[r] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), b0), _mm_mul_ps(_mm_set1_ps(a[1]), b1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), b2), _mm_mul_ps(_mm_set1_ps(a[3]), b3)));
+		}
+
+		_mm_storeu_ps(pDst, d[0]);
+		_mm_storeu_ps(pDst + 4, d[1]);
+		_mm_storeu_ps(pDst + 8, d[2]);
+		_mm_storeu_ps(pDst + 12, d[3]);
+	}
+}
+
+static void _fInverseManySSE4(const float* pSrc, float* pDst, size_t count, bool transpose)
+{
+	__m128 m[16], d[16];
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		_fLoadMat4x4(pSrc + i * 16, m);
+		_fInverse4x4(m, d, transpose);
+		_fStoreMat4x4(pDst + i * 16, d);
+	}
+
+	if (i < count) {
+		size_t rest = (count - i) * 16;
+		F_ALIGN(16) float tm[64];
+		for (size_t k = 0; k < 64; ++k)
+			tm[k] = ((k & 15) % 5 == 0) ? 1.0f : 0.0f;
+		memcpy(tm, pSrc + i * 16, rest * sizeof(float));
+		_fLoadMat4x4(tm, m);
+		_fInverse4x4(m, d, transpose);
+		_fStoreMat4x4(tm, d);
+		memcpy(pDst + i * 16, tm, rest * sizeof(float));
+	}
+}
+
+static void _fMultiplyBlocksSSE4(const float* pA, const float* pB, float* pDst, size_t count)
+{
+	__m128 a[16], b[16], d[16];
+
+	for (size_t i = 0; i < count * 2; ++i) {
+		size_t offset = (i >> 1) * 128 + (i & 1) * 4;
+		_fLoadBlock4x4(pA + offset, a);
+		_fLoadBlock4x4(pB + offset, b);
+		_fMultiply4x4(a, b, d);
+		_fStoreBlock4x4(pDst + offset, d);
+	}
+}
+
+static void _fInverseBlocksSSE4(const float* pSrc, float* pDst, size_t count, bool transpose)
+{
+	__m128 m[16], d[16];
+
+	for (size_t i = 0; i < count * 2; ++i) {
+		size_t offset = (i >> 1) * 128 + (i & 1) * 4;
+		_fLoadBlock4x4(pSrc + offset, m);
+		_fInverse4x4(m, d, transpose);
+		_fStoreBlock4x4(pDst + offset, d);
+	}
+}
+
+// The quaternion kernels operate on 4 quaternions per register, component
+// arrays are loaded directly. For the remaining elements, the inputs are
+// copied to zero-padded local arrays so the same code path can be used.
+
+/// Loads n < 4 floats into a zero-padded register.
+static inline __m128 _fLoadPartial(const float* p, size_t n)
+{
+	F_ALIGN(16) float t[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (size_t i = 0; i < n; ++i)
+		t[i] = p[i];
+	return _mm_load_ps(t);
+}
+
+static inline void _fStorePartial(float* p, __m128 v, size_t n)
+{
+	F_ALIGN(16) float t[4];
+	_mm_store_ps(t, v);
+	for (size_t i = 0; i < n; ++i)
+		p[i] = t[i];
+}
+
+static inline __m128 _fLoad4(const float* p, size_t n)
+{
+	return n < 4 ? _fLoadPartial(p, n) : _mm_loadu_ps(p);
+}
+
+static inline void _fStore4(float* p, __m128 v, size_t n)
+{
+	if (n < 4)
+		_fStorePartial(p, v, n);
+	else
+		_mm_storeu_ps(p, v);
+}
+
+static inline void _fQuatNormalize4(__m128* q)
+{
+	__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(q[0], q[0]), _mm_mul_ps(q[1], q[1])),
+		_mm_add_ps(_mm_mul_ps(q[2], q[2]), _mm_mul_ps(q[3], q[3])));
+	__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(FLT_MIN))));
+	q[0] = _mm_mul_ps(q[0], inv);
+	q[1] = _mm_mul_ps(q[1], inv);
+	q[2] = _mm_mul_ps(q[2], inv);
+	q[3] = _mm_mul_ps(q[3], inv);
+}
+
+/// acos(x) for x in [0, 1].
+static inline __m128 _fAcos01x4(__m128 x)
+{
+	__m128 p = _mm_set1_ps(_fAcosCoeffs[7]);
+	for (int k = 6; k >= 0; --k)
+		p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(_fAcosCoeffs[k]));
+	return _mm_mul_ps(p, _mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)));
+}
+
+/// sin(x) for x in [0, pi/2].
+static inline __m128 _fSinHalfPix4(__m128 x)
+{
+	__m128 x2 = _mm_mul_ps(x, x);
+	__m128 p = _mm_set1_ps(_fSinCoeffs[5]);
+	for (int k = 4; k >= 0; --k)
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(_fSinCoeffs[k]));
+	return _mm_mul_ps(p, x);
+}
+
+static void _fQuatNormalizeSSE4(const float* const* pSrc, float* const* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = fMin(count - i, size_t(4));
+		__m128 q[4];
+		for (size_t c = 0; c < 4; ++c)
+			q[c] = _fLoad4(pSrc[c] + i, n);
+
+		_fQuatNormalize4(q);
+
+		for (size_t c = 0; c < 4; ++c)
+			_fStore4(pDst[c] + i, q[c], n);
+	}
+}
+
+static void _fQuatInterpolateSSE4(const float* const* pA, const float* const* pB,
+	const float* pFactor, size_t factorStride, float* const* pDst, size_t count, bool spherical)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = fMin(count - i, size_t(4));
+		__m128 a[4], b[4];
+		for (size_t c = 0; c < 4; ++c) {
+			a[c] = _fLoad4(pA[c] + i, n);
+			b[c] = _fLoad4(pB[c] + i, n);
+		}
+
+		__m128 t = factorStride ? _fLoad4(pFactor + i, n) : _mm_set1_ps(*pFactor);
+
+		// take the shorter arc by flipping the sign of b if the dot product is negative
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+			_mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+		__m128 sign = _mm_and_ps(d, signMask);
+		d = _mm_xor_ps(d, sign);
+
+		__m128 f1 = _mm_sub_ps(one, t);
+		__m128 f2 = t;
+
+		if (spherical) {
+			__m128 theta = _fAcos01x4(_mm_min_ps(d, one));
+			__m128 s = _mm_div_ps(one, _fSinHalfPix4(theta));
+			__m128 s1 = _mm_mul_ps(_fSinHalfPix4(_mm_mul_ps(f1, theta)), s);
+			__m128 s2 = _mm_mul_ps(_fSinHalfPix4(_mm_mul_ps(f2, theta)), s);
+			__m128 linear = _mm_cmpgt_ps(d, _mm_set1_ps(_fSlerpThreshold));
+			f1 = _mm_blendv_ps(s1, f1, linear);
+			f2 = _mm_blendv_ps(s2, f2, linear);
+		}
+
+		f2 = _mm_xor_ps(f2, sign);
+
+		__m128 q[4];
+		for (size_t c = 0; c < 4; ++c)
+			q[c] = _mm_add_ps(_mm_mul_ps(f1, a[c]), _mm_mul_ps(f2, b[c]));
+
+		_fQuatNormalize4(q);
+
+		for (size_t c = 0; c < 4; ++c)
+			_fStore4(pDst[c] + i, q[c], n);
+	}
+}
+
+static void _fQuatRotateSSE4(const float* const* pQuat, const float* const* pSrc,
+	float* const* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = fMin(count - i, size_t(4));
+		__m128 qx = _fLoad4(pQuat[0] + i, n), qy = _fLoad4(pQuat[1] + i, n);
+		__m128 qz = _fLoad4(pQuat[2] + i, n), qw = _fLoad4(pQuat[3] + i, n);
+		__m128 vx = _fLoad4(pSrc[0] + i, n), vy = _fLoad4(pSrc[1] + i, n);
+		__m128 vz = _fLoad4(pSrc[2] + i, n);
+
+		// t = 2 * (q x v), v' = v + w * t + q x t
+		__m128 tx = _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy));
+		__m128 ty = _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz));
+		__m128 tz = _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx));
+		tx = _mm_add_ps(tx, tx); ty = _mm_add_ps(ty, ty); tz = _mm_add_ps(tz, tz);
+
+		__m128 rx = _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(qw, tx)),
+			_mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty)));
+		__m128 ry = _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(qw, ty)),
+			_mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz)));
+		__m128 rz = _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(qw, tz)),
+			_mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx)));
+
+		_fStore4(pDst[0] + i, rx, n);
+		_fStore4(pDst[1] + i, ry, n);
+		_fStore4(pDst[2] + i, rz, n);
+	}
+}
+
+static void _fQuatToMatrixSSE4(const float* const* pQuat, float* pDst, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 lastRow = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = fMin(count - i, size_t(4));
+		__m128 x = _fLoad4(pQuat[0] + i, n), y = _fLoad4(pQuat[1] + i, n);
+		__m128 z = _fLoad4(pQuat[2] + i, n), w = _fLoad4(pQuat[3] + i, n);
+
+		__m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+		__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+		__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+		__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+		__m128 rows[3][4] = {
+			{ _mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_sub_ps(xy, wz), _mm_add_ps(xz, wy), _mm_setzero_ps() },
+			{ _mm_add_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)), _mm_sub_ps(yz, wx), _mm_setzero_ps() },
+			{ _mm_sub_ps(xz, wy), _mm_add_ps(yz, wx), _mm_sub_ps(one, _mm_add_ps(xx, yy)), _mm_setzero_ps() }
+		};
+
+		F_ALIGN(16) float m[64];
+		float* pm = n < 4 ? m : pDst + i * 16;
+
+		for (size_t r = 0; r < 3; ++r) {
+			__m128* e = rows[r];
+			_MM_TRANSPOSE4_PS(e[0], e[1], e[2], e[3]);
+			for (size_t k = 0; k < 4; ++k)
+				_mm_storeu_ps(pm + k * 16 + r * 4, e[k]);
+		}
+		for (size_t k = 0; k < 4; ++k)
+			_mm_storeu_ps(pm + k * 16 + 12, lastRow);
+
+		if (n < 4)
+			memcpy(pDst + i * 16, m, n * 16 * sizeof(float));
+	}
+}
+
+// The culling kernel converts each box to center and half extent. A box is
+// outside a plane if the plane distance of the center plus the projection of
+// the extent onto the absolute plane normal is negative.
+
+/// Broadcasts a, b, c, d, |a|, |b|, |c| of 6 planes.
+static inline void _fLoadPlanes4(const float* pPlanes, __m128* pl)
+{
+	for (size_t k = 0; k < 6; ++k, pPlanes += 4, pl += 7) {
+		pl[0] = _mm_set1_ps(pPlanes[0]);
+		pl[1] = _mm_set1_ps(pPlanes[1]);
+		pl[2] = _mm_set1_ps(pPlanes[2]);
+		pl[3] = _mm_set1_ps(pPlanes[3]);
+		pl[4] = _mm_set1_ps(fabsf(pPlanes[0]));
+		pl[5] = _mm_set1_ps(fabsf(pPlanes[1]));
+		pl[6] = _mm_set1_ps(fabsf(pPlanes[2]));
+	}
+}
+
+static size_t _fCullBoxesSSE4(const float* const* pBox, const float* pPlanes,
+	size_t count, uint32_t* pVisible)
+{
+	size_t i = 0, n = 0;
+
+	__m128 pl[42];
+	_fLoadPlanes4(pPlanes, pl);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x0 = _mm_loadu_ps(pBox[0] + i), x1 = _mm_loadu_ps(pBox[3] + i);
+		__m128 y0 = _mm_loadu_ps(pBox[1] + i), y1 = _mm_loadu_ps(pBox[4] + i);
+		__m128 z0 = _mm_loadu_ps(pBox[2] + i), z1 = _mm_loadu_ps(pBox[5] + i);
+
+		__m128 cx = _mm_mul_ps(_mm_add_ps(x0, x1), half), ex = _mm_mul_ps(_mm_sub_ps(x1, x0), half);
+		__m128 cy = _mm_mul_ps(_mm_add_ps(y0, y1), half), ey = _mm_mul_ps(_mm_sub_ps(y1, y0), half);
+		__m128 cz = _mm_mul_ps(_mm_add_ps(z0, z1), half), ez = _mm_mul_ps(_mm_sub_ps(z1, z0), half);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (size_t k = 0; k < 42; k += 7) {
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(pl[k], cx), _mm_mul_ps(pl[k + 1], cy)),
+					_mm_add_ps(_mm_mul_ps(pl[k + 2], cz), pl[k + 3])),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(pl[k + 4], ex), _mm_mul_ps(pl[k + 5], ey)),
+					_mm_mul_ps(pl[k + 6], ez)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		_fCompact4(pVisible + n, (uint32_t)i, mask);
+		n += _fBitCount4[mask];
+	}
+
+	for (; i < count; ++i) {
+		if (_fCullBox1(pBox, pPlanes, i))
+			pVisible[n++] = (uint32_t)i;
+	}
+
+	return n;
+}
+
+// For packed triples, 4 elements are loaded as 3 registers without
+// deinterleaving. Lane j of the 12 floats holds component j % 3, the
+// components are separated in the final reduction.
+
+static void _fIncludeBoundsSSE4(const float* pSrc, size_t count, size_t stride,
+	float* pMin, float* pMax)
+{
+	if (count == 0)
+		return;
+
+	size_t i = 0;
+
+	if (stride == 3)
+	{
+		// initialize all lanes with the first element
+		__m128 mn[3], mx[3];
+		mn[0] = mx[0] = _mm_setr_ps(pSrc[0], pSrc[1], pSrc[2], pSrc[0]);
+		mn[1] = mx[1] = _mm_setr_ps(pSrc[1], pSrc[2], pSrc[0], pSrc[1]);
+		mn[2] = mx[2] = _mm_setr_ps(pSrc[2], pSrc[0], pSrc[1], pSrc[2]);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* p = pSrc + i * 3;
+			__m128 a = _mm_loadu_ps(p);
+			__m128 b = _mm_loadu_ps(p + 4);
+			__m128 c = _mm_loadu_ps(p + 8);
+			mn[0] = _mm_min_ps(mn[0], a); mx[0] = _mm_max_ps(mx[0], a);
+			mn[1] = _mm_min_ps(mn[1], b); mx[1] = _mm_max_ps(mx[1], b);
+			mn[2] = _mm_min_ps(mn[2], c); mx[2] = _mm_max_ps(mx[2], c);
+		}
+
+		F_ALIGN(16) float tMin[12], tMax[12];
+		for (size_t k = 0; k < 3; ++k) {
+			_mm_store_ps(tMin + 4 * k, mn[k]);
+			_mm_store_ps(tMax + 4 * k, mx[k]);
+		}
+		_fReduceBounds(tMin, tMax, 12, pMin, pMax);
+	}
+	else
+	{
+		// all elements but the last provide at least 4 readable floats
+		__m128 mn = _mm_setr_ps(pMin[0], pMin[1], pMin[2], pMin[2]);
+		__m128 mx = _mm_setr_ps(pMax[0], pMax[1], pMax[2], pMax[2]);
+		for (; i + 1 < count; ++i) {
+			__m128 v = _mm_loadu_ps(pSrc + i * stride);
+			mn = _mm_min_ps(mn, v);
+			mx = _mm_max_ps(mx, v);
+		}
+
+		F_ALIGN(16) float tMin[4], tMax[4];
+		_mm_store_ps(tMin, mn);
+		_mm_store_ps(tMax, mx);
+		_fReduceBounds(tMin, tMax, 3, pMin, pMax);
+	}
+
+	for (; i < count; ++i) {
+		const float* p = pSrc + i * stride;
+		for (size_t k = 0; k < 3; ++k) {
+			pMin[k] = fMin(pMin[k], p[k]);
+			pMax[k] = fMax(pMax[k], p[k]);
+		}
+	}
+}
+
+// The approximation kernels are instantiated for each function and accuracy,
+// such that the loops contain no branches. See MathSimd.h for the algorithms.
+
+template <int FUNCTION, bool PRECISE>
+static void _fApproxLoopSSE4(const float* pA, const float* pB,
+	float* pDst, float* pDst2, size_t count)
+{
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = count - i;
+		__m128 a = _fLoad4(pA + i, n);
+		__m128 r, c;
+
+		switch (FUNCTION) {
+		case FSimdKernels::ApproxSin:
+			_fSinCos4<PRECISE>(a, r, c);
+			break;
+		case FSimdKernels::ApproxCos:
+			_fSinCos4<PRECISE>(a, c, r);
+			break;
+		case FSimdKernels::ApproxSinCos:
+			_fSinCos4<PRECISE>(a, r, c);
+			_fStore4(pDst2 + i, c, n);
+			break;
+		case FSimdKernels::ApproxExp:
+			r = _fExp4<PRECISE>(a);
+			break;
+		case FSimdKernels::ApproxLog:
+			r = _fLog4<PRECISE>(a);
+			break;
+		case FSimdKernels::ApproxPow:
+			r = _fPow4<PRECISE>(a, _fLoad4(pB + i, n));
+			break;
+		case FSimdKernels::ApproxAtan2:
+			r = _fAtan24<PRECISE>(a, _fLoad4(pB + i, n));
+			break;
+		case FSimdKernels::ApproxAcos:
+			r = _fAcos4<PRECISE>(a);
+			break;
+		}
+
+		_fStore4(pDst + i, r, n);
+	}
+}
+
+static void _fApproxSSE4(FSimdKernels::ApproxFunction function, const float* pA, const float* pB,
+	float* pDst, float* pDst2, size_t count, bool precise)
+{
+	switch (function) {
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxSin)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxCos)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxSinCos)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxExp)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxLog)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxPow)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxAtan2)
+	F_APPROX_CASE(_fApproxLoopSSE4, ApproxAcos)
+	}
+}
+
+// The curve kernels evaluate 4 samples per register. The segment records of
+// the samples are loaded and transposed, such that each lane holds the
+// coefficients of its own segment. The time polynomial is solved by Newton
+// iterations; steps leaving the bisection bracket [lo, hi] are replaced by
+// bisection, which also handles zero derivatives at the segment ends.
+
+/// Loads the segment records of 4 samples and transposes them, s[0] to s[8]
+/// receive start time, inverse duration, c1 to c3 and d0 to d3.
+static inline void _fLoadCurves4(const float* const* p, __m128* s)
+{
+	for (size_t r = 0; r < 2; ++r) {
+		__m128 a0 = _mm_loadu_ps(p[0] + 4 * r);
+		__m128 a1 = _mm_loadu_ps(p[1] + 4 * r);
+		__m128 a2 = _mm_loadu_ps(p[2] + 4 * r);
+		__m128 a3 = _mm_loadu_ps(p[3] + 4 * r);
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		s[4 * r] = a0; s[4 * r + 1] = a1; s[4 * r + 2] = a2; s[4 * r + 3] = a3;
+	}
+
+	s[8] = _mm_setr_ps(p[0][8], p[1][8], p[2][8], p[3][8]);
+}
+
+static inline __m128 _fEvalCurve4(const __m128* s, __m128 time)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 tolerance = _mm_set1_ps(_fCurveTolerance);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	// normalized time in [0, 1]
+	__m128 x = _mm_mul_ps(_mm_sub_ps(time, s[0]), s[1]);
+	x = _mm_min_ps(_mm_max_ps(x, zero), one);
+
+	__m128 dc2 = _mm_add_ps(s[3], s[3]);
+	__m128 dc3 = _mm_mul_ps(s[4], _mm_set1_ps(3.0f));
+	__m128 u = x, lo = zero, hi = one;
+
+	for (size_t k = 0; k < _fCurveMaxIterations; ++k)
+	{
+		__m128 f = _mm_add_ps(_mm_mul_ps(s[4], u), s[3]);
+		f = _mm_add_ps(_mm_mul_ps(f, u), s[2]);
+		f = _mm_sub_ps(_mm_mul_ps(f, u), x);
+
+		__m128 active = _mm_cmpgt_ps(_mm_and_ps(f, absMask), tolerance);
+		if (_mm_movemask_ps(active) == 0)
+			break;
+
+		__m128 df = _mm_add_ps(_mm_mul_ps(dc3, u), dc2);
+		df = _mm_add_ps(_mm_mul_ps(df, u), s[2]);
+
+		__m128 above = _mm_cmpgt_ps(f, zero);
+		hi = _mm_blendv_ps(hi, u, above);
+		lo = _mm_blendv_ps(u, lo, above);
+
+		__m128 next = _mm_sub_ps(u, _mm_div_ps(f, df));
+		__m128 inside = _mm_and_ps(_mm_cmpgt_ps(next, lo), _mm_cmplt_ps(next, hi));
+		next = _mm_blendv_ps(_mm_mul_ps(_mm_add_ps(lo, hi), half), next, inside);
+		u = _mm_blendv_ps(u, next, active);
+	}
+
+	__m128 v = _mm_add_ps(_mm_mul_ps(s[8], u), s[7]);
+	v = _mm_add_ps(_mm_mul_ps(v, u), s[6]);
+	return _mm_add_ps(_mm_mul_ps(v, u), s[5]);
+}
+
+static void _fEvalCurvesSSE4(const float* pSegments, const uint32_t* pIndices,
+	size_t segmentStride, const float* pTimes, float* pValues, size_t count)
+{
+	__m128 s[9];
+	const float* p[4] = { pSegments, pSegments, pSegments, pSegments };
+
+	// a single segment is loaded only once
+	bool uniform = !pIndices && segmentStride == 0;
+	if (uniform)
+		_fLoadCurves4(p, s);
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t n = count - i;
+
+		// lanes beyond count repeat the last sample
+		if (pIndices) {
+			for (size_t k = 0; k < 4; ++k)
+				p[k] = pSegments + pIndices[i + fMin(k, n - 1)] * _fCurveSegmentSize;
+			_fLoadCurves4(p, s);
+		}
+		else if (!uniform) {
+			for (size_t k = 0; k < 4; ++k)
+				p[k] = pSegments + (i + fMin(k, n - 1)) * segmentStride;
+			_fLoadCurves4(p, s);
+		}
+
+		_fStore4(pValues + i, _fEvalCurve4(s, _fLoad4(pTimes + i, n)), n);
+	}
+}
+
+// The conversion kernel processes 4 values per step. Sources are loaded into
+// 4 float or 4 int32 lanes, converted according to the mode and stored as the
+// destination type. Narrowing stores keep the low bits of each lane, which
+// equals the C cast; saturation is applied to the lanes before. Pairs without
+// a SIMD path (bool, unsigned 32-bit and 64-bit integers, double to and from
+// integers) are converted element by element with the same rules.
+
+/// Size in bytes of the numeric FValueType types, indexed by type.
+static const size_t _fConvertTypeSize[12] = { 0, 4, 8, 1, 1, 1, 2, 2, 4, 4, 8, 8 };
+
+static inline uint32_t _fFloatBits(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, 4);
+	return u;
+}
+
+static inline float _fBitsFloat(uint32_t u)
+{
+	float f;
+	memcpy(&f, &u, 4);
+	return f;
+}
+
+/// Converts half precision bits to float. Denormals are scaled into the
+/// float range by a multiplication, infinity and NaN are handled separately.
+static inline float _fHalfToFloat(uint16_t h)
+{
+	uint32_t expMant = h & 0x7fffu;
+	float scaled = _fBitsFloat(expMant << 13) * _fBitsFloat((254 - 15) << 23);
+	uint32_t infNan = expMant > 0x7bffu ? 255u << 23 : 0u;
+	return _fBitsFloat(_fFloatBits(scaled) | ((uint32_t(h) ^ expMant) << 16) | infNan);
+}
+
+/// Converts a float to half precision bits, rounding to nearest even.
+/// Values beyond the half range become infinity.
+static inline uint16_t _fFloatToHalf(float f)
+{
+	uint32_t x = _fFloatBits(f);
+	uint32_t sign = x & 0x80000000u;
+	uint32_t absX = x ^ sign;
+	uint32_t r;
+
+	if (absX >= (127u + 16) << 23) {
+		r = absX > 0x7f800000u ? 0x7e00u : 0x7c00u;
+	}
+	else if (absX < (127u - 14) << 23) {
+		const uint32_t magic = ((127u - 15) + (23 - 10) + 1) << 23;
+		r = _fFloatBits(_fBitsFloat(absX) + _fBitsFloat(magic)) - magic;
+	}
+	else {
+		r = (absX + (0xfffu - ((127u - 15) << 23)) + ((absX >> 13) & 1)) >> 13;
+	}
+
+	return uint16_t(r | (sign >> 16));
+}
+
+/// Destination kinds of a value conversion. Each kind is converted by its
+/// own overload, expressions for other kinds are never instantiated.
+template <typename D> struct _FConvertKind
+{
+	enum { value = std::is_same<D, bool>::value ? 0 : (std::is_floating_point<D>::value ? 1 : 2) };
+};
+
+template <int Kind> struct _FConvertTag { };
+
+/// Converts to bool, all non-zero values become true.
+template <typename D, typename S>
+static inline D _fConvertValue(S v, FSimdKernels::ConvertMode, _FConvertTag<0>)
+{
+	return v != S(0);
+}
+
+/// Converts to floating point, normalizes integers if requested.
+template <typename D, typename S>
+static inline D _fConvertValue(S v, FSimdKernels::ConvertMode mode, _FConvertTag<1>)
+{
+	typedef std::numeric_limits<S> sl;
+
+	if (mode == FSimdKernels::ConvertNormalize
+			&& sl::is_integer && !std::is_same<S, bool>::value) {
+		D r = D(v) * (D(1) / D(sl::max()));
+		return (sl::is_signed && r < D(-1)) ? D(-1) : r;
+	}
+
+	return D(v);
+}
+
+/// Converts to integer, saturates or normalizes if requested.
+template <typename D, typename S>
+static inline D _fConvertValue(S v, FSimdKernels::ConvertMode mode, _FConvertTag<2>)
+{
+	typedef std::numeric_limits<D> dl;
+	typedef std::numeric_limits<S> sl;
+
+	if (mode != FSimdKernels::ConvertSaturate && mode != FSimdKernels::ConvertNormalize)
+		return D(v);
+
+	if (!sl::is_integer)
+	{
+		// floating point to integer, NaN becomes zero
+		S x = v;
+		if (mode == FSimdKernels::ConvertNormalize) {
+			S lo = dl::is_signed ? S(-1) : S(0);
+			x = x < lo ? lo : (x > S(1) ? S(1) : x);
+			x = x * S(dl::max()) + (x < S(0) ? S(-0.5) : S(0.5));
+		}
+
+		if (!(x == x))
+			return D(0);
+		if (x <= S(dl::min()))
+			return dl::min();
+		if (x >= S(dl::max()))
+			return dl::max();
+		return D(x);
+	}
+
+	// integer to integer
+	if (sl::is_signed && v < S(0)) {
+		if (!dl::is_signed)
+			return D(0);
+		return qint64(v) < qint64(dl::min()) ? dl::min() : D(v);
+	}
+
+	return quint64(v) > quint64(dl::max()) ? dl::max() : D(v);
+}
+
+template <typename D, typename S>
+static inline D _fConvertValue(S v, FSimdKernels::ConvertMode mode)
+{
+	return _fConvertValue<D, S>(v, mode, _FConvertTag<_FConvertKind<D>::value>());
+}
+
+template <typename D, typename S>
+static void _fConvertScalar(const S* pSrc, D* pDst, size_t count,
+	FSimdKernels::ConvertMode mode)
+{
+	const bool srcHalf = std::is_same<S, quint16>::value;
+	const bool dstHalf = std::is_same<D, quint16>::value;
+
+	if (mode == FSimdKernels::ConvertHalf && srcHalf != dstHalf)
+	{
+		if (srcHalf) {
+			for (size_t i = 0; i < count; ++i)
+				pDst[i] = _fConvertValue<D, float>(
+					_fHalfToFloat(uint16_t(pSrc[i])), FSimdKernels::ConvertCast);
+		}
+		else {
+			for (size_t i = 0; i < count; ++i)
+				pDst[i] = D(_fFloatToHalf(
+					_fConvertValue<float, S>(pSrc[i], FSimdKernels::ConvertCast)));
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		pDst[i] = _fConvertValue<D, S>(pSrc[i], mode);
+}
+
+/// Lane format of a type in the conversion kernel, floats or int32.
+template <typename T> struct _FConvertLanes { static const bool isFloat = false; };
+template <> struct _FConvertLanes<float> { static const bool isFloat = true; };
+template <> struct _FConvertLanes<double> { static const bool isFloat = true; };
+
+static inline __m128i _fLoadLanes4(const float* p)
+{
+	return _mm_castps_si128(_mm_loadu_ps(p));
+}
+
+static inline __m128i _fLoadLanes4(const double* p)
+{
+	__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(p));
+	__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(p + 2));
+	return _mm_castps_si128(_mm_movelh_ps(lo, hi));
+}
+
+static inline __m128i _fLoadLanes4(const qint8* p)
+{
+	int32_t v;
+	memcpy(&v, p, 4);
+	return _mm_cvtepi8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static inline __m128i _fLoadLanes4(const quint8* p)
+{
+	int32_t v;
+	memcpy(&v, p, 4);
+	return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static inline __m128i _fLoadLanes4(const qint16* p)
+{
+	return _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+static inline __m128i _fLoadLanes4(const quint16* p)
+{
+	return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+static inline __m128i _fLoadLanes4(const qint32* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+static inline void _fStoreLanes4(float* p, __m128i v)
+{
+	_mm_storeu_ps(p, _mm_castsi128_ps(v));
+}
+
+static inline void _fStoreLanes4(double* p, __m128i v)
+{
+	__m128 f = _mm_castsi128_ps(v);
+	_mm_storeu_pd(p, _mm_cvtps_pd(f));
+	_mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+}
+
+static inline void _fStoreLanes4(qint8* p, __m128i v)
+{
+	const __m128i lowBytes = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1);
+	int32_t r = _mm_cvtsi128_si32(_mm_shuffle_epi8(v, lowBytes));
+	memcpy(p, &r, 4);
+}
+
+static inline void _fStoreLanes4(quint8* p, __m128i v)
+{
+	_fStoreLanes4((qint8*)p, v);
+}
+
+static inline void _fStoreLanes4(qint16* p, __m128i v)
+{
+	const __m128i lowWords = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+		-1, -1, -1, -1, -1, -1, -1, -1);
+	_mm_storel_epi64((__m128i*)p, _mm_shuffle_epi8(v, lowWords));
+}
+
+static inline void _fStoreLanes4(quint16* p, __m128i v)
+{
+	_fStoreLanes4((qint16*)p, v);
+}
+
+static inline void _fStoreLanes4(qint32* p, __m128i v)
+{
+	_mm_storeu_si128((__m128i*)p, v);
+}
+
+/// Converts 4 half precision values (low 16 bits of each lane) to floats.
+static inline __m128 _fHalfToFloat4(__m128i h)
+{
+	const __m128i maskNoSign = _mm_set1_epi32(0x7fff);
+	const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+	const __m128i wasInfNan = _mm_set1_epi32(0x7bff);
+	const __m128 expInfNan = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+	__m128i expMant = _mm_and_si128(maskNoSign, h);
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), magic);
+	__m128 infNan = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(expMant, wasInfNan)), expInfNan);
+	__m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_xor_si128(h, expMant), 16));
+	return _mm_or_ps(scaled, _mm_or_ps(sign, infNan));
+}
+
+/// Converts 4 floats to half precision, see _fFloatToHalf().
+static inline __m128i _fFloatToHalf4(__m128 f)
+{
+	const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+	const __m128i subnormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+	__m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+	__m128 absF = _mm_xor_ps(f, sign);
+	__m128i absI = _mm_castps_si128(absF);
+
+	__m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+	__m128i isRegular = _mm_cmpgt_epi32(f16Max, absI);
+	__m128i infNan = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)),
+		_mm_set1_epi32(0x7c00));
+
+	// subnormal results
+	__m128i isSub = _mm_cmpgt_epi32(minNormal, absI);
+	__m128i sub = _mm_sub_epi32(_mm_castps_si128(
+		_mm_add_ps(absF, _mm_castsi128_ps(subnormMagic))), subnormMagic);
+
+	// normal results, ties round to even
+	__m128i mantOdd = _mm_srai_epi32(_mm_slli_epi32(absI, 31 - 13), 31);
+	__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absI, normalBias), mantOdd), 13);
+
+	__m128i r = _mm_blendv_epi8(normal, sub, isSub);
+	r = _mm_blendv_epi8(infNan, r, isRegular);
+	return _mm_or_si128(r, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+template <typename D, typename S, int MODE>
+static inline __m128i _fConvertLanes4(__m128i v)
+{
+	const bool srcFloat = _FConvertLanes<S>::isFloat;
+	const bool dstFloat = _FConvertLanes<D>::isFloat;
+	const bool clamp = MODE == FSimdKernels::ConvertSaturate
+		|| MODE == FSimdKernels::ConvertNormalize;
+
+	typedef std::numeric_limits<D> dl;
+	typedef std::numeric_limits<S> sl;
+
+	if (srcFloat && dstFloat)
+		return v;
+
+	if (!srcFloat && !dstFloat) {
+		if (clamp) {
+			v = _mm_max_epi32(v, _mm_set1_epi32((int32_t)dl::min()));
+			v = _mm_min_epi32(v, _mm_set1_epi32((int32_t)dl::max()));
+		}
+		return v;
+	}
+
+	if (!srcFloat)
+	{
+		// integer to float
+		if (MODE == FSimdKernels::ConvertHalf && std::is_same<S, quint16>::value)
+			return _mm_castps_si128(_fHalfToFloat4(v));
+
+		__m128 f = _mm_cvtepi32_ps(v);
+		if (MODE == FSimdKernels::ConvertNormalize) {
+			f = _mm_mul_ps(f, _mm_set1_ps(1.0f / float(sl::max())));
+			if (sl::is_signed)
+				f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+		}
+		return _mm_castps_si128(f);
+	}
+
+	// float to integer
+	__m128 f = _mm_castsi128_ps(v);
+
+	if (MODE == FSimdKernels::ConvertHalf && std::is_same<D, quint16>::value)
+		return _fFloatToHalf4(f);
+	if (!clamp)
+		return _mm_cvttps_epi32(f);
+
+	// NaN becomes zero
+	f = _mm_and_ps(f, _mm_cmpord_ps(f, f));
+
+	if (MODE == FSimdKernels::ConvertNormalize) {
+		const __m128 half = _mm_set1_ps(0.5f);
+		f = _mm_max_ps(f, _mm_set1_ps(dl::is_signed ? -1.0f : 0.0f));
+		f = _mm_min_ps(f, _mm_set1_ps(1.0f));
+		f = _mm_mul_ps(f, _mm_set1_ps(float(dl::max())));
+		f = _mm_add_ps(f, _mm_or_ps(half, _mm_and_ps(f, _mm_set1_ps(-0.0f))));
+	}
+
+	if (sizeof(D) < 4) {
+		f = _mm_max_ps(f, _mm_set1_ps(float(dl::min())));
+		f = _mm_min_ps(f, _mm_set1_ps(float(dl::max())));
+		return _mm_cvttps_epi32(f);
+	}
+
+	// values from 2^31 overflow to INT_MIN and are replaced by INT_MAX
+	__m128i r = _mm_cvttps_epi32(f);
+	__m128i overflow = _mm_castps_si128(_mm_cmpge_ps(f, _mm_set1_ps(2147483648.0f)));
+	return _mm_blendv_epi8(r, _mm_set1_epi32(0x7fffffff), overflow);
+}
+
+template <typename D, typename S, int MODE>
+static void _fConvertLoopSSE4(const S* pSrc, D* pDst, size_t count)
+{
+	size_t n4 = count & ~size_t(3);
+	for (size_t i = 0; i < n4; i += 4)
+		_fStoreLanes4(pDst + i, _fConvertLanes4<D, S, MODE>(_fLoadLanes4(pSrc + i)));
+
+	// the remaining elements are converted in zero-padded local arrays
+	if (n4 < count) {
+		S s[4] = { S(0), S(0), S(0), S(0) };
+		D d[4];
+		memcpy(s, pSrc + n4, (count - n4) * sizeof(S));
+		_fStoreLanes4(d, _fConvertLanes4<D, S, MODE>(_fLoadLanes4(s)));
+		memcpy(pDst + n4, d, (count - n4) * sizeof(D));
+	}
+}
+
+/// Returns true if the SIMD loop handles the given pair and mode.
+static inline bool _fIsConvertibleSSE4(uint32_t srcType, uint32_t dstType,
+	FSimdKernels::ConvertMode mode)
+{
+	const uint32_t laneTypes = (1u << FValueType::Float) | (1u << FValueType::Double)
+		| (1u << FValueType::Int8) | (1u << FValueType::UInt8) | (1u << FValueType::Int16)
+		| (1u << FValueType::UInt16) | (1u << FValueType::Int32);
+
+	if (!(laneTypes & (1u << srcType)) || !(laneTypes & (1u << dstType)))
+		return false;
+
+	bool srcFloat = srcType == FValueType::Float || srcType == FValueType::Double;
+	bool dstFloat = dstType == FValueType::Float || dstType == FValueType::Double;
+
+	// doubles pass through float lanes, which is exact only between floats
+	if ((srcType == FValueType::Double && !dstFloat)
+			|| (dstType == FValueType::Double && !srcFloat))
+		return false;
+
+	if (mode == FSimdKernels::ConvertHalf
+			&& (srcType == FValueType::UInt16 || dstType == FValueType::UInt16))
+		return srcType == FValueType::Float || dstType == FValueType::Float;
+
+	// the normalize scale of int32 is not representable as float
+	return !(mode == FSimdKernels::ConvertNormalize
+		&& srcFloat && dstType == FValueType::Int32);
+}
+
+#define F_CONVERT_SIMD_SRC(srcVT, srcT, dstT) \
+	case FValueType::srcVT: \
+		_fConvertLoopSSE4<dstT, srcT, MODE>((const srcT*)pSrc, (dstT*)pDst, count); \
+		return;
+
+#define F_CONVERT_SIMD_DST(dstVT, dstT) \
+	case FValueType::dstVT: \
+		switch (srcType) { \
+		F_CONVERT_SIMD_SRC(Float, float, dstT) \
+		F_CONVERT_SIMD_SRC(Double, double, dstT) \
+		F_CONVERT_SIMD_SRC(Int8, qint8, dstT) \
+		F_CONVERT_SIMD_SRC(UInt8, quint8, dstT) \
+		F_CONVERT_SIMD_SRC(Int16, qint16, dstT) \
+		F_CONVERT_SIMD_SRC(UInt16, quint16, dstT) \
+		F_CONVERT_SIMD_SRC(Int32, qint32, dstT) \
+		} \
+		return;
+
+template <int MODE>
+static void _fConvertModeSSE4(const void* pSrc, uint32_t srcType,
+	void* pDst, uint32_t dstType, size_t count)
+{
+	switch (dstType) {
+	F_CONVERT_SIMD_DST(Float, float)
+	F_CONVERT_SIMD_DST(Double, double)
+	F_CONVERT_SIMD_DST(Int8, qint8)
+	F_CONVERT_SIMD_DST(UInt8, quint8)
+	F_CONVERT_SIMD_DST(Int16, qint16)
+	F_CONVERT_SIMD_DST(UInt16, quint16)
+	F_CONVERT_SIMD_DST(Int32, qint32)
+	}
+}
+
+#define F_CONVERT_SCALAR_SRC(srcVT, srcT, dstT) \
+	case FValueType::srcVT: \
+		_fConvertScalar<dstT, srcT>((const srcT*)pSrc, (dstT*)pDst, count, mode); \
+		return;
+
+#define F_CONVERT_SCALAR_DST(dstVT, dstT) \
+	case FValueType::dstVT: \
+		switch (srcType) { \
+		F_CONVERT_SCALAR_SRC(Float, float, dstT) \
+		F_CONVERT_SCALAR_SRC(Double, double, dstT) \
+		F_CONVERT_SCALAR_SRC(Bool, bool, dstT) \
+		F_CONVERT_SCALAR_SRC(Int8, qint8, dstT) \
+		F_CONVERT_SCALAR_SRC(UInt8, quint8, dstT) \
+		F_CONVERT_SCALAR_SRC(Int16, qint16, dstT) \
+		F_CONVERT_SCALAR_SRC(UInt16, quint16, dstT) \
+		F_CONVERT_SCALAR_SRC(Int32, qint32, dstT) \
+		F_CONVERT_SCALAR_SRC(UInt32, quint32, dstT) \
+		F_CONVERT_SCALAR_SRC(Int64, qint64, dstT) \
+		F_CONVERT_SCALAR_SRC(UInt64, quint64, dstT) \
+		} \
+		return;
+
+/// Converts values element by element, handles all pairs of numeric types.
+static void _fConvertGeneric(const void* pSrc, uint32_t srcType,
+	void* pDst, uint32_t dstType, size_t count, FSimdKernels::ConvertMode mode)
+{
+	switch (dstType) {
+	F_CONVERT_SCALAR_DST(Float, float)
+	F_CONVERT_SCALAR_DST(Double, double)
+	F_CONVERT_SCALAR_DST(Bool, bool)
+	F_CONVERT_SCALAR_DST(Int8, qint8)
+	F_CONVERT_SCALAR_DST(UInt8, quint8)
+	F_CONVERT_SCALAR_DST(Int16, qint16)
+	F_CONVERT_SCALAR_DST(UInt16, quint16)
+	F_CONVERT_SCALAR_DST(Int32, qint32)
+	F_CONVERT_SCALAR_DST(UInt32, quint32)
+	F_CONVERT_SCALAR_DST(Int64, qint64)
+	F_CONVERT_SCALAR_DST(UInt64, quint64)
+	}
+}
+
+static void _fConvertSSE4(const void* pSrc, uint32_t srcType,
+	void* pDst, uint32_t dstType, size_t count, FSimdKernels::ConvertMode mode)
+{
+	F_ASSERT(srcType > FValueType::Invalid && srcType < FValueType::String);
+	F_ASSERT(dstType > FValueType::Invalid && dstType < FValueType::String);
+
+	if (srcType == dstType) {
+		if (pSrc != pDst)
+			memmove(pDst, pSrc, count * _fConvertTypeSize[srcType]);
+		return;
+	}
+
+	if (!_fIsConvertibleSSE4(srcType, dstType, mode)) {
+		_fConvertGeneric(pSrc, srcType, pDst, dstType, count, mode);
+		return;
+	}
+
+	switch (mode) {
+	case FSimdKernels::ConvertCast:
+		_fConvertModeSSE4<FSimdKernels::ConvertCast>(pSrc, srcType, pDst, dstType, count);
+		break;
+	case FSimdKernels::ConvertSaturate:
+		_fConvertModeSSE4<FSimdKernels::ConvertSaturate>(pSrc, srcType, pDst, dstType, count);
+		break;
+	case FSimdKernels::ConvertNormalize:
+		_fConvertModeSSE4<FSimdKernels::ConvertNormalize>(pSrc, srcType, pDst, dstType, count);
+		break;
+	case FSimdKernels::ConvertHalf:
+		_fConvertModeSSE4<FSimdKernels::ConvertHalf>(pSrc, srcType, pDst, dstType, count);
+		break;
+	}
+}
+
+const FSimdKernels& _fSimdKernelsSSE4()
+{
+	static const FSimdKernels kernels = {
+		FCpu::SSE4,
+		_fTransformStridedSSE4,
+		_fTransformSoASSE4,
+		_fInterleaveSSE4,
+		_fMultiplyManySSE4,
+		_fInverseManySSE4,
+		_fMultiplyBlocksSSE4,
+		_fInverseBlocksSSE4,
+		_fQuatNormalizeSSE4,
+		_fQuatInterpolateSSE4,
+		_fQuatRotateSSE4,
+		_fQuatToMatrixSSE4,
+		_fCullBoxesSSE4,
+		_fIncludeBoundsSSE4,
+		_fApproxSSE4,
+		_fEvalCurvesSSE4,
+		_fConvertSSE4
+	};
+
+	return kernels;
+}
+
+// -----------------------------------------------------------------------------
+//  Struct FSimdKernels
+// -----------------------------------------------------------------------------
+
+// Static members --------------------------------------------------------------
+
+const FSimdKernels& FSimdKernels::current()
+{
+	return forTier(FCpu::simdTier());
+}
+
+const FSimdKernels& FSimdKernels::forTier(FCpu::SimdTier tier)
+{
+#ifdef FLOW_SIMD_DISPATCH_AVX512
+	if (tier >= FCpu::AVX512)
+		return _fSimdKernelsAVX512();
+#endif
+#ifdef FLOW_SIMD_DISPATCH_AVX2
+	if (tier >= FCpu::AVX2)
+		return _fSimdKernelsAVX2();
+#endif
+
+	return _fSimdKernelsSSE4();
+}
+
+// -----------------------------------------------------------------------------
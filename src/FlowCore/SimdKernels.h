@@ -0,0 +1,357 @@
+// -----------------------------------------------------------------------------
+//  File        SimdKernels.h
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORE_SIMDKERNELS_H
+#define FLOWCORE_SIMDKERNELS_H
+
+#include "FlowCore/Library.h"
+#include "FlowCore/Intrinsics.h"
+#include "FlowCore/MathSimd.h"
+#include "FlowCore/Cpu.h"
+
+#include <float.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+//  Kernel targets
+// -----------------------------------------------------------------------------
+
+// The library itself is built for SSE4.1. Kernels for wider instruction sets
+// are compiled with function level target attributes, so no special compiler
+// flags are required. The FLOW_SIMD_DISPATCH_XXX macros tell whether the
+// compiler is able to generate code for the respective tier.
+
+#if (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || defined(__clang__)
+#  define FLOW_SIMD_DISPATCH_AVX2
+#  define FLOW_SIMD_DISPATCH_AVX512
+#  define F_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#  define F_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#elif defined(_MSC_VER)
+#  if (_MSC_VER >= 1800)
+#    define FLOW_SIMD_DISPATCH_AVX2
+#  endif
+#  if (_MSC_VER >= 1910)
+#    define FLOW_SIMD_DISPATCH_AVX512
+#  endif
+#  define F_TARGET_AVX2
+#  define F_TARGET_AVX512
+#else
+#  define F_TARGET_AVX2
+#  define F_TARGET_AVX512
+#endif
+
+// -----------------------------------------------------------------------------
+//  Struct FSimdKernels
+// -----------------------------------------------------------------------------
+
+/// Table of kernels compiled for one SIMD tier. Use current() to obtain the
+/// table matching the tier selected by FCpu.
+struct FLOWCORE_EXPORT FSimdKernels
+{
+	/// Transforms count xyz triples by an affine 3x4 matrix (12 floats,
+	/// row-major). Strides are given in floats. Optionally normalizes.
+	typedef void (*TransformStridedFunc)(const float* pAffine,
+		const float* pSrc, float* pDst, size_t count,
+		size_t srcStride, size_t dstStride, bool normalize);
+
+	/// Same as above for xyz triples stored in separate component arrays.
+	typedef void (*TransformSoAFunc)(const float* pAffine,
+		const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+		float* pDstX, float* pDstY, float* pDstZ, size_t count, bool normalize);
+
+	/// Copies count elements of elementBytes each from a packed source array
+	/// into a destination with the given stride (in bytes).
+	typedef void (*InterleaveFunc)(char* pDst, size_t dstStride,
+		const char* pSrc, size_t elementBytes, size_t count);
+
+	/// Multiplies count pairs of 4x4 matrices (16 floats each, row-major),
+	/// pDst[i] = pA[i] * pB[i]. The destination may alias either source.
+	typedef void (*MultiplyManyFunc)(const float* pA, const float* pB,
+		float* pDst, size_t count);
+
+	/// Inverts count 4x4 matrices (16 floats each, row-major). If transpose
+	/// is true, the inverse transpose is stored. Works in-place.
+	typedef void (*InverseManyFunc)(const float* pSrc, float* pDst,
+		size_t count, bool transpose);
+
+	/// Same as the functions above for matrices stored in blocks of 8 in
+	/// element-interleaved layout (16 x 8 floats per block),
+	/// count is the number of blocks.
+	typedef MultiplyManyFunc MultiplyBlocksFunc;
+	typedef InverseManyFunc InverseBlocksFunc;
+
+	/// Normalizes count quaternions. Quaternions are given as four component
+	/// arrays x, y, z, w (SoA layout). Works in-place.
+	typedef void (*QuatNormalizeFunc)(const float* const* pSrc,
+		float* const* pDst, size_t count);
+
+	/// Interpolates count pairs of unit quaternions along the shorter arc,
+	/// either spherical or normalized linear. factorStride is a flag, not a
+	/// general stride: with 0, all elements share the factor *pFactor, with
+	/// any other value, element i uses pFactor[i] (factors are contiguous).
+	typedef void (*QuatInterpolateFunc)(const float* const* pA, const float* const* pB,
+		const float* pFactor, size_t factorStride, float* const* pDst,
+		size_t count, bool spherical);
+
+	/// Rotates count vectors (three component arrays) by count unit quaternions.
+	typedef void (*QuatRotateFunc)(const float* const* pQuat,
+		const float* const* pSrc, float* const* pDst, size_t count);
+
+	/// Converts count unit quaternions to 4x4 rotation matrices
+	/// (16 floats each, row-major).
+	typedef void (*QuatToMatrixFunc)(const float* const* pQuat,
+		float* pDst, size_t count);
+
+	/// Tests count boxes against 6 planes. Boxes are given as six component
+	/// arrays minX, minY, minZ, maxX, maxY, maxZ (SoA layout), planes as 6 x 4
+	/// floats (a, b, c, d), with a * x + b * y + c * z + d >= 0 on the inner side.
+	/// Writes the indices of all boxes not completely outside of any plane to
+	/// pVisible, which must provide space for count indices. Returns the number
+	/// of visible boxes.
+	typedef size_t (*CullBoxesFunc)(const float* const* pBox, const float* pPlanes,
+		size_t count, uint32_t* pVisible);
+
+	/// Extends the bounds pMin, pMax (3 floats each) such that they include
+	/// count xyz triples. The stride is given in floats and must be at least 3.
+	typedef void (*IncludeBoundsFunc)(const float* pSrc, size_t count, size_t stride,
+		float* pMin, float* pMax);
+
+	/// Functions provided by the approximation kernel.
+	enum ApproxFunction
+	{
+		ApproxSin = 0,
+		ApproxCos,
+		ApproxSinCos,
+		ApproxExp,
+		ApproxLog,
+		ApproxPow,
+		ApproxAtan2,
+		ApproxAcos
+	};
+
+	/// Evaluates an approximation of the given function for count elements.
+	/// Binary functions (pow, atan2) read their second argument from pB,
+	/// sincos stores the cosine in pDst2. See MathSimd.h for the algorithms.
+	typedef void (*ApproxFunc)(ApproxFunction function, const float* pA, const float* pB,
+		float* pDst, float* pDst2, size_t count, bool precise);
+
+	/// Evaluates count samples of 1D cubic curve segments (12 floats each, see
+	/// FCurveArray for the layout) at the times given in pTimes. Sample i uses
+	/// the segment at pSegments + pIndices[i] * 12, or, if pIndices is NULL,
+	/// at pSegments + i * segmentStride. Use a stride of 0 for a single segment.
+	typedef void (*EvalCurvesFunc)(const float* pSegments, const uint32_t* pIndices,
+		size_t segmentStride, const float* pTimes, float* pValues, size_t count);
+
+	/// Modes of the conversion kernel, see FValueArray::Conversion.
+	enum ConvertMode
+	{
+		ConvertCast = 0,
+		ConvertSaturate,
+		ConvertNormalize,
+		ConvertHalf
+	};
+
+	/// Converts count contiguous values between numeric types, the types are
+	/// given as FValueType values (Float to UInt64). Source and destination
+	/// must not overlap unless they are the same and the types are equal.
+	typedef void (*ConvertFunc)(const void* pSrc, uint32_t srcType,
+		void* pDst, uint32_t dstType, size_t count, ConvertMode mode);
+
+	FCpu::SimdTier tier;
+	TransformStridedFunc transformStrided;
+	TransformSoAFunc transformSoA;
+	InterleaveFunc interleave;
+	MultiplyManyFunc multiplyMany;
+	InverseManyFunc inverseMany;
+	MultiplyBlocksFunc multiplyBlocks;
+	InverseBlocksFunc inverseBlocks;
+	QuatNormalizeFunc quatNormalize;
+	QuatInterpolateFunc quatInterpolate;
+	QuatRotateFunc quatRotate;
+	QuatToMatrixFunc quatToMatrix;
+	CullBoxesFunc cullBoxes;
+	IncludeBoundsFunc includeBounds;
+	ApproxFunc approx;
+	EvalCurvesFunc evalCurves;
+	ConvertFunc convert;
+
+	/// Returns the kernel table for the tier currently selected by FCpu.
+	static const FSimdKernels& current();
+	/// Returns the kernel table for the given tier. If the compiler could not
+	/// generate code for the tier, the next lower available tier is returned.
+	static const FSimdKernels& forTier(FCpu::SimdTier tier);
+};
+
+// Kernel tables, implemented in the SimdKernelsXXX.cpp files.
+const FSimdKernels& _fSimdKernelsSSE4();
+#ifdef FLOW_SIMD_DISPATCH_AVX2
+const FSimdKernels& _fSimdKernelsAVX2();
+#endif
+#ifdef FLOW_SIMD_DISPATCH_AVX512
+const FSimdKernels& _fSimdKernelsAVX512();
+#endif
+
+// -----------------------------------------------------------------------------
+//  Shared 128-bit helpers
+// -----------------------------------------------------------------------------
+
+/// Loads 4 packed xyz triples (12 floats) and deinterleaves them.
+static inline void _fLoadPacked3x4(const float* p, __m128& x, __m128& y, __m128& z)
+{
+	__m128 a = _mm_loadu_ps(p);     // x0 y0 z0 x1
+	__m128 b = _mm_loadu_ps(p + 4); // y1 z1 x2 y2
+	__m128 c = _mm_loadu_ps(p + 8); // z2 x3 y3 z3
+
+	__m128 t0 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+	x = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2, 0, 3, 0));
+	__m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+	__m128 t2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+	y = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 t3 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+	__m128 t4 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+	z = _mm_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/// Interleaves 4 xyz triples and stores them as 12 packed floats.
+static inline void _fStorePacked3x4(float* p, __m128 x, __m128 y, __m128 z)
+{
+	__m128 xyLo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+	__m128 xyHi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+
+	__m128 t0 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+	__m128 a = _mm_shuffle_ps(xyLo, t0, _MM_SHUFFLE(2, 0, 1, 0));
+	__m128 t1 = _mm_shuffle_ps(xyLo, z, _MM_SHUFFLE(1, 1, 3, 3));
+	__m128 b = _mm_shuffle_ps(t1, xyHi, _MM_SHUFFLE(1, 0, 2, 0));
+	__m128 t2 = _mm_shuffle_ps(z, xyHi, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 t3 = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 3, 3, 3));
+	__m128 c = _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2, 0, 2, 0));
+
+	_mm_storeu_ps(p, a);
+	_mm_storeu_ps(p + 4, b);
+	_mm_storeu_ps(p + 8, c);
+}
+
+/// Gathers 4 xyz triples with an arbitrary stride.
+static inline void _fGather3x4(const float* p, size_t s, __m128& x, __m128& y, __m128& z)
+{
+	x = _mm_setr_ps(p[0], p[s    ], p[2*s    ], p[3*s    ]);
+	y = _mm_setr_ps(p[1], p[s + 1], p[2*s + 1], p[3*s + 1]);
+	z = _mm_setr_ps(p[2], p[s + 2], p[2*s + 2], p[3*s + 2]);
+}
+
+/// Scatters 4 xyz triples with an arbitrary stride. Components beyond
+/// the first three of each element are left untouched.
+static inline void _fScatter3x4(float* p, size_t s, __m128 x, __m128 y, __m128 z)
+{
+	F_ALIGN(16) float tx[4], ty[4], tz[4];
+	_mm_store_ps(tx, x);
+	_mm_store_ps(ty, y);
+	_mm_store_ps(tz, z);
+
+	for (size_t i = 0; i < 4; ++i, p += s) {
+		p[0] = tx[i]; p[1] = ty[i]; p[2] = tz[i];
+	}
+}
+
+/// Coefficients of sin(x) = x * P(x^2) for x in [0, pi/2] (Taylor series
+/// up to x^11), absolute error <= 6e-8.
+static const float _fSinCoeffs[6] = {
+	1.0f, -1.6666667e-1f, 8.3333333e-3f, -1.9841270e-4f, 2.7557319e-6f, -2.5052108e-8f
+};
+
+/// Above this dot product, the quaternion slerp kernels fall back to nlerp.
+static const float _fSlerpThreshold = 0.9995f;
+
+/// The curve kernels stop iterating when the normalized time error of all
+/// samples in a register is below the tolerance, or after the maximum number
+/// of iterations (enough for the bisection fallback to reach the tolerance).
+static const float _fCurveTolerance = 1e-6f;
+static const size_t _fCurveMaxIterations = 20;
+
+/// Number of floats per curve segment record, see FCurveArray.
+static const size_t _fCurveSegmentSize = 12;
+
+/// For each 4-bit mask, the positions of the set bits packed into
+/// consecutive bytes. Used to compact the indices of visible boxes.
+static const uint32_t _fCompactIndices[16] = {
+	0x00000000, 0x00000000, 0x00000001, 0x00000100,
+	0x00000002, 0x00000200, 0x00000201, 0x00020100,
+	0x00000003, 0x00000300, 0x00000301, 0x00030100,
+	0x00000302, 0x00030200, 0x00030201, 0x03020100
+};
+
+/// Number of set bits for each 4-bit mask.
+static const size_t _fBitCount4[16] = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/// Stores base plus the positions of the set bits in the 4-bit mask as
+/// consecutive indices. Always writes 4 indices.
+static inline void _fCompact4(uint32_t* p, uint32_t base, int mask)
+{
+	__m128i lane = _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)_fCompactIndices[mask]));
+	_mm_storeu_si128((__m128i*)p, _mm_add_epi32(lane, _mm_set1_epi32((int)base)));
+}
+
+/// Reduces n per-lane minima and maxima of packed xyz triples (n must be
+/// a multiple of 3) and merges the result into the bounds pMin, pMax.
+static inline void _fReduceBounds(const float* tMin, const float* tMax, size_t n,
+	float* pMin, float* pMax)
+{
+	for (size_t j = 0; j < n; ++j) {
+		pMin[j % 3] = fMin(pMin[j % 3], tMin[j]);
+		pMax[j % 3] = fMax(pMax[j % 3], tMax[j]);
+	}
+}
+
+/// Scalar version of the box culling test, used for the remaining elements.
+static inline bool _fCullBox1(const float* const* pBox, const float* pPlanes, size_t i)
+{
+	float cx = (pBox[0][i] + pBox[3][i]) * 0.5f, ex = (pBox[3][i] - pBox[0][i]) * 0.5f;
+	float cy = (pBox[1][i] + pBox[4][i]) * 0.5f, ey = (pBox[4][i] - pBox[1][i]) * 0.5f;
+	float cz = (pBox[2][i] + pBox[5][i]) * 0.5f, ez = (pBox[5][i] - pBox[2][i]) * 0.5f;
+
+	for (size_t k = 0; k < 24; k += 4) {
+		const float* p = pPlanes + k;
+		float dist = p[0] * cx + p[1] * cy + p[2] * cz + p[3]
+			+ fabsf(p[0]) * ex + fabsf(p[1]) * ey + fabsf(p[2]) * ez;
+		if (dist < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+/// Case label of the approximation kernel dispatch, calls the loop
+/// instantiated for the given function and accuracy.
+#define F_APPROX_CASE(kernel, function) \
+	case FSimdKernels::function: \
+		if (precise) kernel<FSimdKernels::function, true>(pA, pB, pDst, pDst2, count); \
+		else kernel<FSimdKernels::function, false>(pA, pB, pDst, pDst2, count); \
+		break;
+
+/// Scalar version of the affine transform, used for the remaining elements.
+static inline void _fAffine3x1(const float* m, const float* pSrc, float* pDst, bool normalize)
+{
+	float x = pSrc[0], y = pSrc[1], z = pSrc[2];
+	float ox = m[0] * x + m[1] * y + m[2] * z + m[3];
+	float oy = m[4] * x + m[5] * y + m[6] * z + m[7];
+	float oz = m[8] * x + m[9] * y + m[10] * z + m[11];
+
+	if (normalize) {
+		float inv = 1.0f / sqrtf(fMax(ox * ox + oy * oy + oz * oz, FLT_MIN));
+		ox *= inv; oy *= inv; oz *= inv;
+	}
+
+	pDst[0] = ox; pDst[1] = oy; pDst[2] = oz;
+}
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORE_SIMDKERNELS_H
@@ -0,0 +1,979 @@
+// -----------------------------------------------------------------------------
+//  File        SimdKernelsAVX2.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/SimdKernels.h"
+
+#ifdef FLOW_SIMD_DISPATCH_AVX2
+
+#include <immintrin.h>
+
+// -----------------------------------------------------------------------------
+//  AVX2 kernels
+// -----------------------------------------------------------------------------
+
+// All functions in this file must carry F_TARGET_AVX2 and may only be called
+// if FCpu reports AVX2 support.
+
+F_TARGET_AVX2 static inline void _fAffine3x8(const __m256* m, __m256& x, __m256& y, __m256& z)
+{
+	__m256 ox = _mm256_fmadd_ps(m[0], x, _mm256_fmadd_ps(m[1], y, _mm256_fmadd_ps(m[2], z, m[3])));
+	__m256 oy = _mm256_fmadd_ps(m[4], x, _mm256_fmadd_ps(m[5], y, _mm256_fmadd_ps(m[6], z, m[7])));
+	__m256 oz = _mm256_fmadd_ps(m[8], x, _mm256_fmadd_ps(m[9], y, _mm256_fmadd_ps(m[10], z, m[11])));
+	x = ox; y = oy; z = oz;
+}
+
+F_TARGET_AVX2 static inline void _fNormalize3x8(__m256& x, __m256& y, __m256& z)
+{
+	__m256 len2 = _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)));
+	__m256 len = _mm256_sqrt_ps(_mm256_max_ps(len2, _mm256_set1_ps(FLT_MIN)));
+	__m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), len);
+	x = _mm256_mul_ps(x, inv);
+	y = _mm256_mul_ps(y, inv);
+	z = _mm256_mul_ps(z, inv);
+}
+
+F_TARGET_AVX2 static inline __m256 _fCombine(__m128 lo, __m128 hi)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+F_TARGET_AVX2 static void _fTransformStridedAVX2(const float* m, const float* pSrc, float* pDst,
+	size_t count, size_t srcStride, size_t dstStride, bool normalize)
+{
+	const bool packed = (srcStride == 3 && dstStride == 3);
+	size_t i = 0;
+
+	__m256 m8[12];
+	for (size_t k = 0; k < 12; ++k)
+		m8[k] = _mm256_set1_ps(m[k]);
+
+	const int s = (int)srcStride;
+	const __m256i index = _mm256_setr_epi32(0, s, 2*s, 3*s, 4*s, 5*s, 6*s, 7*s);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const float* ps = pSrc + i * srcStride;
+		float* pd = pDst + i * dstStride;
+		__m256 x, y, z;
+
+		if (packed) {
+			__m128 x0, y0, z0, x1, y1, z1;
+			_fLoadPacked3x4(ps, x0, y0, z0);
+			_fLoadPacked3x4(ps + 12, x1, y1, z1);
+			x = _fCombine(x0, x1); y = _fCombine(y0, y1); z = _fCombine(z0, z1);
+		}
+		else {
+			x = _mm256_i32gather_ps(ps, index, 4);
+			y = _mm256_i32gather_ps(ps + 1, index, 4);
+			z = _mm256_i32gather_ps(ps + 2, index, 4);
+		}
+
+		_fAffine3x8(m8, x, y, z);
+		if (normalize)
+			_fNormalize3x8(x, y, z);
+
+		__m128 x0 = _mm256_castps256_ps128(x), x1 = _mm256_extractf128_ps(x, 1);
+		__m128 y0 = _mm256_castps256_ps128(y), y1 = _mm256_extractf128_ps(y, 1);
+		__m128 z0 = _mm256_castps256_ps128(z), z1 = _mm256_extractf128_ps(z, 1);
+
+		if (packed) {
+			_fStorePacked3x4(pd, x0, y0, z0);
+			_fStorePacked3x4(pd + 12, x1, y1, z1);
+		}
+		else {
+			_fScatter3x4(pd, dstStride, x0, y0, z0);
+			_fScatter3x4(pd + 4 * dstStride, dstStride, x1, y1, z1);
+		}
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().transformStrided(m, pSrc + i * srcStride, pDst + i * dstStride,
+			count - i, srcStride, dstStride, normalize);
+}
+
+F_TARGET_AVX2 static void _fTransformSoAAVX2(const float* m,
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count, bool normalize)
+{
+	size_t i = 0;
+
+	__m256 m8[12];
+	for (size_t k = 0; k < 12; ++k)
+		m8[k] = _mm256_set1_ps(m[k]);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(pSrcX + i);
+		__m256 y = _mm256_loadu_ps(pSrcY + i);
+		__m256 z = _mm256_loadu_ps(pSrcZ + i);
+
+		_fAffine3x8(m8, x, y, z);
+		if (normalize)
+			_fNormalize3x8(x, y, z);
+
+		_mm256_storeu_ps(pDstX + i, x);
+		_mm256_storeu_ps(pDstY + i, y);
+		_mm256_storeu_ps(pDstZ + i, z);
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().transformSoA(m, pSrcX + i, pSrcY + i, pSrcZ + i,
+			pDstX + i, pDstY + i, pDstZ + i, count - i, normalize);
+}
+
+F_TARGET_AVX2 static void _fInterleaveAVX2(char* pDst, size_t dstStride,
+	const char* pSrc, size_t elementBytes, size_t count)
+{
+	if (elementBytes != 32) {
+		_fSimdKernelsSSE4().interleave(pDst, dstStride, pSrc, elementBytes, count);
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i, pDst += dstStride, pSrc += 32)
+		_mm256_storeu_si256((__m256i*)pDst, _mm256_loadu_si256((const __m256i*)pSrc));
+}
+
+// The matrix array kernels keep one element of 8 matrices per register. For
+// arrays of plain matrices, matrix j and j+4 share a register and the 4x4
+// transpose within each 128-bit half yields the element-wise layout. Matrix
+// blocks are loaded directly. Remaining matrices are handed over to the SSE4
+// kernels.
+
+F_TARGET_AVX2 static inline void _fTranspose4x8(__m256& a, __m256& b, __m256& c, __m256& d)
+{
+	__m256 t0 = _mm256_unpacklo_ps(a, b);
+	__m256 t1 = _mm256_unpacklo_ps(c, d);
+	__m256 t2 = _mm256_unpackhi_ps(a, b);
+	__m256 t3 = _mm256_unpackhi_ps(c, d);
+	a = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	b = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	c = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	d = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+/// Loads row r of 8 consecutive matrices and transposes it to e[0..3].
+F_TARGET_AVX2 static inline void _fLoadRow4x8(const float* p, __m256* e)
+{
+	__m256 a = _fCombine(_mm_loadu_ps(p), _mm_loadu_ps(p + 64));
+	__m256 b = _fCombine(_mm_loadu_ps(p + 16), _mm_loadu_ps(p + 80));
+	__m256 c = _fCombine(_mm_loadu_ps(p + 32), _mm_loadu_ps(p + 96));
+	__m256 d = _fCombine(_mm_loadu_ps(p + 48), _mm_loadu_ps(p + 112));
+	_fTranspose4x8(a, b, c, d);
+	e[0] = a; e[1] = b; e[2] = c; e[3] = d;
+}
+
+F_TARGET_AVX2 static inline void _fStoreRow4x8(float* p, const __m256* e)
+{
+	__m256 a = e[0], b = e[1], c = e[2], d = e[3];
+	_fTranspose4x8(a, b, c, d);
+	_mm_storeu_ps(p, _mm256_castps256_ps128(a));
+	_mm_storeu_ps(p + 16, _mm256_castps256_ps128(b));
+	_mm_storeu_ps(p + 32, _mm256_castps256_ps128(c));
+	_mm_storeu_ps(p + 48, _mm256_castps256_ps128(d));
+	_mm_storeu_ps(p + 64, _mm256_extractf128_ps(a, 1));
+	_mm_storeu_ps(p + 80, _mm256_extractf128_ps(b, 1));
+	_mm_storeu_ps(p + 96, _mm256_extractf128_ps(c, 1));
+	_mm_storeu_ps(p + 112, _mm256_extractf128_ps(d, 1));
+}
+
+F_TARGET_AVX2 static inline void _fLoadMat4x8(const float* p, __m256* e)
+{
+	_fLoadRow4x8(p, e);
+	_fLoadRow4x8(p + 4, e + 4);
+	_fLoadRow4x8(p + 8, e + 8);
+	_fLoadRow4x8(p + 12, e + 12);
+}
+
+F_TARGET_AVX2 static inline void _fStoreMat4x8(float* p, const __m256* e)
+{
+	_fStoreRow4x8(p, e);
+	_fStoreRow4x8(p + 4, e + 4);
+	_fStoreRow4x8(p + 8, e + 8);
+	_fStoreRow4x8(p + 12, e + 12);
+}
+
+/// Loads one matrix row of a block, i.e. 4 consecutive element vectors.
+/// Written out on purpose, a loop over a local array is turned into a
+/// memcpy call by some compilers.
+F_TARGET_AVX2 static inline void _fLoadBlockRow4x8(const float* p, __m256* e)
+{
+	e[0] = _mm256_loadu_ps(p);
+	e[1] = _mm256_loadu_ps(p + 8);
+	e[2] = _mm256_loadu_ps(p + 16);
+	e[3] = _mm256_loadu_ps(p + 24);
+}
+
+F_TARGET_AVX2 static inline void _fStoreBlockRow4x8(float* p, const __m256* e)
+{
+	_mm256_storeu_ps(p, e[0]);
+	_mm256_storeu_ps(p + 8, e[1]);
+	_mm256_storeu_ps(p + 16, e[2]);
+	_mm256_storeu_ps(p + 24, e[3]);
+}
+
+F_TARGET_AVX2 static inline void _fLoadBlock4x8(const float* p, __m256* e)
+{
+	_fLoadBlockRow4x8(p, e);
+	_fLoadBlockRow4x8(p + 32, e + 4);
+	_fLoadBlockRow4x8(p + 64, e + 8);
+	_fLoadBlockRow4x8(p + 96, e + 12);
+}
+
+F_TARGET_AVX2 static inline void _fStoreBlock4x8(float* p, const __m256* e)
+{
+	_fStoreBlockRow4x8(p, e);
+	_fStoreBlockRow4x8(p + 32, e + 4);
+	_fStoreBlockRow4x8(p + 64, e + 8);
+	_fStoreBlockRow4x8(p + 96, e + 12);
+}
+
+F_TARGET_AVX2 static inline __m256 _fDet2x8(__m256 a, __m256 b, __m256 c, __m256 d)
+{
+	return _mm256_fmsub_ps(a, b, _mm256_mul_ps(c, d));
+}
+
+F_TARGET_AVX2 static inline __m256 _fCofactor3x8(__m256 a, __m256 ka, __m256 b, __m256 kb, __m256 c, __m256 kc)
+{
+	return _mm256_fmadd_ps(c, kc, _mm256_fmsub_ps(a, ka, _mm256_mul_ps(b, kb)));
+}
+
+F_TARGET_AVX2 static inline __m256 _fDot4x8(const __m256* a, const __m256* b, size_t c)
+{
+	return _mm256_fmadd_ps(a[0], b[c], _mm256_fmadd_ps(a[1], b[4 + c],
+		_mm256_fmadd_ps(a[2], b[8 + c], _mm256_mul_ps(a[3], b[12 + c]))));
+}
+
+F_TARGET_AVX2 static inline void _fMultiply4x8(const __m256* a, const __m256* b, __m256* d)
+{
+	for (size_t r = 0; r < 16; r += 4) {
+		d[r]     = _fDot4x8(a + r, b, 0);
+		d[r + 1] = _fDot4x8(a + r, b, 1);
+		d[r + 2] = _fDot4x8(a + r, b, 2);
+		d[r + 3] = _fDot4x8(a + r, b, 3);
+	}
+}
+
+F_TARGET_AVX2 static inline void _fInverse4x8(const __m256* m, __m256* d, bool transpose)
+{
+	__m256 s0 = _fDet2x8(m[0], m[5], m[1], m[4]);
+	__m256 s1 = _fDet2x8(m[0], m[6], m[2], m[4]);
+	__m256 s2 = _fDet2x8(m[0], m[7], m[3], m[4]);
+	__m256 s3 = _fDet2x8(m[1], m[6], m[2], m[5]);
+	__m256 s4 = _fDet2x8(m[1], m[7], m[3], m[5]);
+	__m256 s5 = _fDet2x8(m[2], m[7], m[3], m[6]);
+
+	__m256 c0 = _fDet2x8(m[8], m[13], m[9], m[12]);
+	__m256 c1 = _fDet2x8(m[8], m[14], m[10], m[12]);
+	__m256 c2 = _fDet2x8(m[8], m[15], m[11], m[12]);
+	__m256 c3 = _fDet2x8(m[9], m[14], m[10], m[13]);
+	__m256 c4 = _fDet2x8(m[9], m[15], m[11], m[13]);
+	__m256 c5 = _fDet2x8(m[10], m[15], m[11], m[14]);
+
+	__m256 det = _mm256_add_ps(
+		_mm256_fmadd_ps(s2, c3, _mm256_fmadd_ps(s3, c2, _fDet2x8(s0, c5, s1, c4))),
+		_fDet2x8(s5, c0, s4, c1));
+
+	__m256 p = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+	__m256 n = _mm256_sub_ps(_mm256_setzero_ps(), p);
+
+	const size_t i01 = transpose ? 4 : 1,  i02 = transpose ? 8 : 2,  i03 = transpose ? 12 : 3;
+	const size_t i10 = transpose ? 1 : 4,  i12 = transpose ? 9 : 6,  i13 = transpose ? 13 : 7;
+	const size_t i20 = transpose ? 2 : 8,  i21 = transpose ? 6 : 9,  i23 = transpose ? 14 : 11;
+	const size_t i30 = transpose ? 3 : 12, i31 = transpose ? 7 : 13, i32 = transpose ? 11 : 14;
+
+	d[0]   = _mm256_mul_ps(p, _fCofactor3x8(m[5],  c5, m[6],  c4, m[7],  c3));
+	d[i01] = _mm256_mul_ps(n, _fCofactor3x8(m[1],  c5, m[2],  c4, m[3],  c3));
+	d[i02] = _mm256_mul_ps(p, _fCofactor3x8(m[13], s5, m[14], s4, m[15], s3));
+	d[i03] = _mm256_mul_ps(n, _fCofactor3x8(m[9],  s5, m[10], s4, m[11], s3));
+	d[i10] = _mm256_mul_ps(n, _fCofactor3x8(m[4],  c5, m[6],  c2, m[7],  c1));
+	d[5]   = _mm256_mul_ps(p, _fCofactor3x8(m[0],  c5, m[2],  c2, m[3],  c1));
+	d[i12] = _mm256_mul_ps(n, _fCofactor3x8(m[12], s5, m[14], s2, m[15], s1));
+	d[i13] = _mm256_mul_ps(p, _fCofactor3x8(m[8],  s5, m[10], s2, m[11], s1));
+	d[i20] = _mm256_mul_ps(p, _fCofactor3x8(m[4],  c4, m[5],  c2, m[7],  c0));
+	d[i21] = _mm256_mul_ps(n, _fCofactor3x8(m[0],  c4, m[1],  c2, m[3],  c0));
+	d[10]  = _mm256_mul_ps(p, _fCofactor3x8(m[12], s4, m[13], s2, m[15], s0));
+	d[i23] = _mm256_mul_ps(n, _fCofactor3x8(m[8],  s4, m[9],  s2, m[11], s0));
+	d[i30] = _mm256_mul_ps(n, _fCofactor3x8(m[4],  c3, m[5],  c1, m[6],  c0));
+	d[i31] = _mm256_mul_ps(p, _fCofactor3x8(m[0],  c3, m[1],  c1, m[2],  c0));
+	d[i32] = _mm256_mul_ps(n, _fCofactor3x8(m[12], s3, m[13], s1, m[14], s0));
+	d[15]  = _mm256_mul_ps(p, _fCofactor3x8(m[8],  s3, m[9],  s1, m[10], s0));
+}
+
+F_TARGET_AVX2 static void _fMultiplyManyAVX2(const float* pA, const float* pB, float* pDst, size_t count)
+{
+	__m256 a[16], b[16], d[16];
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		_fLoadMat4x8(pA + i * 16, a);
+		_fLoadMat4x8(pB + i * 16, b);
+		_fMultiply4x8(a, b, d);
+		_fStoreMat4x8(pDst + i * 16, d);
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().multiplyMany(pA + i * 16, pB + i * 16, pDst + i * 16, count - i);
+}
+
+F_TARGET_AVX2 static void _fInverseManyAVX2(const float* pSrc, float* pDst, size_t count, bool transpose)
+{
+	__m256 m[16], d[16];
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		_fLoadMat4x8(pSrc + i * 16, m);
+		_fInverse4x8(m, d, transpose);
+		_fStoreMat4x8(pDst + i * 16, d);
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().inverseMany(pSrc + i * 16, pDst + i * 16, count - i, transpose);
+}
+
+F_TARGET_AVX2 static void _fMultiplyBlocksAVX2(const float* pA, const float* pB, float* pDst, size_t count)
+{
+	__m256 a[16], b[16], d[16];
+
+	for (size_t i = 0; i < count; ++i) {
+		_fLoadBlock4x8(pA + i * 128, a);
+		_fLoadBlock4x8(pB + i * 128, b);
+		_fMultiply4x8(a, b, d);
+		_fStoreBlock4x8(pDst + i * 128, d);
+	}
+}
+
+F_TARGET_AVX2 static void _fInverseBlocksAVX2(const float* pSrc, float* pDst, size_t count, bool transpose)
+{
+	__m256 m[16], d[16];
+
+	for (size_t i = 0; i < count; ++i) {
+		_fLoadBlock4x8(pSrc + i * 128, m);
+		_fInverse4x8(m, d, transpose);
+		_fStoreBlock4x8(pDst + i * 128, d);
+	}
+}
+
+// Quaternion kernels, 8 quaternions per register. Remaining elements are
+// handed over to the SSE4 kernels.
+
+F_TARGET_AVX2 static inline void _fQuatNormalize8(__m256* q)
+{
+	__m256 len2 = _mm256_fmadd_ps(q[0], q[0], _mm256_fmadd_ps(q[1], q[1],
+		_mm256_fmadd_ps(q[2], q[2], _mm256_mul_ps(q[3], q[3]))));
+	__m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f),
+		_mm256_sqrt_ps(_mm256_max_ps(len2, _mm256_set1_ps(FLT_MIN))));
+	q[0] = _mm256_mul_ps(q[0], inv);
+	q[1] = _mm256_mul_ps(q[1], inv);
+	q[2] = _mm256_mul_ps(q[2], inv);
+	q[3] = _mm256_mul_ps(q[3], inv);
+}
+
+F_TARGET_AVX2 static inline __m256 _fAcos01x8(__m256 x)
+{
+	__m256 p = _mm256_set1_ps(_fAcosCoeffs[7]);
+	for (int k = 6; k >= 0; --k)
+		p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(_fAcosCoeffs[k]));
+	return _mm256_mul_ps(p, _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x)));
+}
+
+F_TARGET_AVX2 static inline __m256 _fSinHalfPix8(__m256 x)
+{
+	__m256 x2 = _mm256_mul_ps(x, x);
+	__m256 p = _mm256_set1_ps(_fSinCoeffs[5]);
+	for (int k = 4; k >= 0; --k)
+		p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(_fSinCoeffs[k]));
+	return _mm256_mul_ps(p, x);
+}
+
+F_TARGET_AVX2 static void _fQuatNormalizeAVX2(const float* const* pSrc, float* const* pDst, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 q[4];
+		for (size_t c = 0; c < 4; ++c)
+			q[c] = _mm256_loadu_ps(pSrc[c] + i);
+
+		_fQuatNormalize8(q);
+
+		for (size_t c = 0; c < 4; ++c)
+			_mm256_storeu_ps(pDst[c] + i, q[c]);
+	}
+
+	if (i < count) {
+		const float* src[4] = { pSrc[0] + i, pSrc[1] + i, pSrc[2] + i, pSrc[3] + i };
+		float* dst[4] = { pDst[0] + i, pDst[1] + i, pDst[2] + i, pDst[3] + i };
+		_fSimdKernelsSSE4().quatNormalize(src, dst, count - i);
+	}
+}
+
+F_TARGET_AVX2 static void _fQuatInterpolateAVX2(const float* const* pA, const float* const* pB,
+	const float* pFactor, size_t factorStride, float* const* pDst, size_t count, bool spherical)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 a[4], b[4];
+		for (size_t c = 0; c < 4; ++c) {
+			a[c] = _mm256_loadu_ps(pA[c] + i);
+			b[c] = _mm256_loadu_ps(pB[c] + i);
+		}
+
+		__m256 t = factorStride ? _mm256_loadu_ps(pFactor + i) : _mm256_set1_ps(*pFactor);
+
+		__m256 d = _mm256_fmadd_ps(a[0], b[0], _mm256_fmadd_ps(a[1], b[1],
+			_mm256_fmadd_ps(a[2], b[2], _mm256_mul_ps(a[3], b[3]))));
+		__m256 sign = _mm256_and_ps(d, signMask);
+		d = _mm256_xor_ps(d, sign);
+
+		__m256 f1 = _mm256_sub_ps(one, t);
+		__m256 f2 = t;
+
+		if (spherical) {
+			__m256 theta = _fAcos01x8(_mm256_min_ps(d, one));
+			__m256 s = _mm256_div_ps(one, _fSinHalfPix8(theta));
+			__m256 s1 = _mm256_mul_ps(_fSinHalfPix8(_mm256_mul_ps(f1, theta)), s);
+			__m256 s2 = _mm256_mul_ps(_fSinHalfPix8(_mm256_mul_ps(f2, theta)), s);
+			__m256 linear = _mm256_cmp_ps(d, _mm256_set1_ps(_fSlerpThreshold), _CMP_GT_OQ);
+			f1 = _mm256_blendv_ps(s1, f1, linear);
+			f2 = _mm256_blendv_ps(s2, f2, linear);
+		}
+
+		f2 = _mm256_xor_ps(f2, sign);
+
+		__m256 q[4];
+		for (size_t c = 0; c < 4; ++c)
+			q[c] = _mm256_fmadd_ps(f1, a[c], _mm256_mul_ps(f2, b[c]));
+
+		_fQuatNormalize8(q);
+
+		for (size_t c = 0; c < 4; ++c)
+			_mm256_storeu_ps(pDst[c] + i, q[c]);
+	}
+
+	if (i < count) {
+		const float* a[4] = { pA[0] + i, pA[1] + i, pA[2] + i, pA[3] + i };
+		const float* b[4] = { pB[0] + i, pB[1] + i, pB[2] + i, pB[3] + i };
+		float* dst[4] = { pDst[0] + i, pDst[1] + i, pDst[2] + i, pDst[3] + i };
+		_fSimdKernelsSSE4().quatInterpolate(a, b, pFactor + (factorStride ? i : 0), factorStride,
+			dst, count - i, spherical);
+	}
+}
+
+F_TARGET_AVX2 static void _fQuatRotateAVX2(const float* const* pQuat, const float* const* pSrc,
+	float* const* pDst, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 qx = _mm256_loadu_ps(pQuat[0] + i), qy = _mm256_loadu_ps(pQuat[1] + i);
+		__m256 qz = _mm256_loadu_ps(pQuat[2] + i), qw = _mm256_loadu_ps(pQuat[3] + i);
+		__m256 vx = _mm256_loadu_ps(pSrc[0] + i), vy = _mm256_loadu_ps(pSrc[1] + i);
+		__m256 vz = _mm256_loadu_ps(pSrc[2] + i);
+
+		__m256 tx = _mm256_fmsub_ps(qy, vz, _mm256_mul_ps(qz, vy));
+		__m256 ty = _mm256_fmsub_ps(qz, vx, _mm256_mul_ps(qx, vz));
+		__m256 tz = _mm256_fmsub_ps(qx, vy, _mm256_mul_ps(qy, vx));
+		tx = _mm256_add_ps(tx, tx); ty = _mm256_add_ps(ty, ty); tz = _mm256_add_ps(tz, tz);
+
+		__m256 rx = _mm256_fmadd_ps(qw, tx, _mm256_add_ps(vx, _mm256_fmsub_ps(qy, tz, _mm256_mul_ps(qz, ty))));
+		__m256 ry = _mm256_fmadd_ps(qw, ty, _mm256_add_ps(vy, _mm256_fmsub_ps(qz, tx, _mm256_mul_ps(qx, tz))));
+		__m256 rz = _mm256_fmadd_ps(qw, tz, _mm256_add_ps(vz, _mm256_fmsub_ps(qx, ty, _mm256_mul_ps(qy, tx))));
+
+		_mm256_storeu_ps(pDst[0] + i, rx);
+		_mm256_storeu_ps(pDst[1] + i, ry);
+		_mm256_storeu_ps(pDst[2] + i, rz);
+	}
+
+	if (i < count) {
+		const float* q[4] = { pQuat[0] + i, pQuat[1] + i, pQuat[2] + i, pQuat[3] + i };
+		const float* src[3] = { pSrc[0] + i, pSrc[1] + i, pSrc[2] + i };
+		float* dst[3] = { pDst[0] + i, pDst[1] + i, pDst[2] + i };
+		_fSimdKernelsSSE4().quatRotate(q, src, dst, count - i);
+	}
+}
+
+F_TARGET_AVX2 static void _fQuatToMatrixAVX2(const float* const* pQuat, float* pDst, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m128 lastRow = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(pQuat[0] + i), y = _mm256_loadu_ps(pQuat[1] + i);
+		__m256 z = _mm256_loadu_ps(pQuat[2] + i), w = _mm256_loadu_ps(pQuat[3] + i);
+
+		__m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+		__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+		__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+		__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+		__m256 rows[3][4] = {
+			{ _mm256_sub_ps(one, _mm256_add_ps(yy, zz)), _mm256_sub_ps(xy, wz), _mm256_add_ps(xz, wy), _mm256_setzero_ps() },
+			{ _mm256_add_ps(xy, wz), _mm256_sub_ps(one, _mm256_add_ps(xx, zz)), _mm256_sub_ps(yz, wx), _mm256_setzero_ps() },
+			{ _mm256_sub_ps(xz, wy), _mm256_add_ps(yz, wx), _mm256_sub_ps(one, _mm256_add_ps(xx, yy)), _mm256_setzero_ps() }
+		};
+
+		float* pm = pDst + i * 16;
+
+		for (size_t r = 0; r < 3; ++r) {
+			__m256* e = rows[r];
+			_fTranspose4x8(e[0], e[1], e[2], e[3]);
+			for (size_t k = 0; k < 4; ++k) {
+				_mm_storeu_ps(pm + k * 16 + r * 4, _mm256_castps256_ps128(e[k]));
+				_mm_storeu_ps(pm + (k + 4) * 16 + r * 4, _mm256_extractf128_ps(e[k], 1));
+			}
+		}
+		for (size_t k = 0; k < 8; ++k)
+			_mm_storeu_ps(pm + k * 16 + 12, lastRow);
+	}
+
+	if (i < count) {
+		const float* q[4] = { pQuat[0] + i, pQuat[1] + i, pQuat[2] + i, pQuat[3] + i };
+		_fSimdKernelsSSE4().quatToMatrix(q, pDst + i * 16, count - i);
+	}
+}
+
+F_TARGET_AVX2 static size_t _fCullBoxesAVX2(const float* const* pBox, const float* pPlanes,
+	size_t count, uint32_t* pVisible)
+{
+	size_t i = 0, n = 0;
+
+	__m256 pl[42];
+	for (size_t k = 0; k < 6; ++k) {
+		const float* p = pPlanes + 4 * k;
+		pl[7 * k]     = _mm256_set1_ps(p[0]);
+		pl[7 * k + 1] = _mm256_set1_ps(p[1]);
+		pl[7 * k + 2] = _mm256_set1_ps(p[2]);
+		pl[7 * k + 3] = _mm256_set1_ps(p[3]);
+		pl[7 * k + 4] = _mm256_set1_ps(fabsf(p[0]));
+		pl[7 * k + 5] = _mm256_set1_ps(fabsf(p[1]));
+		pl[7 * k + 6] = _mm256_set1_ps(fabsf(p[2]));
+	}
+
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x0 = _mm256_loadu_ps(pBox[0] + i), x1 = _mm256_loadu_ps(pBox[3] + i);
+		__m256 y0 = _mm256_loadu_ps(pBox[1] + i), y1 = _mm256_loadu_ps(pBox[4] + i);
+		__m256 z0 = _mm256_loadu_ps(pBox[2] + i), z1 = _mm256_loadu_ps(pBox[5] + i);
+
+		__m256 cx = _mm256_mul_ps(_mm256_add_ps(x0, x1), half), ex = _mm256_mul_ps(_mm256_sub_ps(x1, x0), half);
+		__m256 cy = _mm256_mul_ps(_mm256_add_ps(y0, y1), half), ey = _mm256_mul_ps(_mm256_sub_ps(y1, y0), half);
+		__m256 cz = _mm256_mul_ps(_mm256_add_ps(z0, z1), half), ez = _mm256_mul_ps(_mm256_sub_ps(z1, z0), half);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (size_t k = 0; k < 42; k += 7) {
+			__m256 d = _mm256_fmadd_ps(pl[k], cx, _mm256_fmadd_ps(pl[k + 1], cy,
+				_mm256_fmadd_ps(pl[k + 2], cz, pl[k + 3])));
+			d = _mm256_fmadd_ps(pl[k + 4], ex, _mm256_fmadd_ps(pl[k + 5], ey,
+				_mm256_fmadd_ps(pl[k + 6], ez, d)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+		}
+
+		// compacted in two halves, the stores never exceed element i + 8
+		int mask = _mm256_movemask_ps(inside);
+		_fCompact4(pVisible + n, (uint32_t)i, mask & 0xf);
+		n += _fBitCount4[mask & 0xf];
+		_fCompact4(pVisible + n, (uint32_t)(i + 4), mask >> 4);
+		n += _fBitCount4[mask >> 4];
+	}
+
+	if (i < count) {
+		const float* pb[6] = { pBox[0] + i, pBox[1] + i, pBox[2] + i, pBox[3] + i, pBox[4] + i, pBox[5] + i };
+		size_t r = _fSimdKernelsSSE4().cullBoxes(pb, pPlanes, count - i, pVisible + n);
+		for (size_t k = n; k < n + r; ++k)
+			pVisible[k] += (uint32_t)i;
+		n += r;
+	}
+
+	return n;
+}
+
+F_TARGET_AVX2 static void _fIncludeBoundsAVX2(const float* pSrc, size_t count, size_t stride,
+	float* pMin, float* pMax)
+{
+	// strided elements are gathered one by one, the SSE4 kernel is used
+	if (stride != 3 || count < 8) {
+		_fSimdKernelsSSE4().includeBounds(pSrc, count, stride, pMin, pMax);
+		return;
+	}
+
+	// 8 packed triples form 3 registers, lane j holds component j % 3
+	__m256 mn[3], mx[3];
+	mn[0] = mx[0] = _mm256_loadu_ps(pSrc);
+	mn[1] = mx[1] = _mm256_loadu_ps(pSrc + 8);
+	mn[2] = mx[2] = _mm256_loadu_ps(pSrc + 16);
+
+	size_t i = 8;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float* p = pSrc + i * 3;
+		__m256 a = _mm256_loadu_ps(p);
+		__m256 b = _mm256_loadu_ps(p + 8);
+		__m256 c = _mm256_loadu_ps(p + 16);
+		mn[0] = _mm256_min_ps(mn[0], a); mx[0] = _mm256_max_ps(mx[0], a);
+		mn[1] = _mm256_min_ps(mn[1], b); mx[1] = _mm256_max_ps(mx[1], b);
+		mn[2] = _mm256_min_ps(mn[2], c); mx[2] = _mm256_max_ps(mx[2], c);
+	}
+
+	F_ALIGN(32) float tMin[24], tMax[24];
+	for (size_t k = 0; k < 3; ++k) {
+		_mm256_store_ps(tMin + 8 * k, mn[k]);
+		_mm256_store_ps(tMax + 8 * k, mx[k]);
+	}
+	_fReduceBounds(tMin, tMax, 24, pMin, pMax);
+
+	if (i < count)
+		_fSimdKernelsSSE4().includeBounds(pSrc + i * 3, count - i, 3, pMin, pMax);
+}
+
+// 8-wide versions of the approximations in MathSimd.h.
+
+F_TARGET_AVX2 static inline __m256 _fPoly8(__m256 x, const float* c, size_t n)
+{
+	__m256 r = _mm256_set1_ps(c[n - 1]);
+	for (size_t i = n - 1; i > 0; --i)
+		r = _mm256_fmadd_ps(r, x, _mm256_set1_ps(c[i - 1]));
+	return r;
+}
+
+template <bool PRECISE>
+F_TARGET_AVX2 static inline void _fSinCos8(__m256 x, __m256& s, __m256& c)
+{
+	__m256 j = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.63661977f)),
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(1.5703125f), x);
+	r = _mm256_fnmadd_ps(j, _mm256_set1_ps(4.837512969970703125e-4f), r);
+	r = _mm256_fnmadd_ps(j, _mm256_set1_ps(7.54978995489188216e-8f), r);
+	__m256i q = _mm256_cvtps_epi32(j);
+	__m256 r2 = _mm256_mul_ps(r, r);
+
+	__m256 ps, pc;
+	if (PRECISE) {
+		ps = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), _fPoly8(r2, _fSinPrecise, 3), r);
+		pc = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), _fPoly8(r2, _fCosPrecise, 3),
+			_mm256_fnmadd_ps(r2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+	}
+	else {
+		ps = _mm256_mul_ps(r, _fPoly8(r2, _fSinFast, 2));
+		pc = _fPoly8(r2, _fCosFast, 3);
+	}
+
+	__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+		_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+	__m256 signS = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+	__m256 signC = _mm256_castsi256_ps(_mm256_slli_epi32(
+		_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+	s = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), signS);
+	c = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), signC);
+}
+
+template <bool PRECISE>
+F_TARGET_AVX2 static inline __m256 _fExp8(__m256 x)
+{
+	const __m256 lo = _mm256_set1_ps(-87.3f);
+	const __m256 hi = _mm256_set1_ps(88.3f);
+	__m256 xc = _mm256_min_ps(hi, _mm256_max_ps(lo, x));
+
+	__m256 n = _mm256_round_ps(_mm256_mul_ps(xc, _mm256_set1_ps(1.44269504f)),
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), xc);
+	r = _mm256_fmadd_ps(n, _mm256_set1_ps(2.12194440e-4f), r);
+
+	__m256 p;
+	if (PRECISE) {
+		p = _mm256_set1_ps(_fExpPrecise[0]);
+		for (size_t i = 1; i < 6; ++i)
+			p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(_fExpPrecise[i]));
+		p = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(r, r), p, r), _mm256_set1_ps(1.0f));
+	}
+	else {
+		p = _fPoly8(r, _fExpFast, 4);
+	}
+
+	__m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+	__m256 result = _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+
+	result = _mm256_and_ps(result, _mm256_cmp_ps(x, lo, _CMP_NLT_UQ));
+	return _mm256_blendv_ps(result, _mm256_set1_ps(HUGE_VALF), _mm256_cmp_ps(x, hi, _CMP_GT_OQ));
+}
+
+template <bool PRECISE>
+F_TARGET_AVX2 static inline __m256 _fLog8(__m256 x)
+{
+	__m256 denormal = _mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ);
+	__m256 xs = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), denormal);
+	__m256i xi = _mm256_castps_si256(xs);
+
+	__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(127));
+	e = _mm256_sub_epi32(e, _mm256_and_si256(_mm256_castps_si256(denormal), _mm256_set1_epi32(23)));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+		_mm256_and_si256(xi, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+
+	__m256 large = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+	e = _mm256_sub_epi32(e, _mm256_castps_si256(large));
+	__m256 ef = _mm256_cvtepi32_ps(e);
+
+	__m256 s = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_add_ps(m, _mm256_set1_ps(1.0f)));
+	__m256 s2 = _mm256_mul_ps(s, s);
+	__m256 p = PRECISE ? _fPoly8(s2, _fLogPrecise, 4) : _fPoly8(s2, _fLogFast, 2);
+
+	__m256 result = _mm256_fmadd_ps(ef, _mm256_set1_ps(0.693359375f),
+		_mm256_fnmadd_ps(ef, _mm256_set1_ps(2.12194440e-4f), _mm256_mul_ps(s, p)));
+
+	result = _mm256_blendv_ps(result, _mm256_set1_ps(-HUGE_VALF),
+		_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+	result = _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, _mm256_set1_ps(HUGE_VALF), _CMP_EQ_OQ));
+	return _mm256_or_ps(result, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NGE_UQ));
+}
+
+template <bool PRECISE>
+F_TARGET_AVX2 static inline __m256 _fAtan28(__m256 y, __m256 x)
+{
+	const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	__m256 ax = _mm256_andnot_ps(sign, x);
+	__m256 ay = _mm256_andnot_ps(sign, y);
+
+	__m256 mx = _mm256_max_ps(ax, ay);
+	__m256 t = _mm256_div_ps(_mm256_min_ps(ax, ay), mx);
+	t = _mm256_and_ps(t, _mm256_cmp_ps(mx, _mm256_setzero_ps(), _CMP_GT_OQ));
+	__m256 reduce = _mm256_cmp_ps(t, _mm256_set1_ps(0.41421356f), _CMP_GT_OQ);
+	t = _mm256_blendv_ps(t, _mm256_div_ps(_mm256_sub_ps(t, _mm256_set1_ps(1.0f)),
+		_mm256_add_ps(t, _mm256_set1_ps(1.0f))), reduce);
+
+	__m256 t2 = _mm256_mul_ps(t, t);
+	__m256 a = _mm256_mul_ps(t, PRECISE ? _fPoly8(t2, _fAtanPrecise, 5) : _fPoly8(t2, _fAtanFast, 2));
+	a = _mm256_add_ps(a, _mm256_and_ps(reduce, _mm256_set1_ps(0.78539816f)));
+
+	a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(1.57079633f), a), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+	a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(3.14159265f), a), x);
+	return _mm256_xor_ps(a, _mm256_and_ps(y, sign));
+}
+
+template <bool PRECISE>
+F_TARGET_AVX2 static inline __m256 _fAcos8(__m256 x)
+{
+	const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	__m256 ax = _mm256_min_ps(_mm256_andnot_ps(sign, x), _mm256_set1_ps(1.0f));
+	__m256 p = PRECISE ? _fPoly8(ax, _fAcosCoeffs, 8) : _fPoly8(ax, _fAcosFast, 4);
+	__m256 r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), ax)), p);
+	return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(3.14159265f), r), x);
+}
+
+template <int FUNCTION, bool PRECISE>
+F_TARGET_AVX2 static void _fApproxLoopAVX2(const float* pA, const float* pB,
+	float* pDst, float* pDst2, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 a = _mm256_loadu_ps(pA + i);
+		__m256 r, c;
+
+		switch (FUNCTION) {
+		case FSimdKernels::ApproxSin:
+			_fSinCos8<PRECISE>(a, r, c);
+			break;
+		case FSimdKernels::ApproxCos:
+			_fSinCos8<PRECISE>(a, c, r);
+			break;
+		case FSimdKernels::ApproxSinCos:
+			_fSinCos8<PRECISE>(a, r, c);
+			_mm256_storeu_ps(pDst2 + i, c);
+			break;
+		case FSimdKernels::ApproxExp:
+			r = _fExp8<PRECISE>(a);
+			break;
+		case FSimdKernels::ApproxLog:
+			r = _fLog8<PRECISE>(a);
+			break;
+		case FSimdKernels::ApproxPow:
+			r = _fExp8<PRECISE>(_mm256_mul_ps(_mm256_loadu_ps(pB + i), _fLog8<PRECISE>(a)));
+			break;
+		case FSimdKernels::ApproxAtan2:
+			r = _fAtan28<PRECISE>(a, _mm256_loadu_ps(pB + i));
+			break;
+		case FSimdKernels::ApproxAcos:
+			r = _fAcos8<PRECISE>(a);
+			break;
+		}
+
+		_mm256_storeu_ps(pDst + i, r);
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().approx(FSimdKernels::ApproxFunction(FUNCTION), pA + i,
+			pB ? pB + i : pB, pDst + i, pDst2 ? pDst2 + i : pDst2, count - i, PRECISE);
+}
+
+F_TARGET_AVX2 static void _fApproxAVX2(FSimdKernels::ApproxFunction function, const float* pA, const float* pB,
+	float* pDst, float* pDst2, size_t count, bool precise)
+{
+	switch (function) {
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxSin)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxCos)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxSinCos)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxExp)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxLog)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxPow)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxAtan2)
+	F_APPROX_CASE(_fApproxLoopAVX2, ApproxAcos)
+	}
+}
+
+// 8-wide version of the curve kernel, see SimdKernels.cpp. The records of
+// samples i and i + 4 share a 256-bit register before the in-lane transpose.
+
+F_TARGET_AVX2 static inline void _fLoadCurves8(const float* const* p, __m256* s)
+{
+	for (size_t r = 0; r < 2; ++r) {
+		__m256 a0 = _mm256_insertf128_ps(_mm256_castps128_ps256(
+			_mm_loadu_ps(p[0] + 4 * r)), _mm_loadu_ps(p[4] + 4 * r), 1);
+		__m256 a1 = _mm256_insertf128_ps(_mm256_castps128_ps256(
+			_mm_loadu_ps(p[1] + 4 * r)), _mm_loadu_ps(p[5] + 4 * r), 1);
+		__m256 a2 = _mm256_insertf128_ps(_mm256_castps128_ps256(
+			_mm_loadu_ps(p[2] + 4 * r)), _mm_loadu_ps(p[6] + 4 * r), 1);
+		__m256 a3 = _mm256_insertf128_ps(_mm256_castps128_ps256(
+			_mm_loadu_ps(p[3] + 4 * r)), _mm_loadu_ps(p[7] + 4 * r), 1);
+
+		__m256 t0 = _mm256_unpacklo_ps(a0, a1);
+		__m256 t1 = _mm256_unpacklo_ps(a2, a3);
+		__m256 t2 = _mm256_unpackhi_ps(a0, a1);
+		__m256 t3 = _mm256_unpackhi_ps(a2, a3);
+		s[4 * r]     = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+		s[4 * r + 1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+		s[4 * r + 2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		s[4 * r + 3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	s[8] = _mm256_setr_ps(p[0][8], p[1][8], p[2][8], p[3][8],
+		p[4][8], p[5][8], p[6][8], p[7][8]);
+}
+
+F_TARGET_AVX2 static inline __m256 _fEvalCurve8(const __m256* s, __m256 time)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 tolerance = _mm256_set1_ps(_fCurveTolerance);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+	__m256 x = _mm256_mul_ps(_mm256_sub_ps(time, s[0]), s[1]);
+	x = _mm256_min_ps(_mm256_max_ps(x, zero), one);
+
+	__m256 dc2 = _mm256_add_ps(s[3], s[3]);
+	__m256 dc3 = _mm256_mul_ps(s[4], _mm256_set1_ps(3.0f));
+	__m256 u = x, lo = zero, hi = one;
+
+	for (size_t k = 0; k < _fCurveMaxIterations; ++k)
+	{
+		__m256 f = _mm256_fmadd_ps(s[4], u, s[3]);
+		f = _mm256_fmadd_ps(f, u, s[2]);
+		f = _mm256_fmsub_ps(f, u, x);
+
+		__m256 active = _mm256_cmp_ps(_mm256_and_ps(f, absMask), tolerance, _CMP_GT_OQ);
+		if (_mm256_movemask_ps(active) == 0)
+			break;
+
+		__m256 df = _mm256_fmadd_ps(dc3, u, dc2);
+		df = _mm256_fmadd_ps(df, u, s[2]);
+
+		__m256 above = _mm256_cmp_ps(f, zero, _CMP_GT_OQ);
+		hi = _mm256_blendv_ps(hi, u, above);
+		lo = _mm256_blendv_ps(u, lo, above);
+
+		__m256 next = _mm256_sub_ps(u, _mm256_div_ps(f, df));
+		__m256 inside = _mm256_and_ps(_mm256_cmp_ps(next, lo, _CMP_GT_OQ),
+			_mm256_cmp_ps(next, hi, _CMP_LT_OQ));
+		next = _mm256_blendv_ps(_mm256_mul_ps(_mm256_add_ps(lo, hi), half), next, inside);
+		u = _mm256_blendv_ps(u, next, active);
+	}
+
+	__m256 v = _mm256_fmadd_ps(s[8], u, s[7]);
+	v = _mm256_fmadd_ps(v, u, s[6]);
+	return _mm256_fmadd_ps(v, u, s[5]);
+}
+
+F_TARGET_AVX2 static void _fEvalCurvesAVX2(const float* pSegments, const uint32_t* pIndices,
+	size_t segmentStride, const float* pTimes, float* pValues, size_t count)
+{
+	__m256 s[9];
+	const float* p[8] = {
+		pSegments, pSegments, pSegments, pSegments, pSegments, pSegments, pSegments, pSegments
+	};
+
+	bool uniform = !pIndices && segmentStride == 0;
+	if (uniform)
+		_fLoadCurves8(p, s);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// the branch is kept outside the lane loops, vectorized pointer
+		// selection would issue masked loads from pIndices even if it is NULL
+		if (pIndices) {
+			for (size_t k = 0; k < 8; ++k)
+				p[k] = pSegments + pIndices[i + k] * _fCurveSegmentSize;
+			_fLoadCurves8(p, s);
+		}
+		else if (!uniform) {
+			for (size_t k = 0; k < 8; ++k)
+				p[k] = pSegments + (i + k) * segmentStride;
+			_fLoadCurves8(p, s);
+		}
+
+		_mm256_storeu_ps(pValues + i, _fEvalCurve8(s, _mm256_loadu_ps(pTimes + i)));
+	}
+
+	if (i < count)
+		_fSimdKernelsSSE4().evalCurves(pIndices ? pSegments : pSegments + i * segmentStride,
+			pIndices ? pIndices + i : pIndices, segmentStride, pTimes + i, pValues + i, count - i);
+}
+
+const FSimdKernels& _fSimdKernelsAVX2()
+{
+	// type conversion is bound by memory bandwidth, the SSE4 kernel is used
+	static const FSimdKernels kernels = {
+		FCpu::AVX2,
+		_fTransformStridedAVX2,
+		_fTransformSoAAVX2,
+		_fInterleaveAVX2,
+		_fMultiplyManyAVX2,
+		_fInverseManyAVX2,
+		_fMultiplyBlocksAVX2,
+		_fInverseBlocksAVX2,
+		_fQuatNormalizeAVX2,
+		_fQuatInterpolateAVX2,
+		_fQuatRotateAVX2,
+		_fQuatToMatrixAVX2,
+		_fCullBoxesAVX2,
+		_fIncludeBoundsAVX2,
+		_fApproxAVX2,
+		_fEvalCurvesAVX2,
+		_fSimdKernelsSSE4().convert
+	};
+
+	return kernels;
+}
+
+#endif // FLOW_SIMD_DISPATCH_AVX2
+
+// -----------------------------------------------------------------------------
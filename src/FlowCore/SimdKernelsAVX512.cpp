@@ -0,0 +1,197 @@
+// -----------------------------------------------------------------------------
+//  File        SimdKernelsAVX512.cpp
+//  Project     FlowCore
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/14 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCore/SimdKernels.h"
+
+#ifdef FLOW_SIMD_DISPATCH_AVX512
+
+#include <immintrin.h>
+
+// -----------------------------------------------------------------------------
+//  AVX-512 kernels
+// -----------------------------------------------------------------------------
+
+// All functions in this file must carry F_TARGET_AVX512 and may only be called
+// if FCpu reports AVX-512 support. Remaining elements are handed over to the
+// AVX2 kernels.
+
+F_TARGET_AVX512 static inline void _fAffine3x16(const __m512* m, __m512& x, __m512& y, __m512& z)
+{
+	__m512 ox = _mm512_fmadd_ps(m[0], x, _mm512_fmadd_ps(m[1], y, _mm512_fmadd_ps(m[2], z, m[3])));
+	__m512 oy = _mm512_fmadd_ps(m[4], x, _mm512_fmadd_ps(m[5], y, _mm512_fmadd_ps(m[6], z, m[7])));
+	__m512 oz = _mm512_fmadd_ps(m[8], x, _mm512_fmadd_ps(m[9], y, _mm512_fmadd_ps(m[10], z, m[11])));
+	x = ox; y = oy; z = oz;
+}
+
+F_TARGET_AVX512 static inline void _fNormalize3x16(__m512& x, __m512& y, __m512& z)
+{
+	__m512 len2 = _mm512_fmadd_ps(x, x, _mm512_fmadd_ps(y, y, _mm512_mul_ps(z, z)));
+	__m512 len = _mm512_sqrt_ps(_mm512_max_ps(len2, _mm512_set1_ps(FLT_MIN)));
+	__m512 inv = _mm512_div_ps(_mm512_set1_ps(1.0f), len);
+	x = _mm512_mul_ps(x, inv);
+	y = _mm512_mul_ps(y, inv);
+	z = _mm512_mul_ps(z, inv);
+}
+
+F_TARGET_AVX512 static void _fTransformStridedAVX512(const float* m, const float* pSrc, float* pDst,
+	size_t count, size_t srcStride, size_t dstStride, bool normalize)
+{
+	size_t i = 0;
+
+	__m512 m16[12];
+	for (size_t k = 0; k < 12; ++k)
+		m16[k] = _mm512_set1_ps(m[k]);
+
+	const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const __m512i srcIndex = _mm512_mullo_epi32(lane, _mm512_set1_epi32((int)srcStride));
+	const __m512i dstIndex = _mm512_mullo_epi32(lane, _mm512_set1_epi32((int)dstStride));
+
+	for (; i + 16 <= count; i += 16)
+	{
+		const float* ps = pSrc + i * srcStride;
+		float* pd = pDst + i * dstStride;
+
+		__m512 x = _mm512_i32gather_ps(srcIndex, ps, 4);
+		__m512 y = _mm512_i32gather_ps(srcIndex, ps + 1, 4);
+		__m512 z = _mm512_i32gather_ps(srcIndex, ps + 2, 4);
+
+		_fAffine3x16(m16, x, y, z);
+		if (normalize)
+			_fNormalize3x16(x, y, z);
+
+		_mm512_i32scatter_ps(pd, dstIndex, x, 4);
+		_mm512_i32scatter_ps(pd + 1, dstIndex, y, 4);
+		_mm512_i32scatter_ps(pd + 2, dstIndex, z, 4);
+	}
+
+	if (i < count)
+		_fSimdKernelsAVX2().transformStrided(m, pSrc + i * srcStride, pDst + i * dstStride,
+			count - i, srcStride, dstStride, normalize);
+}
+
+F_TARGET_AVX512 static void _fTransformSoAAVX512(const float* m,
+	const float* pSrcX, const float* pSrcY, const float* pSrcZ,
+	float* pDstX, float* pDstY, float* pDstZ, size_t count, bool normalize)
+{
+	size_t i = 0;
+
+	__m512 m16[12];
+	for (size_t k = 0; k < 12; ++k)
+		m16[k] = _mm512_set1_ps(m[k]);
+
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512 x = _mm512_loadu_ps(pSrcX + i);
+		__m512 y = _mm512_loadu_ps(pSrcY + i);
+		__m512 z = _mm512_loadu_ps(pSrcZ + i);
+
+		_fAffine3x16(m16, x, y, z);
+		if (normalize)
+			_fNormalize3x16(x, y, z);
+
+		_mm512_storeu_ps(pDstX + i, x);
+		_mm512_storeu_ps(pDstY + i, y);
+		_mm512_storeu_ps(pDstZ + i, z);
+	}
+
+	if (i < count)
+		_fSimdKernelsAVX2().transformSoA(m, pSrcX + i, pSrcY + i, pSrcZ + i,
+			pDstX + i, pDstY + i, pDstZ + i, count - i, normalize);
+}
+
+F_TARGET_AVX512 static size_t _fCullBoxesAVX512(const float* const* pBox, const float* pPlanes,
+	size_t count, uint32_t* pVisible)
+{
+	size_t i = 0, n = 0;
+
+	__m512 pl[42];
+	for (size_t k = 0; k < 6; ++k) {
+		const float* p = pPlanes + 4 * k;
+		pl[7 * k]     = _mm512_set1_ps(p[0]);
+		pl[7 * k + 1] = _mm512_set1_ps(p[1]);
+		pl[7 * k + 2] = _mm512_set1_ps(p[2]);
+		pl[7 * k + 3] = _mm512_set1_ps(p[3]);
+		pl[7 * k + 4] = _mm512_set1_ps(fabsf(p[0]));
+		pl[7 * k + 5] = _mm512_set1_ps(fabsf(p[1]));
+		pl[7 * k + 6] = _mm512_set1_ps(fabsf(p[2]));
+	}
+
+	const __m512 half = _mm512_set1_ps(0.5f);
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512 x0 = _mm512_loadu_ps(pBox[0] + i), x1 = _mm512_loadu_ps(pBox[3] + i);
+		__m512 y0 = _mm512_loadu_ps(pBox[1] + i), y1 = _mm512_loadu_ps(pBox[4] + i);
+		__m512 z0 = _mm512_loadu_ps(pBox[2] + i), z1 = _mm512_loadu_ps(pBox[5] + i);
+
+		__m512 cx = _mm512_mul_ps(_mm512_add_ps(x0, x1), half), ex = _mm512_mul_ps(_mm512_sub_ps(x1, x0), half);
+		__m512 cy = _mm512_mul_ps(_mm512_add_ps(y0, y1), half), ey = _mm512_mul_ps(_mm512_sub_ps(y1, y0), half);
+		__m512 cz = _mm512_mul_ps(_mm512_add_ps(z0, z1), half), ez = _mm512_mul_ps(_mm512_sub_ps(z1, z0), half);
+
+		__mmask16 inside = 0xffff;
+		for (size_t k = 0; k < 42; k += 7) {
+			__m512 d = _mm512_fmadd_ps(pl[k], cx, _mm512_fmadd_ps(pl[k + 1], cy,
+				_mm512_fmadd_ps(pl[k + 2], cz, pl[k + 3])));
+			d = _mm512_fmadd_ps(pl[k + 4], ex, _mm512_fmadd_ps(pl[k + 5], ey,
+				_mm512_fmadd_ps(pl[k + 6], ez, d)));
+			inside = _mm512_mask_cmp_ps_mask(inside, d, zero, _CMP_GE_OQ);
+		}
+
+		__m512i index = _mm512_add_epi32(lane, _mm512_set1_epi32((int)i));
+		_mm512_mask_compressstoreu_epi32(pVisible + n, inside, index);
+		n += _fBitCount4[inside & 0xf] + _fBitCount4[(inside >> 4) & 0xf]
+			+ _fBitCount4[(inside >> 8) & 0xf] + _fBitCount4[inside >> 12];
+	}
+
+	if (i < count) {
+		const float* pb[6] = { pBox[0] + i, pBox[1] + i, pBox[2] + i, pBox[3] + i, pBox[4] + i, pBox[5] + i };
+		size_t r = _fSimdKernelsAVX2().cullBoxes(pb, pPlanes, count - i, pVisible + n);
+		for (size_t k = n; k < n + r; ++k)
+			pVisible[k] += (uint32_t)i;
+		n += r;
+	}
+
+	return n;
+}
+
+const FSimdKernels& _fSimdKernelsAVX512()
+{
+	// interleaving and bounds computation are bound by memory bandwidth, the
+	// AVX2 kernels are used; the matrix array kernels work on blocks of 8
+	// matrices, for these, the quaternion, the approximation and the curve
+	// kernels the AVX2 versions are used as well, type conversion uses the
+	// SSE4 kernel
+	static const FSimdKernels kernels = {
+		FCpu::AVX512,
+		_fTransformStridedAVX512,
+		_fTransformSoAAVX512,
+		_fSimdKernelsAVX2().interleave,
+		_fSimdKernelsAVX2().multiplyMany,
+		_fSimdKernelsAVX2().inverseMany,
+		_fSimdKernelsAVX2().multiplyBlocks,
+		_fSimdKernelsAVX2().inverseBlocks,
+		_fSimdKernelsAVX2().quatNormalize,
+		_fSimdKernelsAVX2().quatInterpolate,
+		_fSimdKernelsAVX2().quatRotate,
+		_fSimdKernelsAVX2().quatToMatrix,
+		_fCullBoxesAVX512,
+		_fSimdKernelsAVX2().includeBounds,
+		_fSimdKernelsAVX2().approx,
+		_fSimdKernelsAVX2().evalCurves,
+		_fSimdKernelsAVX2().convert
+	};
+
+	return kernels;
+}
+
+#endif // FLOW_SIMD_DISPATCH_AVX512
+
+// -----------------------------------------------------------------------------
@@ -95,9 +95,22 @@ __inline double fElapsedSeconds()
 	return (double)currentTicks / scaleFactor;
 }
 #endif // F_USE_PERFORMANCE_COUNTER
+#elif (FLOW_PLATFORM & (FLOW_PLATFORM_LINUX | FLOW_PLATFORM_UNIX))
+
+#include <time.h>
+
+/// Returns the number of seconds elapsed since an arbitrary starting point
+/// using the monotonic system clock.
+__inline double fElapsedSeconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
 #else // (FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS)
 
-// TODO: Implement performance counter query for Linux and OSX
+// TODO: Implement performance counter query for OSX
 /// Returns the performance counter frequency (the number of ticks per second).
 __inline double fElapsedSeconds()
 {
@@ -15,6 +15,11 @@
 //  Class FTypeInfo
 // -----------------------------------------------------------------------------
 
+// Static members --------------------------------------------------------------
+
+// zero, i.e. invalid, even if types are registered before initialization
+QAtomicInt FTypeInfo::s_isHierarchyValid(0);
+
 // Constructors and destructor -------------------------------------------------
 
 FTypeInfo::FTypeInfo(const char* typeName,
@@ -26,7 +31,9 @@ FTypeInfo::FTypeInfo(const char* typeName,
   m_objectSize(objectSize),
   m_version(version),
   m_pfnCreateObject(pfnCreateObject),
-  m_pBaseType(pBaseType)
+  m_pBaseType(pBaseType),
+  m_hierarchyIndex(0),
+  m_hierarchyEnd(0)
 {
 	m_typeId = FTypeRegistry::instance()->registerType(this);
 }
@@ -47,4 +54,11 @@ FObject* FTypeInfo::createObject() const
 	return pObject;
 }
 
+// Internal functions ----------------------------------------------------------
+
+void FTypeInfo::_updateHierarchy()
+{
+	FTypeRegistry::instance()->_updateHierarchy();
+}
+
 // -----------------------------------------------------------------------------
@@ -12,6 +12,8 @@
 
 #include "FlowCore/Library.h"
 
+#include <QAtomicInt>
+
 class FObject;
 
 // -----------------------------------------------------------------------------
@@ -25,6 +27,8 @@ class FObject;
 /// powerful serialization system for complex object graphs.
 class FLOWCORE_EXPORT FTypeInfo
 {
+	friend class FTypeRegistry;
+
 	//  Constructors and destructor ----------------------------------
 
 public:
@@ -40,6 +44,7 @@ public:
 	//  Public queries -----------------------------------------------
 
 	/// Returns true if the actual type is derived from the given base type.
+	/// Takes constant time, independent of the depth of the hierarchy.
 	bool isDerivedFrom(const FTypeInfo* pBaseType) const;
 	/// Returns the type version.
     size_t version() const { return m_version; }
@@ -52,15 +57,28 @@ public:
     /// Returns the size of the type.
     size_t typeSize() const { return m_objectSize; }
 
-	//  Public members -----------------------------------------------
+	//  Internal functions -------------------------------------------
 
 private:
+	static void _updateHierarchy();
+
+	//  Public members -----------------------------------------------
+
 	const char* m_typeName;
     size_t m_objectSize;
     size_t m_version;
     size_t m_typeId;
 	FObject* (*m_pfnCreateObject)();
 	const FTypeInfo* m_pBaseType;
+
+	// position of the type in a preorder traversal of the type hierarchy,
+	// the types derived from it occupy the positions up to m_hierarchyEnd
+	mutable uint32_t m_hierarchyIndex;
+	mutable uint32_t m_hierarchyEnd;
+
+	// cleared when a type is registered, the positions are then updated
+	// by the next call to isDerivedFrom()
+	static QAtomicInt s_isHierarchyValid;
 };
 
 // Inline members --------------------------------------------------------------
@@ -70,15 +88,11 @@ inline bool FTypeInfo::isDerivedFrom(const FTypeInfo* pBaseType) const
 	F_ASSERT(this);
 	F_ASSERT(pBaseType);
 
-	const FTypeInfo* pType = this;
-	while(pType != NULL)
-	{
-		if (pType == pBaseType)
-			return true;
-		pType = pType->m_pBaseType;
-	}
+	if (!s_isHierarchyValid.loadAcquire())
+		_updateHierarchy();
 
-	return false;
+	return m_hierarchyIndex >= pBaseType->m_hierarchyIndex
+		&& m_hierarchyIndex < pBaseType->m_hierarchyEnd;
 }
 
 // -----------------------------------------------------------------------------
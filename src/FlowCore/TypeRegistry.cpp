@@ -10,6 +10,8 @@
 #include "FlowCore/TypeRegistry.h"
 #include "FlowCore/TypeInfo.h"
 
+#include <cstring>
+
 // -----------------------------------------------------------------------------
 //  Class FTypeRegistry
 // -----------------------------------------------------------------------------
@@ -39,13 +41,8 @@ const FTypeInfo* FTypeRegistry::classFromId(size_t classId) const
 
 const FTypeInfo* FTypeRegistry::classFromName(const char* className) const
 {
-	for (size_t i = 0; i < m_classList.size(); ++i)
-	{
-		if (strcmp(className, m_classList[i]->typeName()) == 0)
-			return m_classList[i];
-	}
-
-	return NULL;
+	nameTable_t::const_iterator it = m_nameTable.find(className);
+	return it != m_nameTable.end() ? it->second : NULL;
 }
 
 FObject* FTypeRegistry::createObject(size_t classId) const
@@ -71,7 +68,95 @@ size_t FTypeRegistry::registerType(FTypeInfo* pClass)
 {
 	size_t classId = m_classList.size();
 	m_classList.push_back(pClass);
+
+	// if several classes have the same name, the first one is found
+	m_nameTable.insert(nameTable_t::value_type(pClass->typeName(), pClass));
+
+	// base classes may be registered after their derived classes, the
+	// hierarchy is therefore numbered on demand
+	FTypeInfo::s_isHierarchyValid.storeRelease(0);
+
 	return classId;
 }
 
+// Internal functions ----------------------------------------------------------
+
+void FTypeRegistry::_updateHierarchy()
+{
+	FSectionLock lock(&m_hierarchyLock);
+	if (FTypeInfo::s_isHierarchyValid.loadAcquire())
+		return;
+
+	// collect the derived types of each type, types whose base type
+	// is not registered are roots of the hierarchy
+	typedef std::unordered_map<const FTypeInfo*, std::vector<FTypeInfo*> > childTable_t;
+	childTable_t children;
+	std::vector<FTypeInfo*> roots;
+
+	for (size_t i = 0; i < m_classList.size(); ++i)
+		children[m_classList[i]];
+
+	for (size_t i = 0; i < m_classList.size(); ++i) {
+		FTypeInfo* pClass = m_classList[i];
+		childTable_t::iterator it = children.find(pClass->m_pBaseType);
+		if (it != children.end())
+			it->second.push_back(pClass);
+		else
+			roots.push_back(pClass);
+	}
+
+	// number the types in preorder, the derived types of a type
+	// are numbered within the range [index, end) of the type
+	struct visit_t
+	{
+		FTypeInfo* pClass;
+		size_t child;
+	};
+
+	std::vector<visit_t> stack;
+	uint32_t index = 0;
+
+	for (size_t r = 0; r < roots.size(); ++r)
+	{
+		visit_t root = { roots[r], 0 };
+		root.pClass->m_hierarchyIndex = index++;
+		stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			visit_t& top = stack.back();
+			const std::vector<FTypeInfo*>& derived = children[top.pClass];
+
+			if (top.child < derived.size()) {
+				visit_t next = { derived[top.child++], 0 };
+				next.pClass->m_hierarchyIndex = index++;
+				stack.push_back(next);
+			}
+			else {
+				top.pClass->m_hierarchyEnd = index;
+				stack.pop_back();
+			}
+		}
+	}
+
+	FTypeInfo::s_isHierarchyValid.storeRelease(1);
+}
+
+// Name table ------------------------------------------------------------------
+
+size_t FTypeRegistry::nameHash_t::operator()(const char* name) const
+{
+	// FNV-1a
+	size_t hash = 2166136261u;
+	for (; *name; ++name)
+		hash = (hash ^ size_t(uint8_t(*name))) * 16777619u;
+
+	return hash;
+}
+
+bool FTypeRegistry::nameEqual_t::operator()(const char* name0, const char* name1) const
+{
+	return strcmp(name0, name1) == 0;
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
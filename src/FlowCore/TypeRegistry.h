@@ -12,8 +12,10 @@
 
 #include "FlowCore/Library.h"
 #include "FlowCore/SingletonT.h"
+#include "FlowCore/CriticalSection.h"
 
 #include <QDebug>
+#include <unordered_map>
 #include <vector>
 
 class FObject;
@@ -43,6 +45,7 @@ public:
 
 	/// Returns the runtime class object for a given class name.
 	/// Returns null if the class with given name is not registered.
+	/// Names are looked up in a hash table built at registration.
 	const FTypeInfo* classFromName(const char* className) const;
 
 	/// Creates and returns an object of the class type with given id.
@@ -59,9 +62,29 @@ protected:
 	/// Registers a class type at the object manager.
 	size_t registerType(FTypeInfo* pClass);
 
+	//  Internal functions -------------------------------------------
+
+private:
+	void _updateHierarchy();
+
 	//  Internal data members ----------------------------------------
 
+	struct nameHash_t
+	{
+		size_t operator()(const char* name) const;
+	};
+
+	struct nameEqual_t
+	{
+		bool operator()(const char* name0, const char* name1) const;
+	};
+
+	typedef std::unordered_map<const char*, FTypeInfo*,
+		nameHash_t, nameEqual_t> nameTable_t;
+
 	std::vector<FTypeInfo*> m_classList;
+	nameTable_t m_nameTable;
+	FCriticalSection m_hierarchyLock;
 };
 
 // -----------------------------------------------------------------------------
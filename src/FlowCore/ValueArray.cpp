@@ -9,8 +9,48 @@
 
 #include "FlowCore/ValueArray.h"
 #include "FlowCore/Archive.h"
+#include "FlowCore/Allocator.h"
+#include "FlowCore/SimdKernels.h"
+#include "FlowCore/MappedFile.h"
 #include "FlowCore/MemoryTracer.h"
 
+#include <cstring>
+#include <new>
+
+// Helpers ---------------------------------------------------------------------
+
+// numbers and object pointers are served by the allocator,
+// strings need construction and are allocated on the heap;
+// like new[], running out of memory throws std::bad_alloc
+
+template <typename T>
+static inline T* _fNewArray(FAllocator* pAllocator, FValueArray::size_type count)
+{
+	void* p = pAllocator->allocate(count * sizeof(T));
+	if (!p && count > 0)
+		throw std::bad_alloc();
+
+	return static_cast<T*>(p);
+}
+
+template <>
+inline QString* _fNewArray<QString>(FAllocator*, FValueArray::size_type count)
+{
+	return new QString[count];
+}
+
+template <typename T>
+static inline void _fDeleteArray(FAllocator* pAllocator, T* p, FValueArray::size_type count)
+{
+	pAllocator->deallocate(p, count * sizeof(T));
+}
+
+template <>
+inline void _fDeleteArray<QString>(FAllocator*, QString* p, FValueArray::size_type)
+{
+	delete[] p;
+}
+
 // -----------------------------------------------------------------------------
 //  Class FValueArray
 // -----------------------------------------------------------------------------
@@ -62,12 +102,55 @@ void FValueArray::setChannelCapacity(size_type newChannelCapacity,
 	_reallocate(newChannelCapacity, m_dimensionCapacity, preserveData);
 }
 
+void FValueArray::setAllocator(FAllocator* pAllocator)
+{
+	if (!pAllocator)
+		pAllocator = FAllocator::defaultAllocator();
+
+	if (pAllocator == m_pAllocator)
+		return;
+
+	if (m_isReference || !m_isArray || m_type == FValueType::String) {
+		m_pAllocator = pAllocator;
+		return;
+	}
+
+	detach();
+
+	size_t elementSize = m_type == FValueType::Object
+		? sizeof(FObject*) : type().byteCount();
+	size_t byteCount = capacity() * elementSize;
+	void* pData = pAllocator->allocate(byteCount);
+	if (!pData && byteCount > 0)
+		throw std::bad_alloc();
+
+	memcpy(pData, m_raw.ptr, byteCount);
+
+	m_pAllocator->deallocate(m_raw.ptr, byteCount);
+	m_pAllocator = pAllocator;
+	m_raw.ptr = pData;
+}
+
+void FValueArray::setShared(bool shared)
+{
+	if (shared == (m_isShared != 0))
+		return;
+
+	detach();
+	m_isShared = shared;
+	_updateRefCount();
+}
+
+// set in the type byte if the data is stored as a raw block
+#define _F_VA_BLOCK_FLAG 0x80
+
 #define _F_VA_READ_DATA(valueType, rawType) \
 	case FValueType::valueType: { rawType* pData = _ptr<rawType>(); \
 	for (size_type i = 0; i < size; ++i) ar >> pData[i]; } break;
 
 #define _F_VA_WRITE_DATA(valueType, rawType) \
-	case FValueType::valueType: { rawType* const pData = _ptr<rawType>(); \
+	case FValueType::valueType: { const rawType* pData = \
+	static_cast<const FValueArray*>(this)->_ptr<rawType>(); \
 	for (size_type i = 0; i < size; ++i) ar << pData[i]; } break;
 
 void FValueArray::serialize(FArchive& ar, bool /* serializeRawData = true */)
@@ -84,12 +167,22 @@ void FValueArray::serialize(FArchive& ar, bool /* serializeRawData = true */)
 		ar >> dimensions;
 		ar >> channels;
 
+		bool isBlock = (type & _F_VA_BLOCK_FLAG) != 0;
+		type &= ~_F_VA_BLOCK_FLAG;
+
 		FValueType valueType((FValueType::enum_type)type);
 		_initialize(valueType, channels, dimensions, isReference != 0);
 
 		size_type size = m_dimensionCount * m_channelCount;
 		F_ASSERT(size == dimensions * channels);
 
+		if (isBlock)
+		{
+			F_ASSERT(valueType.isNumber());
+			ar.readBlock(rawPtr(), size, valueType.byteCount());
+			return;
+		}
+
 		switch(m_type)
 		{
 			_F_VA_READ_DATA(Float,   float    );
@@ -119,7 +212,10 @@ void FValueArray::serialize(FArchive& ar, bool /* serializeRawData = true */)
 	}
 	else // isWriting
 	{
-		ar << (quint8)m_type;
+		// numbers are written as one raw block
+		bool isBlock = type().isNumber();
+
+		ar << quint8(isBlock ? m_type | _F_VA_BLOCK_FLAG : m_type);
 		ar << (quint8)m_isReference;
 		ar << m_dimensionCount;
 		ar << m_channelCount;
@@ -129,6 +225,13 @@ void FValueArray::serialize(FArchive& ar, bool /* serializeRawData = true */)
 
 		size_type size = m_dimensionCount * m_channelCount;
 
+		if (isBlock)
+		{
+			const FValueArray* pThis = this;
+			ar.writeBlock(pThis->rawPtr(), size, type().byteCount());
+			return;
+		}
+
 		switch(m_type)
 		{
 			_F_VA_WRITE_DATA(Float,   float    );
@@ -203,6 +306,26 @@ QString FValueArray::dump() const
 
 void FValueArray::_copy(const FValueArray* pSource)
 {
+	if (pSource->m_pRefCount)
+	{
+		// shared data, add a reference
+		m_raw = pSource->m_raw;
+		m_dimensionCount = pSource->m_dimensionCount;
+		m_channelCount = pSource->m_channelCount;
+		m_dimensionCapacity = pSource->m_dimensionCapacity;
+		m_channelCapacity = pSource->m_channelCapacity;
+		m_type = pSource->m_type;
+		m_isArray = pSource->m_isArray;
+		m_isReference = pSource->m_isReference;
+		m_hasChanged = pSource->m_hasChanged;
+		m_isShared = pSource->m_isShared;
+
+		m_pAllocator = pSource->m_pAllocator;
+		m_pRefCount = pSource->m_pRefCount;
+		m_pRefCount->ref();
+		return;
+	}
+
 	_initialize(
 		(FValueType::enum_type)pSource->m_type, pSource->m_channelCapacity,
 		pSource->m_dimensionCapacity, pSource->m_isReference);
@@ -214,11 +337,64 @@ void FValueArray::_copy(const FValueArray* pSource)
 	if (!m_isReference && !isEmpty())
 	{
 		// copy data from other
-		_convert(pSource, 0, 0, m_channelCount, 1, 1, 0, 0, m_dimensionCount);
+		_convert(pSource, 0, 0, m_channelCount, 1, 1, 0, 0, m_dimensionCount, Cast);
 	}
 	else {
 		// copy only external reference
 		m_raw.ptr = pSource->m_raw.ptr;
+
+		m_pMapping = pSource->m_pMapping;
+		if (m_pMapping)
+			m_pMapping->ref();
+	}
+
+	m_isShared = pSource->m_isShared;
+	_updateRefCount();
+}
+
+void FValueArray::_move(FValueArray* pSource)
+{
+	m_raw = pSource->m_raw;
+	m_dimensionCount = pSource->m_dimensionCount;
+	m_channelCount = pSource->m_channelCount;
+	m_dimensionCapacity = pSource->m_dimensionCapacity;
+	m_channelCapacity = pSource->m_channelCapacity;
+	m_type = pSource->m_type;
+	m_pRefCount = pSource->m_pRefCount;
+	m_pAllocator = pSource->m_pAllocator;
+	m_pMapping = pSource->m_pMapping;
+	m_isArray = pSource->m_isArray;
+	m_isReference = pSource->m_isReference;
+	m_hasChanged = pSource->m_hasChanged;
+	m_isShared = pSource->m_isShared;
+
+	// the source no longer owns the data
+	pSource->_initialize(FValueType::Invalid, 0, 0, false);
+}
+
+void FValueArray::_detach()
+{
+	// keep a reference to the shared data while allocating the own copy
+	FValueArray shared(*this);
+	_delete();
+	_allocate();
+
+	if (!isEmpty())
+		_convert(&shared, 0, 0, m_channelCount, 1, 1, 0, 0, m_dimensionCount, Cast);
+}
+
+void FValueArray::_updateRefCount()
+{
+	// only allocated arrays are shared, single values are always copied
+	bool isCounted = m_isShared && m_isArray && !m_isReference;
+
+	if (isCounted && !m_pRefCount) {
+		m_pRefCount = new QAtomicInt(1);
+	}
+	else if (!isCounted && m_pRefCount) {
+		F_ASSERT(m_pRefCount->load() == 1);
+		delete m_pRefCount;
+		m_pRefCount = NULL;
 	}
 }
 
@@ -231,8 +407,12 @@ void FValueArray::_initialize(FValueType type,
 	m_dimensionCapacity = m_dimensionCount = dims;
 
 	m_type = type;
+	m_pRefCount = NULL;
+	m_pMapping = NULL;
+	m_isArray = false;
 	m_isReference = isReference;
 	m_hasChanged = 1;
+	m_isShared = false;
 
 	if (m_type != FValueType::Invalid)
 		_allocate();
@@ -260,25 +440,33 @@ void FValueArray::_allocate()
 		}
 		else
 		{
-			m_isArray = true;
+			if (!m_pAllocator)
+				m_pAllocator = FAllocator::defaultAllocator();
+
+			FAllocator* pA = m_pAllocator;
 
 			switch(m_type)
 			{
-			case FValueType::Float:   m_raw.ptr = new float[cap];    break;
-			case FValueType::Double:  m_raw.ptr = new double[cap];   break;
-			case FValueType::Bool:    m_raw.ptr = new bool[cap];     break;
-			case FValueType::Int8:    m_raw.ptr = new qint8[cap];   break;
-			case FValueType::UInt8:   m_raw.ptr = new quint8[cap];  break;
-			case FValueType::Int16:   m_raw.ptr = new int16_t[cap];  break;
-			case FValueType::UInt16:  m_raw.ptr = new uint16_t[cap]; break;
-			case FValueType::Int32:   m_raw.ptr = new qint32[cap];  break;
-			case FValueType::UInt32:  m_raw.ptr = new quint32[cap]; break;
-			case FValueType::Int64:   m_raw.ptr = new qint64[cap];  break;
-			case FValueType::UInt64:  m_raw.ptr = new quint64[cap]; break;
-			case FValueType::String:  m_raw.ptr = new QString[cap];  break;
-			case FValueType::Object:  m_raw.ptr = new FObject*[cap]; break;
+			case FValueType::Float:   m_raw.ptr = _fNewArray<float   >(pA, cap); break;
+			case FValueType::Double:  m_raw.ptr = _fNewArray<double  >(pA, cap); break;
+			case FValueType::Bool:    m_raw.ptr = _fNewArray<bool    >(pA, cap); break;
+			case FValueType::Int8:    m_raw.ptr = _fNewArray<qint8   >(pA, cap); break;
+			case FValueType::UInt8:   m_raw.ptr = _fNewArray<quint8  >(pA, cap); break;
+			case FValueType::Int16:   m_raw.ptr = _fNewArray<int16_t >(pA, cap); break;
+			case FValueType::UInt16:  m_raw.ptr = _fNewArray<uint16_t>(pA, cap); break;
+			case FValueType::Int32:   m_raw.ptr = _fNewArray<qint32  >(pA, cap); break;
+			case FValueType::UInt32:  m_raw.ptr = _fNewArray<quint32 >(pA, cap); break;
+			case FValueType::Int64:   m_raw.ptr = _fNewArray<qint64  >(pA, cap); break;
+			case FValueType::UInt64:  m_raw.ptr = _fNewArray<quint64 >(pA, cap); break;
+			case FValueType::String:  m_raw.ptr = _fNewArray<QString >(pA, cap); break;
+			case FValueType::Object:  m_raw.ptr = _fNewArray<FObject*>(pA, cap); break;
 			default: F_ASSERT(false); break;
 			}
+
+			// set after allocating, if the allocation throws,
+			// the array holds no data to be released
+			m_isArray = true;
+			_updateRefCount();
 		}
 	}
 	else
@@ -290,15 +478,18 @@ void FValueArray::_allocate()
 #define _F_VA_REALLOCATE_COPY(valueType, rawType) \
 	case FValueType::valueType: \
 	{ rawType* pOld = _ptr<rawType>(); if (newCap == 1) {  \
-	rawType val = *pOld; delete[] pOld; m_isArray = false; *_ptr<rawType>() = val; } \
-	else { rawType* pNew = new rawType[newCap]; \
+	rawType val = *pOld; _fDeleteArray(m_pAllocator, pOld, oldCap); \
+	m_isArray = false; *_ptr<rawType>() = val; } \
+	else { rawType* pNew = _fNewArray<rawType>(m_pAllocator, newCap); \
 	for (size_type i = 0; i < dataSize; ++i) pNew[i] = pOld[i]; \
-	if (m_isArray) delete[] pOld; else m_isArray = true; m_raw.ptr = pNew; } } break
+	if (m_isArray) _fDeleteArray(m_pAllocator, pOld, oldCap); \
+	else m_isArray = true; m_raw.ptr = pNew; } } break
 
 void FValueArray::_reallocate(size_type newChannelCapacity,
 	size_type newDimensionCapacity, bool preserveData)
 {
 	F_ASSERT(!m_isReference);
+	detach();
 
 	size_type oldCap = capacity();
 	size_type oldSize = size();
@@ -309,16 +500,18 @@ void FValueArray::_reallocate(size_type newChannelCapacity,
 	if (oldCap == newCap)
 		return;
 
-	m_channelCapacity = newChannelCapacity;
-	m_dimensionCapacity = newDimensionCapacity;
-
 	if (!preserveData || newCap == 0)
 	{
 		_delete();
+		m_channelCapacity = newChannelCapacity;
+		m_dimensionCapacity = newDimensionCapacity;
 		_allocate();
 	}
 	else
 	{
+		if (!m_pAllocator)
+			m_pAllocator = FAllocator::defaultAllocator();
+
 		// copy only values that remain in use
 		size_type dataSize = fMin(newCap, fMax(1, oldSize));
 
@@ -341,6 +534,12 @@ void FValueArray::_reallocate(size_type newChannelCapacity,
 		default:
 			F_ASSERT(false);
 		}
+
+		// set after copying, if the allocation throws,
+		// the array keeps its data and capacity
+		m_channelCapacity = newChannelCapacity;
+		m_dimensionCapacity = newDimensionCapacity;
+		_updateRefCount();
 	}
 
 	m_channelCount = fMin(m_channelCapacity, m_channelCount);
@@ -358,6 +557,7 @@ void FValueArray::_resize(size_type newChannelCount)
 	F_ASSERT(newChannelCount > m_channelCount);
 	F_ASSERT(!m_isReference);
 	F_ASSERT(m_isArray);
+	detach();
 
 	size_type oldSize = fMax(1, size());
 	size_type newSize = newChannelCount * dimensionCount();
@@ -387,26 +587,49 @@ void FValueArray::_resize(size_type newChannelCount)
 
 void FValueArray::_delete()
 {
+	if (m_pMapping)
+	{
+		// referenced file data is unmapped with the last reference
+		m_pMapping->release();
+		m_pMapping = NULL;
+	}
+
+	if (m_pRefCount)
+	{
+		// shared data is deleted with the last reference
+		bool isReferenced = m_pRefCount->deref();
+		if (isReferenced) {
+			m_pRefCount = NULL;
+			return;
+		}
+
+		delete m_pRefCount;
+		m_pRefCount = NULL;
+	}
+
 	if (!m_isReference)
 	{
 		if (m_isArray)
 		{
+			FAllocator* pA = m_pAllocator;
+			size_type cap = capacity();
+
 			switch(m_type)
 			{
 			case FValueType::Invalid: break;
-			case FValueType::Float:	  delete[] static_cast<float*    >(m_raw.ptr); break;
-			case FValueType::Double:  delete[] static_cast<double*   >(m_raw.ptr); break;
-			case FValueType::Bool:    delete[] static_cast<bool*     >(m_raw.ptr); break;
-			case FValueType::Int8:    delete[] static_cast<qint8*   >(m_raw.ptr); break;
-			case FValueType::UInt8:   delete[] static_cast<quint8*  >(m_raw.ptr); break;
-			case FValueType::Int16:   delete[] static_cast<int16_t*  >(m_raw.ptr); break;
-			case FValueType::UInt16:  delete[] static_cast<uint16_t* >(m_raw.ptr); break;
-			case FValueType::Int32:   delete[] static_cast<qint32*  >(m_raw.ptr); break;
-			case FValueType::UInt32:  delete[] static_cast<quint32* >(m_raw.ptr); break;
-			case FValueType::Int64:   delete[] static_cast<qint64*  >(m_raw.ptr); break;
-			case FValueType::UInt64:  delete[] static_cast<quint64* >(m_raw.ptr); break;
-			case FValueType::String:  delete[] static_cast<QString*  >(m_raw.ptr); break;
-			case FValueType::Object:  delete[] static_cast<FObject** >(m_raw.ptr); break;
+			case FValueType::Float:   _fDeleteArray(pA, static_cast<float*    >(m_raw.ptr), cap); break;
+			case FValueType::Double:  _fDeleteArray(pA, static_cast<double*   >(m_raw.ptr), cap); break;
+			case FValueType::Bool:    _fDeleteArray(pA, static_cast<bool*     >(m_raw.ptr), cap); break;
+			case FValueType::Int8:    _fDeleteArray(pA, static_cast<qint8*    >(m_raw.ptr), cap); break;
+			case FValueType::UInt8:   _fDeleteArray(pA, static_cast<quint8*   >(m_raw.ptr), cap); break;
+			case FValueType::Int16:   _fDeleteArray(pA, static_cast<int16_t*  >(m_raw.ptr), cap); break;
+			case FValueType::UInt16:  _fDeleteArray(pA, static_cast<uint16_t* >(m_raw.ptr), cap); break;
+			case FValueType::Int32:   _fDeleteArray(pA, static_cast<qint32*   >(m_raw.ptr), cap); break;
+			case FValueType::UInt32:  _fDeleteArray(pA, static_cast<quint32*  >(m_raw.ptr), cap); break;
+			case FValueType::Int64:   _fDeleteArray(pA, static_cast<qint64*   >(m_raw.ptr), cap); break;
+			case FValueType::UInt64:  _fDeleteArray(pA, static_cast<quint64*  >(m_raw.ptr), cap); break;
+			case FValueType::String:  _fDeleteArray(pA, static_cast<QString*  >(m_raw.ptr), cap); break;
+			case FValueType::Object:  _fDeleteArray(pA, static_cast<FObject** >(m_raw.ptr), cap); break;
 			default: F_ASSERT(false); break;
 			}
 		}
@@ -453,7 +676,8 @@ void FValueArray::_convert(
 	size_type destinationChannelStride,
 	size_type sourceDimensionStart,
 	size_type destinationDimensionStart,
-	size_type dimensionCount)
+	size_type dimensionCount,
+	Conversion conversion)
 {
 	F_ASSERT(pSource);
 
@@ -474,6 +698,35 @@ void FValueArray::_convert(
 	size_type dstOffset = destinationChannelStart * pDestination->m_dimensionCount + destinationDimensionStart;
 	size_type dstStride = destinationChannelStride * pDestination->m_dimensionCount;
 
+	if (type().isNumber() && pSource->type().isNumber())
+	{
+		const FSimdKernels& kernels = FSimdKernels::current();
+		FSimdKernels::ConvertMode mode = (FSimdKernels::ConvertMode)conversion;
+
+		// detach first, the source may be the destination itself
+		char* pDst = pDestination->rawPtr();
+		const char* pSrc = pSource->rawPtr();
+		size_t srcBytes = pSource->type().byteCount();
+		size_t dstBytes = pDestination->type().byteCount();
+
+		// consecutive channels without wrap-around are converted in one go
+		if (srcStride == dimensionCount && dstStride == dimensionCount
+				&& srcOffset + channelCount * dimensionCount <= srcSize
+				&& dstOffset + channelCount * dimensionCount <= dstSize) {
+			kernels.convert(pSrc + srcOffset * srcBytes, pSource->m_type,
+				pDst + dstOffset * dstBytes, pDestination->m_type,
+				size_t(channelCount) * dimensionCount, mode);
+			return;
+		}
+
+		for (size_type c = 0; c < channelCount; ++c) {
+			kernels.convert(pSrc + ((srcOffset + c * srcStride) % srcSize) * srcBytes,
+				pSource->m_type, pDst + ((dstOffset + c * dstStride) % dstSize) * dstBytes,
+				pDestination->m_type, dimensionCount, mode);
+		}
+		return;
+	}
+
 	switch (pDestination->m_type)
 	{
 		_F_VA_CONVERT_TO(Float,   float);
@@ -13,6 +13,7 @@
 #include "FlowCore/Library.h"
 #include "FlowCore/ValueType.h"
 #include "FlowCore/AutoConvert.h"
+#include "FlowCore/ArrayViewT.h"
 
 #include "FlowCore/Vector2T.h"
 #include "FlowCore/Vector3T.h"
@@ -20,27 +21,64 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QAtomicInt>
 
 class FObject;
 class FArchive;
+class FAllocator;
+class FFileMapping;
 
 // -----------------------------------------------------------------------------
 //  Class FValueArray
 // -----------------------------------------------------------------------------
 
+/// Array of values of one type, organized in channels and dimensions.
+///
+/// By default, copies of a value array duplicate the data. In shared mode
+/// (see setShared()), copies reference the same data and only the first
+/// write access through one of the copies duplicates it (copy-on-write).
+/// Note that the non-const data accessors count as write access.
+///
+/// Arrays of numbers and object pointers are allocated through an FAllocator,
+/// by default the global pool, and are aligned to FAllocator::Alignment
+/// bytes. Single values are stored in place and are not aligned.
+///
+/// Arrays in reference mode point to external data without owning it.
+/// Reference arrays obtained from FMappedFile keep the file mapping alive.
 class FLOWCORE_EXPORT FValueArray
 {
+	friend class FMappedFile;
+
 	//  Public types -------------------------------------------------
   
 public:
 	typedef qint32 size_type;
 
+	/// Conversion rules for numeric values in convertFrom().
+	enum Conversion
+	{
+		/// Values are converted like a C cast, integers wrap around.
+		Cast = 0,
+		/// Integer targets are clamped to their range, NaN becomes zero.
+		Saturate,
+		/// Integers map to [0, 1] (unsigned) or [-1, 1] (signed) floating
+		/// point values and vice versa; between integers as Saturate.
+		Normalize,
+		/// UInt16 values are IEEE half precision floating point numbers
+		/// when converted from or to other types.
+		Half
+	};
+
 	//  Constructors and destructor ----------------------------------
 
 	/// Default Constructor.
 	FValueArray();
 	/// Copy constructor.
 	FValueArray(const FValueArray& other);
+#ifdef Q_COMPILER_RVALUE_REFS
+	/// Move constructor. Takes over the data of other, which is left empty.
+	FValueArray(FValueArray&& other) Q_DECL_NOEXCEPT;
+#endif
 	/// Creates a value array with the given type and storage space.
 	FValueArray(FValueType type, size_type channels, size_type dimensions);
 
@@ -66,6 +104,16 @@ public:
 		return *this;
 	}
 
+#ifdef Q_COMPILER_RVALUE_REFS
+	/// Move assignment operator.
+	FValueArray& operator=(FValueArray&& other) Q_DECL_NOEXCEPT {
+		if (this == &other) return *this;
+
+		_delete(); _move(&other);
+		return *this;
+	}
+#endif
+
 	//  Data access --------------------------------------------------
 
 	/// Returns a const pointer to the first data element.
@@ -138,6 +186,48 @@ public:
 	template <typename T>
 	FVector4T<T>& asVector4(size_t channel, size_t dimension = 0);
 
+	/// Returns a const view on the elements at the given dimension of all
+	/// channels. Types must match. The view is invalidated when the array
+	/// is reallocated or detached.
+	template <typename T>
+	FArrayViewT<const T> view(size_type dimension = 0) const;
+
+	/// Returns a view on the elements at the given dimension of all
+	/// channels. Types must match. Counts as write access, i.e. shared
+	/// data is detached before the view is created.
+	template <typename T>
+	FArrayViewT<T> view(size_type dimension = 0);
+
+	/// Returns a const view on the 2-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<const FVector2T<T> > vector2View(size_type dimension = 0) const;
+
+	/// Returns a view on the 2-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<FVector2T<T> > vector2View(size_type dimension = 0);
+
+	/// Returns a const view on the 3-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<const FVector3T<T> > vector3View(size_type dimension = 0) const;
+
+	/// Returns a view on the 3-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<FVector3T<T> > vector3View(size_type dimension = 0);
+
+	/// Returns a const view on the 4-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<const FVector4T<T> > vector4View(size_type dimension = 0) const;
+
+	/// Returns a view on the 4-vectors starting at the given dimension
+	/// of all channels. Types must match, no type conversion provided.
+	template <typename T>
+	FArrayViewT<FVector4T<T> > vector4View(size_type dimension = 0);
+
 	/// Returns the first data element, converted to the given type.
 	template <typename T>
 	T to() const;
@@ -191,16 +281,20 @@ public:
 
 	/// Copy/convert the data from the given source.
 	/// Dimensions must agree and the types must be compatible.
-	void convertFrom(const FValueArray& source);
+	/// Numeric values are converted according to the given rules,
+	/// contiguous ranges use the vectorized kernels in FSimdKernels.
+	void convertFrom(const FValueArray& source, Conversion conversion = Cast);
 
 	/// Copy/convert one dimension on all channels from the given source.
 	void convertFrom(const FValueArray& source,
-		size_type sourceDimensionIndex, size_type destinationDimensionIndex);
+		size_type sourceDimensionIndex, size_type destinationDimensionIndex,
+		Conversion conversion = Cast);
 
 	/// Copy/convert one dimension on one channel from the given source.
 	void convertFrom(const FValueArray& source,
 		size_type sourceChannelIndex, size_type destinationChannelIndex,
-		size_type sourceDimensionIndex, size_type destinationDimensionIndex);
+		size_type sourceDimensionIndex, size_type destinationDimensionIndex,
+		Conversion conversion = Cast);
 
 	/// Copy/convert from the given source with maximum flexibility.
 	void convertFrom(
@@ -212,7 +306,8 @@ public:
 		size_type destinationChannelStride,
 		size_type sourceDimensionStart,
 		size_type destinationDimensionStart,
-		size_type dimensionCount);
+		size_type dimensionCount,
+		Conversion conversion = Cast);
 
 	/// Resizes the data to the given number of dimensions. Data is not preserved!
 	void setDimensionCount(size_type dimensionCount);
@@ -224,6 +319,24 @@ public:
 	/// Allocates space for the given number of channels.
 	void setChannelCapacity(size_type channelCapacity, bool preserveData = false);
 
+	/// Enables or disables shared mode. In shared mode, copies of the array
+	/// share the data until it is modified. The mode is passed on to copies
+	/// and reset by allocate() and clear().
+	void setShared(bool shared);
+	/// Makes sure the data is not shared with other arrays, e.g. before
+	/// handing the raw data to another thread for writing.
+	void detach();
+
+	/// Sets the allocator for the data of this array. Existing data is moved
+	/// to memory from the new allocator. Passing NULL selects the default
+	/// allocator. The allocator is kept if the array is cleared or
+	/// reallocated, and if another array is assigned to it. Copy constructed
+	/// arrays use the default allocator. Copies of arrays in shared mode
+	/// share the data and therefore the allocator of the source. Throws
+	/// std::bad_alloc if the new allocator is out of memory, the array then
+	/// keeps its data and allocator.
+	void setAllocator(FAllocator* pAllocator);
+
 	/// Sets the changed flag on the data.
 	void setChanged(quint32 state = 1) { m_hasChanged = state; }
 	/// Clears the changed flag on the data.
@@ -273,6 +386,15 @@ public:
 	/// Returns true if the changed flag is set.
 	bool hasChanged() const { return m_hasChanged; }
 
+	/// Returns true if the array is in shared mode.
+	bool isShared() const { return m_isShared; }
+	/// Returns true if the data is not shared with other arrays.
+	bool isDetached() const { return !m_pRefCount || m_pRefCount->load() == 1; }
+
+	/// Returns the allocator used for the data of this array, or NULL if
+	/// no data has been allocated yet.
+	FAllocator* allocator() const { return m_pAllocator; }
+
 #ifdef FLOW_DEBUG
 	/// Returns information about the internal state.
 	QString dump() const;
@@ -282,6 +404,9 @@ public:
 
 private:
 	void _copy(const FValueArray* pSource);
+	void _move(FValueArray* pSource);
+	void _detach();
+	void _updateRefCount();
 	void _convert(
 		const FValueArray* pSource,
 		size_type sourceChannelStart,
@@ -291,7 +416,8 @@ private:
 		size_type destinationChannelStride,
 		size_type sourceDimensionStart,
 		size_type destinationDimensionStart,
-		size_type dimensionCount);
+		size_type dimensionCount,
+		Conversion conversion);
 
 	void _initialize(FValueType type, size_type channels,
 		size_type dimensions, bool isReference);
@@ -320,31 +446,50 @@ private:
 
 	FValueType m_type;
 
+	/// Reference counter of the data in shared mode, NULL otherwise.
+	QAtomicInt* m_pRefCount;
+	/// Allocator for array data, resolved to the default on first allocation.
+	FAllocator* m_pAllocator;
+	/// File mapping holding the referenced data, see FMappedFile.
+	FFileMapping* m_pMapping;
+
 	quint8   m_isArray			:  1;
 	quint8   m_isReference		:  1;
 	quint8   m_hasChanged      :  1;
+	quint8   m_isShared        :  1;
 };
 
 // Constructors ----------------------------------------------------------------
 
 inline FValueArray::FValueArray()
+	: m_pAllocator(NULL), m_pMapping(NULL)
 {
 	_initialize(FValueType::Invalid, 0, 0, false);
 }
 
 inline FValueArray::FValueArray(const FValueArray& other)
+	: m_pAllocator(NULL), m_pMapping(NULL)
 {
 	_copy(&other);
 }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+inline FValueArray::FValueArray(FValueArray&& other) Q_DECL_NOEXCEPT
+{
+	_move(&other);
+}
+#endif
+
 inline FValueArray::FValueArray(
 	FValueType type, size_type channels, size_type dimensions)
+	: m_pAllocator(NULL), m_pMapping(NULL)
 {
 	_initialize(type, channels, dimensions, false);
 }
 
 template <typename T>
 inline FValueArray::FValueArray(const T& val)
+	: m_pAllocator(NULL), m_pMapping(NULL)
 {
 	_initialize(FValueType::fromType<T>(), 1, 1, false);
 	set<T>(val);
@@ -353,6 +498,7 @@ inline FValueArray::FValueArray(const T& val)
 template <typename T>
 FValueArray::FValueArray(T* pVal, size_type channels,
 	size_type dimensions, bool reference /* = false */)
+	: m_pAllocator(NULL), m_pMapping(NULL)
 {
 	F_ASSERT(channels * dimensions > 0);
 	_initialize(FValueType::fromType<T>(), channels, dimensions, reference);
@@ -463,6 +609,70 @@ FVector4T<T>& FValueArray::asVector4(size_t channel, size_t dimension)
 	return *((FVector4T<T>*)(_ptr<T>() + _index(channel, dimension)));
 }
 
+template <typename T>
+FArrayViewT<const T> FValueArray::view(size_type dimension) const
+{
+	F_ASSERT(dimension < m_dimensionCount);
+	return FArrayViewT<const T>(_ptr<T>() + dimension,
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<T> FValueArray::view(size_type dimension)
+{
+	F_ASSERT(dimension < m_dimensionCount);
+	return FArrayViewT<T>(_ptr<T>() + dimension,
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<const FVector2T<T> > FValueArray::vector2View(size_type dimension) const
+{
+	F_ASSERT(dimension + 2 <= m_dimensionCount);
+	return FArrayViewT<const FVector2T<T> >((const FVector2T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<FVector2T<T> > FValueArray::vector2View(size_type dimension)
+{
+	F_ASSERT(dimension + 2 <= m_dimensionCount);
+	return FArrayViewT<FVector2T<T> >((FVector2T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<const FVector3T<T> > FValueArray::vector3View(size_type dimension) const
+{
+	F_ASSERT(dimension + 3 <= m_dimensionCount);
+	return FArrayViewT<const FVector3T<T> >((const FVector3T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<FVector3T<T> > FValueArray::vector3View(size_type dimension)
+{
+	F_ASSERT(dimension + 3 <= m_dimensionCount);
+	return FArrayViewT<FVector3T<T> >((FVector3T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<const FVector4T<T> > FValueArray::vector4View(size_type dimension) const
+{
+	F_ASSERT(dimension + 4 <= m_dimensionCount);
+	return FArrayViewT<const FVector4T<T> >((const FVector4T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
+template <typename T>
+FArrayViewT<FVector4T<T> > FValueArray::vector4View(size_type dimension)
+{
+	F_ASSERT(dimension + 4 <= m_dimensionCount);
+	return FArrayViewT<FVector4T<T> >((FVector4T<T>*)(_ptr<T>() + dimension),
+		m_channelCount, m_dimensionCount * sizeof(T));
+}
+
 template <typename T>
 T FValueArray::to() const
 {
@@ -608,6 +818,7 @@ inline bool FValueArray::is() const
 
 inline char* FValueArray::rawPtr()
 {
+	detach();
 	return m_isArray ? (char*)m_raw.ptr : (char*)(&m_raw.ptr);
 }
 
@@ -653,18 +864,26 @@ inline void FValueArray::clear()
 	_initialize(FValueType::Invalid, 0, 0, false);
 }
 
-inline void FValueArray::convertFrom(const FValueArray& source)
+inline void FValueArray::detach()
+{
+	if (m_pRefCount && m_pRefCount->load() > 1)
+		_detach();
+}
+
+inline void FValueArray::convertFrom(
+	const FValueArray& source, Conversion conversion /* = Cast */)
 {
-	_convert(&source, 0, 0, channelCount(), 1, 1, 0, 0, dimensionCount());
+	_convert(&source, 0, 0, channelCount(), 1, 1, 0, 0, dimensionCount(), conversion);
 }
 
 inline void FValueArray::convertFrom(
 	const FValueArray& source,
 	size_type sourceDimensionIndex,
-	size_type destinationDimensionIndex)
+	size_type destinationDimensionIndex,
+	Conversion conversion /* = Cast */)
 {
 	_convert(&source, 0, 0, channelCount(), 1, 1,
-		sourceDimensionIndex, destinationDimensionIndex, 1);
+		sourceDimensionIndex, destinationDimensionIndex, 1, conversion);
 }
 
 inline void FValueArray::convertFrom(
@@ -672,10 +891,11 @@ inline void FValueArray::convertFrom(
 	size_type sourceChannelIndex,
 	size_type destinationChannelIndex,
 	size_type sourceDimensionIndex,
-	size_type destinationDimensionIndex)
+	size_type destinationDimensionIndex,
+	Conversion conversion /* = Cast */)
 {
 	_convert(&source, sourceChannelIndex, destinationChannelIndex, 1,
-		1, 1, sourceDimensionIndex, destinationDimensionIndex, 1);
+		1, 1, sourceDimensionIndex, destinationDimensionIndex, 1, conversion);
 }
 
 inline void FValueArray::convertFrom(
@@ -687,12 +907,14 @@ inline void FValueArray::convertFrom(
 	size_type destinationChannelStride,
 	size_type sourceDimensionStart,
 	size_type destinationDimensionStart,
-	size_type dimensionCount)
+	size_type dimensionCount,
+	Conversion conversion /* = Cast */)
 {
 	_convert(&source,
 		sourceChannelStart, destinationChannelStart, channelCount,
 		sourceChannelStride, destinationChannelStride,
-		sourceDimensionStart, destinationDimensionStart, dimensionCount);
+		sourceDimensionStart, destinationDimensionStart, dimensionCount,
+		conversion);
 }
 
 // Public queries --------------------------------------------------------------
@@ -723,6 +945,7 @@ template <typename T>
 inline T* FValueArray::_ptr()
 {
 	F_ASSERT(is<T>());
+	detach();
 	return m_isArray ? (T*)m_raw.ptr : (T*)(&m_raw.ptr);
 }
 
@@ -737,6 +960,7 @@ template <>
 inline QString* FValueArray::_ptr()
 {
 	F_ASSERT(is<QString>());
+	detach();
 	return (QString*)m_raw.ptr;
 }
 
@@ -10,6 +10,7 @@
 #include "FlowGraphics/Geometry.h"
 
 #include "FlowCore/Archive.h"
+#include "FlowCore/SimdKernels.h"
 #include "FlowCore/MemoryTracer.h"
 
 // -----------------------------------------------------------------------------
@@ -147,6 +148,8 @@ QByteArray FGeometry::interleavedVertexData() const
 	buffer.resize(vertexCount * bytesPerVertex);
 	char* pDstData = buffer.data();
 
+	FSimdKernels::InterleaveFunc interleave = FSimdKernels::current().interleave;
+
 	size_t attribCount = m_pImpl->vertexData.size();
 	for (size_t i = 0; i < attribCount; ++i) {
 		const FVertexAttribute& attrib = layout.attributeAt(i);
@@ -155,11 +158,8 @@ QByteArray FGeometry::interleavedVertexData() const
 		size_t attribOffset = attrib.byteOffset();
 		const char* pSrcData = va.rawPtr();
 
-		for (size_t j = 0; j < vertexCount; ++j) {
-			const char* pSrcAttrib = pSrcData + j * attribBytes;
-			char* pDstAttrib = pDstData + j * bytesPerVertex + attribOffset;
-			memcpy(pDstAttrib, pSrcAttrib, attribBytes);
-		}
+		interleave(pDstData + attribOffset, bytesPerVertex,
+			pSrcData, attribBytes, vertexCount);
 	}
 
 	return buffer;
@@ -93,11 +93,39 @@ public:
 	template<typename T>
 	const FVector4T<T>& getVector4(const FVertexAttribute& attrib, size_t vertexIndex) const;
 
+	/// Returns a view on the values of the given attribute of all vertices.
+	/// Obtain the view once before processing the vertices, it is
+	/// invalidated when the vertices are reallocated or resized.
+	/// valueView() requires an attribute with a single component,
+	/// vector2View() to vector4View() require 2 to 4 components.
+	template<typename T>
+	FArrayViewT<T> valueView(const FVertexAttribute& attrib);
+	template<typename T>
+	FArrayViewT<const T> valueView(const FVertexAttribute& attrib) const;
+	template<typename T>
+	FArrayViewT<FVector2T<T> > vector2View(const FVertexAttribute& attrib);
+	template<typename T>
+	FArrayViewT<const FVector2T<T> > vector2View(const FVertexAttribute& attrib) const;
+	template<typename T>
+	FArrayViewT<FVector3T<T> > vector3View(const FVertexAttribute& attrib);
+	template<typename T>
+	FArrayViewT<const FVector3T<T> > vector3View(const FVertexAttribute& attrib) const;
+	template<typename T>
+	FArrayViewT<FVector4T<T> > vector4View(const FVertexAttribute& attrib);
+	template<typename T>
+	FArrayViewT<const FVector4T<T> > vector4View(const FVertexAttribute& attrib) const;
+
 	template<typename T>
 	void setIndex(size_t index, const T& vertexIndex);
 	template<typename T>
 	const T& getIndex(size_t index) const;
 
+	/// Returns a view on the index data.
+	template<typename T>
+	FArrayViewT<T> indexView();
+	template<typename T>
+	FArrayViewT<const T> indexView() const;
+
 	//  Public queries -----------------------------------------------
 
 	/// Returns true if this geometry object contains no data.
@@ -224,6 +252,66 @@ inline const FVector4T<T>& FGeometry::getVector4(const FVertexAttribute& attrib,
 	return va.asVector4<T>(vertexIndex);
 }
 
+template<typename T>
+inline FArrayViewT<T> FGeometry::valueView(const FVertexAttribute& attrib)
+{
+	F_ASSERT(attrib.size() == 1);
+	return m_pImpl->vertexData[attrib.index()].view<T>();
+}
+
+template<typename T>
+inline FArrayViewT<const T> FGeometry::valueView(const FVertexAttribute& attrib) const
+{
+	const FValueArray& va = m_pImpl->vertexData[attrib.index()];
+	F_ASSERT(attrib.size() == 1);
+	return va.view<T>();
+}
+
+template<typename T>
+inline FArrayViewT<FVector2T<T> > FGeometry::vector2View(const FVertexAttribute& attrib)
+{
+	F_ASSERT(attrib.size() == 2);
+	return m_pImpl->vertexData[attrib.index()].vector2View<T>();
+}
+
+template<typename T>
+inline FArrayViewT<const FVector2T<T> > FGeometry::vector2View(const FVertexAttribute& attrib) const
+{
+	const FValueArray& va = m_pImpl->vertexData[attrib.index()];
+	F_ASSERT(attrib.size() == 2);
+	return va.vector2View<T>();
+}
+
+template<typename T>
+inline FArrayViewT<FVector3T<T> > FGeometry::vector3View(const FVertexAttribute& attrib)
+{
+	F_ASSERT(attrib.size() == 3);
+	return m_pImpl->vertexData[attrib.index()].vector3View<T>();
+}
+
+template<typename T>
+inline FArrayViewT<const FVector3T<T> > FGeometry::vector3View(const FVertexAttribute& attrib) const
+{
+	const FValueArray& va = m_pImpl->vertexData[attrib.index()];
+	F_ASSERT(attrib.size() == 3);
+	return va.vector3View<T>();
+}
+
+template<typename T>
+inline FArrayViewT<FVector4T<T> > FGeometry::vector4View(const FVertexAttribute& attrib)
+{
+	F_ASSERT(attrib.size() == 4);
+	return m_pImpl->vertexData[attrib.index()].vector4View<T>();
+}
+
+template<typename T>
+inline FArrayViewT<const FVector4T<T> > FGeometry::vector4View(const FVertexAttribute& attrib) const
+{
+	const FValueArray& va = m_pImpl->vertexData[attrib.index()];
+	F_ASSERT(attrib.size() == 4);
+	return va.vector4View<T>();
+}
+
 template <typename T>
 inline void FGeometry::setIndex(size_t index, const T& vertexIndex)
 {
@@ -235,6 +323,19 @@ inline const T& FGeometry::getIndex(size_t index) const
 {
 	return m_pImpl->indexData.as<T>(index);
 }
+
+template <typename T>
+inline FArrayViewT<T> FGeometry::indexView()
+{
+	return m_pImpl->indexData.view<T>();
+}
+
+template <typename T>
+inline FArrayViewT<const T> FGeometry::indexView() const
+{
+	const FValueArray& va = m_pImpl->indexData;
+	return va.view<T>();
+}
 	
 // -----------------------------------------------------------------------------
 
@@ -10,9 +10,14 @@
 #include "FlowCoreTest/ArchiveTest.h"
 
 #include "FlowCore/Archive.h"
+#include "FlowCore/CompressedDevice.h"
+#include "FlowCore/IndexedArchive.h"
 #include "FlowCore/MemoryTracer.h"
 
 #include <QFile>
+#include <QBuffer>
+#include <QtEndian>
+#include <vector>
 
 // -----------------------------------------------------------------------------
 //  Class FMySerializableObject
@@ -184,4 +189,365 @@ void FArchiveTest::test2()
 
 }
 
+void FArchiveTest::testBuffered()
+{
+	FMySerializableObject* pTest1 = new FMySerializableObject(1);
+	FMySerializableObject* pTest2 = new FMySerializableObject(1);
+	pTest1->m_pTestObject1 = pTest2;
+	pTest2->m_pTestObject1 = pTest1;
+
+	const double values[] = { 1.0, -2.5, 3.25, 1e100 };
+
+	QByteArray buffer;
+	FArchive outArchive(&buffer, FArchive::Write);
+	outArchive << pTest1;
+	outArchive << "class name";
+	outArchive.writeBlock(values, 4, sizeof(double));
+	outArchive << quint32(42);
+
+	// buffered archive reading from a byte array
+	FArchive arrayArchive(buffer);
+	F_CHECK(arrayArchive.isBuffered());
+
+	FMySerializableObject* pTest3 = NULL;
+	arrayArchive >> pTest3;
+	compareObjects(pTest1, pTest3);
+	compareObjects(pTest1->m_pTestObject1, pTest3->m_pTestObject1);
+	F_COMPARE(pTest3->m_pTestObject1->m_pTestObject1, pTest3);
+	F_SAFE_DELETE(pTest3->m_pTestObject1);
+	F_SAFE_DELETE(pTest3);
+
+	// buffered archive reading from memory, e.g. a mapped file
+	FArchive inArchive(buffer.constData(), buffer.size());
+	F_CHECK(inArchive.isBuffered());
+
+	inArchive >> pTest3;
+	compareObjects(pTest1, pTest3);
+	compareObjects(pTest1->m_pTestObject1, pTest3->m_pTestObject1);
+
+	// string view points into the buffer
+	size_t length;
+	const char* pName = inArchive.readStringView(&length);
+	F_CHECK(pName >= buffer.constData() && pName < buffer.constData() + buffer.size());
+	F_COMPARE(length, size_t(10));
+	F_CHECK(strcmp(pName, "class name") == 0);
+
+	double fallback[4];
+	const double* pValues = (const double*)inArchive.readBlockView(4, sizeof(double), fallback);
+	F_CHECK(pValues != NULL);
+	F_CHECK(memcmp(pValues, values, sizeof(values)) == 0);
+
+	quint32 last;
+	inArchive >> last;
+	F_COMPARE(last, quint32(42));
+	F_CHECK(inArchive.atEnd());
+	F_CHECK(inArchive.status() == QDataStream::Ok);
+
+	// reading past the end of the data fails
+	FArchive truncArchive(buffer.constData(), 2);
+	quint32 tag;
+	truncArchive >> tag;
+	F_COMPARE(tag, quint32(0));
+	F_CHECK(truncArchive.status() == QDataStream::ReadPastEnd);
+
+	// cleanup
+	F_SAFE_DELETE(pTest1->m_pTestObject1);
+	F_SAFE_DELETE(pTest1);
+	F_SAFE_DELETE(pTest3->m_pTestObject1);
+	F_SAFE_DELETE(pTest3);
+}
+
+void FArchiveTest::testCompressed()
+{
+	FMySerializableObject* pTest1 = new FMySerializableObject(1);
+
+	std::vector<float> values(100000);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = float(i % 1000) * 0.25f;
+
+	FCompressedDevice::Compression methods[] = {
+		FCompressedDevice::NoCompression,
+		FCompressedDevice::FastCompression,
+		FCompressedDevice::HighCompression
+	};
+
+	for (size_t m = 0; m < 3; ++m)
+	{
+		QByteArray data;
+		QBuffer outBuffer(&data);
+		outBuffer.open(QIODevice::WriteOnly);
+
+		FCompressedDevice outDevice(&outBuffer);
+		outDevice.setCompression(methods[m]);
+		outDevice.setBlockSize(64 * 1024);
+		outDevice.open(QIODevice::WriteOnly);
+
+		FArchive outArchive(&outDevice, false);
+		outArchive << pTest1;
+		outArchive.writeBlock(&values[0], values.size(), sizeof(float));
+
+		size_t rawSize = size_t(outDevice.size());
+		outDevice.close();
+		if (methods[m] != FCompressedDevice::NoCompression)
+			F_CHECK(size_t(data.size()) < rawSize / 2);
+
+		QBuffer inBuffer(&data);
+		inBuffer.open(QIODevice::ReadOnly);
+
+		FCompressedDevice inDevice(&inBuffer);
+		inDevice.open(QIODevice::ReadOnly);
+		F_CHECK(!inDevice.isPassThrough());
+		F_CHECK(!inDevice.isSequential());
+		F_COMPARE(inDevice.size(), qint64(rawSize));
+
+		FArchive inArchive(&inDevice, false);
+		FMySerializableObject* pTest2 = NULL;
+		inArchive >> pTest2;
+		compareObjects(pTest1, pTest2);
+		F_SAFE_DELETE(pTest2);
+
+		std::vector<float> result(values.size());
+		F_CHECK(inArchive.readBlock(&result[0], result.size(), sizeof(float)));
+		F_CHECK(result == values);
+		F_CHECK(inDevice.atEnd());
+
+		// random access to the last value
+		F_CHECK(inDevice.seek(rawSize - sizeof(float)));
+		float last = 0.0f;
+		F_COMPARE(inDevice.read((char*)&last, sizeof(float)), qint64(sizeof(float)));
+		F_COMPARE(last, values.back());
+
+		// seek to the end and back into the last block
+		F_CHECK(inDevice.seek(rawSize));
+		F_CHECK(inDevice.atEnd());
+		F_CHECK(inDevice.seek(rawSize - sizeof(float)));
+		last = 0.0f;
+		F_COMPARE(inDevice.read((char*)&last, sizeof(float)), qint64(sizeof(float)));
+		F_COMPARE(last, values.back());
+
+		// blocks larger than the block size are rejected before allocation,
+		// the index is cut off so the block header is read sequentially
+		QByteArray corrupt = data;
+		corrupt.resize(corrupt.size() - 1);
+		qToBigEndian(quint32(0x7fffffff), reinterpret_cast<uchar*>(corrupt.data() + 11));
+		QBuffer corruptBuffer(&corrupt);
+		corruptBuffer.open(QIODevice::ReadOnly);
+		FCompressedDevice corruptDevice(&corruptBuffer);
+		corruptDevice.open(QIODevice::ReadOnly);
+		F_COMPARE(corruptDevice.read(16).size(), 0);
+	}
+
+	// uncompressed data is passed through
+	QByteArray data;
+	FArchive outArchive(&data, FArchive::Write, false);
+	outArchive << pTest1;
+
+	QBuffer inBuffer(&data);
+	inBuffer.open(QIODevice::ReadOnly);
+	FCompressedDevice inDevice(&inBuffer);
+	inDevice.open(QIODevice::ReadOnly);
+	F_CHECK(inDevice.isPassThrough());
+
+	FArchive inArchive(&inDevice, false);
+	FMySerializableObject* pTest2 = NULL;
+	inArchive >> pTest2;
+	compareObjects(pTest1, pTest2);
+
+	// cleanup
+	F_SAFE_DELETE(pTest1);
+	F_SAFE_DELETE(pTest2);
+}
+
+void FArchiveTest::testIndexed()
+{
+	// a and b reference each other, c owns d
+	FMySerializableObject* pA = new FMySerializableObject(1);
+	FMySerializableObject* pB = new FMySerializableObject(1);
+	FMySerializableObject* pC = new FMySerializableObject(1);
+	FMySerializableObject* pD = new FMySerializableObject(1);
+	pA->m_pTestObject1 = pB;
+	pB->m_pTestObject1 = pA;
+	pB->m_pTestObject2 = pB;
+	pC->m_pTestObject1 = pD;
+
+	QByteArray data;
+	QBuffer outBuffer(&data);
+	outBuffer.open(QIODevice::WriteOnly);
+
+	FCompressedDevice outDevice(&outBuffer);
+	outDevice.setBlockSize(256);
+	outDevice.open(QIODevice::WriteOnly);
+
+	FIndexedArchive outArchive(&outDevice);
+	F_COMPARE(outArchive.addObject(pA), quint32(1));
+	F_COMPARE(outArchive.addObject(pB), quint32(2));
+	F_COMPARE(outArchive.addObject(pC), quint32(3));
+	F_COMPARE(outArchive.addObject(pA), quint32(1));
+	outArchive.write();
+	outDevice.close();
+
+	QBuffer inBuffer(&data);
+	inBuffer.open(QIODevice::ReadOnly);
+
+	FCompressedDevice inDevice(&inBuffer);
+	inDevice.open(QIODevice::ReadOnly);
+
+	FIndexedArchive inArchive(&inDevice);
+	F_CHECK(inArchive.isValid());
+	F_COMPARE(inArchive.objectCount(), size_t(3));
+	F_COMPARE(inArchive.objectClass(2), FMySerializableObject::staticType());
+	F_COMPARE(inArchive.findObjects(FObject::staticType()).size(), size_t(3));
+
+	// load c only
+	FMySerializableObject* pC2 = inArchive.loadObject<FMySerializableObject>(3);
+	F_CHECK(pC2 != NULL);
+	compareObjects(pC, pC2);
+	compareObjects(pD, pC2->m_pTestObject1);
+	F_CHECK(!inArchive.isLoaded(1));
+	F_CHECK(!inArchive.isLoaded(2));
+
+	// loading b loads a, references are resolved
+	FMySerializableObject* pB2 = inArchive.loadObject<FMySerializableObject>(2);
+	F_CHECK(inArchive.isLoaded(1));
+	FMySerializableObject* pA2 = inArchive.loadObject<FMySerializableObject>(1);
+	compareObjects(pA, pA2);
+	compareObjects(pB, pB2);
+	F_COMPARE(pA2->m_pTestObject1, pB2);
+	F_COMPARE(pB2->m_pTestObject1, pA2);
+	F_COMPARE(pB2->m_pTestObject2, pB2);
+	F_CHECK(inArchive.loadObject(4) == NULL);
+
+	// buffered archive, objects are loaded independently
+	QByteArray plainData;
+	QBuffer plainBuffer(&plainData);
+	plainBuffer.open(QIODevice::WriteOnly);
+	{
+		FIndexedArchive plainArchive(&plainBuffer);
+		plainArchive.addObject(pA);
+		plainArchive.addObject(pB);
+	}
+
+	FIndexedArchive bufferArchive(plainData);
+	F_CHECK(bufferArchive.isValid());
+	FMySerializableObject* pA3 = bufferArchive.loadObject<FMySerializableObject>(1);
+	FMySerializableObject* pB3 = bufferArchive.loadObject<FMySerializableObject>(2);
+	F_COMPARE(pA3->m_pTestObject1, pB3);
+	F_COMPARE(pB3->m_pTestObject1, pA3);
+
+	// an object which fails to load is discarded, the size of
+	// its section in the index is set to zero
+	QByteArray corruptData;
+	QBuffer corruptBuffer(&corruptData);
+	corruptBuffer.open(QIODevice::WriteOnly);
+	{
+		FIndexedArchive corruptArchive(&corruptBuffer);
+		corruptArchive.addObject(pD);
+	}
+
+	corruptData.replace(corruptData.size() - 32, 8, QByteArray(8, '\0'));
+	FIndexedArchive corruptArchive(corruptData);
+	F_CHECK(corruptArchive.isValid());
+	F_CHECK(corruptArchive.loadObject(1) == NULL);
+	F_CHECK(!corruptArchive.isLoaded(1));
+
+	// loadAll() discards it as well
+	FIndexedArchive corruptAll(corruptData);
+	F_CHECK(!corruptAll.loadAll());
+	F_CHECK(corruptAll.loadObject(1) == NULL);
+	F_CHECK(!corruptAll.isLoaded(1));
+
+	// not an indexed archive
+	FIndexedArchive invalidArchive(plainData.constData(), 10);
+	F_CHECK(!invalidArchive.isValid());
+	F_COMPARE(invalidArchive.objectCount(), size_t(0));
+
+	// cleanup
+	F_SAFE_DELETE(pA);
+	F_SAFE_DELETE(pB);
+	F_SAFE_DELETE(pC);
+	F_SAFE_DELETE(pD);
+	F_SAFE_DELETE(pA2);
+	F_SAFE_DELETE(pB2);
+	F_SAFE_DELETE(pC2->m_pTestObject1);
+	F_SAFE_DELETE(pC2);
+	F_SAFE_DELETE(pA3);
+	F_SAFE_DELETE(pB3);
+}
+
+void FArchiveTest::testIndexedParallel()
+{
+	// a ring of objects, each referencing its successor and owning a child
+	const size_t count = 500;
+	std::vector<FMySerializableObject*> objects(count);
+	for (size_t i = 0; i < count; ++i) {
+		objects[i] = new FMySerializableObject(1);
+		objects[i]->m_valUInt32 = quint32(i);
+		objects[i]->m_pTestObject2 = new FMySerializableObject(1);
+	}
+	for (size_t i = 0; i < count; ++i)
+		objects[i]->m_pTestObject1 = objects[(i + 1) % count];
+
+	QByteArray data;
+	QBuffer outBuffer(&data);
+	outBuffer.open(QIODevice::WriteOnly);
+	{
+		FIndexedArchive outArchive(&outBuffer);
+		for (size_t i = 0; i < count; ++i)
+			outArchive.addObject(objects[i]);
+	}
+
+	// from memory, and from a compressed device
+	QByteArray compressedData;
+	QBuffer compressedBuffer(&compressedData);
+	compressedBuffer.open(QIODevice::WriteOnly);
+	FCompressedDevice outDevice(&compressedBuffer);
+	outDevice.open(QIODevice::WriteOnly);
+	outDevice.write(data);
+	outDevice.close();
+
+	QBuffer inBuffer(&compressedData);
+	inBuffer.open(QIODevice::ReadOnly);
+	FCompressedDevice inDevice(&inBuffer);
+	inDevice.open(QIODevice::ReadOnly);
+
+	FIndexedArchive bufferArchive(data);
+	FIndexedArchive deviceArchive(&inDevice);
+	FIndexedArchive* archives[] = { &bufferArchive, &deviceArchive };
+
+	for (size_t a = 0; a < 2; ++a)
+	{
+		FIndexedArchive& inArchive = *archives[a];
+
+		// an object loaded before is kept
+		FObject* pFirst = inArchive.loadObject(1);
+		F_CHECK(inArchive.loadAll(a == 0 ? 4 : 0));
+		F_COMPARE(inArchive.loadObject(1), pFirst);
+
+		std::vector<FMySerializableObject*> loaded(count);
+		for (size_t i = 0; i < count; ++i) {
+			F_CHECK(inArchive.isLoaded(quint32(i + 1)));
+			loaded[i] = inArchive.loadObject<FMySerializableObject>(quint32(i + 1));
+		}
+
+		bool isIdentical = true;
+		for (size_t i = 0; i < count; ++i) {
+			isIdentical = isIdentical && loaded[i]->m_valUInt32 == quint32(i)
+				&& loaded[i]->m_pTestObject1 == loaded[(i + 1) % count]
+				&& loaded[i]->m_pTestObject2 && loaded[i]->m_pTestObject2 != loaded[i];
+		}
+		F_CHECK(isIdentical);
+		compareObjects(objects[7], loaded[7]);
+
+		for (size_t i = 0; i < count; ++i) {
+			F_SAFE_DELETE(loaded[i]->m_pTestObject2);
+			F_SAFE_DELETE(loaded[i]);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		F_SAFE_DELETE(objects[i]->m_pTestObject2);
+		F_SAFE_DELETE(objects[i]);
+	}
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
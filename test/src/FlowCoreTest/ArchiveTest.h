@@ -65,6 +65,10 @@ public:
 public slots:
 	void test1();
 	void test2();
+	void testBuffered();
+	void testCompressed();
+	void testIndexed();
+	void testIndexedParallel();
 
 private:
 	void compareObjects(FMySerializableObject* pObj1, FMySerializableObject* pObj2);
@@ -0,0 +1,591 @@
+// -----------------------------------------------------------------------------
+//  File        LogTest.cpp
+//  Project     FlowCoreTest
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCoreTest/LogTest.h"
+
+#include "FlowCore/MpscQueueT.h"
+#include "FlowCore/LogManager.h"
+#include "FlowCore/LogFile.h"
+#include "FlowCore/LogHistory.h"
+#include "FlowCore/LogFilter.h"
+#include "FlowCore/BinaryLog.h"
+#include "FlowCore/BinaryLogReader.h"
+#include "FlowCore/StopWatch.h"
+#include "FlowCore/Log.h"
+
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <vector>
+#include <cstdio>
+
+// Helpers ---------------------------------------------------------------------
+
+/// Adds values tagged with the producer index to a queue.
+class _FQueueTask : public QRunnable
+{
+public:
+	_FQueueTask(FMpscQueueT<int>* pQueue, int producer, int count)
+		: m_pQueue(pQueue), m_producer(producer), m_count(count) { }
+
+	virtual void run()
+	{
+		for (int i = 0; i < m_count; ++i) {
+			while (!m_pQueue->enqueue((m_producer << 20) | i))
+				QThread::yieldCurrentThread();
+		}
+	}
+
+private:
+	FMpscQueueT<int>* m_pQueue;
+	int m_producer;
+	int m_count;
+};
+
+/// Logs a number of messages.
+class _FLogTask : public QRunnable
+{
+public:
+	_FLogTask(int count) : m_count(count) { }
+
+	virtual void run()
+	{
+		for (int i = 0; i < m_count; ++i)
+			F_INFO("FLogTest") << "Message " << i;
+	}
+
+private:
+	int m_count;
+};
+
+/// Logs a number of binary messages.
+class _FBinaryLogTask : public QRunnable
+{
+public:
+	_FBinaryLogTask(int count) : m_count(count) { }
+
+	virtual void run()
+	{
+		for (int i = 0; i < m_count; ++i)
+			F_BINARY_LOG(FLogType::Debug, "FLogTest", "Task message %1") << i;
+	}
+
+private:
+	int m_count;
+};
+
+/// Counts the messages of the test module.
+class _FLogCounter : public FLogListener
+{
+public:
+	_FLogCounter() : m_count(0), m_fatalCount(0), m_pThread(NULL) { }
+
+	virtual void logMessage(const FLogMessage& message)
+	{
+		if (message.module() == "FLogTest") {
+			m_count.fetchAndAddRelaxed(1);
+			if (message.type() == FLogType::Fatal)
+				m_fatalCount.fetchAndAddRelaxed(1);
+			m_pThread = QThread::currentThread();
+		}
+	}
+
+	QAtomicInt m_count;
+	QAtomicInt m_fatalCount;
+	QThread* m_pThread;
+};
+
+/// Removes a listener from the log manager.
+class _FLogRemoveTask : public QRunnable
+{
+public:
+	_FLogRemoveTask(FLogListener* pListener) : m_pListener(pListener) { }
+
+	virtual void run()
+	{
+		FLogManager::instance()->removeListener(m_pListener);
+	}
+
+private:
+	FLogListener* m_pListener;
+};
+
+/// Logs a message when receiving the first message of the test module,
+/// and waits for another thread removing the listener.
+class _FLogRemover : public FLogListener
+{
+public:
+	_FLogRemover() : m_count(0) { }
+
+	virtual void logMessage(const FLogMessage& message)
+	{
+		if (message.module() == "FLogTest") {
+			m_count.fetchAndAddRelaxed(1);
+			F_INFO("FLogTestListener") << "Listener removed";
+
+			QThreadPool pool;
+			pool.start(new _FLogRemoveTask(this));
+			pool.waitForDone();
+		}
+	}
+
+	QAtomicInt m_count;
+};
+
+/// Counts visited messages and checks their sequence numbers ascend.
+struct _FLogVisitor
+{
+	_FLogVisitor() : count(0), lastSequence(0), isOrdered(true) { }
+
+	void operator()(quint64 sequence, const FLogMessage& message)
+	{
+		isOrdered = isOrdered && sequence > lastSequence;
+		lastSequence = sequence;
+		count++;
+	}
+
+	size_t count;
+	quint64 lastSequence;
+	bool isOrdered;
+};
+
+/// Counts how often a log message expression is evaluated.
+static int _countEvaluation(int* pCount)
+{
+	return ++(*pCount);
+}
+
+static const char* _countModule(int* pCount)
+{
+	++(*pCount);
+	return "FLogTestFilter";
+}
+
+// -----------------------------------------------------------------------------
+//  Class FLogTest
+// -----------------------------------------------------------------------------
+
+F_IMPLEMENT_TEST(FLogTest, "Class FLogManager and log queue");
+
+void FLogTest::setup()
+{
+}
+
+void FLogTest::shutdown()
+{
+}
+
+void FLogTest::testQueue()
+{
+	FMpscQueueT<int> queue(5);
+	F_COMPARE(queue.capacity(), size_t(8));
+	F_CHECK(queue.isEmpty());
+
+	for (int i = 0; i < 8; ++i)
+		F_CHECK(queue.enqueue(i));
+	F_CHECK(!queue.enqueue(8));
+
+	int value = -1;
+	bool isOrdered = true;
+	for (int i = 0; i < 8; ++i)
+		isOrdered = isOrdered && queue.dequeue(value) && value == i;
+	F_CHECK(isOrdered);
+	F_CHECK(!queue.dequeue(value));
+	F_CHECK(queue.isEmpty());
+
+	// several producers, values of each producer arrive in order
+	const int producerCount = 4;
+	const int count = 20000;
+	FMpscQueueT<int> sharedQueue(256);
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(producerCount);
+	for (int i = 0; i < producerCount; ++i)
+		pool.start(new _FQueueTask(&sharedQueue, i, count));
+
+	std::vector<int> next(producerCount, 0);
+	int received = 0;
+	isOrdered = true;
+	while (received < producerCount * count) {
+		if (sharedQueue.dequeue(value)) {
+			int producer = value >> 20;
+			isOrdered = isOrdered && (value & 0xfffff) == next[producer];
+			next[producer]++;
+			received++;
+		}
+	}
+
+	pool.waitForDone();
+	F_CHECK(isOrdered);
+	F_CHECK(sharedQueue.isEmpty());
+}
+
+void FLogTest::testAsynchronous()
+{
+	FLogManager* pManager = FLogManager::instance();
+	size_t droppedCount = pManager->droppedCount();
+
+	_FLogCounter counter;
+	pManager->addListener(&counter);
+
+	const int taskCount = 4;
+	const int count = 250;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(taskCount);
+	for (int i = 0; i < taskCount; ++i)
+		pool.start(new _FLogTask(count));
+	pool.waitForDone();
+
+	F_CHECK(pManager->flush());
+	pManager->removeListener(&counter);
+
+	// every message is either delivered or counted as dropped
+	size_t delivered = size_t(counter.m_count.load());
+	F_COMPARE(delivered + pManager->droppedCount() - droppedCount, size_t(taskCount * count));
+	F_CHECK(counter.m_pThread != QThread::currentThread());
+
+	// listeners may log messages and remove themselves
+	_FLogRemover remover;
+	pManager->addListener(&remover);
+	F_INFO("FLogTest") << "First message";
+	F_INFO("FLogTest") << "Second message";
+	F_CHECK(pManager->flush());
+	F_COMPARE(remover.m_count.load(), 1);
+}
+
+void FLogTest::testFatalFlush()
+{
+	FLogManager* pManager = FLogManager::instance();
+
+	_FLogCounter counter;
+	pManager->addListener(&counter);
+
+	// fatal messages are processed before the log statement returns
+	F_FATAL("FLogTest") << "Fatal message";
+	F_COMPARE(counter.m_fatalCount.load(), 1);
+
+	pManager->removeListener(&counter);
+}
+
+void FLogTest::testLogFile()
+{
+	const QString line("0123456789012345678901234567890123456789012345678\n");
+
+	{
+		FLogFile logFile("logfiletest.txt");
+		logFile.setBufferSize(256);
+		logFile.setFlushInterval(60000);
+		logFile.setMaxFileSize(1000);
+		logFile.setRetentionCount(2);
+
+		QFile::remove(logFile.fileName());
+		QFile::remove(logFile.rotatedFileName(1));
+		QFile::remove(logFile.rotatedFileName(2));
+
+		// text is buffered until the buffer is full
+		logFile.write(line);
+		F_CHECK(!logFile.isOpen());
+		F_COMPARE(logFile.fileSize(), qint64(50));
+
+		for (int i = 0; i < 5; ++i)
+			logFile.write(line);
+		F_CHECK(logFile.isOpen());
+		F_COMPARE(QFile("logfiletest.txt").size(), qint64(300));
+
+		// the file is rotated when it exceeds the maximum size,
+		// only the given number of rotated files are kept
+		for (int i = 0; i < 100; ++i)
+			logFile.write(line);
+		logFile.flush();
+
+		F_CHECK(QFile::exists(logFile.rotatedFileName(1)));
+		F_CHECK(QFile::exists(logFile.rotatedFileName(2)));
+		F_CHECK(!QFile::exists(logFile.rotatedFileName(3)));
+		F_CHECK(QFile(logFile.rotatedFileName(1)).size() <= 1000);
+		F_CHECK(logFile.fileSize() <= 1000);
+	}
+
+	QFile::remove("logfiletest.txt");
+	QFile::remove("logfiletest.txt.1");
+	QFile::remove("logfiletest.txt.2");
+}
+
+void FLogTest::testHistory()
+{
+	FLogHistory history(4);
+	F_COMPARE(history.size(), size_t(0));
+	F_COMPARE(history.lastSequence(), quint64(0));
+
+	// messages 1 - 6: info, warning, info, warning, info, critical
+	for (int i = 0; i < 6; ++i) {
+		FLogType type = (i == 5) ? FLogType::Critical : (i % 2 ? FLogType::Warning : FLogType::Info);
+		F_COMPARE(history.add(FLogMessage(type, "FLogTest", QString::number(i + 1))), quint64(i + 1));
+	}
+
+	// only the last 4 messages are kept
+	F_COMPARE(history.size(), size_t(4));
+	F_COMPARE(history.firstSequence(), quint64(3));
+	F_COMPARE(history.lastSequence(), quint64(6));
+	F_CHECK(history.message(3).text() == "3");
+
+	std::vector<FLogMessage> messages = history.messages();
+	F_COMPARE(messages.size(), size_t(4));
+	F_CHECK(messages.front().text() == "3" && messages.back().text() == "6");
+
+	messages = history.messages(FLogType::Info);
+	F_COMPARE(messages.size(), size_t(2));
+	F_CHECK(messages[0].text() == "3" && messages[1].text() == "5");
+	F_COMPARE(history.messages(FLogType::Warning).size(), size_t(1));
+	F_COMPARE(history.messages(FLogType::Fatal).size(), size_t(0));
+
+	// incremental retrieval
+	F_COMPARE(history.messages(FLogType::All, 4).size(), size_t(2));
+	F_COMPARE(history.messages(FLogType::Info, 3).size(), size_t(1));
+	F_COMPARE(history.messages(FLogType::All, 6).size(), size_t(0));
+
+	_FLogVisitor visitor;
+	F_COMPARE(history.visit(visitor, FLogType::Info, 0), quint64(6));
+	F_COMPARE(visitor.count, size_t(2));
+	F_CHECK(visitor.isOrdered);
+
+	// a full index ring of a single type
+	for (int i = 0; i < 10; ++i)
+		history.add(FLogMessage(FLogType::Warning, "FLogTest", QString::number(i + 7)));
+	messages = history.messages(FLogType::Warning, 12);
+	F_COMPARE(messages.size(), size_t(4));
+	F_CHECK(messages.front().text() == "13");
+	F_COMPARE(history.messages(FLogType::Info).size(), size_t(0));
+
+	// the log manager delivers new messages since the last call
+	FLogManager* pManager = FLogManager::instance();
+	pManager->flush();
+	quint64 sequence = pManager->lastSequence();
+
+	F_WARNING("FLogTest") << "History message 1";
+	F_INFO("FLogTest") << "History message 2";
+	pManager->flush();
+
+	quint64 lastSequence = 0;
+	messages = pManager->getMessagesSince(sequence, FLogType::Warning, &lastSequence);
+	F_COMPARE(messages.size(), size_t(1));
+	F_COMPARE(lastSequence, sequence + 2);
+
+	_FLogVisitor managerVisitor;
+	F_COMPARE(pManager->visitMessages(managerVisitor, sequence), lastSequence);
+	F_COMPARE(managerVisitor.count, size_t(2));
+}
+
+void FLogTest::testFilter()
+{
+	F_CHECK(FLogFilter::isEnabled(FLogType::Info, "FLogTestFilter"));
+
+	FLogFilter::setModuleLevel("FLogTestFilter", FLogType::Warning);
+	F_CHECK(!FLogFilter::isEnabled(FLogType::Info, "FLogTestFilter"));
+	F_CHECK(FLogFilter::isEnabled(FLogType::Warning, "FLogTestFilter"));
+	F_CHECK(FLogFilter::isEnabled(FLogType::Info, "FLogTest"));
+	F_CHECK(FLogFilter::moduleLevel("FLogTestFilter") == FLogType::Warning);
+
+	// filtered messages are not evaluated
+	int count = 0;
+	F_INFO("FLogTestFilter") << _countEvaluation(&count);
+	F_COMPARE(count, 0);
+	F_WARNING("FLogTestFilter") << _countEvaluation(&count);
+	F_COMPARE(count, 1);
+
+	// the module expression is evaluated once
+	int moduleCount = 0;
+	F_INFO(_countModule(&moduleCount)) << _countEvaluation(&count);
+	F_COMPARE(moduleCount, 1);
+	F_WARNING(_countModule(&moduleCount)) << _countEvaluation(&count);
+	F_COMPARE(moduleCount, 2);
+	F_COMPARE(count, 2);
+
+	// cached module levels follow level changes
+	FLogFilter::setModuleLevel("FLogTestFilter", FLogType::Critical);
+	F_CHECK(!FLogFilter::isEnabled(FLogType::Warning, "FLogTestFilter"));
+	FLogFilter::setModuleLevel("FLogTestFilter", FLogType::Warning);
+	F_CHECK(FLogFilter::isEnabled(FLogType::Warning, "FLogTestFilter"));
+
+	// modules not fitting into the cache any more are resolved under the lock,
+	// the names must stay valid as the cache keeps their addresses
+	static char names[300][16];
+	for (int i = 0; i < 300; ++i)
+		sprintf(names[i], "FLogTestMod%d", i);
+	FLogFilter::setModuleLevel("FLogTestMod0", FLogType::Critical);
+	FLogFilter::setModuleLevel("FLogTestMod299", FLogType::Critical);
+	bool isResolved = true;
+	for (int i = 0; i < 300; ++i) {
+		bool isCritical = i == 0 || i == 299;
+		isResolved = isResolved && FLogFilter::isEnabled(FLogType::Info, names[i]) != isCritical;
+		isResolved = isResolved && FLogFilter::isEnabled(FLogType::Info, names[i]) != isCritical;
+	}
+	F_CHECK(isResolved);
+	FLogFilter::resetModuleLevel("FLogTestMod299");
+	F_CHECK(FLogFilter::isEnabled(FLogType::Info, names[299]));
+	FLogFilter::resetModuleLevel("FLogTestMod0");
+
+	// modules without a level of their own use the global level
+	FLogFilter::setLevel(FLogType::Critical);
+	F_CHECK(!FLogFilter::isEnabled(FLogType::Warning, "FLogTest"));
+	F_CHECK(FLogFilter::isEnabled(FLogType::Warning, "FLogTestFilter"));
+	F_CHECK(FLogFilter::isEnabled(FLogType::Critical, "FLogTest"));
+
+	FLogFilter::setModuleLevel("FLogTestVerbose", FLogType::Debug);
+	F_CHECK(FLogFilter::isEnabled(FLogType::Debug, "FLogTestVerbose"));
+	F_CHECK(!FLogFilter::isEnabled(FLogType::Debug, "FLogTest"));
+
+	// fatal messages are never filtered
+	FLogFilter::setLevel(FLogType::All);
+	FLogFilter::setModuleLevel("FLogTestVerbose", FLogType::All);
+	F_CHECK(FLogFilter::level() == FLogType::Fatal);
+	F_CHECK(FLogFilter::isEnabled(FLogType::Fatal, "FLogTest"));
+	F_CHECK(FLogFilter::isEnabled(FLogType::Fatal, "FLogTestVerbose"));
+
+	FLogFilter::resetModuleLevels();
+	FLogFilter::setLevel(FLogType::Trace);
+	F_CHECK(FLogFilter::isEnabled(FLogType::Info, "FLogTestFilter"));
+	F_CHECK(FLogFilter::moduleLevel("FLogTestFilter") == FLogType::Trace);
+
+	// the compile time minimum level
+	count = 0;
+	F_DEBUG("FLogTest") << _countEvaluation(&count);
+#ifdef FLOW_DEBUG
+	F_COMPARE(count, 1);
+#else
+	F_COMPARE(count, 0);
+#endif
+}
+
+void FLogTest::testBinaryLog()
+{
+	FBinaryLog* pLog = FBinaryLog::instance();
+	F_CHECK(!FBinaryLog::isEnabled(FLogType::Fatal));
+
+	// messages are not evaluated while no log file is open
+	int count = 0;
+	F_BINARY_LOG(FLogType::Info, "FLogTest", "%1") << _countEvaluation(&count);
+	F_COMPARE(count, 0);
+
+	F_CHECK(pLog->open("binarylogtest.flb"));
+	F_CHECK(FBinaryLog::isEnabled(FLogType::Trace));
+
+	F_BINARY_LOG(FLogType::Info, "FLogTest", "Frame %1 took %2 ms, %3")
+		<< 42 << 16.5 << "done";
+	F_BINARY_LOG(FLogType::Warning, "FLogTest", "%1 %2 %3 %4")
+		<< true << -7 << quint64(1) << QString("text");
+
+	// arguments are not searched for placeholders, pointers are logged as address
+	int value = 0;
+	F_BINARY_LOG(FLogType::Info, "FLogTest", "%1 at %2") << "%2" << &value;
+
+	// arguments not fitting into the record are dropped
+	QString longText(300, QChar('x'));
+	F_BINARY_LOG(FLogType::Debug, "FLogTest", "%1 %2") << longText << 1;
+
+	// messages below the level are not evaluated
+	pLog->setLevel(FLogType::Warning);
+	F_BINARY_LOG(FLogType::Info, "FLogTest", "%1") << _countEvaluation(&count);
+	F_COMPARE(count, 0);
+	pLog->setLevel(FLogType::Trace);
+
+	const int taskCount = 4;
+	const int taskMessages = 100;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(taskCount);
+	for (int i = 0; i < taskCount; ++i)
+		pool.start(new _FBinaryLogTask(taskMessages));
+	pool.waitForDone();
+
+	pLog->close();
+	F_CHECK(!FBinaryLog::isEnabled(FLogType::Fatal));
+
+	{
+		QFile file("binarylogtest.flb");
+		F_CHECK(file.open(QIODevice::ReadOnly));
+
+		FBinaryLogReader reader(&file);
+		F_CHECK(reader.isValid());
+
+		FBinaryLogEntry entry;
+		F_CHECK(reader.readNext(&entry));
+		F_CHECK(entry.type() == FLogType::Info);
+		F_COMPARE(entry.module(), QString("FLogTest"));
+		F_COMPARE(entry.text(), QString("Frame 42 took 16.5 ms, done"));
+		F_COMPARE(entry.args().size(), 3);
+		F_CHECK(!entry.isTruncated());
+		F_CHECK(entry.line() > 0);
+
+		QJsonObject json = entry.toJson();
+		F_COMPARE(json.value("type").toString(), QString("Info"));
+		F_COMPARE(json.value("args").toArray().size(), 3);
+		F_COMPARE(json.value("text").toString(), entry.text());
+
+		F_CHECK(reader.readNext(&entry));
+		F_CHECK(entry.type() == FLogType::Warning);
+		F_COMPARE(entry.text(), QString("true -7 1 text"));
+
+		F_CHECK(reader.readNext(&entry));
+		F_COMPARE(entry.text(), QString("%2 at 0x%1").arg(
+			quint64(quintptr(&value)), 16, 16, QChar('0')));
+
+		// placeholders of missing arguments are kept
+		F_CHECK(reader.readNext(&entry));
+		F_CHECK(entry.isTruncated());
+		F_COMPARE(entry.args().size(), 1);
+		F_COMPARE(entry.text(), QString(FBinaryLog::ArgsCapacity - 3, QChar('x')) + " %2");
+
+		// messages from other threads are either written or counted as dropped
+		size_t received = 0;
+		while (reader.readNext(&entry)) {
+			if (entry.format() == "Task message %1")
+				received++;
+		}
+
+		F_CHECK(!reader.hasError());
+		F_COMPARE(received + reader.droppedCount(), size_t(taskCount * taskMessages));
+	}
+
+	QFile::remove("binarylogtest.flb");
+}
+
+void FLogTest::benchmarkFilter()
+{
+	const int count = 10000000;
+	int evaluations = 0;
+	FLogFilter::setLevel(FLogType::Warning);
+
+	FStopWatch watch;
+	watch.start();
+	for (int i = 0; i < count; ++i)
+		F_INFO("FLogTest") << _countEvaluation(&evaluations);
+	double time = watch.stop();
+
+	// with a module level below the message type, the module is looked up
+	FLogFilter::setModuleLevel("FLogTestVerbose", FLogType::Debug);
+	watch.start();
+	for (int i = 0; i < count; ++i)
+		F_INFO("FLogTest") << _countEvaluation(&evaluations);
+	double moduleTime = watch.stop();
+
+	FLogFilter::resetModuleLevels();
+	FLogFilter::setLevel(FLogType::Trace);
+
+	F_COMPARE(evaluations, 0);
+	F_TRACE << "Filtered log statements: " << count << " in " << time * 1000.0 << " ms";
+	F_TRACE << "Filtered log statements with module levels: " << count
+		<< " in " << moduleTime * 1000.0 << " ms";
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,41 @@
+// -----------------------------------------------------------------------------
+//  File        LogTest.h
+//  Project     FlowCoreTest
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/28 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORETEST_LOGTEST_H
+#define FLOWCORETEST_LOGTEST_H
+
+#include "FlowCore/UnitTest.h"
+
+// -----------------------------------------------------------------------------
+//  Class FLogTest
+// -----------------------------------------------------------------------------
+
+class FLogTest : public FUnitTest
+{
+	Q_OBJECT;
+	F_DECLARE_TEST;
+
+public:
+	virtual void setup();
+	virtual void shutdown();
+
+public slots:
+	void testQueue();
+	void testAsynchronous();
+	void testFatalFlush();
+	void testLogFile();
+	void testHistory();
+	void testFilter();
+	void testBinaryLog();
+	void benchmarkFilter();
+};
+
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORETEST_LOGTEST_H
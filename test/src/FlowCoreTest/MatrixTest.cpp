@@ -0,0 +1,420 @@
+// -----------------------------------------------------------------------------
+//  File        MatrixTest.cpp
+//  Project     FlowCoreTest
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/11 $
+// -----------------------------------------------------------------------------
+
+#include "FlowCoreTest/MatrixTest.h"
+
+#include "FlowCore/FastVec.h"
+#include "FlowCore/FastMat.h"
+#include "FlowCore/FastMat4d.h"
+#include "FlowCore/Frustum.h"
+#include "FlowCore/BoxArray.h"
+#include "FlowCore/Cpu.h"
+#include "FlowCore/StopWatch.h"
+#include "FlowCore/Log.h"
+
+#include <vector>
+#include <cmath>
+
+// -----------------------------------------------------------------------------
+//  Class FMatrixTest
+// -----------------------------------------------------------------------------
+
+F_IMPLEMENT_TEST(FMatrixTest, "Class FFastMat4f");
+
+// Initialization --------------------------------------------------------------
+
+void FMatrixTest::setup()
+{
+}
+
+void FMatrixTest::shutdown()
+{
+}
+
+// Tests -----------------------------------------------------------------------
+
+void FMatrixTest::testBatchTransform()
+{
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		_checkBatchTransform(FCpu::tierName((FCpu::SimdTier)t));
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FMatrixTest::benchmarkBatchTransform()
+{
+	const size_t count = 2000000;
+	std::vector<float> src(count * 3), dst(count * 3);
+	for (size_t i = 0; i < count * 3; ++i)
+		src[i] = float(i % 1000) * 0.01f;
+
+	FFastMat4f mat( 0.8f, -0.6f,  0.0f, 10.0f,
+	                0.6f,  0.8f,  0.0f, -5.0f,
+	                0.0f,  0.0f,  2.0f,  1.5f,
+	                0.0f,  0.0f,  0.0f,  1.0f);
+
+	FStopWatch watch;
+	watch.start();
+	for (size_t i = 0; i < count; ++i) {
+		FFastVec4f v = mat * FFastVec4f(src[i*3], src[i*3+1], src[i*3+2], 1.0f);
+		dst[i*3] = v[0]; dst[i*3+1] = v[1]; dst[i*3+2] = v[2];
+	}
+	double singleTime = watch.stop();
+
+	F_TRACE << "Transform of " << count << " points: per-vector "
+		<< singleTime * 1000.0 << " ms";
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		watch.reset();
+		watch.start();
+		mat.transformPoints(&src[0], &dst[0], count);
+		double batchTime = watch.stop();
+
+		F_TRACE << "Transform of " << count << " points: batch "
+			<< FCpu::tierName((FCpu::SimdTier)t) << " " << batchTime * 1000.0 << " ms";
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FMatrixTest::testDoubleMatrix()
+{
+	FFastMat4d mat( 2.0, -1.0,  0.5,  3.0,
+	                0.0,  4.0,  1.0, -2.0,
+	                1.0,  0.0,  3.0,  1.0,
+	               -1.0,  2.0,  0.0,  5.0);
+
+	FFastMat4d product = mat * mat.inverse();
+	bool inverseOk = true;
+	for (size_t r = 0; r < 4; ++r)
+		for (size_t c = 0; c < 4; ++c)
+			inverseOk = inverseOk && fabs(product(r, c) - (r == c ? 1.0 : 0.0)) < 1e-12;
+
+	F_CHECK_MESSAGE(inverseOk, "FFastMat4d::inverse");
+	F_CHECK_MESSAGE(fabs(mat.determinant() - 152.0) < 1e-12, "FFastMat4d::determinant");
+	F_CHECK_MESSAGE(mat.transposed().column(1) == mat.row(1), "FFastMat4d::transposed");
+
+	FFastVec4d v(1.0, 2.0, 3.0, 1.0);
+	FFastVec4d mv = mat * v;
+	F_CHECK_MESSAGE(mv == FFastVec4d(4.5, 9.0, 11.0, 8.0), "FFastMat4d * FFastVec4d");
+
+	FFastVec4d cross = FFastVec4d(1.0, 0.0, 0.0, 0.0).cross(FFastVec4d(0.0, 1.0, 0.0, 0.0));
+	F_CHECK_MESSAGE(cross == FFastVec4d(0.0, 0.0, 1.0, 0.0), "FFastVec4d::cross");
+}
+
+void FMatrixTest::testMatrixArrays()
+{
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		_checkMatrixArrays(FCpu::tierName((FCpu::SimdTier)t));
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FMatrixTest::benchmarkMatrixArrays()
+{
+	const size_t count = 10000;
+	const size_t blockCount = (count + 7) / 8;
+	std::vector<FFastMat4f> src(count), dst(count);
+	std::vector<FFastMat4fBlock> srcBlocks(blockCount), dstBlocks(blockCount);
+
+	for (size_t i = 0; i < count; ++i) {
+		float f = float(i % 100) * 0.01f;
+		src[i] = FFastMat4f(2.0f + f, 0.5f, f, 1.0f,  -f, 3.0f, 0.5f, 2.0f,
+			0.5f, f, 4.0f - f, -1.0f,  0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	FFastMat4f::toBlocks(&src[0], &srcBlocks[0], count);
+
+	FStopWatch watch;
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		dst[i] = src[i].inverse();
+	double inverseTime = watch.stop();
+
+	watch.reset();
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		dst[i] = src[i] * src[count - 1 - i];
+	double multiplyTime = watch.stop();
+
+	F_TRACE << "Inverse/multiply of " << count << " matrices: per-matrix "
+		<< inverseTime * 1000.0 << " / " << multiplyTime * 1000.0 << " ms";
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		QString tierName = FCpu::tierName((FCpu::SimdTier)t);
+
+		watch.reset();
+		watch.start();
+		FFastMat4f::inverseMany(&src[0], &dst[0], count);
+		inverseTime = watch.stop();
+
+		watch.reset();
+		watch.start();
+		FFastMat4f::multiplyMany(&src[0], &src[0], &dst[0], count);
+		multiplyTime = watch.stop();
+
+		F_TRACE << "Inverse/multiply of " << count << " matrices: array " << tierName << " "
+			<< inverseTime * 1000.0 << " / " << multiplyTime * 1000.0 << " ms";
+
+		watch.reset();
+		watch.start();
+		FFastMat4f::inverseMany(&srcBlocks[0], &dstBlocks[0], blockCount);
+		inverseTime = watch.stop();
+
+		watch.reset();
+		watch.start();
+		FFastMat4f::multiplyMany(&srcBlocks[0], &srcBlocks[0], &dstBlocks[0], blockCount);
+		multiplyTime = watch.stop();
+
+		F_TRACE << "Inverse/multiply of " << count << " matrices: blocks " << tierName << " "
+			<< inverseTime * 1000.0 << " / " << multiplyTime * 1000.0 << " ms";
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FMatrixTest::testBoxCulling()
+{
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		_checkBoxCulling(FCpu::tierName((FCpu::SimdTier)t));
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FMatrixTest::benchmarkBoxCulling()
+{
+	const size_t count = 50000;
+	FBoxArray boxes;
+	boxes.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		FVector3f p(float(i % 97) - 48.0f, float(i % 89) - 44.0f, float(i % 83) - 41.0f);
+		boxes.append(FRange3f(p, p + FVector3f(1.0f, 2.0f, 1.5f)));
+	}
+
+	FMatrix4f viewProjection;
+	viewProjection.makeProjectionPerspectiveLH(1.2f, true, 1.5f, 0.5f, 100.0f);
+	FFrustum frustum(viewProjection);
+
+	std::vector<uint32_t> visible;
+	visible.reserve(count);
+
+	FStopWatch watch;
+	watch.start();
+	for (size_t i = 0; i < count; ++i) {
+		if (frustum.intersects(boxes.box(i)))
+			visible.push_back(uint32_t(i));
+	}
+	double singleTime = watch.stop();
+
+	F_TRACE << "Culling of " << count << " boxes: per-box " << singleTime * 1000.0 << " ms";
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		watch.reset();
+		watch.start();
+		boxes.cull(frustum, visible);
+		double batchTime = watch.stop();
+
+		F_TRACE << "Culling of " << count << " boxes: batch "
+			<< FCpu::tierName((FCpu::SimdTier)t) << " " << batchTime * 1000.0 << " ms, "
+			<< visible.size() << " visible";
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+// Internal functions ----------------------------------------------------------
+
+void FMatrixTest::_checkBatchTransform(const QString& tier)
+{
+	FFastMat4f mat( 0.8f, -0.6f,  0.0f, 10.0f,
+	                0.6f,  0.8f,  0.0f, -5.0f,
+	                0.0f,  0.0f,  2.0f,  1.5f,
+	                0.0f,  0.0f,  0.0f,  1.0f);
+
+	// 37 elements: covers the 16-, 8- and 4-wide and the scalar code paths
+	const size_t count = 37;
+	std::vector<float> src(count * 3), dst(count * 3), strided(count * 5, -1.0f);
+	std::vector<float> sx(count), sy(count), sz(count), dx(count), dy(count), dz(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		src[i*3] = sx[i] = float(i) * 0.5f;
+		src[i*3+1] = sy[i] = 3.0f - float(i);
+		src[i*3+2] = sz[i] = float(i % 4) - 1.5f;
+	}
+
+	mat.transformPoints(&src[0], &dst[0], count);
+	mat.transformPoints(&src[0], &strided[0], count, 3, 5);
+	mat.transformPoints(&sx[0], &sy[0], &sz[0], &dx[0], &dy[0], &dz[0], count);
+
+	bool pointsOk = true, stridedOk = true, soaOk = true;
+	for (size_t i = 0; i < count; ++i) {
+		FFastVec4f ref = mat * FFastVec4f(src[i*3], src[i*3+1], src[i*3+2], 1.0f);
+		for (size_t k = 0; k < 3; ++k) {
+			pointsOk = pointsOk && fabsf(ref[k] - dst[i*3+k]) < 1e-4f;
+			stridedOk = stridedOk && fabsf(ref[k] - strided[i*5+k]) < 1e-4f;
+		}
+		stridedOk = stridedOk && strided[i*5+3] == -1.0f && strided[i*5+4] == -1.0f;
+		soaOk = soaOk && fabsf(ref[0] - dx[i]) < 1e-4f
+			&& fabsf(ref[1] - dy[i]) < 1e-4f && fabsf(ref[2] - dz[i]) < 1e-4f;
+	}
+
+	F_CHECK_MESSAGE(pointsOk, QString("transformPoints, packed layout, %1").arg(tier));
+	F_CHECK_MESSAGE(stridedOk, QString("transformPoints, strided layout, %1").arg(tier));
+	F_CHECK_MESSAGE(soaOk, QString("transformPoints, SoA layout, %1").arg(tier));
+
+	mat.transformVectors(&src[0], &dst[0], count);
+	bool vectorsOk = true;
+	for (size_t i = 0; i < count; ++i) {
+		FFastVec4f ref = mat * FFastVec4f(src[i*3], src[i*3+1], src[i*3+2], 0.0f);
+		for (size_t k = 0; k < 3; ++k)
+			vectorsOk = vectorsOk && fabsf(ref[k] - dst[i*3+k]) < 1e-4f;
+	}
+
+	F_CHECK_MESSAGE(vectorsOk, QString("transformVectors, %1").arg(tier));
+
+	// a normal must stay perpendicular to a transformed tangent
+	float normals[6] = { 0.0f, 0.0f, 1.0f,  1.0f, 1.0f, 0.0f };
+	float tangents[6] = { 1.0f, 0.0f, 0.0f,  1.0f, -1.0f, 0.0f };
+	mat.transformNormals(normals, normals, 2);
+	mat.transformVectors(tangents, tangents, 2);
+
+	bool normalsOk = true;
+	for (size_t i = 0; i < 2; ++i) {
+		float* n = normals + i * 3;
+		float* t = tangents + i * 3;
+		normalsOk = normalsOk && fabsf(n[0]*t[0] + n[1]*t[1] + n[2]*t[2]) < 1e-5f
+			&& fabsf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2] - 1.0f) < 1e-5f;
+	}
+
+	F_CHECK_MESSAGE(normalsOk, QString("transformNormals, %1").arg(tier));
+}
+
+void FMatrixTest::_checkMatrixArrays(const QString& tier)
+{
+	// 13 matrices: covers full and incomplete groups of 4 and 8
+	const size_t count = 13;
+	std::vector<FFastMat4f> a(count), b(count), product(count), inverse(count), normal(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		float f = float(i) * 0.25f;
+		a[i] = FFastMat4f(2.0f, f, 0.5f, 1.0f,  -1.0f, 3.0f + f, 0.0f, 2.0f,
+			0.5f, 1.0f, 4.0f, -f,  f, 0.0f, 1.0f, 1.0f);
+		b[i] = FFastMat4f(1.0f, 0.0f, f, 0.0f,  0.0f, 2.0f, 0.0f, 1.0f,
+			-f, 0.0f, 1.0f, 0.0f,  0.0f, 0.5f, 0.0f, 1.0f);
+	}
+
+	FFastMat4f::multiplyMany(&a[0], &b[0], &product[0], count);
+	FFastMat4f::inverseMany(&a[0], &inverse[0], count);
+	FFastMat4f::inverseTransposeMany(&a[0], &normal[0], count);
+
+	size_t blockCount = (count + 7) / 8;
+	std::vector<FFastMat4fBlock> blocks(blockCount), blocksB(blockCount);
+	std::vector<FFastMat4f> blockProduct(count), blockInverse(count);
+
+	FFastMat4f::toBlocks(&a[0], &blocks[0], count);
+	FFastMat4f::toBlocks(&b[0], &blocksB[0], count);
+	FFastMat4f::multiplyMany(&blocks[0], &blocksB[0], &blocksB[0], blockCount);
+	FFastMat4f::fromBlocks(&blocksB[0], &blockProduct[0], count);
+	FFastMat4f::inverseMany(&blocks[0], &blocks[0], blockCount);
+	FFastMat4f::fromBlocks(&blocks[0], &blockInverse[0], count);
+
+	bool productOk = true, inverseOk = true, normalOk = true, blocksOk = true;
+	for (size_t i = 0; i < count; ++i) {
+		FFastMat4f refProduct = a[i] * b[i];
+		FFastMat4f identity = a[i] * inverse[i];
+		for (size_t r = 0; r < 4; ++r) {
+			for (size_t c = 0; c < 4; ++c) {
+				productOk = productOk && fabsf(refProduct(r, c) - product[i](r, c)) < 1e-4f;
+				inverseOk = inverseOk && fabsf(identity(r, c) - (r == c ? 1.0f : 0.0f)) < 1e-4f;
+				normalOk = normalOk && normal[i](r, c) == inverse[i](c, r);
+				blocksOk = blocksOk && fabsf(blockProduct[i](r, c) - product[i](r, c)) < 1e-4f
+					&& fabsf(blockInverse[i](r, c) - inverse[i](r, c)) < 1e-4f;
+			}
+		}
+	}
+
+	F_CHECK_MESSAGE(productOk, QString("multiplyMany, %1").arg(tier));
+	F_CHECK_MESSAGE(inverseOk, QString("inverseMany, %1").arg(tier));
+	F_CHECK_MESSAGE(normalOk, QString("inverseTransposeMany, %1").arg(tier));
+	F_CHECK_MESSAGE(blocksOk, QString("matrix blocks, %1").arg(tier));
+}
+
+void FMatrixTest::_checkBoxCulling(const QString& tier)
+{
+	// camera at the origin looking along +z, slightly rotated
+	FMatrix4f projection, view;
+	projection.makeProjectionPerspectiveLH(1.2f, true, 1.5f, 0.5f, 100.0f);
+	view.makeRotationY(0.3f);
+	FFrustum frustum(projection * view);
+
+	// 1003 boxes, covers the 16-, 8- and 4-wide and the remainder code paths
+	const size_t count = 1003;
+	FBoxArray boxes;
+	std::vector<FVector3f> points;
+	for (size_t i = 0; i < count; ++i) {
+		FVector3f p(float(i * 37 % 201) - 100.0f, float(i * 53 % 151) - 75.0f, float(i * 71 % 241) - 120.0f);
+		FVector3f s(float(i % 7) + 0.5f, float(i % 5) + 0.5f, float(i % 3) + 0.5f);
+		boxes.append(FRange3f(p, p + s));
+		points.push_back(p);
+	}
+
+	std::vector<uint32_t> visible;
+	boxes.cull(frustum, visible);
+
+	std::vector<uint32_t> expected;
+	for (size_t i = 0; i < count; ++i) {
+		if (frustum.intersects(boxes.box(i)))
+			expected.push_back(uint32_t(i));
+	}
+
+	F_CHECK_MESSAGE(visible == expected, QString("FBoxArray::cull, %1").arg(tier));
+	F_CHECK_MESSAGE(!expected.empty() && expected.size() < count,
+		QString("FBoxArray::cull partial visibility, %1").arg(tier));
+
+	// box in front of the camera is visible, box behind the camera is not
+	FBoxArray single;
+	single.append(FRange3f(-1.0f, -1.0f, 9.0f, 1.0f, 1.0f, 11.0f));
+	single.append(FRange3f(-1.0f, -1.0f, -11.0f, 1.0f, 1.0f, -9.0f));
+	single.cull(FFrustum(projection), visible);
+	F_CHECK_MESSAGE(visible.size() == 1 && visible[0] == 0,
+		QString("FBoxArray::cull front/back, %1").arg(tier));
+
+	FRange3f bounds, expectedBounds;
+	bounds.invalidate();
+	expectedBounds.invalidate();
+	bounds.include(&points[0], count);
+	for (size_t i = 0; i < count; ++i)
+		expectedBounds.include(points[i]);
+
+	F_CHECK_MESSAGE(bounds.lowerBound() == expectedBounds.lowerBound()
+		&& bounds.upperBound() == expectedBounds.upperBound(),
+		QString("FRange3f::include, %1").arg(tier));
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+// -----------------------------------------------------------------------------
+//  File        MatrixTest.h
+//  Project     FlowCoreTest
+// -----------------------------------------------------------------------------
+//  $Author: Ralph Wiedemeier $
+//  $Revision: 1 $
+//  $Date: 2014/02/11 $
+// -----------------------------------------------------------------------------
+
+#ifndef FLOWCORETEST_MATRIXTEST_H
+#define FLOWCORETEST_MATRIXTEST_H
+
+#include "FlowCore/UnitTest.h"
+
+// -----------------------------------------------------------------------------
+//  Class FMatrixTest
+// -----------------------------------------------------------------------------
+
+class FMatrixTest : public FUnitTest
+{
+	Q_OBJECT;
+	F_DECLARE_TEST;
+
+	//  Public commands ----------------------------------------------
+
+public:
+	virtual void setup();
+	virtual void shutdown();
+
+public slots:
+	void testBatchTransform();
+	void benchmarkBatchTransform();
+	void testDoubleMatrix();
+	void testMatrixArrays();
+	void benchmarkMatrixArrays();
+	void testBoxCulling();
+	void benchmarkBoxCulling();
+
+	//  Internal functions -------------------------------------------
+
+private:
+	void _checkBatchTransform(const QString& tier);
+	void _checkMatrixArrays(const QString& tier);
+	void _checkBoxCulling(const QString& tier);
+};
+	
+// -----------------------------------------------------------------------------
+
+#endif // FLOWCORETEST_MATRIXTEST_H
@@ -9,6 +9,83 @@
 
 #include "FlowCoreTest/ObjectTest.h"
 
+#include "FlowCore/TypeInfo.h"
+#include "FlowCore/TypeRegistry.h"
+#include "FlowCore/Allocator.h"
+#include "FlowCore/StopWatch.h"
+#include "FlowCore/Log.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Test classes
+// -----------------------------------------------------------------------------
+
+F_IMPLEMENT_TYPEINFO(FDeepType1, FObject);
+F_IMPLEMENT_TYPEINFO(FDeepType2, FDeepType1);
+F_IMPLEMENT_TYPEINFO(FDeepType3, FDeepType2);
+F_IMPLEMENT_TYPEINFO(FDeepType4, FDeepType3);
+F_IMPLEMENT_TYPEINFO(FDeepType5, FDeepType4);
+F_IMPLEMENT_TYPEINFO(FDeepType6, FDeepType5);
+F_IMPLEMENT_TYPEINFO(FDeepType7, FDeepType6);
+F_IMPLEMENT_TYPEINFO(FDeepType8, FDeepType7);
+F_IMPLEMENT_TYPEINFO(FSiblingType2, FDeepType1);
+F_IMPLEMENT_TYPEINFO(FSiblingType3, FSiblingType2);
+
+F_IMPLEMENT_TYPEINFO(FSlabObject, FObject);
+F_IMPLEMENT_SLAB_ALLOCATED(FSlabObject);
+F_IMPLEMENT_TYPEINFO(FLargeSlabObject, FSlabObject);
+F_IMPLEMENT_TYPEINFO(FHeapObject, FObject);
+
+// Helpers ---------------------------------------------------------------------
+
+/// Creates and deletes slab allocated objects, checking they don't overlap.
+class _FSlabTask : public QRunnable
+{
+public:
+	_FSlabTask(QAtomicInt* pErrors) : m_pErrors(pErrors) { }
+
+	virtual void run()
+	{
+		std::vector<FSlabObject*> objects;
+		for (size_t round = 0; round < 20; ++round)
+		{
+			for (size_t i = 0; i < 500; ++i) {
+				objects.push_back(new FSlabObject());
+				objects.back()->m_index = objects.size();
+			}
+			for (size_t i = 0; i < objects.size(); ++i) {
+				if (objects[i]->m_index != i + 1)
+					m_pErrors->ref();
+			}
+			for (size_t i = objects.size() / 2; i < objects.size(); ++i)
+				delete objects[i];
+			objects.resize(objects.size() / 2);
+		}
+
+		for (size_t i = 0; i < objects.size(); ++i)
+			delete objects[i];
+	}
+
+private:
+	QAtomicInt* m_pErrors;
+};
+
+/// Walks the chain of base types, as isDerivedFrom() did before
+/// the hierarchy was numbered. Used for comparison only.
+static bool _fWalkBaseTypes(const FTypeInfo* pType, const FTypeInfo* pBaseType)
+{
+	for (; pType; pType = pType->baseType()) {
+		if (pType == pBaseType)
+			return true;
+	}
+
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 //  Class FObjectTest
 // -----------------------------------------------------------------------------
@@ -37,4 +114,176 @@ void FObjectTest::test2()
 {
 }
 
+void FObjectTest::testTypeHierarchy()
+{
+	const FTypeInfo* types[] = {
+		FObject::staticType(), FDeepType1::staticType(), FDeepType2::staticType(),
+		FDeepType3::staticType(), FDeepType4::staticType(), FDeepType5::staticType(),
+		FDeepType6::staticType(), FDeepType7::staticType(), FDeepType8::staticType(),
+		FSiblingType2::staticType(), FSiblingType3::staticType()
+	};
+	const size_t typeCount = sizeof(types) / sizeof(types[0]);
+
+	bool isConsistent = true;
+	for (size_t i = 0; i < typeCount; ++i) {
+		for (size_t j = 0; j < typeCount; ++j) {
+			isConsistent = isConsistent && types[i]->isDerivedFrom(types[j])
+				== _fWalkBaseTypes(types[i], types[j]);
+		}
+	}
+	F_CHECK(isConsistent);
+
+	F_CHECK(FDeepType8::staticType()->isDerivedFrom(FObject::staticType()));
+	F_CHECK(FSiblingType3::staticType()->isDerivedFrom(FDeepType1::staticType()));
+	F_CHECK(!FSiblingType3::staticType()->isDerivedFrom(FDeepType2::staticType()));
+	F_CHECK(!FDeepType2::staticType()->isDerivedFrom(FDeepType3::staticType()));
+
+	FDeepType8 object;
+	F_CHECK(object.castTo<FDeepType4>() == &object);
+	F_CHECK(object.castTo<FSiblingType2>() == NULL);
+	F_CHECK(object.isKindOf<FDeepType8>());
+
+	// a type registered later is inserted into the hierarchy
+	static const FTypeInfo lateType("FLateType", sizeof(FDeepType4), 1,
+		NULL, FDeepType3::staticType());
+	F_CHECK(lateType.isDerivedFrom(FDeepType3::staticType()));
+	F_CHECK(lateType.isDerivedFrom(FObject::staticType()));
+	F_CHECK(!lateType.isDerivedFrom(FDeepType4::staticType()));
+	F_CHECK(FDeepType8::staticType()->isDerivedFrom(FDeepType3::staticType()));
+
+	FTypeRegistry* pRegistry = FTypeRegistry::instance();
+	F_COMPARE(pRegistry->classFromName("FDeepType5"), FDeepType5::staticType());
+	F_COMPARE(pRegistry->classFromName("FLateType"), &lateType);
+	F_CHECK(pRegistry->classFromName("FDeepType") == NULL);
+}
+
+void FObjectTest::benchmarkCastTo()
+{
+	const size_t count = 10000000;
+	std::vector<FObject*> objects;
+	objects.push_back(new FDeepType8());
+	objects.push_back(new FSiblingType3());
+	objects.push_back(new FDeepType2());
+	objects.push_back(new FDeepType5());
+
+	const FTypeInfo* pBaseType = FDeepType2::staticType();
+	size_t walkCount = 0, castCount = 0;
+
+	FStopWatch watch;
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		walkCount += _fWalkBaseTypes(objects[i & 3]->dynamicType(), pBaseType);
+	double walkTime = watch.stop();
+
+	watch.reset();
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		castCount += objects[i & 3]->castTo<FDeepType2>() != NULL;
+	double castTime = watch.stop();
+
+	F_COMPARE(walkCount, castCount);
+	F_TRACE << "castTo on hierarchy of depth 9, " << count << " casts: base type walk "
+		<< walkTime * 1000.0 << " ms, numbered hierarchy " << castTime * 1000.0 << " ms";
+
+	const char* names[] = { "FDeepType8", "FSiblingType3", "FObject", "FUnknownType" };
+	size_t foundCount = 0;
+
+	watch.reset();
+	watch.start();
+	for (size_t i = 0; i < count / 10; ++i)
+		foundCount += FTypeRegistry::instance()->classFromName(names[i & 3]) != NULL;
+	double lookupTime = watch.stop();
+
+	F_COMPARE(foundCount, count / 10 / 4 * 3);
+	F_TRACE << "classFromName, " << count / 10 << " lookups: " << lookupTime * 1000.0 << " ms";
+
+	for (size_t i = 0; i < objects.size(); ++i)
+		F_SAFE_DELETE(objects[i]);
+}
+
+void FObjectTest::testSlabAllocator()
+{
+	FSlabAllocator* pAllocator = FSlabObject::slabAllocator();
+	F_CHECK(pAllocator->elementSize() >= FSlabObject::staticType()->typeSize());
+	F_CHECK(pAllocator->elementSize() % 16 == 0);
+
+	const size_t count = 1000;
+	std::vector<FSlabObject*> objects(count);
+	for (size_t i = 0; i < count; ++i) {
+		objects[i] = new FSlabObject();
+		objects[i]->m_index = i;
+	}
+
+	bool isValid = true;
+	for (size_t i = 0; i < count; ++i)
+		isValid = isValid && objects[i]->m_index == i && (size_t)objects[i] % 16 == 0;
+	F_CHECK(isValid);
+	F_CHECK(pAllocator->allocatedCount() >= count);
+
+	// freed blocks are reused, no new slabs are allocated
+	size_t reservedSize = pAllocator->reservedSize();
+	for (size_t i = 0; i < count; ++i)
+		delete objects[i];
+	F_CHECK(pAllocator->allocatedCount() < count);
+
+	for (size_t i = 0; i < count; ++i)
+		objects[i] = new FSlabObject();
+	F_COMPARE(pAllocator->reservedSize(), reservedSize);
+
+	// derived classes of a different size are allocated from the heap
+	FSlabObject* pLarge = new FLargeSlabObject();
+	pLarge->m_index = 1;
+	F_CHECK(pLarge->isKindOf<FLargeSlabObject>());
+	delete pLarge;
+
+	for (size_t i = 0; i < count; ++i)
+		delete objects[i];
+
+	// concurrent allocation from several threads
+	QAtomicInt errors(0);
+	QThreadPool pool;
+	pool.setMaxThreadCount(4);
+	for (int i = 0; i < 8; ++i)
+		pool.start(new _FSlabTask(&errors));
+	pool.waitForDone();
+	F_COMPARE(errors.load(), 0);
+
+	// bulk release
+	pAllocator->reset();
+	F_COMPARE(pAllocator->reservedSize(), size_t(0));
+	F_COMPARE(pAllocator->allocatedCount(), size_t(0));
+
+	FSlabObject* pObject = new FSlabObject();
+	F_CHECK(pAllocator->allocatedCount() > 0);
+	F_CHECK(pAllocator->reservedSize() > 0);
+	delete pObject;
+}
+
+void FObjectTest::benchmarkSlabAllocator()
+{
+	const size_t count = 1000000;
+	std::vector<FObject*> objects(count);
+
+	FStopWatch watch;
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		objects[i] = new FHeapObject();
+	for (size_t i = 0; i < count; ++i)
+		delete objects[i];
+	double heapTime = watch.stop();
+
+	watch.reset();
+	watch.start();
+	for (size_t i = 0; i < count; ++i)
+		objects[i] = new FSlabObject();
+	for (size_t i = 0; i < count; ++i)
+		delete objects[i];
+	double slabTime = watch.stop();
+
+	F_TRACE << "Create and delete " << count << " objects: heap "
+		<< heapTime * 1000.0 << " ms, slab allocator " << slabTime * 1000.0 << " ms";
+
+	FSlabObject::slabAllocator()->reset();
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
@@ -11,6 +11,64 @@
 #define FLOWCORETEST_OBJECTTEST_H
 
 #include "FlowCore/UnitTest.h"
+#include "FlowCore/Object.h"
+
+// -----------------------------------------------------------------------------
+//  Test classes
+// -----------------------------------------------------------------------------
+
+/// Declares a test class derived from the given base class.
+#define F_DECLARE_TEST_TYPE(className, baseClassName) \
+	class className : public baseClassName \
+	{ \
+		F_DECLARE_TYPEINFO(className); \
+	public: \
+		className() { } \
+	};
+
+F_DECLARE_TEST_TYPE(FDeepType1, FObject)
+F_DECLARE_TEST_TYPE(FDeepType2, FDeepType1)
+F_DECLARE_TEST_TYPE(FDeepType3, FDeepType2)
+F_DECLARE_TEST_TYPE(FDeepType4, FDeepType3)
+F_DECLARE_TEST_TYPE(FDeepType5, FDeepType4)
+F_DECLARE_TEST_TYPE(FDeepType6, FDeepType5)
+F_DECLARE_TEST_TYPE(FDeepType7, FDeepType6)
+F_DECLARE_TEST_TYPE(FDeepType8, FDeepType7)
+F_DECLARE_TEST_TYPE(FSiblingType2, FDeepType1)
+F_DECLARE_TEST_TYPE(FSiblingType3, FSiblingType2)
+
+/// Test class allocated from a slab allocator.
+class FSlabObject : public FObject
+{
+	F_DECLARE_TYPEINFO(FSlabObject);
+	F_DECLARE_SLAB_ALLOCATED(FSlabObject);
+
+public:
+	FSlabObject() : m_index(0), m_weight(0.0) { }
+	size_t m_index;
+	double m_weight;
+};
+
+/// Test class derived from a slab allocated class, allocated from the heap.
+class FLargeSlabObject : public FSlabObject
+{
+	F_DECLARE_TYPEINFO(FLargeSlabObject);
+
+public:
+	FLargeSlabObject() { }
+	double m_values[16];
+};
+
+/// Test class of the same size as FSlabObject, allocated from the heap.
+class FHeapObject : public FObject
+{
+	F_DECLARE_TYPEINFO(FHeapObject);
+
+public:
+	FHeapObject() : m_index(0), m_weight(0.0) { }
+	size_t m_index;
+	double m_weight;
+};
 
 // -----------------------------------------------------------------------------
 //  Class FObjectTest
@@ -30,6 +88,10 @@ public:
 public slots:
 	void test1();
 	void test2();
+	void testTypeHierarchy();
+	void benchmarkCastTo();
+	void testSlabAllocator();
+	void benchmarkSlabAllocator();
 
 	//  Internal data members ----------------------------------------
 
@@ -10,9 +10,18 @@
 #include "FlowCoreTest/ValueArrayTest.h"
 
 #include "FlowCore/ValueArray.h"
+#include "FlowCore/Allocator.h"
+#include "FlowCore/Archive.h"
+#include "FlowCore/MappedFile.h"
 #include "FlowCore/Vector3T.h"
 #include "FlowCore/MemoryTracer.h"
 
+#include <QFile>
+
+#include <utility>
+#include <numeric>
+#include <algorithm>
+
 // -----------------------------------------------------------------------------
 //  Class FValueArrayTest
 // -----------------------------------------------------------------------------
@@ -219,4 +228,442 @@ void FValueArrayTest::testConversion()
 	}
 }
 
+void FValueArrayTest::testConversionModes()
+{
+	// normalized 8 bit colors, 2 channels of 5 dimensions
+	uint8_t pu8[] = { 0, 51, 102, 204, 255, 255, 204, 102, 51, 0 };
+	FValueArray u8(pu8, 2, 5, false);
+	FValueArray f32(FValueType::Float, 2, 5);
+	f32.convertFrom(u8, FValueArray::Normalize);
+	F_CHECK(f32.as<float>(0, 0) == 0.0f);
+	F_CHECK(f32.as<float>(0, 4) == 1.0f);
+	F_CHECK(fabsf(f32.as<float>(1, 1) - 0.8f) < 1e-6f);
+
+	FValueArray b8(FValueType::UInt8, 2, 5);
+	b8.convertFrom(f32, FValueArray::Normalize);
+	for (FValueArray::size_type i = 0; i < 10; ++i)
+		F_CHECK(b8.as<uint8_t>(i / 5, i % 5) == pu8[i]);
+
+	// saturation of floats and integers
+	float pf[] = { -1.5f, 0.4f, 127.9f, 300.0f, NAN, -1e10f };
+	FValueArray fs(pf, 1, 6, false);
+	FValueArray s8(FValueType::Int8, 1, 6);
+	s8.convertFrom(fs, FValueArray::Saturate);
+	F_CHECK(s8.as<int8_t>(0, 0) == -1);
+	F_CHECK(s8.as<int8_t>(0, 1) == 0);
+	F_CHECK(s8.as<int8_t>(0, 2) == 127);
+	F_CHECK(s8.as<int8_t>(0, 3) == 127);
+	F_CHECK(s8.as<int8_t>(0, 4) == 0);
+	F_CHECK(s8.as<int8_t>(0, 5) == -128);
+
+	int32_t pi32[] = { -100000, -5, 70000, 32767 };
+	FValueArray i32(pi32, 1, 4, false);
+	FValueArray i16(FValueType::Int16, 1, 4);
+	i16.convertFrom(i32, FValueArray::Saturate);
+	F_CHECK(i16.as<int16_t>(0, 0) == -32768);
+	F_CHECK(i16.as<int16_t>(0, 1) == -5);
+	F_CHECK(i16.as<int16_t>(0, 2) == 32767);
+
+	// casts wrap around, as before
+	int16_t pi16[] = { 300, -129 };
+	FValueArray w16(pi16, 1, 2, false);
+	FValueArray w8(FValueType::Int8, 1, 2);
+	w8.convertFrom(w16);
+	F_CHECK(w8.as<int8_t>(0, 0) == 44);
+	F_CHECK(w8.as<int8_t>(0, 1) == 127);
+
+	// half precision floats in UInt16 arrays
+	float ph[] = { 1.0f, -2.0f, 65504.0f, 1e6f, 5.9604645e-8f, 0.0f };
+	FValueArray hf(ph, 1, 6, false);
+	FValueArray h16(FValueType::UInt16, 1, 6);
+	h16.convertFrom(hf, FValueArray::Half);
+	F_CHECK(h16.as<uint16_t>(0, 0) == 0x3c00);
+	F_CHECK(h16.as<uint16_t>(0, 1) == 0xc000);
+	F_CHECK(h16.as<uint16_t>(0, 2) == 0x7bff);
+	F_CHECK(h16.as<uint16_t>(0, 3) == 0x7c00);
+	F_CHECK(h16.as<uint16_t>(0, 4) == 0x0001);
+
+	FValueArray hb(FValueType::Float, 1, 6);
+	hb.convertFrom(h16, FValueArray::Half);
+	F_CHECK(hb.as<float>(0, 0) == 1.0f);
+	F_CHECK(hb.as<float>(0, 2) == 65504.0f);
+	F_CHECK(hb.as<float>(0, 4) == 5.9604645e-8f);
+	F_CHECK(hb.as<float>(0, 3) > 1e38f);
+
+	// strided conversion into every other channel
+	FValueArray sd(FValueType::Double, 4, 5);
+	sd.convertFrom(u8, 0, 0, 2, 1, 2, 0, 0, 5, FValueArray::Normalize);
+	F_CHECK(sd.as<double>(0, 4) == 1.0);
+	F_CHECK(sd.as<double>(2, 0) == 1.0);
+	F_CHECK(sd.as<double>(2, 4) == 0.0);
+	F_CHECK(fabs(sd.as<double>(2, 2) - 0.4) < 1e-12);
+}
+
+void FValueArrayTest::testViews()
+{
+	// 4 channels (vertices) of 5 dimensions: position xyz, texcoord uv
+	FValueArray va(FValueType::Float, 4, 5);
+	for (FValueArray::size_type c = 0; c < 4; ++c)
+		for (FValueArray::size_type d = 0; d < 5; ++d)
+			va.as<float>(c, d) = float(c * 10 + d);
+
+	FArrayViewT<FVector3T<float> > pos = va.vector3View<float>();
+	F_CHECK(pos.size() == 4);
+	F_CHECK(pos.stride() == 5 * sizeof(float));
+	F_CHECK(!pos.isContiguous());
+	F_CHECK(pos[2].y == 21.0f);
+
+	FArrayViewT<FVector2T<float> > uv = va.vector2View<float>(3);
+	F_CHECK(uv[1].x == 13.0f && uv[3].y == 34.0f);
+
+	// writes through the view reach the array
+	for (size_t i = 0; i < pos.size(); ++i)
+		pos[i].z = -1.0f;
+	F_CHECK(va.as<float>(3, 2) == -1.0f);
+	F_CHECK(va.as<float>(3, 3) == 33.0f);
+
+	// iterators and std algorithms
+	FArrayViewT<float> vy = va.view<float>(1);
+	std::reverse(vy.begin(), vy.end());
+	F_CHECK(va.as<float>(0, 1) == 31.0f && va.as<float>(3, 1) == 1.0f);
+	F_CHECK(*std::max_element(vy.begin(), vy.end()) == 31.0f);
+	F_CHECK(vy.end() - vy.begin() == 4);
+	F_CHECK(std::accumulate(vy.begin(), vy.end(), 0.0f) == 64.0f);
+
+	FArrayViewT<const float> cvy = vy;
+	FArrayViewT<const float>::const_iterator it = vy.begin() + 2;
+	F_CHECK(*it == 11.0f && cvy[2] == 11.0f);
+	F_CHECK(cvy.mid(1, 2).size() == 2 && cvy.mid(1, 2)[0] == 21.0f);
+
+	vy.mid(2, 2).fill(7.0f);
+	F_CHECK(va.as<float>(1, 1) == 21.0f && va.as<float>(3, 1) == 7.0f);
+
+	// const views do not detach shared data, mutable views do
+	va.setShared(true);
+	FValueArray vb(va);
+	const FValueArray& cva = va;
+	const FValueArray& cvb = vb;
+	F_CHECK(cvb.view<float>(4).data() == cva.view<float>(4).data());
+	F_CHECK(!vb.isDetached());
+	vb.view<float>(4)[0] = 0.0f;
+	F_CHECK(vb.isDetached() && cva.as<float>(0, 4) == 4.0f);
+}
+
+static inline const float* _fDataPtr(const FValueArray& va)
+{
+	return va.ptr<float>();
+}
+
+void FValueArrayTest::testSharing()
+{
+	float pv[] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+
+	// move leaves the source empty
+	FValueArray da1(pv, 2, 3, false);
+	const float* pData = _fDataPtr(da1);
+	FValueArray da2(std::move(da1));
+	F_CHECK(da1.isEmpty());
+	F_CHECK(da1.type() == FValueType::Invalid);
+	F_CHECK(_fDataPtr(da2) == pData);
+	F_CHECK(da2.as<float>(1, 2) == 6.0f);
+
+	FValueArray da3;
+	da3 = std::move(da2);
+	F_CHECK(da2.isEmpty());
+	F_CHECK(da3.as<float>(0, 1) == 2.0f);
+
+	// copies are deep by default
+	FValueArray da4(da3);
+	F_CHECK(!da4.isShared());
+	F_CHECK(_fDataPtr(da4) != _fDataPtr(da3));
+
+	// shared copies reference the same data until written to
+	da3.setShared(true);
+	FValueArray da5(da3);
+	FValueArray da6 = da5;
+	F_CHECK(da5.isShared());
+	F_CHECK(!da3.isDetached());
+	F_CHECK(_fDataPtr(da5) == _fDataPtr(da3));
+	F_CHECK(_fDataPtr(da6) == _fDataPtr(da3));
+
+	da5.set<float>(0, 0, 10.0f);
+	F_CHECK(da5.isDetached());
+	F_CHECK(_fDataPtr(da5) != _fDataPtr(da3));
+	F_CHECK(da5.as<float>(0, 0) == 10.0f);
+	F_CHECK(da5.as<float>(1, 2) == 6.0f);
+	F_CHECK(da3.as<float>(0, 0) == 1.0f);
+	F_CHECK(da6.as<float>(0, 0) == 1.0f);
+
+	da6.setChannelCount(8, true);
+	F_CHECK(da3.isDetached());
+	F_CHECK(da3.channelCount() == 2);
+	F_CHECK(da6.channelCount() == 8);
+	F_CHECK(da6.as<float>(1, 2) == 6.0f);
+
+	// strings are shared as well
+	FValueArray da7(FValueType::String, 1, 3);
+	da7.setShared(true);
+	da7.set<QString>(0, 1, "abc");
+	FValueArray da8(da7);
+	da8.set<QString>(0, 1, "def");
+	F_CHECK(da7.as<QString>(0, 1) == "abc");
+	F_CHECK(da8.as<QString>(0, 1) == "def");
+
+	// leaving shared mode detaches
+	FValueArray da9(da7);
+	da9.setShared(false);
+	F_CHECK(!da9.isShared());
+	F_CHECK(da7.isDetached());
+	F_CHECK(da9.as<QString>(0, 1) == "abc");
+}
+
+class FCountingAllocator : public FAllocator
+{
+public:
+	FCountingAllocator() : allocations(0), bytes(0) { }
+
+	virtual void* allocate(size_t size) {
+		++allocations; bytes += size;
+		return allocateAligned(size);
+	}
+	virtual void deallocate(void* p, size_t size) {
+		--allocations; bytes -= size;
+		freeAligned(p);
+	}
+
+	int allocations;
+	size_t bytes;
+};
+
+class FExhaustedAllocator : public FAllocator
+{
+public:
+	virtual void* allocate(size_t) { return NULL; }
+	virtual void deallocate(void*, size_t) { }
+};
+
+void FValueArrayTest::testAllocation()
+{
+	// numeric arrays are aligned for SIMD access
+	FValueArray da1(FValueType::Float, 4, 33);
+	FValueArray da2(FValueType::UInt8, 3, 7);
+	FValueArray da3(FValueType::Double, 1, 100000);
+	F_CHECK(da1.allocator() == FAllocator::defaultAllocator());
+	F_CHECK(((size_t)da1.rawPtr() & (FAllocator::Alignment - 1)) == 0);
+	F_CHECK(((size_t)da2.rawPtr() & (FAllocator::Alignment - 1)) == 0);
+	F_CHECK(((size_t)da3.rawPtr() & (FAllocator::Alignment - 1)) == 0);
+
+	// freed blocks are recycled by the pool
+	FPoolAllocator pool;
+	FValueArray da4;
+	da4.setAllocator(&pool);
+	da4.allocate(FValueType::Float, 3, 20);
+	F_CHECK(pool.allocatedSize() == 256);
+	const char* pBlock = da4.rawPtr();
+	da4.clear();
+	F_CHECK(pool.allocatedSize() == 0);
+	da4.allocate(FValueType::Int32, 4, 12);
+	F_CHECK(da4.rawPtr() == pBlock);
+	F_CHECK(da4.allocator() == &pool);
+
+	da4.setChannelCapacity(10, true);
+	F_CHECK(pool.allocatedSize() == 512);
+	da4.clear();
+	size_t reserved = pool.reservedSize();
+	F_CHECK(reserved > 0);
+	pool.reset();
+	F_CHECK(pool.reservedSize() == 0);
+
+	// space left in a chunk is reused, reset releases the chunks
+	// once all blocks have been returned
+	const size_t maxBlock = FPoolAllocator::MaxBlockSize;
+	FPoolAllocator arena(maxBlock);
+	void* pLarge = arena.allocate(maxBlock + 1);
+	void* pSmall = arena.allocate(64);
+	void* pFull = arena.allocate(maxBlock);
+	F_CHECK(pLarge && pSmall && pFull);
+	F_CHECK(arena.reservedSize() == 3 * maxBlock + 1);
+	void* pReused = arena.allocate(128);
+	F_CHECK(pReused != NULL);
+	F_CHECK(arena.reservedSize() == 3 * maxBlock + 1);
+	F_CHECK(arena.allocatedSize() == 2 * maxBlock + 193);
+	arena.deallocate(pLarge, maxBlock + 1);
+	arena.deallocate(pSmall, 64);
+	arena.deallocate(pFull, maxBlock);
+	arena.deallocate(pReused, 128);
+	F_CHECK(arena.reservedSize() == 2 * maxBlock);
+	arena.reset();
+	F_CHECK(arena.allocatedSize() == 0);
+	F_CHECK(arena.reservedSize() == 0);
+
+	// external allocator, existing data is moved
+	FCountingAllocator counter;
+	float pv[] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+	FValueArray da5(pv, 2, 3, false);
+	da5.setAllocator(&counter);
+	F_CHECK(counter.allocations == 1);
+	F_CHECK(counter.bytes == sizeof(pv));
+	F_CHECK(da5.as<float>(1, 2) == 6.0f);
+
+	FValueArray da6(da5);
+	F_CHECK(da6.allocator() == FAllocator::defaultAllocator());
+	F_CHECK(counter.allocations == 1);
+
+	da5.setChannelCount(4, true);
+	F_CHECK(counter.allocations == 1);
+	F_CHECK(counter.bytes == 2 * sizeof(pv));
+	F_CHECK(da5.as<float>(3, 2) == 6.0f);
+	da5.clear();
+	F_CHECK(counter.allocations == 0);
+
+	FAllocator::setDefaultAllocator(&counter);
+	{
+		FValueArray da7(FValueType::Int16, 5, 5);
+		F_CHECK(da7.allocator() == &counter);
+		F_CHECK(counter.allocations == 1);
+	}
+	FAllocator::setDefaultAllocator(NULL);
+	F_CHECK(counter.allocations == 0);
+
+	// an exhausted allocator throws, the array keeps its data
+	FExhaustedAllocator exhausted;
+	FValueArray da8(pv, 2, 3, false);
+	bool hasThrown = false;
+	try { da8.setAllocator(&exhausted); }
+	catch (const std::bad_alloc&) { hasThrown = true; }
+	F_CHECK(hasThrown);
+	F_CHECK(da8.allocator() == FAllocator::defaultAllocator());
+	F_CHECK(da8.as<float>(1, 2) == 6.0f);
+
+	FValueArray da9;
+	da9.setAllocator(&exhausted);
+	hasThrown = false;
+	try { da9.allocate(FValueType::Float, 2, 3); }
+	catch (const std::bad_alloc&) { hasThrown = true; }
+	F_CHECK(hasThrown);
+}
+
+#define _F_TEST_SERIALIZATION(valueType, rawType, v1, v2, v3, v4, v5, v6) \
+{ \
+	rawType pv[] = { v1, v2, v3, v4, v5, v6 }; \
+	FValueArray da1(pv, 2, 3, false); \
+	QByteArray buffer; \
+	{ FArchive ar(&buffer, FArchive::Write, false); da1.serialize(ar); } \
+	FValueArray da2; \
+	{ FArchive ar(buffer, false); da2.serialize(ar); } \
+	F_CHECK(da2.type() == FValueType::valueType); \
+	F_CHECK(da2.channelCount() == 2); \
+	F_CHECK(da2.dimensionCount() == 3); \
+	for (FValueArray::size_type c = 0; c < 2; ++c) \
+	for (FValueArray::size_type i = 0; i < 3; ++i) \
+	F_CHECK(da2.as<rawType>(c, i) == da1.as<rawType>(c, i)); \
+}
+
+void FValueArrayTest::testSerialization()
+{
+	_F_TEST_SERIALIZATION(Float, float, 1.1f, 2.2f, 3.3f, 4.4f, 5.5f, 6.6f);
+	_F_TEST_SERIALIZATION(Double, double, 1.11, 2.22, 3.33, 4.44, 5.55, 6.66);
+	_F_TEST_SERIALIZATION(Bool, bool, false, false, true, true, false, true);
+	_F_TEST_SERIALIZATION(Int8, int8_t, -11, -22, -33, -44, -55, -66);
+	_F_TEST_SERIALIZATION(UInt16, uint16_t, 1111, 2222, 3333, 4444, 5555, 6666);
+	_F_TEST_SERIALIZATION(Int32, int32_t, -1010, -2020, -3030, -4040, -5050, -6060);
+	_F_TEST_SERIALIZATION(UInt64, uint64_t, 10101, 20202, 30303, 40404, 50505, 60606);
+	_F_TEST_SERIALIZATION(String, QString, QString("abc"), QString("def"), QString("ghi"), QString("jkl"), QString("mno"), QString("pqr"));
+
+	// numbers are written as one raw block in native byte order
+	float pf[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+	FValueArray da1(pf, 4, 1, false);
+	QByteArray buffer;
+	{ FArchive ar(&buffer, FArchive::Write, false); da1.serialize(ar); }
+	F_CHECK(buffer.size() == 1 + 1 + 4 + 4 + 1 + 1 + 8 + sizeof(pf));
+	F_CHECK(memcmp(buffer.constData() + buffer.size() - sizeof(pf), pf, sizeof(pf)) == 0);
+
+	// a block in foreign byte order is swapped on reading
+	quint32 pu[] = { 0x01020304, 0xa0b0c0d0, 0x11223344 };
+	quint32 ps[] = { 0x04030201, 0xd0c0b0a0, 0x44332211 };
+	buffer.clear();
+	{
+		FArchive ar(&buffer, FArchive::Write, false);
+		ar << quint8(FValueType::UInt32 | 0x80) << quint8(0);
+		ar << FValueArray::size_type(1) << FValueArray::size_type(3);
+		ar.stream() << quint8(Q_BYTE_ORDER == Q_BIG_ENDIAN ? 0 : 1)
+			<< quint8(4) << quint64(sizeof(ps));
+		ar.stream().writeRawData((const char*)ps, sizeof(ps));
+	}
+	FValueArray da2;
+	{ FArchive ar(buffer, false); da2.serialize(ar); }
+	F_CHECK(da2.as<quint32>(0, 0) == pu[0]);
+	F_CHECK(da2.as<quint32>(1, 0) == pu[1]);
+	F_CHECK(da2.as<quint32>(2, 0) == pu[2]);
+
+	// archives with per element data can still be read
+	buffer.clear();
+	{
+		FArchive ar(&buffer, FArchive::Write, false);
+		ar << quint8(FValueType::Double) << quint8(0);
+		ar << FValueArray::size_type(1) << FValueArray::size_type(2);
+		ar << 1.5 << -2.5;
+	}
+	FValueArray da3;
+	{ FArchive ar(buffer, false); da3.serialize(ar); }
+	F_CHECK(da3.as<double>(0, 0) == 1.5);
+	F_CHECK(da3.as<double>(1, 0) == -2.5);
+}
+
+void FValueArrayTest::testMapping()
+{
+	// a header of 100 bytes, followed by 1000 floats (250 channels of 4)
+	QByteArray data(100, 'h');
+	for (int i = 0; i < 1000; ++i) {
+		float v = float(i) * 0.5f;
+		data.append((const char*)&v, sizeof(float));
+	}
+
+	QFile outFile("test.fmap");
+	outFile.open(QFile::WriteOnly);
+	outFile.write(data);
+	outFile.close();
+
+	FMappedFile missing;
+	F_CHECK(!missing.map("missing.fmap") && !missing.isMapped());
+
+	FMappedFile file("test.fmap");
+	F_CHECK(file.isMapped() && file.size() == data.size());
+	F_CHECK(memcmp(file.data(), data.constData(), data.size()) == 0);
+
+	FValueArray va = file.array<float>(100, 250, 4);
+	F_CHECK(va.isReference() && va.is<float>());
+	F_CHECK(va.channelCount() == 250 && va.dimensionCount() == 4);
+	F_CHECK(va.as<float>(249, 3) == 499.5f);
+
+	// copies share the data, arrays keep the mapping alive
+	FValueArray vb(va);
+	F_CHECK(vb.rawPtr() == va.rawPtr());
+	file.unmap();
+	F_CHECK(!file.isMapped());
+	va = FValueArray();
+	F_CHECK(vb.as<float>(10, 2) == 21.0f);
+	F_CHECK(vb.vector3View<float>()[3].x == 6.0f);
+
+	// unaligned offset, copy-on-write changes stay in memory
+	FMappedFile region;
+	F_CHECK(region.map("test.fmap", FMappedFile::CopyOnWrite, 104, 400));
+	F_CHECK(region.size() == 400);
+	FValueArray vc = region.array(FValueType::Float, 0, 100);
+	F_CHECK(vc.as<float>(0) == 0.5f);
+	vc.as<float>(0) = -1.0f;
+	F_CHECK(vc.as<float>(0) == -1.0f);
+
+	FMappedFile original("test.fmap");
+	F_CHECK(original.array<float>(104, 1).as<float>(0) == 0.5f);
+
+	// regions beyond the end of the file can't be mapped
+	F_CHECK(!region.map("test.fmap", FMappedFile::ReadOnly, 4000, 200));
+
+	vb = FValueArray();
+	vc = FValueArray();
+	original.unmap();
+	QFile::remove("test.fmap");
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
@@ -29,6 +29,12 @@ public:
 		void evaluateVerbose();
 		void testConstruction();
 		void testConversion();
+		void testConversionModes();
+		void testViews();
+		void testSharing();
+		void testAllocation();
+		void testSerialization();
+		void testMapping();
 };
 	
 // -----------------------------------------------------------------------------
@@ -13,6 +13,19 @@
 #include "FlowCore/Vector3T.h"
 #include "FlowCore/Vector4T.h"
 #include "FlowCore/FastVec.h"
+#include "FlowCore/FastMat.h"
+#include "FlowCore/Matrix4T.h"
+#include "FlowCore/QuaternionBatch.h"
+#include "FlowCore/Math.h"
+#include "FlowCore/CurveArray.h"
+#include "FlowCore/CycleCounter.h"
+#include "FlowCore/Cpu.h"
+#include "FlowCore/Log.h"
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstring>
 
 // -----------------------------------------------------------------------------
 //  Class FVectorTest
@@ -102,4 +115,300 @@ void FVectorTest::testVector()
 	F_CHECK_MESSAGE(t1 == ft1, "Dot product fDot(v2, v1), Fast version");
 }
 
+void FVectorTest::testQuaternionBatch()
+{
+	// 13 quaternions: covers the 8- and 4-wide and the remainder code paths
+	const size_t count = 13;
+	std::vector<float> a(count * 4), b(count * 4), d(count * 4), factors(count);
+	std::vector<float> vx(count), vy(count), vz(count), rx(count), ry(count), rz(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		FQuaternion4d qa(FVector3d(1.0, float(i), 2.0).normalized(), 0.3 * i);
+		FQuaternion4d qb(FVector3d(float(i), -1.0, 0.5).normalized(), 2.0 - 0.4 * i);
+		for (size_t c = 0; c < 4; ++c) {
+			a[c * count + i] = float(qa[c]);
+			b[c * count + i] = float(qb[c]);
+		}
+		factors[i] = float(i) / float(count - 1);
+		vx[i] = 1.0f; vy[i] = float(i) * 0.5f; vz[i] = -2.0f;
+	}
+
+	FQuaternionSoA qa(&a[0], &a[count], &a[count * 2], &a[count * 3]);
+	FQuaternionSoA qb(&b[0], &b[count], &b[count * 2], &b[count * 3]);
+	FQuaternionSoA qd(&d[0], &d[count], &d[count * 2], &d[count * 3]);
+	std::vector<FFastMat4f> matrices(count);
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		QString tierName = FCpu::tierName((FCpu::SimdTier)t);
+
+		FQuaternionBatch::slerp(qa, qb, &factors[0], qd, count);
+		FQuaternionBatch::rotate(qa, &vx[0], &vy[0], &vz[0], &rx[0], &ry[0], &rz[0], count);
+		FQuaternionBatch::toMatrices(qa, &matrices[0], count);
+
+		bool slerpOk = true, rotateOk = true, matrixOk = true;
+		for (size_t i = 0; i < count; ++i) {
+			FQuaternion4d q1(qa.x[i], qa.y[i], qa.z[i], qa.w[i]);
+			FQuaternion4d q2(qb.x[i], qb.y[i], qb.z[i], qb.w[i]);
+			FQuaternion4d ref = fSlerp(q1, q2, double(factors[i]));
+			slerpOk = slerpOk && fabs(ref.x - qd.x[i]) < 3e-7 && fabs(ref.y - qd.y[i]) < 3e-7
+				&& fabs(ref.z - qd.z[i]) < 3e-7 && fabs(ref.w - qd.w[i]) < 3e-7;
+
+			FVector3d v = q1.rotate(FVector3d(vx[i], vy[i], vz[i]));
+			double tol = 5e-7 * FVector3d(vx[i], vy[i], vz[i]).length();
+			rotateOk = rotateOk && fabs(v.x - rx[i]) < tol
+				&& fabs(v.y - ry[i]) < tol && fabs(v.z - rz[i]) < tol;
+
+			FMatrix4d m;
+			m.makeRotation(q1);
+			for (size_t r = 0; r < 4; ++r)
+				for (size_t c = 0; c < 4; ++c)
+					matrixOk = matrixOk && fabs(m(r, c) - matrices[i](r, c)) < 3e-7;
+		}
+
+		F_CHECK_MESSAGE(slerpOk, QString("FQuaternionBatch::slerp, %1").arg(tierName));
+		F_CHECK_MESSAGE(rotateOk, QString("FQuaternionBatch::rotate, %1").arg(tierName));
+		F_CHECK_MESSAGE(matrixOk, QString("FQuaternionBatch::toMatrices, %1").arg(tierName));
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+void FVectorTest::testApproximations()
+{
+	// 1003 values, covers the 8- and 4-wide and the remainder code paths
+	const size_t count = 1003;
+	std::vector<float> x(count), y(count), a(count), b(count), r(count), s(count), c(count);
+	for (size_t i = 0; i < count; ++i) {
+		x[i] = -20.0f + 40.0f * float(i) / float(count);
+		y[i] = 0.01f + 50.0f * float(i) / float(count);
+		a[i] = -1.0f + 2.0f * float(i) / float(count - 1);
+		b[i] = -2.0f + 4.0f * float((i * 7) % count) / float(count);
+	}
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+
+		for (int k = FMath::Fast; k <= FMath::Precise; ++k) {
+			FMath::Accuracy accuracy = (FMath::Accuracy)k;
+			double tol = accuracy == FMath::Precise ? 2e-6 : 1e-3;
+			QString name = QString("%1, %2").arg(FCpu::tierName((FCpu::SimdTier)t))
+				.arg(accuracy == FMath::Precise ? "precise" : "fast");
+
+			double sinErr = 0.0, cosErr = 0.0, expErr = 0.0, logErr = 0.0;
+			double powErr = 0.0, atanErr = 0.0, acosErr = 0.0;
+
+			FMath::approxSinCos(&x[0], &s[0], &c[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i) {
+				sinErr = fMax(sinErr, fabs(s[i] - sin(double(x[i]))));
+				cosErr = fMax(cosErr, fabs(c[i] - cos(double(x[i]))));
+			}
+			FMath::approxExp(&x[0], &r[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i)
+				expErr = fMax(expErr, fabs(r[i] / exp(double(x[i])) - 1.0));
+			FMath::approxLog(&y[0], &r[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i)
+				logErr = fMax(logErr, fabs(r[i] - log(double(y[i]))) / fMax(1.0, fabs(log(double(y[i])))));
+			FMath::approxPow(&y[0], &b[0], &r[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i)
+				powErr = fMax(powErr, fabs(r[i] / pow(double(y[i]), double(b[i])) - 1.0));
+			FMath::approxAtan2(&x[0], &b[0], &r[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i)
+				atanErr = fMax(atanErr, fabs(r[i] - atan2(double(x[i]), double(b[i]))));
+			FMath::approxAcos(&a[0], &r[0], count, accuracy);
+			for (size_t i = 0; i < count; ++i)
+				acosErr = fMax(acosErr, fabs(r[i] - acos(double(a[i]))));
+
+			F_CHECK_MESSAGE(sinErr < tol && cosErr < tol, QString("FMath::approxSinCos, %1").arg(name));
+			F_CHECK_MESSAGE(expErr < tol, QString("FMath::approxExp, %1").arg(name));
+			F_CHECK_MESSAGE(logErr < tol, QString("FMath::approxLog, %1").arg(name));
+			F_CHECK_MESSAGE(powErr < tol * 5.0, QString("FMath::approxPow, %1").arg(name));
+			F_CHECK_MESSAGE(atanErr < tol, QString("FMath::approxAtan2, %1").arg(name));
+			F_CHECK_MESSAGE(acosErr < tol, QString("FMath::approxAcos, %1").arg(name));
+
+			// out of range and NaN arguments, nine values also cover the tail loops
+			const float nan = std::numeric_limits<float>::quiet_NaN();
+			const float inf = std::numeric_limits<float>::infinity();
+			float edge[9] = { nan, -inf, -100.0f, inf, 100.0f, 0.0f, 1.0f, -1.0f, nan };
+			float edgeExp[9];
+			FMath::approxExp(edge, edgeExp, 9, accuracy);
+			F_CHECK_MESSAGE(edgeExp[0] != edgeExp[0] && edgeExp[8] != edgeExp[8],
+				QString("FMath::approxExp(NaN), %1").arg(name));
+			F_CHECK_MESSAGE(edgeExp[1] == 0.0f && edgeExp[2] == 0.0f
+				&& edgeExp[3] == inf && edgeExp[4] == inf && fabs(edgeExp[5] - 1.0f) < tol,
+				QString("FMath::approxExp, out of range, %1").arg(name));
+		}
+	}
+
+	FCpu::setSimdTier(tier);
+
+	// the FFastVec4f functions use the same approximations as the SSE4 kernels
+	F_ALIGN(16) float src[4] = { -2.5f, 0.3f, 1.7f, 12.0f };
+	F_ALIGN(16) float den[4] = { 0.3f, 1.7f, 12.0f, 1.0f };
+	F_ALIGN(16) float dst[4];
+	F_ALIGN(16) float vec[4];
+
+	FCpu::setSimdTier(FCpu::SSE4);
+	FMath::approxSin(src, dst, 4);
+	fSin(FFastVec4f(src)).copyToAligned(vec);
+	F_CHECK_MESSAGE(memcmp(vec, dst, sizeof(dst)) == 0, "fSin(FFastVec4f)");
+	FMath::approxAtan2(src, den, dst, 4, FMath::Fast);
+	fAtan2(FFastVec4f(src), FFastVec4f(den), FMath::Fast).copyToAligned(vec);
+	F_CHECK_MESSAGE(memcmp(vec, dst, sizeof(dst)) == 0, "fAtan2(FFastVec4f)");
+	FCpu::setSimdTier(tier);
+}
+
+void FVectorTest::testCurveEvaluation()
+{
+	// segments with regular, extreme, crossing and out of range time handles,
+	// followed by Hermite segments
+	const size_t segmentCount = 24;
+	std::vector<double> ref(segmentCount * 8);
+	FCurveArray curves;
+
+	for (size_t i = 0; i < segmentCount; ++i) {
+		double* t = &ref[i * 8];
+		double* v = t + 4;
+		double t0 = double(i) * 2.0 - 5.0, t3 = t0 + 0.5 + double(i % 5);
+		double d = t3 - t0;
+		double h[8][2] = { { 0.3, 0.7 }, { 0.0, 1.0 }, { 1.0, 0.0 }, { 0.9, 0.1 },
+			{ -0.5, 1.5 }, { 0.01, 0.02 }, { 0.98, 0.99 }, { 0.5, 0.5 } };
+		const double* hk = h[i % 8];
+
+		t[0] = t0; t[3] = t3;
+		v[0] = double(i % 3) - 1.0; v[3] = double(i % 7) * 0.5;
+
+		if (i < 16) {
+			t[1] = t0 + hk[0] * d; t[2] = t0 + hk[1] * d;
+			v[1] = 4.0 - double(i); v[2] = double(i) * 0.25;
+			curves.appendBezier(FVector2f(float(t[0]), float(v[0])), FVector2f(float(t[1]), float(v[1])),
+				FVector2f(float(t[2]), float(v[2])), FVector2f(float(t[3]), float(v[3])));
+			t[1] = fMinMax(t[1], t0, t3); t[2] = fMinMax(t[2], t0, t3);
+		}
+		else {
+			double outTangent = double(i % 4) - 1.5, inTangent = 2.0 - double(i % 3);
+			t[1] = t0 + d / 3.0; t[2] = t3 - d / 3.0;
+			v[1] = v[0] + outTangent * d / 3.0; v[2] = v[3] - inTangent * d / 3.0;
+			curves.appendHermite(float(t0), float(v[0]), float(outTangent),
+				float(t3), float(v[3]), float(inTangent));
+		}
+	}
+
+	F_CHECK(curves.size() == segmentCount);
+	F_CHECK(curves.startTime(3) == 1.0f && curves.endTime(3) == 4.5f);
+
+	// 203 samples, including times before and after the segments
+	const size_t count = 203;
+	std::vector<uint32_t> index(count);
+	std::vector<float> time(count), value(count);
+	std::vector<double> expected(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		index[i] = uint32_t((i * 7) % segmentCount);
+		const double* t = &ref[index[i] * 8];
+		time[i] = float(t[0] - 0.1 + (t[3] - t[0] + 0.2) * double((i * 13) % 101) / 100.0);
+		expected[i] = _solveBezier(t, t + 4, time[i]);
+	}
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		QString name = FCpu::tierName((FCpu::SimdTier)t);
+
+		double maxError = 0.0;
+		curves.evaluate(&index[0], &time[0], &value[0], count);
+		for (size_t i = 0; i < count; ++i)
+			maxError = fMax(maxError, fabs(value[i] - expected[i]));
+		F_CHECK_MESSAGE(maxError < 1e-4, QString("FCurveArray::evaluate, indexed, %1").arg(name));
+
+		maxError = 0.0;
+		curves.evaluate(&time[0], &value[0]);
+		for (size_t i = 0; i < segmentCount; ++i)
+			maxError = fMax(maxError, fabs(value[i] - _solveBezier(&ref[i * 8], &ref[i * 8 + 4], time[i])));
+		F_CHECK_MESSAGE(maxError < 1e-4, QString("FCurveArray::evaluate, all segments, %1").arg(name));
+
+		maxError = 0.0;
+		curves.evaluate(5, &time[0], &value[0], count);
+		for (size_t i = 0; i < count; ++i)
+			maxError = fMax(maxError, fabs(value[i] - _solveBezier(&ref[40], &ref[44], time[i])));
+		F_CHECK_MESSAGE(maxError < 1e-4, QString("FCurveArray::evaluate, single segment, %1").arg(name));
+	}
+
+	FCpu::setSimdTier(tier);
+
+	F_CHECK(fabs(curves.evaluate(2, -100.0f) - ref[16 + 4]) < 1e-6);
+	F_CHECK(fabs(curves.evaluate(2, 100.0f) - ref[16 + 7]) < 1e-6);
+}
+
+void FVectorTest::benchmarkCurveEvaluation()
+{
+	// one sample per segment, as for the channels of a rig during playback
+	const size_t count = 10000;
+	FCurveArray curves;
+	std::vector<float> time(count), value(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		float a = float(i % 10) * 0.1f, b = float(i % 7) / 7.0f;
+		curves.appendBezier(FVector2f(0.0f, 0.0f), FVector2f(a, 1.0f),
+			FVector2f(b, -1.0f), FVector2f(1.0f, 0.5f));
+		time[i] = float((i * 37) % 1000) * 0.001f;
+	}
+
+	// scalar reference: 14 fixed Newton iterations per sample
+	const float* s = curves.data();
+	double sum = 0.0;
+
+	FCycleCounter counter;
+	counter.start();
+	for (size_t i = 0; i < count; ++i, s += FCurveArray::SegmentSize) {
+		double x = (time[i] - s[0]) * s[1], u = x;
+		for (int k = 0; k < 14; ++k)
+			u -= (((s[4] * u + s[3]) * u + s[2]) * u - x) / ((3.0 * s[4] * u + 2.0 * s[3]) * u + s[2]);
+		sum += ((s[8] * u + s[7]) * u + s[6]) * u + s[5];
+	}
+	counter.stop();
+
+	F_TRACE << "Curve evaluation of " << count << " samples: scalar "
+		<< counter.cyclesPerRun(count) << " cycles per sample (" << sum << ")";
+
+	FCpu::SimdTier tier = FCpu::simdTier();
+
+	for (int t = FCpu::SSE4; t <= FCpu::supportedTier(); ++t) {
+		FCpu::setSimdTier((FCpu::SimdTier)t);
+		counter.start();
+		curves.evaluate(&time[0], &value[0]);
+		counter.stop();
+
+		F_TRACE << "Curve evaluation of " << count << " samples: batch "
+			<< FCpu::tierName((FCpu::SimdTier)t) << " "
+			<< counter.cyclesPerRun(count) << " cycles per sample";
+	}
+
+	FCpu::setSimdTier(tier);
+}
+
+// Internal functions ----------------------------------------------------------
+
+double FVectorTest::_solveBezier(const double* pTime, const double* pValue, double time)
+{
+	// bisection on the Bernstein form of the time curve
+	double lo = 0.0, hi = 1.0, u = 0.5;
+	time = fMinMax(time, pTime[0], pTime[3]);
+
+	for (int k = 0; k < 60; ++k) {
+		u = 0.5 * (lo + hi);
+		double r = 1.0 - u;
+		double x = r*r*r * pTime[0] + 3.0*r*r*u * pTime[1] + 3.0*r*u*u * pTime[2] + u*u*u * pTime[3];
+		if (x < time) lo = u; else hi = u;
+	}
+
+	double r = 1.0 - u;
+	return r*r*r * pValue[0] + 3.0*r*r*u * pValue[1] + 3.0*r*u*u * pValue[2] + u*u*u * pValue[3];
+}
+
 // -----------------------------------------------------------------------------
\ No newline at end of file
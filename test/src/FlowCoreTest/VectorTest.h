@@ -29,7 +29,15 @@ public:
 
 public slots:
 	void testVector();
+	void testQuaternionBatch();
+	void testApproximations();
+	void testCurveEvaluation();
+	void benchmarkCurveEvaluation();
 
+	//  Internal functions -------------------------------------------
+
+private:
+	double _solveBezier(const double* pTime, const double* pValue, double time);
 };
 	
 // -----------------------------------------------------------------------------